@@ -2,6 +2,8 @@
 
 #include "d3d11_include.h"
 
+#include "../dxvk/dxvk_context.h"
+
 namespace dxvk {
 
   /**
@@ -13,6 +15,7 @@ namespace dxvk {
   enum class D3D11CmdType {
     DrawIndirect,
     DrawIndirectIndexed,
+    UpdateBuffer,
   };
 
 
@@ -40,4 +43,18 @@ namespace dxvk {
     uint32_t            stride;
   };
 
+
+  /**
+   * \brief Buffer update command data
+   * 
+   * Stores consecutive buffer updates so that
+   * they can be executed in one single batch.
+   */
+  struct D3D11CmdUpdateBufferData : public D3D11CmdData {
+    constexpr static uint32_t MaxCount = 16;
+
+    uint32_t                                count;
+    std::array<DxvkBufferUpdate, MaxCount>  updates;
+  };
+
 }
\ No newline at end of file
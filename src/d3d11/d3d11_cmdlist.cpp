@@ -73,6 +73,28 @@ namespace dxvk {
   }
   
   
+  void D3D11CommandList::SetBindings(
+    const D3D11ContextState&  State) {
+    SaveStageBindings(m_bindings.stages[uint32_t(DxbcProgramType::VertexShader)],   State.vs);
+    SaveStageBindings(m_bindings.stages[uint32_t(DxbcProgramType::HullShader)],     State.hs);
+    SaveStageBindings(m_bindings.stages[uint32_t(DxbcProgramType::DomainShader)],   State.ds);
+    SaveStageBindings(m_bindings.stages[uint32_t(DxbcProgramType::GeometryShader)], State.gs);
+    SaveStageBindings(m_bindings.stages[uint32_t(DxbcProgramType::PixelShader)],    State.ps);
+    SaveStageBindings(m_bindings.stages[uint32_t(DxbcProgramType::ComputeShader)],  State.cs);
+
+    for (uint32_t i = 0; i < D3D11_1_UAV_SLOT_COUNT; i++) {
+      m_bindings.psUavs[i] = State.ps.unorderedAccessViews[i].ptr();
+      m_bindings.csUavs[i] = State.cs.unorderedAccessViews[i].ptr();
+    }
+
+    for (uint32_t i = 0; i < D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT; i++) {
+      m_bindings.vertexBuffers[i].buffer = State.ia.vertexBuffers[i].buffer.ptr();
+      m_bindings.vertexBuffers[i].offset = State.ia.vertexBuffers[i].offset;
+      m_bindings.vertexBuffers[i].stride = State.ia.vertexBuffers[i].stride;
+    }
+  }
+
+
   void D3D11CommandList::MarkSubmitted() {
     if (m_submitted.exchange(true) && !m_warned.exchange(true)
      && m_parent->GetOptions()->dcSingleUseMode) {
@@ -82,4 +104,22 @@ namespace dxvk {
     }
   }
   
+
+
+  template<typename T>
+  void D3D11CommandList::SaveStageBindings(
+          D3D11StageBindings& Bindings,
+    const T&                  State) {
+    for (uint32_t i = 0; i < D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT; i++) {
+      Bindings.constantBuffers[i].buffer         = State.constantBuffers[i].buffer.ptr();
+      Bindings.constantBuffers[i].constantOffset = State.constantBuffers[i].constantOffset;
+      Bindings.constantBuffers[i].constantBound  = State.constantBuffers[i].constantBound;
+    }
+
+    for (uint32_t i = 0; i < D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT; i++)
+      Bindings.shaderResources[i] = State.shaderResources.views[i].ptr();
+
+    Bindings.samplers = State.samplers;
+  }
+  
 }
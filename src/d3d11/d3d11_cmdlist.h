@@ -31,6 +31,27 @@ namespace dxvk {
     
     void EmitToCsThread(
             DxvkCsThread*       CsThread);
+
+    /**
+     * \brief Stores final resource bindings
+     *
+     * Must be called when the command list gets finished.
+     * \param [in] State Current deferred context state
+     */
+    void SetBindings(
+      const D3D11ContextState&  State);
+
+    /**
+     * \brief Resource bindings after execution
+     *
+     * Every command list starts by either resetting or
+     * restoring the full context state, so executing it
+     * always leaves the DXVK context with these bindings.
+     * \returns Bindings at the end of the command list
+     */
+    const D3D11ContextBindings& GetBindings() const {
+      return m_bindings;
+    }
     
   private:
     
@@ -39,10 +60,17 @@ namespace dxvk {
     std::vector<DxvkCsChunkRef>         m_chunks;
     std::vector<Com<D3D11Query, false>> m_queries;
 
+    D3D11ContextBindings m_bindings;
+
     std::atomic<bool> m_submitted = { false };
     std::atomic<bool> m_warned    = { false };
 
     void MarkSubmitted();
+
+    template<typename T>
+    static void SaveStageBindings(
+            D3D11StageBindings& Bindings,
+      const T&                  State);
     
   };
   
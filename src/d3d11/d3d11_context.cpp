@@ -49,7 +49,8 @@ namespace dxvk {
     }
     
     if (riid == __uuidof(ID3D11VkExtContext)
-     || riid == __uuidof(ID3D11VkExtContext1)) {
+     || riid == __uuidof(ID3D11VkExtContext1)
+     || riid == __uuidof(ID3D11VkExtContext2)) {
       *ppvObject = ref(&m_contextExt);
       return S_OK;
     }
@@ -971,16 +972,7 @@ namespace dxvk {
         DxvkDataSlice dataSlice = AllocUpdateBufferSlice(size);
         std::memcpy(dataSlice.ptr(), pSrcData, size);
         
-        EmitCs([
-          cDataBuffer   = std::move(dataSlice),
-          cBufferSlice  = bufferSlice.subSlice(offset, size)
-        ] (DxvkContext* ctx) {
-          ctx->updateBuffer(
-            cBufferSlice.buffer(),
-            cBufferSlice.offset(),
-            cBufferSlice.length(),
-            cDataBuffer.ptr());
-        });
+        UpdateBuffer(bufferSlice.subSlice(offset, size), std::move(dataSlice));
       }
     } else {
       D3D11CommonTexture* dstTexture = GetCommonTexture(pDstResource);
@@ -3668,6 +3660,30 @@ namespace dxvk {
   }
 
 
+  void D3D11DeviceContext::UpdateBuffer(
+    const DxvkBufferSlice&                  DstSlice,
+          DxvkDataSlice&&                   SrcData) {
+    // Batch consecutive buffer updates so that the
+    // backend can perform them with fewer copies
+    auto cmdData = static_cast<D3D11CmdUpdateBufferData*>(m_cmdData);
+
+    if (!cmdData || cmdData->type != D3D11CmdType::UpdateBuffer
+     || cmdData->count == D3D11CmdUpdateBufferData::MaxCount) {
+      cmdData = EmitCsCmd<D3D11CmdUpdateBufferData>(
+        [] (DxvkContext* ctx, const D3D11CmdUpdateBufferData* data) {
+          ctx->updateBuffers(data->count, data->updates.data());
+        });
+
+      cmdData->type  = D3D11CmdType::UpdateBuffer;
+      cmdData->count = 0;
+    }
+
+    auto& update = cmdData->updates[cmdData->count++];
+    update.dstSlice = DstSlice;
+    update.srcData  = std::move(SrcData);
+  }
+
+
   void D3D11DeviceContext::UpdateImage(
           D3D11CommonTexture*               pDstTexture,
     const VkImageSubresource*               pDstSubresource,
@@ -4064,7 +4080,11 @@ namespace dxvk {
   }
 
 
-  void D3D11DeviceContext::RestoreState() {
+  void D3D11DeviceContext::RestoreState(
+    const D3D11ContextBindings*             pPrevious) {
+    // If the bindings currently applied to the DXVK context
+    // are known, only emit commands for slots that differ.
+    // Everything else is cheap enough to restore in full.
     BindFramebuffer();
     
     BindShader<DxbcProgramType::VertexShader>   (GetCommonShader(m_state.vs.shader.ptr()));
@@ -4093,6 +4113,15 @@ namespace dxvk {
       m_state.ia.indexBuffer.format);
     
     for (uint32_t i = 0; i < m_state.ia.vertexBuffers.size(); i++) {
+      if (pPrevious) {
+        const auto& prev = pPrevious->vertexBuffers[i];
+
+        if (prev.buffer == m_state.ia.vertexBuffers[i].buffer.ptr()
+         && prev.offset == m_state.ia.vertexBuffers[i].offset
+         && prev.stride == m_state.ia.vertexBuffers[i].stride)
+          continue;
+      }
+
       BindVertexBuffer(i,
         m_state.ia.vertexBuffers[i].buffer.ptr(),
         m_state.ia.vertexBuffers[i].offset,
@@ -4102,38 +4131,48 @@ namespace dxvk {
     for (uint32_t i = 0; i < m_state.so.targets.size(); i++)
       BindXfbBuffer(i, m_state.so.targets[i].buffer.ptr(), ~0u);
     
-    RestoreConstantBuffers<DxbcProgramType::VertexShader>   (m_state.vs.constantBuffers);
-    RestoreConstantBuffers<DxbcProgramType::HullShader>     (m_state.hs.constantBuffers);
-    RestoreConstantBuffers<DxbcProgramType::DomainShader>   (m_state.ds.constantBuffers);
-    RestoreConstantBuffers<DxbcProgramType::GeometryShader> (m_state.gs.constantBuffers);
-    RestoreConstantBuffers<DxbcProgramType::PixelShader>    (m_state.ps.constantBuffers);
-    RestoreConstantBuffers<DxbcProgramType::ComputeShader>  (m_state.cs.constantBuffers);
+    RestoreConstantBuffers<DxbcProgramType::VertexShader>   (m_state.vs.constantBuffers, pPrevious);
+    RestoreConstantBuffers<DxbcProgramType::HullShader>     (m_state.hs.constantBuffers, pPrevious);
+    RestoreConstantBuffers<DxbcProgramType::DomainShader>   (m_state.ds.constantBuffers, pPrevious);
+    RestoreConstantBuffers<DxbcProgramType::GeometryShader> (m_state.gs.constantBuffers, pPrevious);
+    RestoreConstantBuffers<DxbcProgramType::PixelShader>    (m_state.ps.constantBuffers, pPrevious);
+    RestoreConstantBuffers<DxbcProgramType::ComputeShader>  (m_state.cs.constantBuffers, pPrevious);
     
-    RestoreSamplers<DxbcProgramType::VertexShader>  (m_state.vs.samplers);
-    RestoreSamplers<DxbcProgramType::HullShader>    (m_state.hs.samplers);
-    RestoreSamplers<DxbcProgramType::DomainShader>  (m_state.ds.samplers);
-    RestoreSamplers<DxbcProgramType::GeometryShader>(m_state.gs.samplers);
-    RestoreSamplers<DxbcProgramType::PixelShader>   (m_state.ps.samplers);
-    RestoreSamplers<DxbcProgramType::ComputeShader> (m_state.cs.samplers);
+    RestoreSamplers<DxbcProgramType::VertexShader>  (m_state.vs.samplers, pPrevious);
+    RestoreSamplers<DxbcProgramType::HullShader>    (m_state.hs.samplers, pPrevious);
+    RestoreSamplers<DxbcProgramType::DomainShader>  (m_state.ds.samplers, pPrevious);
+    RestoreSamplers<DxbcProgramType::GeometryShader>(m_state.gs.samplers, pPrevious);
+    RestoreSamplers<DxbcProgramType::PixelShader>   (m_state.ps.samplers, pPrevious);
+    RestoreSamplers<DxbcProgramType::ComputeShader> (m_state.cs.samplers, pPrevious);
     
-    RestoreShaderResources<DxbcProgramType::VertexShader>   (m_state.vs.shaderResources);
-    RestoreShaderResources<DxbcProgramType::HullShader>     (m_state.hs.shaderResources);
-    RestoreShaderResources<DxbcProgramType::DomainShader>   (m_state.ds.shaderResources);
-    RestoreShaderResources<DxbcProgramType::GeometryShader> (m_state.gs.shaderResources);
-    RestoreShaderResources<DxbcProgramType::PixelShader>    (m_state.ps.shaderResources);
-    RestoreShaderResources<DxbcProgramType::ComputeShader>  (m_state.cs.shaderResources);
+    RestoreShaderResources<DxbcProgramType::VertexShader>   (m_state.vs.shaderResources, pPrevious);
+    RestoreShaderResources<DxbcProgramType::HullShader>     (m_state.hs.shaderResources, pPrevious);
+    RestoreShaderResources<DxbcProgramType::DomainShader>   (m_state.ds.shaderResources, pPrevious);
+    RestoreShaderResources<DxbcProgramType::GeometryShader> (m_state.gs.shaderResources, pPrevious);
+    RestoreShaderResources<DxbcProgramType::PixelShader>    (m_state.ps.shaderResources, pPrevious);
+    RestoreShaderResources<DxbcProgramType::ComputeShader>  (m_state.cs.shaderResources, pPrevious);
     
-    RestoreUnorderedAccessViews<DxbcProgramType::PixelShader>   (m_state.ps.unorderedAccessViews);
-    RestoreUnorderedAccessViews<DxbcProgramType::ComputeShader> (m_state.cs.unorderedAccessViews);
+    RestoreUnorderedAccessViews<DxbcProgramType::PixelShader>   (m_state.ps.unorderedAccessViews, pPrevious);
+    RestoreUnorderedAccessViews<DxbcProgramType::ComputeShader> (m_state.cs.unorderedAccessViews, pPrevious);
   }
   
   
   template<DxbcProgramType Stage>
   void D3D11DeviceContext::RestoreConstantBuffers(
-          D3D11ConstantBufferBindings&      Bindings) {
+          D3D11ConstantBufferBindings&      Bindings,
+    const D3D11ContextBindings*             pPrevious) {
     uint32_t slotId = computeConstantBufferBinding(Stage, 0);
     
     for (uint32_t i = 0; i < Bindings.size(); i++) {
+      if (pPrevious) {
+        const auto& prev = pPrevious->stages[uint32_t(Stage)].constantBuffers[i];
+
+        if (prev.buffer         == Bindings[i].buffer.ptr()
+         && prev.constantOffset == Bindings[i].constantOffset
+         && prev.constantBound  == Bindings[i].constantBound)
+          continue;
+      }
+
       BindConstantBuffer(slotId + i, Bindings[i].buffer.ptr(),
         Bindings[i].constantOffset, Bindings[i].constantBound);
     }
@@ -4142,31 +4181,48 @@ namespace dxvk {
   
   template<DxbcProgramType Stage>
   void D3D11DeviceContext::RestoreSamplers(
-          D3D11SamplerBindings&             Bindings) {
+          D3D11SamplerBindings&             Bindings,
+    const D3D11ContextBindings*             pPrevious) {
     uint32_t slotId = computeSamplerBinding(Stage, 0);
     
-    for (uint32_t i = 0; i < Bindings.size(); i++)
+    for (uint32_t i = 0; i < Bindings.size(); i++) {
+      if (pPrevious && pPrevious->stages[uint32_t(Stage)].samplers[i] == Bindings[i])
+        continue;
+
       BindSampler(slotId + i, Bindings[i]);
+    }
   }
   
   
   template<DxbcProgramType Stage>
   void D3D11DeviceContext::RestoreShaderResources(
-          D3D11ShaderResourceBindings&      Bindings) {
+          D3D11ShaderResourceBindings&      Bindings,
+    const D3D11ContextBindings*             pPrevious) {
     uint32_t slotId = computeSrvBinding(Stage, 0);
     
-    for (uint32_t i = 0; i < Bindings.views.size(); i++)
+    for (uint32_t i = 0; i < Bindings.views.size(); i++) {
+      if (pPrevious && pPrevious->stages[uint32_t(Stage)].shaderResources[i] == Bindings.views[i].ptr())
+        continue;
+
       BindShaderResource(slotId + i, Bindings.views[i].ptr());
+    }
   }
   
   
   template<DxbcProgramType Stage>
   void D3D11DeviceContext::RestoreUnorderedAccessViews(
-          D3D11UnorderedAccessBindings&     Bindings) {
+          D3D11UnorderedAccessBindings&     Bindings,
+    const D3D11ContextBindings*             pPrevious) {
     uint32_t uavSlotId = computeUavBinding       (Stage, 0);
     uint32_t ctrSlotId = computeUavCounterBinding(Stage, 0);
+
+    const auto* prev = pPrevious ? (Stage == DxbcProgramType::ComputeShader
+      ? &pPrevious->csUavs : &pPrevious->psUavs) : nullptr;
     
     for (uint32_t i = 0; i < Bindings.size(); i++) {
+      if (prev && (*prev)[i] == Bindings[i].ptr())
+        continue;
+
       BindUnorderedAccessView(
         uavSlotId + i,
         Bindings[i].ptr(),
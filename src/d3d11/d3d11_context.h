@@ -804,6 +804,10 @@ namespace dxvk {
             ID3D11Resource*                   pResource,
             UINT                              Subresource);
 
+    void UpdateBuffer(
+      const DxvkBufferSlice&                  DstSlice,
+            DxvkDataSlice&&                   SrcData);
+
     void UpdateImage(
             D3D11CommonTexture*               pDstTexture,
       const VkImageSubresource*               pDstSubresource,
@@ -867,23 +871,28 @@ namespace dxvk {
 
     void ResetState();
 
-    void RestoreState();
+    void RestoreState(
+      const D3D11ContextBindings*             pPrevious = nullptr);
     
     template<DxbcProgramType Stage>
     void RestoreConstantBuffers(
-            D3D11ConstantBufferBindings&      Bindings);
+            D3D11ConstantBufferBindings&      Bindings,
+      const D3D11ContextBindings*             pPrevious);
     
     template<DxbcProgramType Stage>
     void RestoreSamplers(
-            D3D11SamplerBindings&             Bindings);
+            D3D11SamplerBindings&             Bindings,
+      const D3D11ContextBindings*             pPrevious);
     
     template<DxbcProgramType Stage>
     void RestoreShaderResources(
-            D3D11ShaderResourceBindings&      Bindings);
+            D3D11ShaderResourceBindings&      Bindings,
+      const D3D11ContextBindings*             pPrevious);
     
     template<DxbcProgramType Stage>
     void RestoreUnorderedAccessViews(
-            D3D11UnorderedAccessBindings&     Bindings);
+            D3D11UnorderedAccessBindings&     Bindings,
+      const D3D11ContextBindings*             pPrevious);
     
     bool TestRtvUavHazards(
             UINT                              NumRTVs,
@@ -147,11 +147,12 @@ namespace dxvk {
     D3D10DeviceLock lock = LockContext();
 
     FlushCsChunk();
-    
-    static_cast<D3D11CommandList*>(pCommandList)->EmitToCommandList(m_commandList.ptr());
+
+    auto commandList = static_cast<D3D11CommandList*>(pCommandList);
+    commandList->EmitToCommandList(m_commandList.ptr());
     
     if (RestoreContextState)
-      RestoreState();
+      RestoreState(&commandList->GetBindings());
     else
       ClearState();
   }
@@ -164,6 +165,8 @@ namespace dxvk {
 
     FinalizeQueries();
     FlushCsChunk();
+
+    m_commandList->SetBindings(m_state);
     
     if (ppCommandList != nullptr)
       *ppCommandList = m_commandList.ref();
@@ -195,4 +195,36 @@ namespace dxvk {
 
     return true;
   }
+
+
+  void STDMETHODCALLTYPE D3D11DeviceContextExt::AddMapDirtyRegion(
+          ID3D11Resource*         pResource,
+          UINT                    Subresource,
+    const D3D11_BOX*              pBox) {
+    D3D10DeviceLock lock = m_ctx->LockContext();
+
+    // Deferred contexts always upload the entire
+    // subresource, since they do not map in place
+    if (m_ctx->GetType() != D3D11_DEVICE_CONTEXT_IMMEDIATE)
+      return;
+
+    auto texture = GetCommonTexture(pResource);
+
+    if (!texture || texture->GetMapMode() != D3D11_COMMON_TEXTURE_MAP_MODE_BUFFER)
+      return;
+
+    D3D11_MAP mapType = texture->GetMapType(Subresource);
+
+    // Discarded subresources get copied in their entirety,
+    // unless the texture cannot be mapped any other way
+    bool discardMap = mapType == D3D11_MAP_WRITE_DISCARD
+      && texture->Desc()->Usage != D3D11_USAGE_DYNAMIC;
+
+    if (mapType == D3D11_MAP(~0u)
+     || mapType == D3D11_MAP_READ
+     || discardMap)
+      return;
+
+    texture->AddDirtyRegion(Subresource, pBox);
+  }
 }
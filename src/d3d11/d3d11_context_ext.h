@@ -6,7 +6,7 @@ namespace dxvk {
   
   class D3D11DeviceContext;
 
-  class D3D11DeviceContextExt : public ID3D11VkExtContext1 {
+  class D3D11DeviceContextExt : public ID3D11VkExtContext2 {
     
   public:
     
@@ -69,6 +69,11 @@ namespace dxvk {
             void* const*            pWriteResources,
             uint32_t                NumWriteResources);
 
+    void STDMETHODCALLTYPE AddMapDirtyRegion(
+            ID3D11Resource*         pResource,
+            UINT                    Subresource,
+      const D3D11_BOX*              pBox);
+
   private:
     
     D3D11DeviceContext* m_ctx;
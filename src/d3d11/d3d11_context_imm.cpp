@@ -13,7 +13,7 @@ namespace dxvk {
           D3D11Device*    pParent,
     const Rc<DxvkDevice>& Device)
   : D3D11DeviceContext(pParent, Device, DxvkCsChunkFlag::SingleUse),
-    m_csThread(Device->createContext()),
+    m_csThread(Device, Device->createContext()),
     m_videoContext(this, Device) {
     EmitCs([
       cDevice                 = m_device,
@@ -156,6 +156,8 @@ namespace dxvk {
   void STDMETHODCALLTYPE D3D11ImmediateContext::Flush1(
           D3D11_CONTEXT_TYPE          ContextType,
           HANDLE                      hEvent) {
+    DxvkTraceScope trace(m_device->tracer(), "d3d11", "Flush");
+
     m_parent->FlushInitContext();
 
     if (hEvent)
@@ -215,7 +217,7 @@ namespace dxvk {
     commandList->EmitToCsThread(&m_csThread);
     
     if (RestoreContextState)
-      RestoreState();
+      RestoreState(&commandList->GetBindings());
     else
       ClearState();
     
@@ -487,14 +489,63 @@ namespace dxvk {
     if (pResource->GetMapMode() == D3D11_COMMON_TEXTURE_MAP_MODE_BUFFER) {
       // Now that data has been written into the buffer,
       // we need to copy its contents into the image
-      VkImageAspectFlags aspectMask = imageFormatInfo(pResource->GetPackedFormat())->aspectMask;
+      auto formatInfo = imageFormatInfo(pResource->GetPackedFormat());
+
+      VkImageAspectFlags aspectMask = formatInfo->aspectMask;
       VkImageSubresource subresource = pResource->GetSubresourceFromIndex(aspectMask, Subresource);
 
-      UpdateImage(pResource, &subresource, VkOffset3D { 0, 0, 0 },
-        pResource->MipLevelExtent(subresource.mipLevel),
-        DxvkBufferSlice(pResource->GetMappedBuffer(Subresource)));
+      // If the application told us which regions it has written,
+      // only copy those. Planar and packed depth-stencil formats
+      // are rare enough that we can always copy everything. With
+      // DISCARD, the mapped buffer is a new slice with undefined
+      // contents, so unless the texture can only ever be mapped
+      // with DISCARD, copy everything in order to keep the buffer
+      // consistent with the image for subsequent map operations.
+      std::vector<D3D11_BOX> dirtyRegions = pResource->TakeDirtyRegions(Subresource);
+
+      bool discardMap = mapType == D3D11_MAP_WRITE_DISCARD
+        && pResource->Desc()->Usage != D3D11_USAGE_DYNAMIC;
+
+      if (discardMap
+       || formatInfo->flags.test(DxvkFormatFlag::MultiPlane)
+       || aspectMask == (VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT))
+        dirtyRegions.clear();
+
+      if (dirtyRegions.empty()) {
+        UpdateImage(pResource, &subresource, VkOffset3D { 0, 0, 0 },
+          pResource->MipLevelExtent(subresource.mipLevel),
+          DxvkBufferSlice(pResource->GetMappedBuffer(Subresource)));
+      } else {
+        for (const auto& box : dirtyRegions)
+          UpdateMappedImageRegion(pResource, Subresource, box);
+      }
     }
   }
+
+
+  void D3D11ImmediateContext::UpdateMappedImageRegion(
+          D3D11CommonTexture*         pResource,
+          UINT                        Subresource,
+    const D3D11_BOX&                  Box) {
+    VkImageAspectFlags aspectMask = imageFormatInfo(pResource->GetPackedFormat())->aspectMask;
+    VkImageSubresource subresource = pResource->GetSubresourceFromIndex(aspectMask, Subresource);
+
+    VkOffset3D offset = { int32_t(Box.left), int32_t(Box.top), int32_t(Box.front) };
+    VkExtent3D extent = { Box.right - Box.left, Box.bottom - Box.top, Box.back - Box.front };
+
+    EmitCs([
+      cDstImage   = pResource->GetImage(),
+      cDstLayers  = vk::makeSubresourceLayers(subresource),
+      cDstOffset  = offset,
+      cDstExtent  = extent,
+      cSrcBuffer  = pResource->GetMappedBuffer(Subresource),
+      cSrcLayout  = pResource->GetSubresourceLayout(aspectMask, Subresource),
+      cSrcOffset  = pResource->ComputeMappedOffset(Subresource, 0, offset)
+    ] (DxvkContext* ctx) {
+      ctx->copyBufferToImage(cDstImage, cDstLayers, cDstOffset, cDstExtent,
+        cSrcBuffer, cSrcOffset, cSrcLayout.RowPitch, cSrcLayout.DepthPitch);
+    });
+  }
   
   
   void STDMETHODCALLTYPE D3D11ImmediateContext::SwapDeviceContextState(
@@ -563,12 +614,21 @@ namespace dxvk {
         FlushImplicit(FALSE);
         return false;
       } else {
+        auto t0 = dxvk::high_resolution_clock::now();
+
         // Make sure pending commands using the resource get
         // executed on the the GPU if we have to wait for it
         Flush();
         SynchronizeCsThread();
         
         Resource->waitIdle(access);
+
+        auto t1 = dxvk::high_resolution_clock::now();
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+
+        m_device->addStatCtr(DxvkStatCounter::MapWaitCount, 1);
+        m_device->addStatCtr(DxvkStatCounter::MapWaitTicks, us);
+        m_device->addStatSample(DxvkStatHistogramType::MapWaitTime, us);
       }
     }
     
@@ -143,6 +143,11 @@ namespace dxvk {
     void UnmapImage(
             D3D11CommonTexture*         pResource,
             UINT                        Subresource);
+
+    void UpdateMappedImageRegion(
+            D3D11CommonTexture*         pResource,
+            UINT                        Subresource,
+      const D3D11_BOX&                  Box);
     
     void SynchronizeDevice();
     
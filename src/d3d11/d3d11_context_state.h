@@ -183,5 +183,45 @@ namespace dxvk {
     D3D11ContextStateSO so;
     D3D11ContextStatePR pr;
   };
+
+
+  struct D3D11ConstantBufferRef {
+    Com<D3D11Buffer, false> buffer         = nullptr;
+    UINT                    constantOffset = 0;
+    UINT                    constantBound  = 0;
+  };
+
+
+  struct D3D11VertexBufferRef {
+    Com<D3D11Buffer, false> buffer = nullptr;
+    UINT                    offset = 0;
+    UINT                    stride = 0;
+  };
+
+
+  struct D3D11StageBindings {
+    std::array<D3D11ConstantBufferRef, D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT> constantBuffers = { };
+    std::array<Com<D3D11ShaderResourceView, false>, D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT> shaderResources = { };
+    D3D11SamplerBindings                                                                  samplers = { };
+  };
+
+
+  /**
+   * \brief Context resource bindings
+   *
+   * Stores the per-slot resource bindings of a context
+   * at a given point in time. Only private references
+   * are held so that the ref counts that applications
+   * can observe are not affected. Sampler states are
+   * owned by the device and never get destroyed.
+   */
+  struct D3D11ContextBindings {
+    std::array<D3D11StageBindings, 6> stages;
+
+    std::array<Com<D3D11UnorderedAccessView, false>, D3D11_1_UAV_SLOT_COUNT> psUavs = { };
+    std::array<Com<D3D11UnorderedAccessView, false>, D3D11_1_UAV_SLOT_COUNT> csUavs = { };
+
+    std::array<D3D11VertexBufferRef, D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT> vertexBuffers = { };
+  };
   
 }
\ No newline at end of file
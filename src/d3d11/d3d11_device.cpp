@@ -40,7 +40,10 @@ namespace dxvk {
     m_dxvkAdapter   (m_dxvkDevice->adapter()),
     m_d3d11Formats  (m_dxvkAdapter),
     m_d3d11Options  (m_dxvkDevice->instance()->config(), m_dxvkDevice),
-    m_dxbcOptions   (m_dxvkDevice, m_d3d11Options) {
+    m_dxbcOptions   (m_dxvkDevice, m_d3d11Options),
+    m_shaderModules (m_dxvkDevice, m_d3d11Options.asyncShaderCompile
+      && m_dxvkDevice->extensions().extShaderStencilExport
+      && m_dxvkDevice->extensions().extShaderViewportIndexLayer) {
     m_initializer = new D3D11Initializer(this);
     m_context     = new D3D11ImmediateContext(this, m_dxvkDevice);
     m_d3d10Device = new D3D10Device(this, m_context.ptr());
@@ -2021,15 +2024,24 @@ namespace dxvk {
     if (FAILED(hr))
       return hr;
 
-    auto shader = commonShader.GetShader();
+    // The shader may still be compiling at this point, and
+    // the checks below can only fail if it is not, so only
+    // access the shader if any extension is unsupported
+    if (!m_dxvkDevice->extensions().extShaderStencilExport
+     || !m_dxvkDevice->extensions().extShaderViewportIndexLayer) {
+      auto shader = commonShader.GetShader();
 
-    if (shader->flags().test(DxvkShaderFlag::ExportsStencilRef)
-     && !m_dxvkDevice->extensions().extShaderStencilExport)
-      return E_INVALIDARG;
+      if (shader == nullptr)
+        return E_INVALIDARG;
 
-    if (shader->flags().test(DxvkShaderFlag::ExportsViewportIndexLayerFromVertexStage)
-     && !m_dxvkDevice->extensions().extShaderViewportIndexLayer)
-      return E_INVALIDARG;
+      if (shader->flags().test(DxvkShaderFlag::ExportsStencilRef)
+       && !m_dxvkDevice->extensions().extShaderStencilExport)
+        return E_INVALIDARG;
+
+      if (shader->flags().test(DxvkShaderFlag::ExportsViewportIndexLayerFromVertexStage)
+       && !m_dxvkDevice->extensions().extShaderViewportIndexLayer)
+        return E_INVALIDARG;
+    }
 
     *pShaderModule = std::move(commonShader);
     return S_OK;
@@ -163,14 +163,51 @@ ID3D11VkExtContext1 : public ID3D11VkExtContext {
 };
 
 
+/**
+ * \brief Extended extended extended D3D11 context
+ * 
+ * Allows applications to specify which parts of a
+ * mapped texture subresource have been written.
+ */
+MIDL_INTERFACE("e665a3b1-03b5-4878-984c-e022295d1b52")
+ID3D11VkExtContext2 : public ID3D11VkExtContext1 {
+
+  /**
+   * \brief Marks a region of a mapped subresource as written
+   * 
+   * Must be called between \c Map and \c Unmap, and only
+   * affects the current mapping. If at least one region
+   * is specified for a mapped subresource, only the given
+   * regions will be copied to the texture on \c Unmap,
+   * and the contents of the remaining area are preserved.
+   * Dirty regions are ignored if a non-dynamic subresource
+   * was mapped with \c DISCARD, since the contents of the
+   * mapped memory are undefined in that case and the entire
+   * subresource will be copied to the texture. Dynamic
+   * textures can only be mapped with \c DISCARD, so their
+   * dirty regions are always respected.
+   * \param [in] pResource Mapped texture
+   * \param [in] Subresource Mapped subresource index
+   * \param [in] pBox Written region. If \c nullptr,
+   *    the entire subresource is considered written.
+   */
+  virtual void STDMETHODCALLTYPE AddMapDirtyRegion(
+          ID3D11Resource*         pResource,
+          UINT                    Subresource,
+    const D3D11_BOX*              pBox) = 0;
+};
+
+
 #ifdef _MSC_VER
 struct __declspec(uuid("8a6e3c42-f74c-45b7-8265-a231b677ca17")) ID3D11VkExtDevice;
 struct __declspec(uuid("cfcf64ef-9586-46d0-bca4-97cf2ca61b06")) ID3D11VkExtDevice1;
 struct __declspec(uuid("fd0bca13-5cb6-4c3a-987e-4750de2ca791")) ID3D11VkExtContext;
 struct __declspec(uuid("874b09b2-ae0b-41d8-8476-5f3b7a0e879d")) ID3D11VkExtContext1;
+struct __declspec(uuid("e665a3b1-03b5-4878-984c-e022295d1b52")) ID3D11VkExtContext2;
 #else
 __CRT_UUID_DECL(ID3D11VkExtDevice,         0x8a6e3c42,0xf74c,0x45b7,0x82,0x65,0xa2,0x31,0xb6,0x77,0xca,0x17);
 __CRT_UUID_DECL(ID3D11VkExtDevice1,        0xcfcf64ef,0x9586,0x46d0,0xbc,0xa4,0x97,0xcf,0x2c,0xa6,0x1b,0x06);
 __CRT_UUID_DECL(ID3D11VkExtContext,        0xfd0bca13,0x5cb6,0x4c3a,0x98,0x7e,0x47,0x50,0xde,0x2c,0xa7,0x91);
 __CRT_UUID_DECL(ID3D11VkExtContext1,       0x874b09b2,0xae0b,0x41d8,0x84,0x76,0x5f,0x3b,0x7a,0x0e,0x87,0x9d);
+__CRT_UUID_DECL(ID3D11VkExtContext2,       0xe665a3b1,0x03b5,0x4878,0x98,0x4c,0xe0,0x22,0x29,0x5d,0x1b,0x52);
 #endif
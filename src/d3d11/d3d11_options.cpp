@@ -17,6 +17,7 @@ namespace dxvk {
     this->samplerAnisotropy     = config.getOption<int32_t>("d3d11.samplerAnisotropy", -1);
     this->invariantPosition     = config.getOption<bool>("d3d11.invariantPosition", true);
     this->floatControls         = config.getOption<bool>("d3d11.floatControls", true);
+    this->asyncShaderCompile    = config.getOption<bool>("d3d11.asyncShaderCompile", true);
     this->disableMsaa           = config.getOption<bool>("d3d11.disableMsaa", false);
     this->deferSurfaceCreation  = config.getOption<bool>("dxgi.deferSurfaceCreation", false);
     this->numBackBuffers        = config.getOption<int32_t>("dxgi.numBackBuffers", 0);
@@ -73,6 +73,10 @@ namespace dxvk {
     /// Enable float control bits
     bool floatControls;
 
+    /// Translate shaders on worker threads rather
+    /// than in the shader creation functions
+    bool asyncShaderCompile;
+
     /// Back buffer count for the Vulkan swap chain.
     /// Overrides DXGI_SWAP_CHAIN_DESC::BufferCount.
     int32_t numBackBuffers;
@@ -8,43 +8,43 @@ namespace dxvk {
   
   
   D3D11CommonShader::D3D11CommonShader(
-          D3D11Device*    pDevice,
-    const DxvkShaderKey*  pShaderKey,
-    const DxbcModuleInfo* pDxbcModuleInfo,
-    const void*           pShaderBytecode,
-          size_t          BytecodeLength) {
+          D3D11Device*        pDevice,
+          D3D11ShaderCache*   pCache,
+    const DxvkShaderKey*      pShaderKey,
+    const DxbcModuleInfo*     pDxbcModuleInfo,
+    const DxbcAnalysisInfo*   pDxbcAnalysisInfo,
+    const DxbcModule&         Module) {
     const std::string name = pShaderKey->toString();
-    Logger::debug(str::format("Compiling shader ", name));
-    
-    DxbcReader reader(
-      reinterpret_cast<const char*>(pShaderBytecode),
-      BytecodeLength);
-    
-    DxbcModule module(reader);
-    
-    // If requested by the user, dump both the raw DXBC
-    // shader and the compiled SPIR-V module to a file.
-    const std::string dumpPath = env::getEnvVar("DXVK_SHADER_DUMP_PATH");
-    
-    if (dumpPath.size() != 0) {
-      reader.store(std::ofstream(str::tows(str::format(dumpPath, "/", name, ".dxbc").c_str()).c_str(),
-        std::ios_base::binary | std::ios_base::trunc));
-    }
     
     // Decide whether we need to create a pass-through
     // geometry shader for vertex shader stream output
     bool passthroughShader = pDxbcModuleInfo->xfb != nullptr
-      && (module.programInfo().type() == DxbcProgramType::VertexShader
-       || module.programInfo().type() == DxbcProgramType::DomainShader);
+      && (Module.programInfo().type() == DxbcProgramType::VertexShader
+       || Module.programInfo().type() == DxbcProgramType::DomainShader);
+
+    // Try to load the translated shader from the disk
+    // cache first, and add it to the cache otherwise
+    DxvkShaderKey cacheKey = D3D11ShaderCache::ComputeKey(
+      *pShaderKey, *pDxbcModuleInfo);
+
+    m_shader = pCache->LookupShader(cacheKey);
+
+    if (m_shader == nullptr) {
+      Logger::debug(str::format("Compiling shader ", name));
 
-    if (module.programInfo().shaderStage() != pShaderKey->type() && !passthroughShader)
-      throw DxvkError("Mismatching shader type.");
+      m_shader = passthroughShader
+        ? Module.compilePassthroughShader(*pDxbcModuleInfo, name)
+        : Module.compile                 (*pDxbcModuleInfo, *pDxbcAnalysisInfo, name);
+
+      pCache->StoreShader(cacheKey, m_shader);
+    }
 
-    m_shader = passthroughShader
-      ? module.compilePassthroughShader(*pDxbcModuleInfo, name)
-      : module.compile                 (*pDxbcModuleInfo, name);
     m_shader->setShaderKey(*pShaderKey);
     
+    // If requested by the user, dump the compiled
+    // SPIR-V module to a file.
+    const std::string dumpPath = env::getEnvVar("DXVK_SHADER_DUMP_PATH");
+    
     if (dumpPath.size() != 0) {
       std::ofstream dumpStream(
         str::tows(str::format(dumpPath, "/", name, ".spv").c_str()).c_str(),
@@ -76,9 +76,107 @@ namespace dxvk {
     pDevice->GetDXVKDevice()->registerShader(m_shader);
   }
 
+
+  D3D11CommonShader::D3D11CommonShader(
+    const Rc<D3D11ShaderCompileJob>& Job)
+  : m_job(Job) {
+
+  }
+
+
+  D3D11ShaderCompileJob::D3D11ShaderCompileJob(
+          D3D11Device*        pDevice,
+          D3D11ShaderCache*   pCache,
+    const DxvkShaderKey&      ShaderKey,
+    const DxbcModuleInfo&     ModuleInfo,
+    const DxbcAnalysisInfo&   AnalysisInfo,
+    const DxbcModule&         Module)
+  : m_device      (pDevice),
+    m_cache       (pCache),
+    m_shaderKey   (ShaderKey),
+    m_moduleInfo  (ModuleInfo),
+    m_tessInfo    (),
+    m_analysisInfo(AnalysisInfo),
+    m_module      (Module) {
+    // The module info may point to temporary data
+    if (ModuleInfo.tess != nullptr) {
+      m_tessInfo = *ModuleInfo.tess;
+      m_moduleInfo.tess = &m_tessInfo;
+    }
+  }
+
+
+  D3D11ShaderCompileJob::~D3D11ShaderCompileJob() {
+
+  }
+
+
+  void D3D11ShaderCompileJob::Run() {
+    State expected = State::Pending;
+
+    if (!m_state.compare_exchange_strong(expected, State::Running))
+      return;
+
+    D3D11CommonShader shader;
+
+    try {
+      shader = D3D11CommonShader(m_device, m_cache,
+        &m_shaderKey, &m_moduleInfo, &m_analysisInfo, m_module);
+    } catch (const DxvkError& e) {
+      Logger::err(str::format("D3D11: Failed to compile shader ",
+        m_shaderKey.toString(), ", shader will not be bound:\n", e.message()));
+    }
+
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    m_shader = std::move(shader);
+    m_state.store(State::Done, std::memory_order_release);
+    m_cond.notify_all();
+  }
+
+
+  void D3D11ShaderCompileJob::Cancel() {
+    State expected = State::Pending;
+
+    if (m_state.compare_exchange_strong(expected, State::Done))
+      return;
+
+    std::unique_lock<dxvk::mutex> lock(m_mutex);
+
+    m_cond.wait(lock, [this] {
+      return m_state.load() == State::Done;
+    });
+  }
+
+
+  const D3D11CommonShader& D3D11ShaderCompileJob::WaitForShader() {
+    this->Run();
+
+    std::unique_lock<dxvk::mutex> lock(m_mutex);
+
+    m_cond.wait(lock, [this] {
+      return m_state.load() == State::Done;
+    });
+
+    return m_shader;
+  }
+
   
-  D3D11ShaderModuleSet:: D3D11ShaderModuleSet() { }
-  D3D11ShaderModuleSet::~D3D11ShaderModuleSet() { }
+  D3D11ShaderModuleSet::D3D11ShaderModuleSet(
+    const Rc<DxvkDevice>&     Device,
+          bool                AsyncCompile)
+  : m_device      (Device),
+    m_cache       (Device),
+    m_asyncCompile(AsyncCompile) {
+
+  }
+
+
+  D3D11ShaderModuleSet::~D3D11ShaderModuleSet() {
+    // Jobs may still be queued on the device's compiler
+    // threads, so make sure they don't access the cache
+    for (const auto& entry : m_modules)
+      entry.second.CancelJob();
+  }
   
   
   HRESULT D3D11ShaderModuleSet::GetShaderModule(
@@ -101,10 +199,48 @@ namespace dxvk {
     // This shader has not been compiled yet, so we have to create a
     // new module. This takes a while, so we won't lock the structure.
     D3D11CommonShader module;
+    Rc<D3D11ShaderCompileJob> job;
     
     try {
-      module = D3D11CommonShader(pDevice, pShaderKey,
-        pDxbcModuleInfo, pShaderBytecode, BytecodeLength);
+      DxbcReader reader(
+        reinterpret_cast<const char*>(pShaderBytecode),
+        BytecodeLength);
+
+      DxbcModule dxbcModule(reader);
+
+      // If requested by the user, dump the raw DXBC shader
+      // to a file. The SPIR-V code gets dumped once compiled.
+      const std::string dumpPath = env::getEnvVar("DXVK_SHADER_DUMP_PATH");
+
+      if (dumpPath.size() != 0) {
+        reader.store(std::ofstream(str::tows(str::format(dumpPath, "/", pShaderKey->toString(), ".dxbc").c_str()).c_str(),
+          std::ios_base::binary | std::ios_base::trunc));
+      }
+
+      bool passthroughShader = pDxbcModuleInfo->xfb != nullptr
+        && (dxbcModule.programInfo().type() == DxbcProgramType::VertexShader
+         || dxbcModule.programInfo().type() == DxbcProgramType::DomainShader);
+
+      if (dxbcModule.programInfo().shaderStage() != pShaderKey->type() && !passthroughShader)
+        throw DxvkError("Mismatching shader type.");
+
+      // Analyze the shader up front so that invalid shaders
+      // fail here rather than after we returned S_OK. Only
+      // SPIR-V generation is deferred to the worker threads.
+      DxbcAnalysisInfo analysisInfo = !passthroughShader
+        ? dxbcModule.analyze(*pDxbcModuleInfo)
+        : DxbcAnalysisInfo();
+
+      // Stream output declarations reference app-provided
+      // strings, so compile those shaders immediately
+      if (m_asyncCompile && pDxbcModuleInfo->xfb == nullptr) {
+        job = new D3D11ShaderCompileJob(pDevice, &m_cache,
+          *pShaderKey, *pDxbcModuleInfo, analysisInfo, dxbcModule);
+        module = D3D11CommonShader(job);
+      } else {
+        module = D3D11CommonShader(pDevice, &m_cache,
+          pShaderKey, pDxbcModuleInfo, &analysisInfo, dxbcModule);
+      }
     } catch (const DxvkError& e) {
       Logger::err(e.message());
       return E_INVALIDARG;
@@ -121,6 +257,9 @@ namespace dxvk {
         return S_OK;
       }
     }
+
+    if (job != nullptr)
+      m_device->compilerWorkers().enqueue([job] { job->Run(); }, DxvkWorkerPriority::High);
     
     *pShader = std::move(module);
     return S_OK;
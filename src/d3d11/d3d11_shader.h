@@ -5,6 +5,7 @@
 
 #include "../dxbc/dxbc_module.h"
 #include "../dxvk/dxvk_device.h"
+#include "../dxvk/dxvk_worker_pool.h"
 
 #include "../d3d10/d3d10_shader.h"
 
@@ -14,10 +15,12 @@
 
 #include "d3d11_device_child.h"
 #include "d3d11_interfaces.h"
+#include "d3d11_shader_cache.h"
 
 namespace dxvk {
   
   class D3D11Device;
+  class D3D11ShaderCompileJob;
   
   /**
    * \brief Common shader object
@@ -25,6 +28,11 @@ namespace dxvk {
    * Stores the compiled SPIR-V shader and the SHA-1
    * hash of the original DXBC shader, which can be
    * used to identify the shader.
+   *
+   * If the shader is compiled asynchronously, the
+   * shader object will only be available once the
+   * compile job has finished, and any method that
+   * accesses it will wait for the job to complete.
    */
   class D3D11CommonShader {
     
@@ -32,31 +40,157 @@ namespace dxvk {
     
     D3D11CommonShader();
     D3D11CommonShader(
-            D3D11Device*    pDevice,
-      const DxvkShaderKey*  pShaderKey,
-      const DxbcModuleInfo* pDxbcModuleInfo,
-      const void*           pShaderBytecode,
-            size_t          BytecodeLength);
+            D3D11Device*        pDevice,
+            D3D11ShaderCache*   pCache,
+      const DxvkShaderKey*      pShaderKey,
+      const DxbcModuleInfo*     pDxbcModuleInfo,
+      const DxbcAnalysisInfo*   pDxbcAnalysisInfo,
+      const DxbcModule&         Module);
+    D3D11CommonShader(
+      const Rc<D3D11ShaderCompileJob>& Job);
     ~D3D11CommonShader();
 
-    Rc<DxvkShader> GetShader() const {
-      return m_shader;
-    }
+    /**
+     * \brief Retrieves the shader
+     *
+     * Shaders are validated before the shader object
+     * is created, but SPIR-V generation on a worker
+     * thread can still fail. In that case, this returns
+     * \c nullptr, and binding the shader will leave the
+     * corresponding shader stage unbound.
+     * \returns The shader, or \c nullptr
+     */
+    Rc<DxvkShader> GetShader() const;
 
-    Rc<DxvkBuffer> GetIcb() const {
-      return m_buffer;
-    }
+    Rc<DxvkBuffer> GetIcb() const;
     
     std::string GetName() const {
-      return m_shader->debugName();
+      Rc<DxvkShader> shader = GetShader();
+
+      return shader != nullptr
+        ? shader->debugName()
+        : std::string();
     }
+
+    /**
+     * \brief Cancels pending compile job
+     *
+     * If the shader has not been compiled yet, it will
+     * not be compiled at all. Waits for the job if it
+     * is currently running.
+     */
+    void CancelJob() const;
     
   private:
     
     Rc<DxvkShader> m_shader;
     Rc<DxvkBuffer> m_buffer;
+
+    Rc<D3D11ShaderCompileJob> m_job;
     
   };
+
+
+  /**
+   * \brief Shader compile job
+   *
+   * Translates a shader on a worker thread. If the
+   * shader is needed before any worker has picked up
+   * the job, the thread that needs the shader will
+   * translate it instead of waiting for the workers.
+   */
+  class D3D11ShaderCompileJob : public RcObject {
+
+  public:
+
+    D3D11ShaderCompileJob(
+            D3D11Device*        pDevice,
+            D3D11ShaderCache*   pCache,
+      const DxvkShaderKey&      ShaderKey,
+      const DxbcModuleInfo&     ModuleInfo,
+      const DxbcAnalysisInfo&   AnalysisInfo,
+      const DxbcModule&         Module);
+
+    ~D3D11ShaderCompileJob();
+
+    /**
+     * \brief Compiles the shader
+     *
+     * Does nothing if the shader is already
+     * being compiled by another thread.
+     */
+    void Run();
+
+    /**
+     * \brief Cancels the job
+     *
+     * Prevents the job from running if it has not
+     * started yet, or waits for it to finish. The
+     * shader will be \c nullptr if cancelled.
+     */
+    void Cancel();
+
+    /**
+     * \brief Retrieves compiled shader
+     *
+     * Compiles the shader on the calling thread if
+     * necessary, or waits for it to get compiled.
+     * \returns The compiled shader
+     */
+    const D3D11CommonShader& GetShader() {
+      if (likely(m_state.load(std::memory_order_acquire) == State::Done))
+        return m_shader;
+
+      return WaitForShader();
+    }
+
+  private:
+
+    enum class State : uint32_t {
+      Pending,
+      Running,
+      Done,
+    };
+
+    D3D11Device*              m_device;
+    D3D11ShaderCache*         m_cache;
+
+    DxvkShaderKey             m_shaderKey;
+    DxbcModuleInfo            m_moduleInfo;
+    DxbcTessInfo              m_tessInfo;
+    DxbcAnalysisInfo          m_analysisInfo;
+    DxbcModule                m_module;
+
+    std::atomic<State>        m_state = { State::Pending };
+
+    dxvk::mutex               m_mutex;
+    dxvk::condition_variable  m_cond;
+
+    D3D11CommonShader         m_shader;
+
+    const D3D11CommonShader& WaitForShader();
+
+  };
+
+
+  inline Rc<DxvkShader> D3D11CommonShader::GetShader() const {
+    return m_job != nullptr
+      ? m_job->GetShader().m_shader
+      : m_shader;
+  }
+
+
+  inline Rc<DxvkBuffer> D3D11CommonShader::GetIcb() const {
+    return m_job != nullptr
+      ? m_job->GetShader().m_buffer
+      : m_buffer;
+  }
+
+
+  inline void D3D11CommonShader::CancelJob() const {
+    if (m_job != nullptr)
+      m_job->Cancel();
+  }
   
   
   /**
@@ -128,12 +262,19 @@ namespace dxvk {
    * times, so we should cache the resulting shader modules
    * and reuse them rather than creating new ones. This
    * class is thread-safe.
+   *
+   * If enabled, shaders are translated on the device's
+   * compiler threads so that applications that create many
+   * shaders at once can make use of all CPU cores. Translated
+   * shaders are also stored in a persistent cache.
    */
   class D3D11ShaderModuleSet {
     
   public:
     
-    D3D11ShaderModuleSet();
+    D3D11ShaderModuleSet(
+      const Rc<DxvkDevice>&     Device,
+            bool                AsyncCompile);
     ~D3D11ShaderModuleSet();
     
     HRESULT GetShaderModule(
@@ -152,6 +293,11 @@ namespace dxvk {
       DxvkShaderKey,
       D3D11CommonShader,
       DxvkHash, DxvkEq> m_modules;
+
+    Rc<DxvkDevice>    m_device;
+    D3D11ShaderCache  m_cache;
+
+    bool              m_asyncCompile = false;
     
   };
   
@@ -0,0 +1,74 @@
+#include "d3d11_shader_cache.h"
+
+namespace dxvk {
+
+  D3D11ShaderCache::D3D11ShaderCache(
+    const Rc<DxvkDevice>&         Device)
+  : m_cache(Device, ".dxvk-shadercache") {
+
+  }
+
+
+  D3D11ShaderCache::~D3D11ShaderCache() {
+
+  }
+
+
+  DxvkShaderKey D3D11ShaderCache::ComputeKey(
+    const DxvkShaderKey&          ShaderKey,
+    const DxbcModuleInfo&         ModuleInfo) {
+    const DxbcOptions& options = ModuleInfo.options;
+
+    // Don't hash the options struct directly since it
+    // contains padding, and tess info is a pointer
+    std::array<uint32_t, 19> data = {{
+      CacheVersion,
+      uint32_t(options.useDepthClipWorkaround),
+      uint32_t(options.useStorageImageReadWithoutFormat),
+      uint32_t(options.useSubgroupOpsForAtomicCounters),
+      uint32_t(options.useDemoteToHelperInvocation),
+      uint32_t(options.useSubgroupOpsForEarlyDiscard),
+      uint32_t(options.useSdivForBufferIndex),
+      uint32_t(options.enableRtOutputNanFixup),
+      uint32_t(options.dynamicIndexedConstantBufferAsSsbo),
+      uint32_t(options.zeroInitWorkgroupMemory),
+      uint32_t(options.invariantPosition),
+      uint32_t(options.forceTgsmBarriers),
+      uint32_t(options.disableMsaa),
+      uint32_t(options.floatControl.raw()),
+      uint32_t(options.minSsboAlignment),
+      uint32_t(options.minSsboAlignment >> 32),
+      uint32_t(ModuleInfo.tess != nullptr),
+      uint32_t(ModuleInfo.xfb  != nullptr),
+      0u }};
+
+    // The tess factor clamp is baked into hull shaders
+    if (ModuleInfo.tess != nullptr)
+      std::memcpy(&data.back(), &ModuleInfo.tess->maxTessFactor, sizeof(float));
+
+    // Xfb info is already part of the shader key
+    Sha1Hash sha1 = ShaderKey.sha1();
+
+    std::array<Sha1Data, 2> chunks = {{
+      { &sha1,       sizeof(sha1) },
+      { data.data(), sizeof(data) },
+    }};
+
+    return DxvkShaderKey(VkShaderStageFlagBits(ShaderKey.type()),
+      Sha1Hash::compute(chunks.size(), chunks.data()));
+  }
+
+
+  Rc<DxvkShader> D3D11ShaderCache::LookupShader(
+    const DxvkShaderKey&          Key) {
+    return m_cache.lookupShader(Key);
+  }
+
+
+  void D3D11ShaderCache::StoreShader(
+    const DxvkShaderKey&          Key,
+    const Rc<DxvkShader>&         Shader) {
+    m_cache.storeShader(Key, Shader);
+  }
+
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "../dxbc/dxbc_modinfo.h"
+#include "../dxvk/dxvk_device.h"
+#include "../dxvk/dxvk_shader_cache.h"
+
+namespace dxvk {
+
+  /**
+   * \brief Translated shader cache
+   *
+   * Stores translated DXBC shaders on disk, so that
+   * shaders do not have to be translated again on
+   * subsequent runs. See \ref DxvkShaderCache.
+   */
+  class D3D11ShaderCache {
+    /// Bump this when changing dxbc_compiler.cpp
+    constexpr static uint32_t CacheVersion = 1;
+  public:
+
+    D3D11ShaderCache(
+      const Rc<DxvkDevice>&         Device);
+
+    ~D3D11ShaderCache();
+
+    /**
+     * \brief Checks whether the cache is enabled
+     * \returns \c true if shaders are cached
+     */
+    bool IsEnabled() const {
+      return m_cache.isEnabled();
+    }
+
+    /**
+     * \brief Computes cache key
+     *
+     * Takes all compiler options into account
+     * that may affect the generated code.
+     * \param [in] ShaderKey Unique shader key
+     * \param [in] ModuleInfo Module info
+     * \returns Key for cache lookups
+     */
+    static DxvkShaderKey ComputeKey(
+      const DxvkShaderKey&          ShaderKey,
+      const DxbcModuleInfo&         ModuleInfo);
+
+    /**
+     * \brief Looks up a shader
+     *
+     * \param [in] Key Cache key
+     * \returns The shader, or \c nullptr
+     *    if the shader is not cached
+     */
+    Rc<DxvkShader> LookupShader(
+      const DxvkShaderKey&          Key);
+
+    /**
+     * \brief Adds a shader to the cache
+     *
+     * Does nothing if the shader is already cached.
+     * \param [in] Key Cache key
+     * \param [in] Shader The shader
+     */
+    void StoreShader(
+      const DxvkShaderKey&          Key,
+      const Rc<DxvkShader>&         Shader);
+
+  private:
+
+    DxvkShaderCache               m_cache;
+
+  };
+
+}
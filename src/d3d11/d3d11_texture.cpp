@@ -244,6 +244,60 @@ namespace dxvk {
   }
 
 
+  void D3D11CommonTexture::AddDirtyRegion(
+          UINT                  Subresource,
+    const D3D11_BOX*            pBox) {
+    if (Subresource >= m_buffers.size())
+      return;
+
+    auto& regions = m_buffers[Subresource].dirtyRegions;
+
+    VkExtent3D mipExtent = MipLevelExtent(Subresource % m_desc.MipLevels);
+    VkExtent3D blockSize = imageFormatInfo(m_packedFormat)->blockSize;
+
+    D3D11_BOX box = { 0, 0, 0, mipExtent.width, mipExtent.height, mipExtent.depth };
+
+    if (pBox) {
+      if (pBox->left >= pBox->right
+       || pBox->top >= pBox->bottom
+       || pBox->front >= pBox->back)
+        return;
+
+      // Partial blocks cannot be copied, and the last
+      // block of a mip may extend past the mip extent
+      box.left   = alignDown(pBox->left, blockSize.width);
+      box.top    = alignDown(pBox->top,  blockSize.height);
+      box.front  = pBox->front;
+      box.right  = std::min(align(pBox->right,  blockSize.width),  mipExtent.width);
+      box.bottom = std::min(align(pBox->bottom, blockSize.height), mipExtent.height);
+      box.back   = std::min(pBox->back, mipExtent.depth);
+
+      if (box.left >= box.right
+       || box.top >= box.bottom
+       || box.front >= box.back)
+        return;
+    }
+
+    if (regions.size() < MaxDirtyRegions) {
+      regions.push_back(box);
+      return;
+    }
+
+    // Merge all regions into their bounding box
+    for (const auto& region : regions) {
+      box.left   = std::min(box.left,   region.left);
+      box.top    = std::min(box.top,    region.top);
+      box.front  = std::min(box.front,  region.front);
+      box.right  = std::max(box.right,  region.right);
+      box.bottom = std::max(box.bottom, region.bottom);
+      box.back   = std::max(box.back,   region.back);
+    }
+
+    regions.clear();
+    regions.push_back(box);
+  }
+
+
   VkImageSubresource D3D11CommonTexture::GetSubresourceFromIndex(
           VkImageAspectFlags    Aspect,
           UINT                  Subresource) const {
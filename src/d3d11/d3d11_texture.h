@@ -211,6 +211,34 @@ namespace dxvk {
         : DxvkBufferSliceHandle();
     }
 
+    /**
+     * \brief Adds a dirty region to a mapped subresource
+     *
+     * The region is aligned to the format's block size. If
+     * too many regions get added, they are merged into one.
+     * \param [in] Subresource Subresource index
+     * \param [in] pBox Dirty region, or \c nullptr to
+     *    mark the entire subresource as dirty
+     */
+    void AddDirtyRegion(
+            UINT                  Subresource,
+      const D3D11_BOX*            pBox);
+
+    /**
+     * \brief Retrieves and resets dirty regions
+     *
+     * \param [in] Subresource Subresource index
+     * \returns Dirty regions of the subresource. If this
+     *    is empty, no regions have been specified and the
+     *    entire subresource must be considered dirty.
+     */
+    std::vector<D3D11_BOX> TakeDirtyRegions(
+            UINT                  Subresource) {
+      return Subresource < m_buffers.size()
+        ? std::exchange(m_buffers[Subresource].dirtyRegions, {})
+        : std::vector<D3D11_BOX>();
+    }
+
     /**
      * \brief Returns underlying packed Vulkan format
      *
@@ -305,9 +333,13 @@ namespace dxvk {
     
   private:
     
+    /// Dirty regions per subresource before they get merged
+    constexpr static size_t MaxDirtyRegions = 8;
+
     struct MappedBuffer {
-      Rc<DxvkBuffer>        buffer;
-      DxvkBufferSliceHandle slice;
+      Rc<DxvkBuffer>          buffer;
+      DxvkBufferSliceHandle   slice;
+      std::vector<D3D11_BOX>  dirtyRegions;
     };
 
     D3D11Device* const            m_device;
@@ -44,11 +44,10 @@ namespace dxvk {
     , m_behaviorFlags  ( BehaviorFlags )
     , m_adapter        ( pAdapter )
     , m_dxvkDevice     ( dxvkDevice )
-    , m_shaderModules  ( new D3D9ShaderModuleSet )
     , m_d3d9Options    ( dxvkDevice, pParent->GetInstance()->config() )
     , m_multithread    ( BehaviorFlags & D3DCREATE_MULTITHREADED )
     , m_isSWVP         ( (BehaviorFlags & D3DCREATE_SOFTWARE_VERTEXPROCESSING) ? true : false )
-    , m_csThread       ( dxvkDevice->createContext() )
+    , m_csThread       ( dxvkDevice, dxvkDevice->createContext() )
     , m_csChunk        ( AllocCsChunk() ) {
     // If we can SWVP, then we use an extended constant set
     // as SWVP has many more slots available than HWVP.
@@ -60,6 +59,8 @@ namespace dxvk {
 
     m_initializer      = new D3D9Initializer(m_dxvkDevice);
     m_converter        = new D3D9FormatHelper(m_dxvkDevice);
+    m_shaderModules    = new D3D9ShaderModuleSet(m_dxvkDevice, m_d3d9Options.asyncShaderCompile);
+    m_ffModules        = new D3D9FFShaderModuleSet(this);
 
     EmitCs([
       cDevice = m_dxvkDevice
@@ -2589,20 +2590,9 @@ namespace dxvk {
     if (unlikely(pDestBuffer == nullptr || pVertexDecl == nullptr))
       return D3DERR_INVALIDCALL;
 
-    if (!SupportsSWVP()) {
-      static bool s_errorShown = false;
-
-      if (!std::exchange(s_errorShown, true))
-        Logger::err("D3D9DeviceEx::ProcessVertices: SWVP emu unsupported (vertexPipelineStoresAndAtomics)");
-
-      return D3D_OK;
-    }
-
     D3D9CommonBuffer* dst  = static_cast<D3D9VertexBuffer*>(pDestBuffer)->GetCommonBuffer();
     D3D9VertexDecl*   decl = static_cast<D3D9VertexDecl*>  (pVertexDecl);
 
-    PrepareDraw(D3DPT_FORCE_DWORD);
-
     if (decl == nullptr) {
       DWORD FVF = dst->Desc()->FVF;
 
@@ -2618,6 +2608,33 @@ namespace dxvk {
 
     uint32_t offset = DestIndex * decl->GetSize();
 
+    if (CanProcessVerticesOnCpu()) {
+      // Applications commonly read back the results, which
+      // requires waiting for the GPU if we use the GPU path.
+      // Process small batches on the CPU if the destination
+      // buffer can be written to without stalling.
+      D3D9Range range(offset, offset + VertexCount * decl->GetSize());
+
+      bool preferCpu = VertexCount <= MaxCpuProcessVertices
+        && dst->GetMapMode() == D3D9_COMMON_BUFFER_MAP_MODE_BUFFER
+        && !dst->WasWrittenByGPU()
+        && (dst->DoesStagingBufferUploads() || !dst->GPUReadingRange().Overlaps(range));
+
+      if (preferCpu || !SupportsSWVP())
+        return ProcessVerticesCpu(SrcStartIndex, DestIndex, VertexCount, dst, decl, Flags);
+    }
+
+    if (!SupportsSWVP()) {
+      static bool s_errorShown = false;
+
+      if (!std::exchange(s_errorShown, true))
+        Logger::err("D3D9DeviceEx::ProcessVertices: SWVP emu unsupported (vertexPipelineStoresAndAtomics)");
+
+      return D3D_OK;
+    }
+
+    PrepareDraw(D3DPT_FORCE_DWORD);
+
     auto slice = dst->GetBufferSlice<D3D9_COMMON_BUFFER_TYPE_REAL>();
          slice = slice.subSlice(offset, slice.length() - offset);
 
@@ -2683,6 +2700,109 @@ namespace dxvk {
   }
 
 
+  bool D3D9DeviceEx::CanProcessVerticesOnCpu() {
+    if (m_state.vertexShader != nullptr || m_state.vertexDecl == nullptr)
+      return false;
+
+    // Pre-transformed vertices are passed through as-is
+    if (m_state.vertexDecl->TestFlag(D3D9VertexDeclFlag::HasPositionT))
+      return true;
+
+    // Lighting, vertex blending and texture coordinate
+    // generation are only implemented in the FF shader
+    if (m_state.renderStates[D3DRS_LIGHTING]
+     || m_state.renderStates[D3DRS_VERTEXBLEND] != D3DVBF_DISABLE)
+      return false;
+
+    for (uint32_t i = 0; i < caps::TextureStageCount; i++) {
+      const auto& stage = m_state.textureStages[i];
+
+      if ((stage[DXVK_TSS_TEXCOORDINDEX] & TCIMask)
+       || (stage[DXVK_TSS_TEXTURETRANSFORMFLAGS] & ~D3DTTFF_PROJECTED) != D3DTTFF_DISABLE)
+        return false;
+    }
+
+    return true;
+  }
+
+
+  HRESULT D3D9DeviceEx::ProcessVerticesCpu(
+          UINT                    SrcStartIndex,
+          UINT                    DestIndex,
+          UINT                    VertexCount,
+          D3D9CommonBuffer*       pDstBuffer,
+          D3D9VertexDecl*         pDstDecl,
+          DWORD                   Flags) {
+    uint32_t dstStride = pDstDecl->GetSize();
+    uint32_t dstOffset = DestIndex * dstStride;
+    uint32_t dstSize   = pDstBuffer->Desc()->Size;
+
+    if (unlikely(!dstStride || dstOffset >= dstSize))
+      return D3D_OK;
+
+    VertexCount = std::min(VertexCount, (dstSize - dstOffset) / dstStride);
+
+    D3D9SWVPCpuState state;
+    state.WorldViewProj = m_state.transforms[GetTransformIndex(D3DTS_PROJECTION)]
+                        * m_state.transforms[GetTransformIndex(D3DTS_VIEW)]
+                        * m_state.transforms[GetTransformIndex(D3DTS_WORLD)];
+    state.Viewport      = m_state.viewport;
+
+    for (uint32_t i = 0; i < caps::TextureStageCount; i++)
+      state.TexcoordIndices[i] = m_state.textureStages[i][DXVK_TSS_TEXCOORDINDEX];
+
+    // Lock all source streams for reading. This
+    // only waits if the GPU wrote to the buffer.
+    std::array<D3D9CommonBuffer*, caps::MaxStreams> srcBuffers = { };
+
+    for (const auto& element : m_state.vertexDecl->GetElements()) {
+      uint32_t idx = element.Stream;
+
+      if (idx >= caps::MaxStreams || srcBuffers[idx] != nullptr)
+        continue;
+
+      const auto& vbo = m_state.vertexBuffers[idx];
+
+      if (vbo.vertexBuffer == nullptr)
+        continue;
+
+      D3D9CommonBuffer* buffer = vbo.vertexBuffer->GetCommonBuffer();
+      void* data = nullptr;
+
+      if (FAILED(LockBuffer(buffer, 0, 0, &data, D3DLOCK_READONLY)))
+        continue;
+
+      uint32_t size = buffer->Desc()->Size;
+
+      auto& stream = state.Streams[idx];
+      stream.pData  = reinterpret_cast<const uint8_t*>(data) + vbo.offset;
+      stream.Size   = vbo.offset < size ? size - vbo.offset : 0;
+      stream.Stride = vbo.stride;
+
+      srcBuffers[idx] = buffer;
+    }
+
+    void* dstData = nullptr;
+    HRESULT hr = LockBuffer(pDstBuffer, dstOffset, VertexCount * dstStride, &dstData, 0);
+
+    if (SUCCEEDED(hr)) {
+      m_swvpCpu.ProcessVertices(state,
+        m_state.vertexDecl.ptr(), pDstDecl,
+        SrcStartIndex, VertexCount,
+        reinterpret_cast<uint8_t*>(dstData), Flags);
+
+      UnlockBuffer(pDstBuffer);
+    }
+
+    for (D3D9CommonBuffer* buffer : srcBuffers) {
+      if (buffer != nullptr)
+        UnlockBuffer(buffer);
+    }
+
+    return hr;
+  }
+
+
   HRESULT STDMETHODCALLTYPE D3D9DeviceEx::CreateVertexDeclaration(
     const D3DVERTEXELEMENT9*            pVertexElements,
           IDirect3DVertexDeclaration9** ppDecl) {
@@ -4050,12 +4170,21 @@ namespace dxvk {
         return false;
       }
       else {
+        auto t0 = dxvk::high_resolution_clock::now();
+
         // Make sure pending commands using the resource get
         // executed on the the GPU if we have to wait for it
         Flush();
         SynchronizeCsThread();
 
         Resource->waitIdle(access);
+
+        auto t1 = dxvk::high_resolution_clock::now();
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+
+        m_dxvkDevice->addStatCtr(DxvkStatCounter::MapWaitCount, 1);
+        m_dxvkDevice->addStatCtr(DxvkStatCounter::MapWaitTicks, us);
+        m_dxvkDevice->addStatSample(DxvkStatHistogramType::MapWaitTime, us);
       }
     }
 
@@ -5165,6 +5294,8 @@ namespace dxvk {
   void D3D9DeviceEx::Flush() {
     D3D9DeviceLock lock = LockDevice();
 
+    DxvkTraceScope trace(m_dxvkDevice->tracer(), "d3d9", "Flush");
+
     m_initializer->Flush();
     m_converter->Flush();
 
@@ -6580,7 +6711,7 @@ namespace dxvk {
       EmitCs([
         this,
         cKey     = key,
-       &cShaders = m_ffModules
+       &cShaders = *m_ffModules
       ](DxvkContext* ctx) {
         auto shader = cShaders.GetShaderModule(this, cKey);
         ctx->bindShader(VK_SHADER_STAGE_VERTEX_BIT, shader.GetShader());
@@ -6768,11 +6899,21 @@ namespace dxvk {
       EmitCs([
         this,
         cKey     = key,
-       &cShaders = m_ffModules
+       &cShaders = *m_ffModules
       ](DxvkContext* ctx) {
         auto shader = cShaders.GetShaderModule(this, cKey);
         ctx->bindShader(VK_SHADER_STAGE_FRAGMENT_BIT, shader.GetShader());
       });
+
+      // The uber shader reads texture stage state from the constant buffer
+      if (m_d3d9Options.ffUberShaders && m_lastPixelShaderKeyFF != key)
+        m_flags.set(D3D9DeviceFlag::DirtyFFPixelData);
+
+      // Keep binding the shader until the specialized one is ready
+      if (m_ffModules->UsesUberShader(key))
+        m_flags.set(D3D9DeviceFlag::DirtyFFPixelShader);
+
+      m_lastPixelShaderKeyFF = key;
     }
 
     // Constants
@@ -6793,6 +6934,7 @@ namespace dxvk {
 
       D3D9FixedFunctionPS* data = reinterpret_cast<D3D9FixedFunctionPS*>(slice.mapPtr);
       DecodeD3DCOLOR((D3DCOLOR)rs[D3DRS_TEXTUREFACTOR], data->textureFactor.data);
+      PackFixedFunctionStages(m_lastPixelShaderKeyFF, data);
     }
   }
 
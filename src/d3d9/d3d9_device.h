@@ -21,6 +21,7 @@
 
 #include "d3d9_sampler.h"
 #include "d3d9_fixed_function.h"
+#include "d3d9_swvp_cpu.h"
 #include "d3d9_swvp_emu.h"
 
 #include "d3d9_shader_permutations.h"
@@ -97,6 +98,8 @@ namespace dxvk {
 
     constexpr static uint32_t NullStreamIdx = caps::MaxStreams;
 
+    constexpr static uint32_t MaxCpuProcessVertices = 256;
+
     friend class D3D9SwapChainEx;
   public:
 
@@ -1100,6 +1103,16 @@ namespace dxvk {
 
     void UpdateFixedFunctionPS();
 
+    bool CanProcessVerticesOnCpu();
+
+    HRESULT ProcessVerticesCpu(
+            UINT                    SrcStartIndex,
+            UINT                    DestIndex,
+            UINT                    VertexCount,
+            D3D9CommonBuffer*       pDstBuffer,
+            D3D9VertexDecl*         pDstDecl,
+            DWORD                   Flags);
+
     void ApplyPrimitiveType(
       DxvkContext*      pContext,
       D3DPRIMITIVETYPE  PrimType);
@@ -1134,8 +1147,9 @@ namespace dxvk {
     D3D9Initializer*                m_initializer = nullptr;
     D3D9FormatHelper*               m_converter   = nullptr;
 
-    D3D9FFShaderModuleSet           m_ffModules;
+    Rc<D3D9FFShaderModuleSet>       m_ffModules;
     D3D9SWVPEmulator                m_swvpEmulator;
+    D3D9SWVPCpuProcessor            m_swvpCpu;
 
     Com<D3D9StateBlock, false>      m_recorder;
 
@@ -1211,6 +1225,8 @@ namespace dxvk {
     uint32_t                        m_lastHazardsDS = 0;
     uint32_t                        m_lastSamplerTypesFF = 0;
 
+    D3D9FFShaderKeyFS               m_lastPixelShaderKeyFF;
+
     D3D9ShaderMasks                 m_vsShaderMasks = D3D9ShaderMasks();
     D3D9ShaderMasks                 m_psShaderMasks = FixedFunctionMask;
 
@@ -517,6 +517,7 @@ namespace dxvk {
 
   enum D3D9FFPSMembers {
     TextureFactor = 0,
+    Stages,
 
     MemberCount
   };
@@ -548,6 +549,13 @@ namespace dxvk {
     } out;
   };
 
+  struct D3D9FFTextureOpContext {
+    uint32_t current;
+    uint32_t diffuse;
+
+    std::function<uint32_t ()> getTexture;
+  };
+
   class D3D9FFShaderCompiler {
 
   public:
@@ -564,6 +572,12 @@ namespace dxvk {
       const std::string&             Name,
             D3D9FixedFunctionOptions Options);
 
+    // Creates the uber pixel shader
+    D3D9FFShaderCompiler(
+            Rc<DxvkDevice>           Device,
+      const std::string&             Name,
+            D3D9FixedFunctionOptions Options);
+
     Rc<DxvkShader> compile();
 
     DxsoIsgn isgn() { return m_isgn; }
@@ -588,6 +602,22 @@ namespace dxvk {
 
     void compilePS();
 
+    void compileUberPS();
+
+    uint32_t emitTextureOp(
+            D3DTEXTUREOP                            op,
+            uint32_t                                dst,
+            std::array<uint32_t, TextureArgCount>   arg,
+      const D3D9FFTextureOpContext&                 ctx);
+
+    uint32_t emitScalarReplicate(uint32_t reg);
+
+    uint32_t emitAlphaReplicate(uint32_t reg);
+
+    uint32_t emitComplement(uint32_t reg);
+
+    uint32_t emitSaturate(uint32_t reg);
+
     void setupPS();
 
     void emitPsSharedConstants();
@@ -610,6 +640,7 @@ namespace dxvk {
     DxsoProgramType       m_programType;
     D3D9FFShaderKeyVS     m_vsKey;
     D3D9FFShaderKeyFS     m_fsKey;
+    bool                  m_uberShader = false;
 
     D3D9FFVertexData      m_vs = { };
     D3D9FFPixelData       m_ps = { };
@@ -657,6 +688,19 @@ namespace dxvk {
   }
 
 
+  D3D9FFShaderCompiler::D3D9FFShaderCompiler(
+          Rc<DxvkDevice>           Device,
+    const std::string&             Name,
+          D3D9FixedFunctionOptions Options)
+  : m_module(spvVersion(1, 3)), m_options(Options) {
+    // The default key uses 2D textures for all
+    // stages, which is what the uber shader needs
+    m_programType = DxsoProgramTypes::PixelShader;
+    m_uberShader  = true;
+    m_filename    = Name;
+  }
+
+
   Rc<DxvkShader> D3D9FFShaderCompiler::compile() {
     m_floatType  = m_module.defFloatType(32);
     m_uint32Type = m_module.defIntType(32, 0);
@@ -693,6 +737,8 @@ namespace dxvk {
 
     if (isVS())
       compileVS();
+    else if (m_uberShader)
+      compileUberPS();
     else
       compilePS();
 
@@ -1670,30 +1716,6 @@ namespace dxvk {
         return texture;
       };
 
-      auto ScalarReplicate = [&](uint32_t reg) {
-        std::array<uint32_t, 4> replicant = { reg, reg, reg, reg };
-        return m_module.opCompositeConstruct(m_vec4Type, replicant.size(), replicant.data());
-      };
-
-      auto AlphaReplicate = [&](uint32_t reg) {
-        uint32_t alphaComponentId = 3;
-        uint32_t alpha = m_module.opCompositeExtract(m_floatType, reg, 1, &alphaComponentId);
-
-        return ScalarReplicate(alpha);
-      };
-
-      auto Complement = [&](uint32_t reg) {
-        return m_module.opFSub(m_vec4Type,
-          m_module.constvec4f32(1.0f, 1.0f, 1.0f, 1.0f),
-          reg);
-      };
-
-      auto Saturate = [&](uint32_t reg) {
-        return m_module.opFClamp(m_vec4Type, reg,
-          m_module.constvec4f32(0.0f, 0.0f, 0.0f, 0.0f),
-          m_module.constvec4f32(1.0f, 1.0f, 1.0f, 1.0f));
-      };
-
       auto GetArg = [&] (uint32_t arg) {
         uint32_t reg = m_module.constvec4f32(1.0f, 1.0f, 1.0f, 1.0f);
 
@@ -1730,163 +1752,22 @@ namespace dxvk {
 
         // reg = 1 - reg
         if (arg & D3DTA_COMPLEMENT)
-          reg = Complement(reg);
+          reg = emitComplement(reg);
 
         // reg = reg.wwww
         if (arg & D3DTA_ALPHAREPLICATE)
-          reg = AlphaReplicate(reg);
+          reg = emitAlphaReplicate(reg);
 
         return reg;
       };
 
       auto DoOp = [&](D3DTEXTUREOP op, uint32_t dst, std::array<uint32_t, TextureArgCount> arg) {
-        switch (op) {
-          case D3DTOP_SELECTARG1:
-            dst = arg[1];
-            break;
-
-          case D3DTOP_SELECTARG2:
-            dst = arg[2];
-            break;
-
-          case D3DTOP_MODULATE4X:
-            dst = m_module.opFMul(m_vec4Type, arg[1], arg[2]);
-            dst = m_module.opVectorTimesScalar(m_vec4Type, dst, m_module.constf32(4.0f));
-            dst = Saturate(dst);
-            break;
-
-          case D3DTOP_MODULATE2X:
-            dst = m_module.opFMul(m_vec4Type, arg[1], arg[2]);
-            dst = m_module.opVectorTimesScalar(m_vec4Type, dst, m_module.constf32(2.0f));
-            dst = Saturate(dst);
-            break;
-
-          case D3DTOP_MODULATE:
-            dst = m_module.opFMul(m_vec4Type, arg[1], arg[2]);
-            break;
-
-          case D3DTOP_ADDSIGNED2X:
-            arg[2] = m_module.opFSub(m_vec4Type, arg[2],
-              m_module.constvec4f32(0.5f, 0.5f, 0.5f, 0.5f));
-
-            dst = m_module.opFAdd(m_vec4Type, arg[1], arg[2]);
-            dst = m_module.opVectorTimesScalar(m_vec4Type, dst, m_module.constf32(2.0f));
-            dst = Saturate(dst);
-            break;
-
-          case D3DTOP_ADDSIGNED:
-            arg[2] = m_module.opFSub(m_vec4Type, arg[2],
-              m_module.constvec4f32(0.5f, 0.5f, 0.5f, 0.5f));
-
-            dst = m_module.opFAdd(m_vec4Type, arg[1], arg[2]);
-            dst = Saturate(dst);
-            break;
-
-          case D3DTOP_ADD:
-            dst = m_module.opFAdd(m_vec4Type, arg[1], arg[2]);
-            dst = Saturate(dst);
-            break;
-
-          case D3DTOP_SUBTRACT:
-            dst = m_module.opFSub(m_vec4Type, arg[1], arg[2]);
-            dst = Saturate(dst);
-            break;
-
-          case D3DTOP_ADDSMOOTH:
-            dst = m_module.opFFma(m_vec4Type, Complement(arg[1]), arg[2], arg[1]);
-            dst = Saturate(dst);
-            break;
-
-          case D3DTOP_BLENDDIFFUSEALPHA:
-            dst = m_module.opFMix(m_vec4Type, arg[2], arg[1], AlphaReplicate(diffuse));
-            break;
-
-          case D3DTOP_BLENDTEXTUREALPHA:
-            dst = m_module.opFMix(m_vec4Type, arg[2], arg[1], AlphaReplicate(GetTexture()));
-            break;
-
-          case D3DTOP_BLENDFACTORALPHA:
-            dst = m_module.opFMix(m_vec4Type, arg[2], arg[1], AlphaReplicate(m_ps.constants.textureFactor));
-            break;
-
-          case D3DTOP_BLENDTEXTUREALPHAPM:
-            dst = m_module.opFFma(m_vec4Type, arg[2], Complement(AlphaReplicate(GetTexture())), arg[1]);
-            dst = Saturate(dst);
-            break;
-
-          case D3DTOP_BLENDCURRENTALPHA:
-            dst = m_module.opFMix(m_vec4Type, arg[2], arg[1], AlphaReplicate(current));
-            break;
-
-          case D3DTOP_PREMODULATE:
-            Logger::warn("D3DTOP_PREMODULATE: not implemented");
-            break;
-
-          case D3DTOP_MODULATEALPHA_ADDCOLOR:
-            dst = m_module.opFFma(m_vec4Type, AlphaReplicate(arg[1]), arg[2], arg[1]);
-            dst = Saturate(dst);
-            break;
-
-          case D3DTOP_MODULATECOLOR_ADDALPHA:
-            dst = m_module.opFFma(m_vec4Type, arg[1], arg[2], AlphaReplicate(arg[1]));
-            dst = Saturate(dst);
-            break;
-
-          case D3DTOP_MODULATEINVALPHA_ADDCOLOR:
-            dst = m_module.opFFma(m_vec4Type, Complement(AlphaReplicate(arg[1])), arg[2], arg[1]);
-            dst = Saturate(dst);
-            break;
-
-          case D3DTOP_MODULATEINVCOLOR_ADDALPHA:
-            dst = m_module.opFFma(m_vec4Type, Complement(arg[1]), arg[2], AlphaReplicate(arg[1]));
-            dst = Saturate(dst);
-            break;
-
-          case D3DTOP_BUMPENVMAPLUMINANCE:
-          case D3DTOP_BUMPENVMAP:
-            // Load texture for the next stage...
-            texture = GetTexture();
-            break;
-
-          case D3DTOP_DOTPRODUCT3: {
-            // Get vec3 of arg1 & 2
-            uint32_t vec3Type = m_module.defVectorType(m_floatType, 3);
-            std::array<uint32_t, 3> indices = { 0, 1, 2 };
-            arg[1] = m_module.opVectorShuffle(vec3Type, arg[1], arg[1], indices.size(), indices.data());
-            arg[2] = m_module.opVectorShuffle(vec3Type, arg[2], arg[2], indices.size(), indices.data());
-
-            // Bias according to spec.
-            arg[1] = m_module.opFSub(vec3Type, arg[1], m_module.constvec3f32(0.5f, 0.5f, 0.5f));
-            arg[2] = m_module.opFSub(vec3Type, arg[2], m_module.constvec3f32(0.5f, 0.5f, 0.5f));
-
-            // Do the dotting!
-            dst = m_module.opDot(m_floatType, arg[1], arg[2]);
-
-            // Multiply by 4 and replicate -> vec4
-            dst = m_module.opFMul(m_floatType, dst, m_module.constf32(4.0f));
-            dst = ScalarReplicate(dst);
-
-            // Saturate
-            dst = Saturate(dst);
-
-            break;
-          }
-
-          case D3DTOP_MULTIPLYADD:
-            dst = m_module.opFFma(m_vec4Type, arg[1], arg[2], arg[0]);
-            dst = Saturate(dst);
-            break;
-
-          case D3DTOP_LERP:
-            dst = m_module.opFMix(m_vec4Type, arg[2], arg[1], arg[0]);
-            break;
+        D3D9FFTextureOpContext ctx;
+        ctx.current    = current;
+        ctx.diffuse    = diffuse;
+        ctx.getTexture = GetTexture;
 
-          default:
-            Logger::warn("Unhandled texture op!");
-            break;
-        }
-
-        return dst;
+        return emitTextureOp(op, dst, arg, ctx);
       };
 
       uint32_t& dst = stage.ResultIsTemp ? temp : current;
@@ -1972,6 +1853,419 @@ namespace dxvk {
     alphaTestPS();
   }
 
+  void D3D9FFShaderCompiler::compileUberPS() {
+    setupPS();
+
+    uint32_t boolType  = m_module.defBoolType();
+    uint32_t bvec4Type = m_module.defVectorType(boolType, 4);
+    uint32_t uvec4Type = m_module.defVectorType(m_uint32Type, 4);
+    uint32_t uvec4Ptr  = m_module.defPointerType(uvec4Type, spv::StorageClassUniform);
+
+    uint32_t diffuse  = m_ps.in.COLOR[0];
+    uint32_t specular = m_ps.in.COLOR[1];
+
+    uint32_t current  = diffuse;
+    uint32_t temp     = m_module.constvec4f32(0.0f, 0.0f, 0.0f, 0.0f);
+
+    // Label of the block we are currently emitting code
+    // into, needed to build phis for the stage results
+    uint32_t label    = m_mainFuncLabel;
+    uint32_t enabled  = 0;
+
+    // Bump mapping is not supported, and D3DTOP_PREMODULATE
+    // is not implemented, so these keep the previous value.
+    static constexpr std::array<D3DTEXTUREOP, 22> supportedOps = {
+      D3DTOP_SELECTARG1,                D3DTOP_SELECTARG2,
+      D3DTOP_MODULATE,                  D3DTOP_MODULATE2X,
+      D3DTOP_MODULATE4X,                D3DTOP_ADD,
+      D3DTOP_ADDSIGNED,                 D3DTOP_ADDSIGNED2X,
+      D3DTOP_SUBTRACT,                  D3DTOP_ADDSMOOTH,
+      D3DTOP_BLENDDIFFUSEALPHA,         D3DTOP_BLENDTEXTUREALPHA,
+      D3DTOP_BLENDFACTORALPHA,          D3DTOP_BLENDTEXTUREALPHAPM,
+      D3DTOP_BLENDCURRENTALPHA,         D3DTOP_MODULATEALPHA_ADDCOLOR,
+      D3DTOP_MODULATECOLOR_ADDALPHA,    D3DTOP_MODULATEINVALPHA_ADDCOLOR,
+      D3DTOP_MODULATEINVCOLOR_ADDALPHA, D3DTOP_DOTPRODUCT3,
+      D3DTOP_MULTIPLYADD,               D3DTOP_LERP,
+    };
+
+    auto SelectVec4 = [&] (uint32_t cond, uint32_t a, uint32_t b) {
+      std::array<uint32_t, 4> conds = { cond, cond, cond, cond };
+      uint32_t cond4 = m_module.opCompositeConstruct(bvec4Type, conds.size(), conds.data());
+      return m_module.opSelect(m_vec4Type, cond4, a, b);
+    };
+
+    auto ExtractBits = [&] (uint32_t value, uint32_t offset, uint32_t count) {
+      return m_module.opBitFieldUExtract(m_uint32Type, value,
+        m_module.consti32(offset), m_module.consti32(count));
+    };
+
+    auto TestBits = [&] (uint32_t value, uint32_t mask) {
+      return m_module.opINotEqual(boolType,
+        m_module.opBitwiseAnd(m_uint32Type, value, m_module.constu32(mask)),
+        m_module.constu32(0));
+    };
+
+    auto LoadStage = [&] (uint32_t idx) {
+      std::array<uint32_t, 2> indices = {
+        m_module.constu32(uint32_t(D3D9FFPSMembers::Stages)),
+        m_module.constu32(idx) };
+
+      return m_module.opLoad(uvec4Type, m_module.opAccessChain(
+        uvec4Ptr, m_ps.constantBuffer, indices.size(), indices.data()));
+    };
+
+    auto Component = [&] (uint32_t vector, uint32_t idx) {
+      return m_module.opCompositeExtract(m_uint32Type, vector, 1, &idx);
+    };
+
+    for (uint32_t i = 0; i < caps::TextureStageCount; i++) {
+      uint32_t stage     = LoadStage(i);
+      uint32_t ops       = Component(stage, 0);
+      uint32_t colorArgs = Component(stage, 1);
+      uint32_t alphaArgs = Component(stage, 2);
+
+      uint32_t colorOp   = ExtractBits(ops, 0, 8);
+      uint32_t alphaOp   = ExtractBits(ops, 8, 8);
+      uint32_t isTemp    = TestBits(ops, 1u << 16);
+
+      // A disabled stage cancels all subsequent stages.
+      uint32_t stageEnabled = m_module.opINotEqual(boolType, colorOp, m_module.constu32(D3DTOP_DISABLE));
+
+      enabled = i ? m_module.opLogicalAnd(boolType, enabled, stageEnabled) : stageEnabled;
+
+      uint32_t stageLabel = m_module.allocateId();
+      uint32_t mergeLabel = m_module.allocateId();
+      uint32_t skipLabel  = label;
+
+      m_module.opSelectionMerge(mergeLabel, spv::SelectionControlMaskNone);
+      m_module.opBranchConditional(enabled, stageLabel, mergeLabel);
+      m_module.opLabel(label = stageLabel);
+
+      // Always sample the texture since we don't know whether
+      // any of the args use it. Control flow is uniform here.
+      std::array<uint32_t, 2> coordIndices = { 0, 1 };
+      uint32_t coord = m_module.opVectorShuffle(m_vec2Type,
+        m_ps.in.TEXCOORD[i], m_ps.in.TEXCOORD[i],
+        coordIndices.size(), coordIndices.data());
+
+      uint32_t texture = m_module.opImageSampleImplicitLod(m_vec4Type,
+        m_module.opLoad(m_ps.samplers[i].typeId, m_ps.samplers[i].varId),
+        coord, SpirvImageOperands());
+
+      texture = SelectVec4(m_ps.samplers[i].bound, texture,
+        m_module.constvec4f32(0.0f, 0.0f, 0.0f, 1.0f));
+
+      uint32_t constantOffset = m_module.constu32(D3D9SharedPSStages_Count * i + D3D9SharedPSStages_Constant);
+      uint32_t constant = m_module.opLoad(m_vec4Type,
+        m_module.opAccessChain(m_module.defPointerType(m_vec4Type, spv::StorageClassUniform),
+          m_ps.sharedState, 1, &constantOffset));
+
+      auto GetArg = [&] (uint32_t args, uint32_t idx) {
+        uint32_t arg = ExtractBits(args, idx * 8, 8);
+        uint32_t sel = m_module.opBitwiseAnd(m_uint32Type, arg, m_module.constu32(D3DTA_SELECTMASK));
+
+        std::array<std::pair<uint32_t, uint32_t>, 7> sources = {{
+          { D3DTA_CONSTANT, constant                      },
+          { D3DTA_CURRENT,  current                       },
+          { D3DTA_DIFFUSE,  diffuse                       },
+          { D3DTA_SPECULAR, specular                      },
+          { D3DTA_TEMP,     temp                          },
+          { D3DTA_TEXTURE,  texture                       },
+          { D3DTA_TFACTOR,  m_ps.constants.textureFactor  },
+        }};
+
+        uint32_t reg = m_module.constvec4f32(1.0f, 1.0f, 1.0f, 1.0f);
+
+        for (const auto& source : sources) {
+          uint32_t match = m_module.opIEqual(boolType, sel, m_module.constu32(source.first));
+          reg = SelectVec4(match, source.second, reg);
+        }
+
+        // reg = 1 - reg
+        reg = SelectVec4(TestBits(arg, D3DTA_COMPLEMENT), emitComplement(reg), reg);
+
+        // reg = reg.wwww
+        reg = SelectVec4(TestBits(arg, D3DTA_ALPHAREPLICATE), emitAlphaReplicate(reg), reg);
+        return reg;
+      };
+
+      D3D9FFTextureOpContext ctx;
+      ctx.current    = current;
+      ctx.diffuse    = diffuse;
+      ctx.getTexture = [texture] () { return texture; };
+
+      auto DoOp = [&] (uint32_t op, uint32_t dst, uint32_t args) {
+        std::array<uint32_t, TextureArgCount> arg = {
+          GetArg(args, 0), GetArg(args, 1), GetArg(args, 2) };
+
+        std::array<SpirvSwitchCaseLabel, supportedOps.size()> caseLabels;
+        std::array<SpirvPhiLabel, supportedOps.size() + 1> phiLabels;
+
+        for (uint32_t j = 0; j < supportedOps.size(); j++) {
+          caseLabels[j].literal = uint32_t(supportedOps[j]);
+          caseLabels[j].labelId = m_module.allocateId();
+        }
+
+        uint32_t defaultLabel = m_module.allocateId();
+        uint32_t switchLabel  = m_module.allocateId();
+
+        m_module.opSelectionMerge(switchLabel, spv::SelectionControlMaskNone);
+        m_module.opSwitch(op, defaultLabel, caseLabels.size(), caseLabels.data());
+
+        for (uint32_t j = 0; j < supportedOps.size(); j++) {
+          m_module.opLabel(caseLabels[j].labelId);
+          phiLabels[j].varId   = emitTextureOp(supportedOps[j], dst, arg, ctx);
+          phiLabels[j].labelId = caseLabels[j].labelId;
+          m_module.opBranch(switchLabel);
+        }
+
+        m_module.opLabel(defaultLabel);
+        phiLabels[supportedOps.size()].varId   = dst;
+        phiLabels[supportedOps.size()].labelId = defaultLabel;
+        m_module.opBranch(switchLabel);
+
+        m_module.opLabel(label = switchLabel);
+        return m_module.opPhi(m_vec4Type, phiLabels.size(), phiLabels.data());
+      };
+
+      uint32_t dst = SelectVec4(isTemp, temp, current);
+
+      uint32_t colorResult = DoOp(colorOp, dst, colorArgs);
+      uint32_t alphaResult = DoOp(alphaOp, dst, alphaArgs);
+
+      // D3DTOP_DOTPRODUCT3 also writes the alpha component.
+      uint32_t isDot3 = m_module.opIEqual(boolType, colorOp, m_module.constu32(D3DTOP_DOTPRODUCT3));
+      alphaResult = SelectVec4(isDot3, colorResult, alphaResult);
+
+      // src0.x, src0.y, src0.z src1.w
+      std::array<uint32_t, 4> indices = { 0, 1, 2, 4 + 3 };
+      uint32_t result = m_module.opVectorShuffle(m_vec4Type,
+        colorResult, alphaResult, indices.size(), indices.data());
+
+      std::array<SpirvPhiLabel, 2> currentPhi = {{
+        { SelectVec4(isTemp, current, result), label },
+        { current, skipLabel },
+      }};
+
+      std::array<SpirvPhiLabel, 2> tempPhi = {{
+        { SelectVec4(isTemp, result, temp), label },
+        { temp, skipLabel },
+      }};
+
+      m_module.opBranch(mergeLabel);
+      m_module.opLabel(label = mergeLabel);
+
+      current = m_module.opPhi(m_vec4Type, currentPhi.size(), currentPhi.data());
+      temp    = m_module.opPhi(m_vec4Type, tempPhi.size(), tempPhi.data());
+    }
+
+    uint32_t flags = Component(LoadStage(0), 3);
+
+    uint32_t specularColor = m_module.opFMul(m_vec4Type, specular, m_module.constvec4f32(1.0f, 1.0f, 1.0f, 0.0f));
+    current = SelectVec4(TestBits(flags, 1u << 0), m_module.opFAdd(m_vec4Type, current, specularColor), current);
+
+    D3D9FogContext fogCtx;
+    fogCtx.IsPixel     = true;
+    fogCtx.RangeFog    = false;
+    fogCtx.RenderState = m_rsBlock;
+    fogCtx.vPos        = m_ps.in.POS;
+    fogCtx.vFog        = m_ps.in.FOG;
+    fogCtx.oColor      = current;
+    fogCtx.IsFixedFunction = true;
+    fogCtx.IsPositionT = false;
+    fogCtx.HasSpecular = false;
+    fogCtx.Specular    = 0;
+    current = DoFixedFunctionFog(m_module, fogCtx);
+
+    m_module.opStore(m_ps.out.COLOR, current);
+
+    alphaTestPS();
+  }
+
+
+  uint32_t D3D9FFShaderCompiler::emitTextureOp(
+          D3DTEXTUREOP                            op,
+          uint32_t                                dst,
+          std::array<uint32_t, TextureArgCount>   arg,
+    const D3D9FFTextureOpContext&                 ctx) {
+    switch (op) {
+      case D3DTOP_SELECTARG1:
+        dst = arg[1];
+        break;
+
+      case D3DTOP_SELECTARG2:
+        dst = arg[2];
+        break;
+
+      case D3DTOP_MODULATE4X:
+        dst = m_module.opFMul(m_vec4Type, arg[1], arg[2]);
+        dst = m_module.opVectorTimesScalar(m_vec4Type, dst, m_module.constf32(4.0f));
+        dst = emitSaturate(dst);
+        break;
+
+      case D3DTOP_MODULATE2X:
+        dst = m_module.opFMul(m_vec4Type, arg[1], arg[2]);
+        dst = m_module.opVectorTimesScalar(m_vec4Type, dst, m_module.constf32(2.0f));
+        dst = emitSaturate(dst);
+        break;
+
+      case D3DTOP_MODULATE:
+        dst = m_module.opFMul(m_vec4Type, arg[1], arg[2]);
+        break;
+
+      case D3DTOP_ADDSIGNED2X:
+        arg[2] = m_module.opFSub(m_vec4Type, arg[2],
+          m_module.constvec4f32(0.5f, 0.5f, 0.5f, 0.5f));
+
+        dst = m_module.opFAdd(m_vec4Type, arg[1], arg[2]);
+        dst = m_module.opVectorTimesScalar(m_vec4Type, dst, m_module.constf32(2.0f));
+        dst = emitSaturate(dst);
+        break;
+
+      case D3DTOP_ADDSIGNED:
+        arg[2] = m_module.opFSub(m_vec4Type, arg[2],
+          m_module.constvec4f32(0.5f, 0.5f, 0.5f, 0.5f));
+
+        dst = m_module.opFAdd(m_vec4Type, arg[1], arg[2]);
+        dst = emitSaturate(dst);
+        break;
+
+      case D3DTOP_ADD:
+        dst = m_module.opFAdd(m_vec4Type, arg[1], arg[2]);
+        dst = emitSaturate(dst);
+        break;
+
+      case D3DTOP_SUBTRACT:
+        dst = m_module.opFSub(m_vec4Type, arg[1], arg[2]);
+        dst = emitSaturate(dst);
+        break;
+
+      case D3DTOP_ADDSMOOTH:
+        dst = m_module.opFFma(m_vec4Type, emitComplement(arg[1]), arg[2], arg[1]);
+        dst = emitSaturate(dst);
+        break;
+
+      case D3DTOP_BLENDDIFFUSEALPHA:
+        dst = m_module.opFMix(m_vec4Type, arg[2], arg[1], emitAlphaReplicate(ctx.diffuse));
+        break;
+
+      case D3DTOP_BLENDTEXTUREALPHA:
+        dst = m_module.opFMix(m_vec4Type, arg[2], arg[1], emitAlphaReplicate(ctx.getTexture()));
+        break;
+
+      case D3DTOP_BLENDFACTORALPHA:
+        dst = m_module.opFMix(m_vec4Type, arg[2], arg[1], emitAlphaReplicate(m_ps.constants.textureFactor));
+        break;
+
+      case D3DTOP_BLENDTEXTUREALPHAPM:
+        dst = m_module.opFFma(m_vec4Type, arg[2], emitComplement(emitAlphaReplicate(ctx.getTexture())), arg[1]);
+        dst = emitSaturate(dst);
+        break;
+
+      case D3DTOP_BLENDCURRENTALPHA:
+        dst = m_module.opFMix(m_vec4Type, arg[2], arg[1], emitAlphaReplicate(ctx.current));
+        break;
+
+      case D3DTOP_PREMODULATE:
+        Logger::warn("D3DTOP_PREMODULATE: not implemented");
+        break;
+
+      case D3DTOP_MODULATEALPHA_ADDCOLOR:
+        dst = m_module.opFFma(m_vec4Type, emitAlphaReplicate(arg[1]), arg[2], arg[1]);
+        dst = emitSaturate(dst);
+        break;
+
+      case D3DTOP_MODULATECOLOR_ADDALPHA:
+        dst = m_module.opFFma(m_vec4Type, arg[1], arg[2], emitAlphaReplicate(arg[1]));
+        dst = emitSaturate(dst);
+        break;
+
+      case D3DTOP_MODULATEINVALPHA_ADDCOLOR:
+        dst = m_module.opFFma(m_vec4Type, emitComplement(emitAlphaReplicate(arg[1])), arg[2], arg[1]);
+        dst = emitSaturate(dst);
+        break;
+
+      case D3DTOP_MODULATEINVCOLOR_ADDALPHA:
+        dst = m_module.opFFma(m_vec4Type, emitComplement(arg[1]), arg[2], emitAlphaReplicate(arg[1]));
+        dst = emitSaturate(dst);
+        break;
+
+      case D3DTOP_BUMPENVMAPLUMINANCE:
+      case D3DTOP_BUMPENVMAP:
+        // Load texture for the next stage...
+        ctx.getTexture();
+        break;
+
+      case D3DTOP_DOTPRODUCT3: {
+        // Get vec3 of arg1 & 2
+        uint32_t vec3Type = m_module.defVectorType(m_floatType, 3);
+        std::array<uint32_t, 3> indices = { 0, 1, 2 };
+        arg[1] = m_module.opVectorShuffle(vec3Type, arg[1], arg[1], indices.size(), indices.data());
+        arg[2] = m_module.opVectorShuffle(vec3Type, arg[2], arg[2], indices.size(), indices.data());
+
+        // Bias according to spec.
+        arg[1] = m_module.opFSub(vec3Type, arg[1], m_module.constvec3f32(0.5f, 0.5f, 0.5f));
+        arg[2] = m_module.opFSub(vec3Type, arg[2], m_module.constvec3f32(0.5f, 0.5f, 0.5f));
+
+        // Do the dotting!
+        dst = m_module.opDot(m_floatType, arg[1], arg[2]);
+
+        // Multiply by 4 and replicate -> vec4
+        dst = m_module.opFMul(m_floatType, dst, m_module.constf32(4.0f));
+        dst = emitScalarReplicate(dst);
+
+        // Saturate
+        dst = emitSaturate(dst);
+
+        break;
+      }
+
+      case D3DTOP_MULTIPLYADD:
+        dst = m_module.opFFma(m_vec4Type, arg[1], arg[2], arg[0]);
+        dst = emitSaturate(dst);
+        break;
+
+      case D3DTOP_LERP:
+        dst = m_module.opFMix(m_vec4Type, arg[2], arg[1], arg[0]);
+        break;
+
+      default:
+        Logger::warn("Unhandled texture op!");
+        break;
+    }
+
+    return dst;
+  }
+
+
+  uint32_t D3D9FFShaderCompiler::emitScalarReplicate(uint32_t reg) {
+    std::array<uint32_t, 4> replicant = { reg, reg, reg, reg };
+    return m_module.opCompositeConstruct(m_vec4Type, replicant.size(), replicant.data());
+  }
+
+
+  uint32_t D3D9FFShaderCompiler::emitAlphaReplicate(uint32_t reg) {
+    uint32_t alphaComponentId = 3;
+    uint32_t alpha = m_module.opCompositeExtract(m_floatType, reg, 1, &alphaComponentId);
+
+    return emitScalarReplicate(alpha);
+  }
+
+
+  uint32_t D3D9FFShaderCompiler::emitComplement(uint32_t reg) {
+    return m_module.opFSub(m_vec4Type,
+      m_module.constvec4f32(1.0f, 1.0f, 1.0f, 1.0f),
+      reg);
+  }
+
+
+  uint32_t D3D9FFShaderCompiler::emitSaturate(uint32_t reg) {
+    return m_module.opFClamp(m_vec4Type, reg,
+      m_module.constvec4f32(0.0f, 0.0f, 0.0f, 0.0f),
+      m_module.constvec4f32(1.0f, 1.0f, 1.0f, 1.0f));
+  }
+
+
   void D3D9FFShaderCompiler::setupPS() {
     setupRenderStateInfo();
 
@@ -2000,8 +2294,14 @@ namespace dxvk {
     m_ps.out.COLOR   = declareIO(false, DxsoSemantic{ DxsoUsage::Color, 0 });
 
     // Constant Buffer for PS.
+    uint32_t stageArrayType = m_module.defArrayTypeUnique(
+      m_module.defVectorType(m_uint32Type, 4),
+      m_module.constu32(caps::TextureStageCount));
+    m_module.decorateArrayStride(stageArrayType, sizeof(D3D9FixedFunctionPSStage));
+
     std::array<uint32_t, uint32_t(D3D9FFPSMembers::MemberCount)> members = {
-      m_vec4Type // Texture Factor
+      m_vec4Type,     // Texture Factor
+      stageArrayType, // Stages
     };
 
     const uint32_t structType =
@@ -2017,6 +2317,7 @@ namespace dxvk {
 
     m_module.setDebugName(structType, "D3D9FixedFunctionPS");
     m_module.setDebugMemberName(structType, 0, "textureFactor");
+    m_module.setDebugMemberName(structType, 1, "stages");
 
     m_ps.constantBuffer = m_module.newVar(
       m_module.defPointerType(structType, spv::StorageClassUniform),
@@ -2351,6 +2652,13 @@ namespace dxvk {
     pDevice->GetDXVKDevice()->registerShader(m_shader);
   }
 
+  D3D9FFShader::D3D9FFShader(
+    const Rc<DxvkShader>&       Shader)
+  : m_shader(Shader) {
+
+  }
+
+
   template <typename T>
   void D3D9FFShader::Dump(const T& Key, const std::string& Name) {
     const std::string dumpPath = env::getEnvVar("DXVK_SHADER_DUMP_PATH");
@@ -2365,6 +2673,38 @@ namespace dxvk {
   }
 
 
+  D3D9FFShaderModuleSet::D3D9FFShaderModuleSet(
+          D3D9DeviceEx*         pDevice)
+  : m_device  (pDevice->GetDXVKDevice()),
+    m_options (pDevice->GetOptions()),
+    m_cache   (m_device, ".dxvk-ffcache") {
+    if (pDevice->GetOptions()->ffUberShaders) {
+      m_fsUberShader = CreateUberShader();
+      Logger::info("D3D9: Using fixed-function uber shader");
+    }
+
+    if (m_cache.isEnabled())
+      m_preloadThread = dxvk::thread([this] { PreloadShaders(); });
+  }
+
+
+  D3D9FFShaderModuleSet::~D3D9FFShaderModuleSet() {
+    m_stopped.store(true);
+
+    // Jobs on the device's compiler threads reference this
+    // object, so wait for all of them to run or bail out
+    { std::unique_lock<dxvk::mutex> lock(m_fsMutex);
+
+      m_fsCond.wait(lock, [this] {
+        return m_fsPending.empty();
+      });
+    }
+
+    if (m_preloadThread.joinable())
+      m_preloadThread.join();
+  }
+
+
   D3D9FFShader D3D9FFShaderModuleSet::GetShaderModule(
           D3D9DeviceEx*         pDevice,
     const D3D9FFShaderKeyVS&    ShaderKey) {
@@ -2373,8 +2713,8 @@ namespace dxvk {
     if (entry != m_vsModules.end())
       return entry->second;
     
-    D3D9FFShader shader(
-      pDevice, ShaderKey);
+    D3D9FFShader shader = CreateShaderModule(
+      pDevice, VK_SHADER_STAGE_VERTEX_BIT, ShaderKey);
 
     m_vsModules.insert({ShaderKey, shader});
 
@@ -2385,20 +2725,209 @@ namespace dxvk {
   D3D9FFShader D3D9FFShaderModuleSet::GetShaderModule(
           D3D9DeviceEx*         pDevice,
     const D3D9FFShaderKeyFS&    ShaderKey) {
-    // Use the shader's unique key for the lookup
-    auto entry = m_fsModules.find(ShaderKey);
-    if (entry != m_fsModules.end())
-      return entry->second;
-    
-    D3D9FFShader shader(
-      pDevice, ShaderKey);
+    // Use the shader's unique key for the lookup. Shaders
+    // compiled in the background get added by the workers.
+    { std::lock_guard<dxvk::mutex> lock(m_fsMutex);
+
+      auto entry = m_fsModules.find(ShaderKey);
+      if (entry != m_fsModules.end())
+        return entry->second;
+    }
+
+    if (m_fsUberShader != nullptr && SupportsFixedFunctionUberPS(ShaderKey)) {
+      DxvkShaderKey cacheKey = ComputeCacheKey(
+        VK_SHADER_STAGE_FRAGMENT_BIT, &ShaderKey, sizeof(ShaderKey));
+
+      Rc<DxvkShader> cached = LookupCachedShader(cacheKey);
+
+      std::lock_guard<dxvk::mutex> lock(m_fsMutex);
+
+      if (cached != nullptr) {
+        D3D9FFShader shader(cached);
+        m_fsModules.insert({ShaderKey, shader});
+        return shader;
+      }
+
+      // Compile the specialized shader in the background
+      // and use the uber shader until it becomes available
+      if (m_fsPending.insert(ShaderKey).second) {
+        m_device->compilerWorkers().enqueue([this, pDevice, ShaderKey, cacheKey] {
+          CompilePixelShader(pDevice, ShaderKey, cacheKey);
+        }, DxvkWorkerPriority::High);
+      }
+
+      return D3D9FFShader(m_fsUberShader);
+    }
 
+    D3D9FFShader shader = CreateShaderModule(
+      pDevice, VK_SHADER_STAGE_FRAGMENT_BIT, ShaderKey);
+
+    std::lock_guard<dxvk::mutex> lock(m_fsMutex);
     m_fsModules.insert({ShaderKey, shader});
 
     return shader;
   }
 
 
+  bool D3D9FFShaderModuleSet::UsesUberShader(
+    const D3D9FFShaderKeyFS&    ShaderKey) {
+    if (m_fsUberShader == nullptr || !SupportsFixedFunctionUberPS(ShaderKey))
+      return false;
+
+    std::lock_guard<dxvk::mutex> lock(m_fsMutex);
+    return m_fsModules.find(ShaderKey) == m_fsModules.end();
+  }
+
+
+  template<typename T>
+  D3D9FFShader D3D9FFShaderModuleSet::CreateShaderModule(
+          D3D9DeviceEx*         pDevice,
+          VkShaderStageFlagBits Stage,
+    const T&                    ShaderKey) {
+    DxvkShaderKey cacheKey = ComputeCacheKey(
+      Stage, &ShaderKey, sizeof(ShaderKey));
+
+    Rc<DxvkShader> cached = LookupCachedShader(cacheKey);
+
+    if (cached != nullptr)
+      return D3D9FFShader(cached);
+
+    D3D9FFShader shader(pDevice, ShaderKey);
+    m_cache.storeShader(cacheKey, shader.GetShader());
+    return shader;
+  }
+
+
+  Rc<DxvkShader> D3D9FFShaderModuleSet::LookupCachedShader(
+    const DxvkShaderKey&        CacheKey) {
+    { std::lock_guard<dxvk::mutex> lock(m_cachedMutex);
+      auto entry = m_cachedShaders.find(CacheKey);
+
+      if (entry != m_cachedShaders.end())
+        return entry->second;
+    }
+
+    Rc<DxvkShader> shader = m_cache.lookupShader(CacheKey);
+
+    if (shader == nullptr)
+      return nullptr;
+
+    // The preload thread and the CS thread may both load
+    // the same shader, make sure only one gets registered
+    { std::lock_guard<dxvk::mutex> lock(m_cachedMutex);
+      auto result = m_cachedShaders.insert({ CacheKey, shader });
+
+      if (!result.second)
+        return result.first->second;
+    }
+
+    m_device->registerShader(shader);
+    return shader;
+  }
+
+
+  DxvkShaderKey D3D9FFShaderModuleSet::ComputeCacheKey(
+          VkShaderStageFlagBits Stage,
+    const void*                 pShaderKey,
+          size_t                KeySize) const {
+    std::array<uint32_t, 2> data = {{
+      CacheVersion,
+      uint32_t(m_options.invariantPosition),
+    }};
+
+    std::array<Sha1Data, 2> chunks = {{
+      { pShaderKey,  KeySize      },
+      { data.data(), sizeof(data) },
+    }};
+
+    return DxvkShaderKey(Stage,
+      Sha1Hash::compute(chunks.size(), chunks.data()));
+  }
+
+
+  Rc<DxvkShader> D3D9FFShaderModuleSet::CreateUberShader() {
+    const std::string name = "FF_UberPS";
+
+    D3D9FFShaderCompiler compiler(m_device, name, m_options);
+    Rc<DxvkShader> shader = compiler.compile();
+
+    shader->setShaderKey(DxvkShaderKey(VK_SHADER_STAGE_FRAGMENT_BIT,
+      Sha1Hash::compute(name.data(), name.size())));
+
+    m_device->registerShader(shader);
+    return shader;
+  }
+
+
+  void D3D9FFShaderModuleSet::CompilePixelShader(
+          D3D9DeviceEx*         pDevice,
+    const D3D9FFShaderKeyFS&    ShaderKey,
+    const DxvkShaderKey&        CacheKey) {
+    if (!m_stopped.load()) {
+      D3D9FFShader shader(pDevice, ShaderKey);
+      m_cache.storeShader(CacheKey, shader.GetShader());
+
+      std::lock_guard<dxvk::mutex> lock(m_fsMutex);
+      m_fsModules.insert({ShaderKey, shader});
+    }
+
+    std::lock_guard<dxvk::mutex> lock(m_fsMutex);
+    m_fsPending.erase(ShaderKey);
+    m_fsCond.notify_all();
+  }
+
+
+  void D3D9FFShaderModuleSet::PreloadShaders() {
+    env::setThreadName("dxvk-ff-cache");
+
+    std::vector<DxvkShaderKey> keys = m_cache.getKeys();
+
+    for (const auto& key : keys) {
+      if (m_stopped.load())
+        return;
+
+      LookupCachedShader(key);
+    }
+
+    Logger::info(str::format("D3D9: Preloaded ", keys.size(), " fixed-function shaders"));
+  }
+
+
+  bool SupportsFixedFunctionUberPS(const D3D9FFShaderKeyFS& Key) {
+    if (Key.Stages[0].Contents.GlobalFlatShade)
+      return false;
+
+    for (uint32_t i = 0; i < caps::TextureStageCount; i++) {
+      const auto& stage = Key.Stages[i].Contents;
+
+      if (stage.ColorOp == D3DTOP_DISABLE)
+        break;
+
+      if (D3DRESOURCETYPE(stage.Type + D3DRTYPE_TEXTURE) != D3DRTYPE_TEXTURE || stage.Projected)
+        return false;
+
+      if (stage.ColorOp == D3DTOP_BUMPENVMAP || stage.ColorOp == D3DTOP_BUMPENVMAPLUMINANCE
+       || stage.AlphaOp == D3DTOP_BUMPENVMAP || stage.AlphaOp == D3DTOP_BUMPENVMAPLUMINANCE)
+        return false;
+    }
+
+    return true;
+  }
+
+
+  void PackFixedFunctionStages(const D3D9FFShaderKeyFS& Key, D3D9FixedFunctionPS* pData) {
+    for (uint32_t i = 0; i < caps::TextureStageCount; i++) {
+      const auto& stage = Key.Stages[i].Contents;
+      auto& data = pData->stages[i];
+
+      data.ops       = stage.ColorOp   | (stage.AlphaOp   << 8) | (stage.ResultIsTemp << 16);
+      data.colorArgs = stage.ColorArg0 | (stage.ColorArg1 << 8) | (stage.ColorArg2    << 16);
+      data.alphaArgs = stage.AlphaArg0 | (stage.AlphaArg1 << 8) | (stage.AlphaArg2    << 16);
+      data.flags     = stage.GlobalSpecularEnable;
+    }
+  }
+
+
   size_t D3D9FFShaderKeyHash::operator () (const D3D9FFShaderKeyVS& key) const {
     DxvkHashState state;
 
@@ -5,10 +5,14 @@
 #include "d3d9_caps.h"
 
 #include "../dxvk/dxvk_shader.h"
+#include "../dxvk/dxvk_shader_cache.h"
+#include "../dxvk/dxvk_worker_pool.h"
 
 #include "../dxso/dxso_isgn.h"
 
+#include <atomic>
 #include <unordered_map>
+#include <unordered_set>
 #include <bitset>
 
 namespace dxvk {
@@ -17,6 +21,7 @@ namespace dxvk {
   class SpirvModule;
 
   struct D3D9Options;
+  struct D3D9FixedFunctionPS;
 
   struct D3D9FogContext {
     // General inputs...
@@ -190,6 +195,13 @@ namespace dxvk {
     bool operator () (const D3D9FFShaderKeyFS& a, const D3D9FFShaderKeyFS& b) const;
   };
 
+  // Whether the uber shader can emulate the given texture stage state.
+  // Only 2D textures are supported, and no projection or bump mapping.
+  bool SupportsFixedFunctionUberPS(const D3D9FFShaderKeyFS& Key);
+
+  // Writes the texture stage state that the uber shader reads
+  void PackFixedFunctionStages(const D3D9FFShaderKeyFS& Key, D3D9FixedFunctionPS* pData);
+
   class D3D9FFShader {
 
   public:
@@ -202,6 +214,9 @@ namespace dxvk {
             D3D9DeviceEx*         pDevice,
       const D3D9FFShaderKeyFS&    Key);
 
+    D3D9FFShader(
+      const Rc<DxvkShader>&       Shader);
+
     template <typename T>
     void Dump(const T& Key, const std::string& Name);
 
@@ -218,10 +233,31 @@ namespace dxvk {
   };
 
 
+  /**
+   * \brief Fixed-function shader module set
+   *
+   * Generated shaders are stored in a disk cache, keyed
+   * by the shader key and fixed-function options. When
+   * the set is created, all cached shaders are loaded
+   * and registered with the device on a background
+   * thread, so that pipelines can be compiled from the
+   * state cache before the shaders are first used.
+   *
+   * If enabled, pixel shaders that are not cached are
+   * compiled on the device's compiler threads, and an
+   * uber shader that reads the texture stage state from
+   * the constant buffer is used until the shader is ready.
+   */
   class D3D9FFShaderModuleSet : public RcObject {
-
+    /// Bump this when changing the fixed-function shader generator
+    constexpr static uint32_t CacheVersion = 2;
   public:
 
+    D3D9FFShaderModuleSet(
+            D3D9DeviceEx*         pDevice);
+
+    ~D3D9FFShaderModuleSet();
+
     D3D9FFShader GetShaderModule(
             D3D9DeviceEx*         pDevice,
       const D3D9FFShaderKeyVS&    ShaderKey);
@@ -230,18 +266,75 @@ namespace dxvk {
             D3D9DeviceEx*         pDevice,
       const D3D9FFShaderKeyFS&    ShaderKey);
 
+    /**
+     * \brief Checks whether the uber shader is used for a key
+     *
+     * If this returns \c true, the pixel shader should be
+     * bound again on subsequent draws, so that the specialized
+     * shader gets used as soon as it is available.
+     * \param [in] ShaderKey Pixel shader key
+     * \returns \c true if the specialized shader is not ready
+     */
+    bool UsesUberShader(
+      const D3D9FFShaderKeyFS&    ShaderKey);
+
   private:
 
+    Rc<DxvkDevice>            m_device;
+    D3D9FixedFunctionOptions  m_options;
+    DxvkShaderCache           m_cache;
+
+    dxvk::mutex               m_cachedMutex;
+    std::unordered_map<
+      DxvkShaderKey,
+      Rc<DxvkShader>,
+      DxvkHash, DxvkEq>       m_cachedShaders;
+
+    std::atomic<bool>         m_stopped = { false };
+    dxvk::thread              m_preloadThread;
+
     std::unordered_map<
       D3D9FFShaderKeyVS,
       D3D9FFShader,
       D3D9FFShaderKeyHash, D3D9FFShaderKeyEq> m_vsModules;
 
+    dxvk::mutex               m_fsMutex;
+    dxvk::condition_variable  m_fsCond;
+
     std::unordered_map<
       D3D9FFShaderKeyFS,
       D3D9FFShader,
       D3D9FFShaderKeyHash, D3D9FFShaderKeyEq> m_fsModules;
 
+    std::unordered_set<
+      D3D9FFShaderKeyFS,
+      D3D9FFShaderKeyHash, D3D9FFShaderKeyEq> m_fsPending;
+
+    Rc<DxvkShader>            m_fsUberShader;
+
+    template<typename T>
+    D3D9FFShader CreateShaderModule(
+            D3D9DeviceEx*         pDevice,
+            VkShaderStageFlagBits Stage,
+      const T&                    ShaderKey);
+
+    Rc<DxvkShader> LookupCachedShader(
+      const DxvkShaderKey&        CacheKey);
+
+    DxvkShaderKey ComputeCacheKey(
+            VkShaderStageFlagBits Stage,
+      const void*                 pShaderKey,
+            size_t                KeySize) const;
+
+    Rc<DxvkShader> CreateUberShader();
+
+    void CompilePixelShader(
+            D3D9DeviceEx*         pDevice,
+      const D3D9FFShaderKeyFS&    ShaderKey,
+      const DxvkShaderKey&        CacheKey);
+
+    void PreloadShaders();
+
   };
 
 
@@ -72,6 +72,8 @@ namespace dxvk {
     this->alphaTestWiggleRoom           = config.getOption<bool>        ("d3d9.alphaTestWiggleRoom",           false);
     this->apitraceMode                  = config.getOption<bool>        ("d3d9.apitraceMode",                  false);
     this->deviceLocalConstantBuffers    = config.getOption<bool>        ("d3d9.deviceLocalConstantBuffers",    false);
+    this->ffUberShaders                 = config.getOption<bool>        ("d3d9.ffUberShaders",                 false);
+    this->asyncShaderCompile            = config.getOption<bool>        ("d3d9.asyncShaderCompile",            true);
 
     // If we are not Nvidia, enable general hazards.
     this->generalHazards = adapter != nullptr
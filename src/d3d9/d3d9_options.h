@@ -156,6 +156,14 @@ namespace dxvk {
 
     /// Use device local memory for constant buffers.
     bool deviceLocalConstantBuffers;
+
+    /// Use an uber shader for fixed-function pixel processing
+    /// while specialized shaders are compiled in the background
+    bool ffUberShaders;
+
+    /// Translate shaders on worker threads rather
+    /// than in the shader creation functions
+    bool asyncShaderCompile;
   };
 
 }
\ No newline at end of file
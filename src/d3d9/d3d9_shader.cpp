@@ -10,6 +10,7 @@ namespace dxvk {
 
   D3D9CommonShader::D3D9CommonShader(
             D3D9DeviceEx*         pDevice,
+            D3D9ShaderCache*      pCache,
             VkShaderStageFlagBits ShaderStage,
       const DxvkShaderKey&        Key,
       const DxsoModuleInfo*       pDxsoModuleInfo,
@@ -50,28 +51,38 @@ namespace dxvk {
       }
     }
     
-    // Decide whether we need to create a pass-through
-    // geometry shader for vertex shader stream output
-
     const D3D9ConstantLayout& constantLayout = ShaderStage == VK_SHADER_STAGE_VERTEX_BIT
       ? pDevice->GetVertexConstantLayout()
       : pDevice->GetPixelConstantLayout();
-    m_shaders      = pModule->compile(*pDxsoModuleInfo, name, AnalysisInfo, constantLayout);
-    m_isgn         = pModule->isgn();
-    m_usedSamplers = pModule->usedSamplers();
 
-    // Shift up these sampler bits so we can just
-    // do an or per-draw in the device.
-    // We shift by 17 because 16 ps samplers + 1 dmap (tess)
-    if (ShaderStage == VK_SHADER_STAGE_VERTEX_BIT)
-      m_usedSamplers <<= caps::MaxTexturesPS + 1;
+    // Try to load the translated shader and its metadata
+    // from the disk cache first, and add it otherwise
+    DxvkShaderKey cacheKey = D3D9ShaderCache::ComputeKey(
+      Key, *pDxsoModuleInfo, constantLayout);
+
+    std::vector<uint8_t> metadata;
+
+    if (!pCache->LookupShader(cacheKey, &m_shaders, &metadata)
+     || !DeserializeMetadata(metadata)) {
+      m_shaders      = pModule->compile(*pDxsoModuleInfo, name, AnalysisInfo, constantLayout);
+      m_isgn         = pModule->isgn();
+      m_usedSamplers = pModule->usedSamplers();
 
-    m_usedRTs      = pModule->usedRTs();
+      // Shift up these sampler bits so we can just
+      // do an or per-draw in the device.
+      // We shift by 17 because 16 ps samplers + 1 dmap (tess)
+      if (ShaderStage == VK_SHADER_STAGE_VERTEX_BIT)
+        m_usedSamplers <<= caps::MaxTexturesPS + 1;
 
-    m_info      = pModule->info();
-    m_meta      = pModule->meta();
-    m_constants = pModule->constants();
-    m_maxDefinedConst = pModule->maxDefinedConstant();
+      m_usedRTs      = pModule->usedRTs();
+
+      m_info      = pModule->info();
+      m_meta      = pModule->meta();
+      m_constants = pModule->constants();
+      m_maxDefinedConst = pModule->maxDefinedConstant();
+
+      pCache->StoreShader(cacheKey, m_shaders, SerializeMetadata());
+    }
 
     m_shaders[0]->setShaderKey(Key);
 
@@ -95,6 +106,179 @@ namespace dxvk {
   }
 
 
+  D3D9CommonShader::D3D9CommonShader(
+    const Rc<D3D9ShaderCompileJob>& Job)
+  : m_bytecode(Job->GetBytecode()),
+    m_job     (Job) {
+
+  }
+
+
+  const D3D9CommonShader& D3D9CommonShader::WaitForJob() const {
+    return m_job->GetShader();
+  }
+
+
+  void D3D9CommonShader::CancelJob() const {
+    if (m_job != nullptr)
+      m_job->Cancel();
+  }
+
+
+  std::vector<uint8_t> D3D9CommonShader::SerializeMetadata() const {
+    std::vector<uint8_t> data;
+
+    auto write = [&data] (const void* src, size_t size) {
+      auto bytes = reinterpret_cast<const uint8_t*>(src);
+      data.insert(data.end(), bytes, bytes + size);
+    };
+
+    uint32_t constantCount = m_constants.size();
+
+    write(&m_isgn,            sizeof(m_isgn));
+    write(&m_usedSamplers,    sizeof(m_usedSamplers));
+    write(&m_usedRTs,         sizeof(m_usedRTs));
+    write(&m_info,            sizeof(m_info));
+    write(&m_meta,            sizeof(m_meta));
+    write(&m_maxDefinedConst, sizeof(m_maxDefinedConst));
+    write(&constantCount,     sizeof(constantCount));
+    write(m_constants.data(), m_constants.size() * sizeof(DxsoDefinedConstant));
+    return data;
+  }
+
+
+  bool D3D9CommonShader::DeserializeMetadata(
+    const std::vector<uint8_t>& Data) {
+    size_t offset = 0;
+
+    auto read = [&] (void* dst, size_t size) {
+      if (Data.size() - offset < size)
+        return false;
+
+      std::memcpy(dst, Data.data() + offset, size);
+      offset += size;
+      return true;
+    };
+
+    uint32_t constantCount = 0;
+
+    if (!read(&m_isgn,            sizeof(m_isgn))
+     || !read(&m_usedSamplers,    sizeof(m_usedSamplers))
+     || !read(&m_usedRTs,         sizeof(m_usedRTs))
+     || !read(&m_info,            sizeof(m_info))
+     || !read(&m_meta,            sizeof(m_meta))
+     || !read(&m_maxDefinedConst, sizeof(m_maxDefinedConst))
+     || !read(&constantCount,     sizeof(constantCount))
+     || Data.size() - offset != constantCount * sizeof(DxsoDefinedConstant))
+      return false;
+
+    m_constants.resize(constantCount);
+    return read(m_constants.data(), m_constants.size() * sizeof(DxsoDefinedConstant));
+  }
+
+
+  D3D9ShaderCompileJob::D3D9ShaderCompileJob(
+          D3D9DeviceEx*         pDevice,
+          D3D9ShaderCache*      pCache,
+          VkShaderStageFlagBits ShaderStage,
+    const DxvkShaderKey&        ShaderKey,
+    const DxsoModuleInfo&       ModuleInfo,
+    const void*                 pShaderBytecode,
+    const DxsoAnalysisInfo&     AnalysisInfo)
+  : m_device    (pDevice),
+    m_cache     (pCache),
+    m_stage     (ShaderStage),
+    m_shaderKey (ShaderKey),
+    m_moduleInfo(ModuleInfo),
+    m_analysis  (AnalysisInfo) {
+    auto bytecode = reinterpret_cast<const uint8_t*>(pShaderBytecode);
+    m_bytecode.assign(bytecode, bytecode + AnalysisInfo.bytecodeByteLength);
+  }
+
+
+  D3D9ShaderCompileJob::~D3D9ShaderCompileJob() {
+
+  }
+
+
+  void D3D9ShaderCompileJob::Run() {
+    State expected = State::Pending;
+
+    if (!m_state.compare_exchange_strong(expected, State::Running))
+      return;
+
+    DxsoReader reader(
+      reinterpret_cast<const char*>(m_bytecode.data()));
+
+    DxsoModule module(reader);
+    D3D9CommonShader shader;
+
+    try {
+      shader = D3D9CommonShader(m_device, m_cache,
+        m_stage, m_shaderKey, &m_moduleInfo,
+        m_bytecode.data(), m_analysis, &module);
+    } catch (const DxvkError& e) {
+      Logger::err(str::format("D3D9: Failed to compile shader ",
+        m_shaderKey.toString(), ", shader will not be bound:\n", e.message()));
+
+      // The device uses the program info even if no
+      // shader is bound, so keep it consistent
+      shader.m_bytecode = m_bytecode;
+      shader.m_info     = module.info();
+    }
+
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    m_shader = std::move(shader);
+    m_state.store(State::Done, std::memory_order_release);
+    m_cond.notify_all();
+  }
+
+
+  void D3D9ShaderCompileJob::Cancel() {
+    State expected = State::Pending;
+
+    if (m_state.compare_exchange_strong(expected, State::Done))
+      return;
+
+    std::unique_lock<dxvk::mutex> lock(m_mutex);
+
+    m_cond.wait(lock, [this] {
+      return m_state.load() == State::Done;
+    });
+  }
+
+
+  const D3D9CommonShader& D3D9ShaderCompileJob::WaitForShader() {
+    this->Run();
+
+    std::unique_lock<dxvk::mutex> lock(m_mutex);
+
+    m_cond.wait(lock, [this] {
+      return m_state.load() == State::Done;
+    });
+
+    return m_shader;
+  }
+
+
+  D3D9ShaderModuleSet::D3D9ShaderModuleSet(
+    const Rc<DxvkDevice>&       Device,
+          bool                  AsyncCompile)
+  : m_device      (Device),
+    m_cache       (Device),
+    m_asyncCompile(AsyncCompile) {
+
+  }
+
+
+  D3D9ShaderModuleSet::~D3D9ShaderModuleSet() {
+    // Jobs may still be queued on the device's compiler
+    // threads, so make sure they don't access the cache
+    for (const auto& entry : m_modules)
+      entry.second.CancelJob();
+  }
+
+
   void D3D9ShaderModuleSet::GetShaderModule(
             D3D9DeviceEx*         pDevice,
             D3D9CommonShader*     pShaderModule,
@@ -130,10 +314,19 @@ namespace dxvk {
     
     // This shader has not been compiled yet, so we have to create a
     // new module. This takes a while, so we won't lock the structure.
-    *pShaderModule = D3D9CommonShader(
-      pDevice, ShaderStage, lookupKey,
-      pDxbcModuleInfo, pShaderBytecode,
-      info, &module);
+    Rc<D3D9ShaderCompileJob> job;
+
+    if (m_asyncCompile) {
+      job = new D3D9ShaderCompileJob(pDevice, &m_cache,
+        ShaderStage, lookupKey, *pDxbcModuleInfo,
+        pShaderBytecode, info);
+      *pShaderModule = D3D9CommonShader(job);
+    } else {
+      *pShaderModule = D3D9CommonShader(
+        pDevice, &m_cache, ShaderStage, lookupKey,
+        pDxbcModuleInfo, pShaderBytecode,
+        info, &module);
+    }
     
     // Insert the new module into the lookup table. If another thread
     // has compiled the same shader in the meantime, we should return
@@ -146,6 +339,9 @@ namespace dxvk {
         return;
       }
     }
+
+    if (job != nullptr)
+      m_device->compilerWorkers().enqueue([job] { job->Run(); }, DxvkWorkerPriority::High);
   }
 
 }
@@ -2,6 +2,7 @@
 
 #include "d3d9_resource.h"
 #include "../dxso/dxso_module.h"
+#include "d3d9_shader_cache.h"
 #include "d3d9_shader_permutations.h"
 #include "d3d9_util.h"
 
@@ -9,6 +10,7 @@
 
 namespace dxvk {
 
+  class D3D9ShaderCompileJob;
 
   /**
    * \brief Common shader object
@@ -16,15 +18,24 @@ namespace dxvk {
    * Stores the compiled SPIR-V shader and the SHA-1
    * hash of the original DXBC shader, which can be
    * used to identify the shader.
+   *
+   * If the shader is compiled asynchronously, the
+   * shader and its metadata will only be available
+   * once the compile job has finished, and any method
+   * that accesses them will wait for the job to complete.
+   * If translation fails on a worker thread, the shader
+   * objects will be \c nullptr and no metadata other
+   * than the program info will be available.
    */
   class D3D9CommonShader {
-
+    friend class D3D9ShaderCompileJob;
   public:
 
     D3D9CommonShader();
 
     D3D9CommonShader(
             D3D9DeviceEx*         pDevice,
+            D3D9ShaderCache*      pCache,
             VkShaderStageFlagBits ShaderStage,
       const DxvkShaderKey&        Key,
       const DxsoModuleInfo*       pDxbcModuleInfo,
@@ -32,13 +43,20 @@ namespace dxvk {
       const DxsoAnalysisInfo&     AnalysisInfo,
             DxsoModule*           pModule);
 
+    D3D9CommonShader(
+      const Rc<D3D9ShaderCompileJob>& Job);
+
 
     Rc<DxvkShader> GetShader(D3D9ShaderPermutation Permutation) const {
-      return m_shaders[Permutation];
+      return GetCompiled().m_shaders[Permutation];
     }
 
     std::string GetName() const {
-      return m_shaders[D3D9ShaderPermutations::None]->debugName();
+      Rc<DxvkShader> shader = GetShader(D3D9ShaderPermutations::None);
+
+      return shader != nullptr
+        ? shader->debugName()
+        : std::string();
     }
 
     const std::vector<uint8_t>& GetBytecode() const {
@@ -46,33 +64,152 @@ namespace dxvk {
     }
 
     const DxsoIsgn& GetIsgn() const {
-      return m_isgn;
+      return GetCompiled().m_isgn;
     }
 
-    const DxsoShaderMetaInfo& GetMeta() const { return m_meta; }
-    const DxsoDefinedConstants& GetConstants() const { return m_constants; }
+    const DxsoShaderMetaInfo& GetMeta() const { return GetCompiled().m_meta; }
+    const DxsoDefinedConstants& GetConstants() const { return GetCompiled().m_constants; }
+
+    D3D9ShaderMasks GetShaderMask() const {
+      const D3D9CommonShader& shader = GetCompiled();
+      return D3D9ShaderMasks{ shader.m_usedSamplers, shader.m_usedRTs };
+    }
 
-    D3D9ShaderMasks GetShaderMask() const { return D3D9ShaderMasks{ m_usedSamplers, m_usedRTs }; }
+    const DxsoProgramInfo& GetInfo() const { return GetCompiled().m_info; }
 
-    const DxsoProgramInfo& GetInfo() const { return m_info; }
+    uint32_t GetMaxDefinedConstant() const { return GetCompiled().m_maxDefinedConst; }
 
-    uint32_t GetMaxDefinedConstant() const { return m_maxDefinedConst; }
+    /**
+     * \brief Cancels pending compile job
+     *
+     * If the shader has not been compiled yet, it will
+     * not be compiled at all. Waits for the job if it
+     * is currently running.
+     */
+    void CancelJob() const;
 
   private:
 
     DxsoIsgn              m_isgn;
-    uint32_t              m_usedSamplers;
-    uint32_t              m_usedRTs;
+    uint32_t              m_usedSamplers    = 0;
+    uint32_t              m_usedRTs         = 0;
 
     DxsoProgramInfo       m_info;
     DxsoShaderMetaInfo    m_meta;
     DxsoDefinedConstants  m_constants;
-    uint32_t              m_maxDefinedConst;
+    uint32_t              m_maxDefinedConst = 0;
 
     DxsoPermutations      m_shaders;
 
     std::vector<uint8_t>  m_bytecode;
 
+    Rc<D3D9ShaderCompileJob> m_job;
+
+    const D3D9CommonShader& GetCompiled() const {
+      return likely(m_job == nullptr) ? *this : WaitForJob();
+    }
+
+    const D3D9CommonShader& WaitForJob() const;
+
+    std::vector<uint8_t> SerializeMetadata() const;
+
+    bool DeserializeMetadata(
+      const std::vector<uint8_t>& Data);
+
+  };
+
+
+  /**
+   * \brief Shader compile job
+   *
+   * Translates a shader on a worker thread. If the
+   * shader is needed before any worker has picked up
+   * the job, the thread that needs the shader will
+   * translate it instead of waiting for the workers.
+   */
+  class D3D9ShaderCompileJob : public RcObject {
+
+  public:
+
+    D3D9ShaderCompileJob(
+            D3D9DeviceEx*         pDevice,
+            D3D9ShaderCache*      pCache,
+            VkShaderStageFlagBits ShaderStage,
+      const DxvkShaderKey&        ShaderKey,
+      const DxsoModuleInfo&       ModuleInfo,
+      const void*                 pShaderBytecode,
+      const DxsoAnalysisInfo&     AnalysisInfo);
+
+    ~D3D9ShaderCompileJob();
+
+    /**
+     * \brief Compiles the shader
+     *
+     * Does nothing if the shader is already
+     * being compiled by another thread.
+     */
+    void Run();
+
+    /**
+     * \brief Cancels the job
+     *
+     * Prevents the job from running if it has not
+     * started yet, or waits for it to finish. The
+     * shader will not be usable if cancelled.
+     */
+    void Cancel();
+
+    /**
+     * \brief Retrieves compiled shader
+     *
+     * Compiles the shader on the calling thread if
+     * necessary, or waits for it to get compiled.
+     * \returns The compiled shader
+     */
+    const D3D9CommonShader& GetShader() {
+      if (likely(m_state.load(std::memory_order_acquire) == State::Done))
+        return m_shader;
+
+      return WaitForShader();
+    }
+
+    /**
+     * \brief Retrieves shader bytecode
+     * \returns Copy of the original bytecode
+     */
+    const std::vector<uint8_t>& GetBytecode() const {
+      return m_bytecode;
+    }
+
+  private:
+
+    enum class State : uint32_t {
+      Pending,
+      Running,
+      Done,
+    };
+
+    D3D9DeviceEx*             m_device;
+    D3D9ShaderCache*          m_cache;
+
+    VkShaderStageFlagBits     m_stage;
+    DxvkShaderKey             m_shaderKey;
+    DxsoModuleInfo            m_moduleInfo;
+    DxsoAnalysisInfo          m_analysis;
+
+    // The module only references the bytecode,
+    // so we need to keep our own copy around
+    std::vector<uint8_t>      m_bytecode;
+
+    std::atomic<State>        m_state = { State::Pending };
+
+    dxvk::mutex               m_mutex;
+    dxvk::condition_variable  m_cond;
+
+    D3D9CommonShader          m_shader;
+
+    const D3D9CommonShader& WaitForShader();
+
   };
 
   /**
@@ -166,12 +303,20 @@ namespace dxvk {
    * 
    * Some applications may compile the same shader multiple
    * times, so we should cache the resulting shader modules
-   * and reuse them rather than creating new ones. This
-   * class is thread-safe.
+   * and reuse them rather than creating new ones. New shaders
+   * are looked up in the disk cache, and translated on the
+   * device's compiler threads if asynchronous compilation is
+   * enabled. This class is thread-safe.
    */
   class D3D9ShaderModuleSet : public RcObject {
     
   public:
+
+    D3D9ShaderModuleSet(
+      const Rc<DxvkDevice>&       Device,
+            bool                  AsyncCompile);
+
+    ~D3D9ShaderModuleSet();
     
     void GetShaderModule(
             D3D9DeviceEx*         pDevice,
@@ -188,6 +333,11 @@ namespace dxvk {
       DxvkShaderKey,
       D3D9CommonShader,
       DxvkHash, DxvkEq> m_modules;
+
+    Rc<DxvkDevice>  m_device;
+    D3D9ShaderCache m_cache;
+
+    bool            m_asyncCompile;
     
   };
 
@@ -0,0 +1,133 @@
+#include "d3d9_shader_cache.h"
+
+namespace dxvk {
+
+  D3D9ShaderCache::D3D9ShaderCache(
+    const Rc<DxvkDevice>&         Device)
+  : m_cache(Device, ".dxvk-d3d9cache") {
+
+  }
+
+
+  D3D9ShaderCache::~D3D9ShaderCache() {
+
+  }
+
+
+  DxvkShaderKey D3D9ShaderCache::ComputeKey(
+    const DxvkShaderKey&          ShaderKey,
+    const DxsoModuleInfo&         ModuleInfo,
+    const D3D9ConstantLayout&     Layout) {
+    const DxsoOptions& options = ModuleInfo.options;
+
+    // Don't hash the options struct directly since it contains
+    // padding. The constant layout depends on whether the device
+    // supports software vertex processing, so include it as well.
+    std::array<uint32_t, 17> data = {{
+      CacheVersion,
+      uint32_t(options.useDemoteToHelperInvocation),
+      uint32_t(options.useSubgroupOpsForEarlyDiscard),
+      uint32_t(options.strictConstantCopies),
+      uint32_t(options.d3d9FloatEmulation),
+      uint32_t(options.strictPow),
+      uint32_t(options.shaderModel),
+      uint32_t(options.invariantPosition),
+      uint32_t(options.forceSamplerTypeSpecConstants),
+      uint32_t(options.vertexFloatConstantBufferAsSSBO),
+      uint32_t(options.longMad),
+      uint32_t(options.alphaTestWiggleRoom),
+      uint32_t(options.robustness2Supported),
+      Layout.floatCount,
+      Layout.intCount,
+      Layout.boolCount,
+      Layout.bitmaskCount }};
+
+    Sha1Hash sha1 = ShaderKey.sha1();
+
+    std::array<Sha1Data, 2> chunks = {{
+      { &sha1,       sizeof(sha1) },
+      { data.data(), sizeof(data) },
+    }};
+
+    return DxvkShaderKey(VkShaderStageFlagBits(ShaderKey.type()),
+      Sha1Hash::compute(chunks.size(), chunks.data()));
+  }
+
+
+  bool D3D9ShaderCache::LookupShader(
+    const DxvkShaderKey&          Key,
+          DxsoPermutations*       pShaders,
+          std::vector<uint8_t>*   pMetadata) {
+    // The first permutation stores a mask of all permutations
+    // that exist for the shader, followed by the metadata
+    std::vector<uint8_t> data;
+    uint32_t mask = 0;
+
+    Rc<DxvkShader> shader = m_cache.lookupShader(Key, &data);
+
+    if (shader == nullptr || data.size() < sizeof(mask))
+      return false;
+
+    std::memcpy(&mask, data.data(), sizeof(mask));
+
+    DxsoPermutations shaders = { };
+    shaders[D3D9ShaderPermutations::None] = std::move(shader);
+
+    for (uint32_t i = 1; i < shaders.size(); i++) {
+      if (!(mask & (1u << i)))
+        continue;
+
+      shaders[i] = m_cache.lookupShader(GetPermutationKey(Key, i));
+
+      if (shaders[i] == nullptr)
+        return false;
+    }
+
+    *pShaders = std::move(shaders);
+    pMetadata->assign(data.begin() + sizeof(mask), data.end());
+    return true;
+  }
+
+
+  void D3D9ShaderCache::StoreShader(
+    const DxvkShaderKey&          Key,
+    const DxsoPermutations&       Shaders,
+    const std::vector<uint8_t>&   Metadata) {
+    if (!m_cache.isEnabled())
+      return;
+
+    // Store the first permutation last, so that lookups
+    // never find an entry whose permutations are missing
+    uint32_t mask = 0;
+
+    for (uint32_t i = 1; i < Shaders.size(); i++) {
+      if (Shaders[i] == nullptr)
+        continue;
+
+      m_cache.storeShader(GetPermutationKey(Key, i), Shaders[i]);
+      mask |= 1u << i;
+    }
+
+    std::vector<uint8_t> data(sizeof(mask) + Metadata.size());
+    std::memcpy(data.data(), &mask, sizeof(mask));
+    std::memcpy(data.data() + sizeof(mask), Metadata.data(), Metadata.size());
+
+    m_cache.storeShader(Key, Shaders[D3D9ShaderPermutations::None], data);
+  }
+
+
+  DxvkShaderKey D3D9ShaderCache::GetPermutationKey(
+    const DxvkShaderKey&          Key,
+          uint32_t                Permutation) {
+    Sha1Hash sha1 = Key.sha1();
+
+    std::array<Sha1Data, 2> chunks = {{
+      { &sha1,        sizeof(sha1)        },
+      { &Permutation, sizeof(Permutation) },
+    }};
+
+    return DxvkShaderKey(VkShaderStageFlagBits(Key.type()),
+      Sha1Hash::compute(chunks.size(), chunks.data()));
+  }
+
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "d3d9_constant_layout.h"
+#include "d3d9_shader_permutations.h"
+
+#include "../dxso/dxso_modinfo.h"
+#include "../dxvk/dxvk_device.h"
+#include "../dxvk/dxvk_shader_cache.h"
+
+namespace dxvk {
+
+  /**
+   * \brief Translated shader cache
+   *
+   * Stores translated DXSO shaders on disk, including
+   * all permutations and the shader metadata that the
+   * device needs, so that shaders do not have to be
+   * translated again on subsequent runs. See
+   * \ref DxvkShaderCache.
+   */
+  class D3D9ShaderCache {
+    /// Bump this when changing dxso_compiler.cpp
+    constexpr static uint32_t CacheVersion = 1;
+  public:
+
+    D3D9ShaderCache(
+      const Rc<DxvkDevice>&         Device);
+
+    ~D3D9ShaderCache();
+
+    /**
+     * \brief Checks whether the cache is enabled
+     * \returns \c true if shaders are cached
+     */
+    bool IsEnabled() const {
+      return m_cache.isEnabled();
+    }
+
+    /**
+     * \brief Computes cache key
+     *
+     * Takes all compiler options into account
+     * that may affect the generated code.
+     * \param [in] ShaderKey Unique shader key
+     * \param [in] ModuleInfo Module info
+     * \param [in] Layout Constant buffer layout
+     * \returns Key for cache lookups
+     */
+    static DxvkShaderKey ComputeKey(
+      const DxvkShaderKey&          ShaderKey,
+      const DxsoModuleInfo&         ModuleInfo,
+      const D3D9ConstantLayout&     Layout);
+
+    /**
+     * \brief Looks up a shader
+     *
+     * \param [in] Key Cache key
+     * \param [out] pShaders Shader permutations
+     * \param [out] pMetadata Shader metadata
+     * \returns \c true if all permutations
+     *    of the shader were found
+     */
+    bool LookupShader(
+      const DxvkShaderKey&          Key,
+            DxsoPermutations*       pShaders,
+            std::vector<uint8_t>*   pMetadata);
+
+    /**
+     * \brief Adds a shader to the cache
+     *
+     * Does nothing if the shader is already cached.
+     * \param [in] Key Cache key
+     * \param [in] Shaders Shader permutations
+     * \param [in] Metadata Shader metadata
+     */
+    void StoreShader(
+      const DxvkShaderKey&          Key,
+      const DxsoPermutations&       Shaders,
+      const std::vector<uint8_t>&   Metadata);
+
+  private:
+
+    DxvkShaderCache               m_cache;
+
+    static DxvkShaderKey GetPermutationKey(
+      const DxvkShaderKey&          Key,
+            uint32_t                Permutation);
+
+  };
+
+}
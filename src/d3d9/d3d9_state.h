@@ -137,8 +137,19 @@ namespace dxvk {
   };
 
 
+  struct D3D9FixedFunctionPSStage {
+    uint32_t ops;       // Color op, alpha op, result arg
+    uint32_t colorArgs; // Color args 0-2
+    uint32_t alphaArgs; // Alpha args 0-2
+    uint32_t flags;     // Global state, stage 0 only
+  };
+
+
   struct D3D9FixedFunctionPS {
     Vector4 textureFactor;
+
+    // Only used by the uber shader
+    std::array<D3D9FixedFunctionPSStage, caps::TextureStageCount> stages;
   };
 
   enum D3D9SharedPSStages {
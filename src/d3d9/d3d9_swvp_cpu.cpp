@@ -0,0 +1,422 @@
+#include "d3d9_swvp_cpu.h"
+
+#include "d3d9_vertex_declaration.h"
+
+namespace dxvk {
+
+  static float ConvertHalfToFloat(uint16_t Value) {
+    uint32_t sign = uint32_t(Value & 0x8000) << 16;
+    uint32_t exp  = (Value >> 10) & 0x1f;
+    uint32_t mant = Value & 0x3ff;
+
+    if (exp == 0) {
+      // Zero or denormal, which is mant * 2^-24
+      float result = float(mant) * (1.0f / 16777216.0f);
+      return sign ? -result : result;
+    }
+
+    uint32_t bits = exp == 0x1f
+      ? sign | 0x7f800000u | (mant << 13)
+      : sign | ((exp + 112) << 23) | (mant << 13);
+
+    return bit::cast<float>(bits);
+  }
+
+
+  static uint16_t ConvertFloatToHalf(float Value) {
+    uint32_t bits = bit::cast<uint32_t>(Value);
+    uint32_t sign = (bits >> 16) & 0x8000;
+    uint32_t mant = bits & 0x7fffff;
+    int32_t  exp  = int32_t((bits >> 23) & 0xff) - 112;
+
+    if (((bits >> 23) & 0xff) == 0xff)
+      return uint16_t(sign | 0x7c00 | (mant ? 0x200 : 0));
+
+    if (exp >= 0x1f)
+      return uint16_t(sign | 0x7c00);
+
+    if (exp <= 0) {
+      if (exp < -10)
+        return uint16_t(sign);
+
+      uint32_t shift = uint32_t(14 - exp);
+      mant |= 0x800000;
+      return uint16_t(sign | ((mant + (1u << (shift - 1))) >> shift));
+    }
+
+    // Rounding may carry into the exponent, which is correct
+    uint32_t result = sign | (uint32_t(exp) << 10) | (mant >> 13);
+    return uint16_t(result + ((mant >> 12) & 1));
+  }
+
+
+  static int32_t ConvertFloatToInt(float Value, float Min, float Max) {
+    return int32_t(std::round(std::clamp(Value, Min, Max)));
+  }
+
+
+  static Vector4 DecodeElement(
+          D3DDECLTYPE             Type,
+    const uint8_t*                pData) {
+    Vector4 result(0.0f, 0.0f, 0.0f, 1.0f);
+
+    switch (Type) {
+      case D3DDECLTYPE_FLOAT1:
+      case D3DDECLTYPE_FLOAT2:
+      case D3DDECLTYPE_FLOAT3:
+      case D3DDECLTYPE_FLOAT4:
+        std::memcpy(result.data, pData, GetDecltypeSize(Type));
+        break;
+
+      case D3DDECLTYPE_D3DCOLOR:
+        result = Vector4(
+          float(pData[2]) / 255.0f, float(pData[1]) / 255.0f,
+          float(pData[0]) / 255.0f, float(pData[3]) / 255.0f);
+        break;
+
+      case D3DDECLTYPE_UBYTE4:
+      case D3DDECLTYPE_UBYTE4N: {
+        float scale = Type == D3DDECLTYPE_UBYTE4N ? 1.0f / 255.0f : 1.0f;
+
+        for (uint32_t i = 0; i < 4; i++)
+          result[i] = float(pData[i]) * scale;
+      } break;
+
+      case D3DDECLTYPE_SHORT2:
+      case D3DDECLTYPE_SHORT4:
+      case D3DDECLTYPE_SHORT2N:
+      case D3DDECLTYPE_SHORT4N: {
+        bool normalized = Type == D3DDECLTYPE_SHORT2N || Type == D3DDECLTYPE_SHORT4N;
+
+        for (uint32_t i = 0; i < GetDecltypeCount(Type); i++) {
+          int16_t value;
+          std::memcpy(&value, pData + i * sizeof(value), sizeof(value));
+
+          result[i] = normalized
+            ? std::max(float(value) / 32767.0f, -1.0f)
+            : float(value);
+        }
+      } break;
+
+      case D3DDECLTYPE_USHORT2N:
+      case D3DDECLTYPE_USHORT4N: {
+        for (uint32_t i = 0; i < GetDecltypeCount(Type); i++) {
+          uint16_t value;
+          std::memcpy(&value, pData + i * sizeof(value), sizeof(value));
+          result[i] = float(value) / 65535.0f;
+        }
+      } break;
+
+      case D3DDECLTYPE_UDEC3:
+      case D3DDECLTYPE_DEC3N: {
+        uint32_t value;
+        std::memcpy(&value, pData, sizeof(value));
+
+        for (uint32_t i = 0; i < 3; i++) {
+          uint32_t bits = (value >> (10 * i)) & 0x3ff;
+
+          result[i] = Type == D3DDECLTYPE_DEC3N
+            ? std::max(float(int32_t(bits << 22) >> 22) / 511.0f, -1.0f)
+            : float(bits);
+        }
+      } break;
+
+      case D3DDECLTYPE_FLOAT16_2:
+      case D3DDECLTYPE_FLOAT16_4: {
+        for (uint32_t i = 0; i < GetDecltypeCount(Type); i++) {
+          uint16_t value;
+          std::memcpy(&value, pData + i * sizeof(value), sizeof(value));
+          result[i] = ConvertHalfToFloat(value);
+        }
+      } break;
+
+      default:
+        break;
+    }
+
+    return result;
+  }
+
+
+  static void EncodeElement(
+          D3DDECLTYPE             Type,
+    const Vector4&                Value,
+          uint8_t*                pData) {
+    switch (Type) {
+      case D3DDECLTYPE_FLOAT1:
+      case D3DDECLTYPE_FLOAT2:
+      case D3DDECLTYPE_FLOAT3:
+      case D3DDECLTYPE_FLOAT4:
+        std::memcpy(pData, Value.data, GetDecltypeSize(Type));
+        break;
+
+      case D3DDECLTYPE_D3DCOLOR: {
+        std::array<uint32_t, 4> indices = { 2, 1, 0, 3 };
+
+        for (uint32_t i = 0; i < 4; i++)
+          pData[i] = uint8_t(ConvertFloatToInt(Value[indices[i]] * 255.0f, 0.0f, 255.0f));
+      } break;
+
+      case D3DDECLTYPE_UBYTE4:
+      case D3DDECLTYPE_UBYTE4N: {
+        float scale = Type == D3DDECLTYPE_UBYTE4N ? 255.0f : 1.0f;
+
+        for (uint32_t i = 0; i < 4; i++)
+          pData[i] = uint8_t(ConvertFloatToInt(Value[i] * scale, 0.0f, 255.0f));
+      } break;
+
+      case D3DDECLTYPE_SHORT2:
+      case D3DDECLTYPE_SHORT4:
+      case D3DDECLTYPE_SHORT2N:
+      case D3DDECLTYPE_SHORT4N: {
+        bool normalized = Type == D3DDECLTYPE_SHORT2N || Type == D3DDECLTYPE_SHORT4N;
+
+        for (uint32_t i = 0; i < GetDecltypeCount(Type); i++) {
+          int16_t value = normalized
+            ? int16_t(ConvertFloatToInt(Value[i] * 32767.0f, -32767.0f, 32767.0f))
+            : int16_t(ConvertFloatToInt(Value[i], -32768.0f, 32767.0f));
+          std::memcpy(pData + i * sizeof(value), &value, sizeof(value));
+        }
+      } break;
+
+      case D3DDECLTYPE_USHORT2N:
+      case D3DDECLTYPE_USHORT4N: {
+        for (uint32_t i = 0; i < GetDecltypeCount(Type); i++) {
+          uint16_t value = uint16_t(ConvertFloatToInt(Value[i] * 65535.0f, 0.0f, 65535.0f));
+          std::memcpy(pData + i * sizeof(value), &value, sizeof(value));
+        }
+      } break;
+
+      case D3DDECLTYPE_UDEC3:
+      case D3DDECLTYPE_DEC3N: {
+        uint32_t value = 0;
+
+        for (uint32_t i = 0; i < 3; i++) {
+          int32_t bits = Type == D3DDECLTYPE_DEC3N
+            ? ConvertFloatToInt(Value[i] * 511.0f, -511.0f, 511.0f)
+            : ConvertFloatToInt(Value[i], 0.0f, 1023.0f);
+          value |= (uint32_t(bits) & 0x3ff) << (10 * i);
+        }
+
+        std::memcpy(pData, &value, sizeof(value));
+      } break;
+
+      case D3DDECLTYPE_FLOAT16_2:
+      case D3DDECLTYPE_FLOAT16_4: {
+        for (uint32_t i = 0; i < GetDecltypeCount(Type); i++) {
+          uint16_t value = ConvertFloatToHalf(Value[i]);
+          std::memcpy(pData + i * sizeof(value), &value, sizeof(value));
+        }
+      } break;
+
+      default:
+        break;
+    }
+  }
+
+
+  static const D3DVERTEXELEMENT9* FindElement(
+    const D3D9VertexDecl*         pDecl,
+          BYTE                    Usage,
+          BYTE                    UsageIndex) {
+    for (const auto& element : pDecl->GetElements()) {
+      if (element.Usage == Usage && element.UsageIndex == UsageIndex)
+        return &element;
+    }
+
+    return nullptr;
+  }
+
+
+  void D3D9SWVPCpuProcessor::ProcessVertices(
+    const D3D9SWVPCpuState&       State,
+    const D3D9VertexDecl*         pSrcDecl,
+    const D3D9VertexDecl*         pDstDecl,
+          UINT                    SrcStartIndex,
+          UINT                    VertexCount,
+          uint8_t*                pDstData,
+          DWORD                   Flags) {
+    const uint32_t dstStride = pDstDecl->GetSize();
+
+    // Positions are transformed separately since they
+    // are the only element that requires any math
+    const D3DVERTEXELEMENT9* dstPos = FindElement(pDstDecl, D3DDECLUSAGE_POSITIONT, 0);
+
+    if (dstPos == nullptr)
+      dstPos = FindElement(pDstDecl, D3DDECLUSAGE_POSITION, 0);
+
+    const D3DVERTEXELEMENT9* srcPos = FindElement(pSrcDecl, D3DDECLUSAGE_POSITIONT, 0);
+    bool transform = srcPos == nullptr;
+
+    if (transform)
+      srcPos = FindElement(pSrcDecl, D3DDECLUSAGE_POSITION, 0);
+
+    ElementCopy posCopy = { };
+    posCopy.SrcStream = srcPos ? srcPos->Stream : caps::MaxStreams;
+    posCopy.SrcOffset = srcPos ? srcPos->Offset : 0;
+    posCopy.SrcType   = srcPos ? D3DDECLTYPE(srcPos->Type) : D3DDECLTYPE_UNUSED;
+    posCopy.Default   = Vector4(0.0f, 0.0f, 0.0f, 1.0f);
+
+    BuildElementCopies(State, pSrcDecl, pDstDecl, Flags);
+
+    for (uint32_t first = 0; first < VertexCount; first += BatchSize) {
+      uint32_t count = std::min(VertexCount - first, BatchSize);
+      uint8_t* dstBatch = pDstData + first * dstStride;
+
+      if (dstPos != nullptr) {
+        for (uint32_t i = 0; i < count; i++)
+          m_positions[i] = ReadElement(State, posCopy, SrcStartIndex + first + i);
+
+        if (transform)
+          TransformPositions(State, count, m_positions.data());
+
+        for (uint32_t i = 0; i < count; i++) {
+          EncodeElement(D3DDECLTYPE(dstPos->Type), m_positions[i],
+            dstBatch + i * dstStride + dstPos->Offset);
+        }
+      }
+
+      for (uint32_t i = 0; i < count; i++) {
+        uint8_t* dstVertex = dstBatch + i * dstStride;
+
+        for (const auto& copy : m_copies) {
+          EncodeElement(copy.DstType,
+            ReadElement(State, copy, SrcStartIndex + first + i),
+            dstVertex + copy.DstOffset);
+        }
+      }
+    }
+  }
+
+
+  void D3D9SWVPCpuProcessor::BuildElementCopies(
+    const D3D9SWVPCpuState&       State,
+    const D3D9VertexDecl*         pSrcDecl,
+    const D3D9VertexDecl*         pDstDecl,
+          DWORD                   Flags) {
+    m_copies.clear();
+
+    if (Flags & D3DPV_DONOTCOPYDATA)
+      return;
+
+    for (const auto& dstElement : pDstDecl->GetElements()) {
+      if ((dstElement.Usage == D3DDECLUSAGE_POSITION
+        || dstElement.Usage == D3DDECLUSAGE_POSITIONT)
+       && dstElement.UsageIndex == 0)
+        continue;
+
+      // Texture coordinates are selected by the texture
+      // stage, other elements are passed through as-is
+      BYTE srcUsageIndex = dstElement.UsageIndex;
+
+      if (dstElement.Usage == D3DDECLUSAGE_TEXCOORD && dstElement.UsageIndex < caps::TextureStageCount)
+        srcUsageIndex = BYTE(State.TexcoordIndices[dstElement.UsageIndex] & 0b111);
+
+      const D3DVERTEXELEMENT9* srcElement = FindElement(
+        pSrcDecl, dstElement.Usage, srcUsageIndex);
+
+      ElementCopy copy;
+      copy.SrcStream = srcElement ? srcElement->Stream : caps::MaxStreams;
+      copy.SrcOffset = srcElement ? srcElement->Offset : 0;
+      copy.SrcType   = srcElement ? D3DDECLTYPE(srcElement->Type) : D3DDECLTYPE_UNUSED;
+      copy.DstOffset = dstElement.Offset;
+      copy.DstType   = D3DDECLTYPE(dstElement.Type);
+      copy.Default   = Vector4(0.0f, 0.0f, 0.0f, 1.0f);
+
+      // Missing colors default to white diffuse and black specular
+      if (dstElement.Usage == D3DDECLUSAGE_COLOR) {
+        copy.Default = dstElement.UsageIndex == 0
+          ? Vector4(1.0f, 1.0f, 1.0f, 1.0f)
+          : Vector4(0.0f, 0.0f, 0.0f, 0.0f);
+      }
+
+      m_copies.push_back(copy);
+    }
+  }
+
+
+  void D3D9SWVPCpuProcessor::TransformPositions(
+    const D3D9SWVPCpuState&       State,
+          uint32_t                Count,
+          Vector4*                pPositions) {
+    const Matrix4& m = State.WorldViewProj;
+    const D3DVIEWPORT9& vp = State.Viewport;
+
+    std::array<std::array<__m128, 4>, 4> matrix;
+
+    for (uint32_t i = 0; i < 4; i++) {
+      for (uint32_t j = 0; j < 4; j++)
+        matrix[i][j] = _mm_set1_ps(m[i][j]);
+    }
+
+    float halfW = 0.5f * float(vp.Width);
+    float halfH = 0.5f * float(vp.Height);
+
+    const __m128 scaleX  = _mm_set1_ps( halfW);
+    const __m128 scaleY  = _mm_set1_ps(-halfH);
+    const __m128 scaleZ  = _mm_set1_ps(vp.MaxZ - vp.MinZ);
+    const __m128 offsetX = _mm_set1_ps(float(vp.X) + halfW);
+    const __m128 offsetY = _mm_set1_ps(float(vp.Y) + halfH);
+    const __m128 offsetZ = _mm_set1_ps(vp.MinZ);
+
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one  = _mm_set1_ps(1.0f);
+
+    // Process four vertices at a time in SoA layout. The
+    // position array is padded to a multiple of four, so
+    // reading past the end of the batch is fine.
+    for (uint32_t i = 0; i < Count; i += 4) {
+      __m128 x = _mm_loadu_ps(pPositions[i + 0].data);
+      __m128 y = _mm_loadu_ps(pPositions[i + 1].data);
+      __m128 z = _mm_loadu_ps(pPositions[i + 2].data);
+      __m128 w = _mm_loadu_ps(pPositions[i + 3].data);
+
+      _MM_TRANSPOSE4_PS(x, y, z, w);
+
+      std::array<__m128, 4> v;
+
+      for (uint32_t j = 0; j < 4; j++) {
+        v[j] = _mm_add_ps(
+          _mm_add_ps(_mm_mul_ps(matrix[0][j], x), _mm_mul_ps(matrix[1][j], y)),
+          _mm_add_ps(_mm_mul_ps(matrix[2][j], z), _mm_mul_ps(matrix[3][j], w)));
+      }
+
+      // rhw = w == 0 ? 1 : 1 / w
+      __m128 isZero = _mm_cmpeq_ps(v[3], zero);
+      __m128 rhw    = _mm_div_ps(one, v[3]);
+             rhw    = _mm_or_ps(_mm_and_ps(isZero, one), _mm_andnot_ps(isZero, rhw));
+
+      x = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(v[0], rhw), scaleX), offsetX);
+      y = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(v[1], rhw), scaleY), offsetY);
+      z = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(v[2], rhw), scaleZ), offsetZ);
+      w = rhw;
+
+      _MM_TRANSPOSE4_PS(x, y, z, w);
+
+      _mm_storeu_ps(pPositions[i + 0].data, x);
+      _mm_storeu_ps(pPositions[i + 1].data, y);
+      _mm_storeu_ps(pPositions[i + 2].data, z);
+      _mm_storeu_ps(pPositions[i + 3].data, w);
+    }
+  }
+
+
+  Vector4 D3D9SWVPCpuProcessor::ReadElement(
+    const D3D9SWVPCpuState&       State,
+    const ElementCopy&            Copy,
+          uint32_t                Index) {
+    if (Copy.SrcStream >= caps::MaxStreams)
+      return Copy.Default;
+
+    const D3D9SWVPCpuStream& stream = State.Streams[Copy.SrcStream];
+
+    size_t offset = size_t(Index) * stream.Stride + Copy.SrcOffset;
+    size_t size   = GetDecltypeSize(Copy.SrcType);
+
+    if (stream.pData == nullptr || offset + size > stream.Size)
+      return Copy.Default;
+
+    return DecodeElement(Copy.SrcType, stream.pData + offset);
+  }
+
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "d3d9_caps.h"
+#include "d3d9_include.h"
+
+#include "../util/util_matrix.h"
+
+namespace dxvk {
+
+  class D3D9VertexDecl;
+
+  /**
+   * \brief Source vertex stream
+   *
+   * Points to the vertex data of a bound vertex buffer,
+   * starting at the stream offset. Elements that lie
+   * outside of the given size are treated as unbound.
+   */
+  struct D3D9SWVPCpuStream {
+    const uint8_t* pData  = nullptr;
+    uint32_t       Size   = 0;
+    uint32_t       Stride = 0;
+  };
+
+
+  /**
+   * \brief State for CPU vertex processing
+   *
+   * Stores the subset of the fixed-function state
+   * that is required to process vertices on the CPU.
+   */
+  struct D3D9SWVPCpuState {
+    Matrix4       WorldViewProj;
+    D3DVIEWPORT9  Viewport;
+
+    std::array<uint32_t, caps::TextureStageCount> TexcoordIndices;
+    std::array<D3D9SWVPCpuStream, caps::MaxStreams> Streams;
+  };
+
+
+  /**
+   * \brief CPU vertex processor
+   *
+   * Implements \c ProcessVertices for the fixed-function
+   * pipeline without lighting, vertex blending or texture
+   * coordinate generation. Positions are transformed to
+   * screen space in batches using SSE, all other elements
+   * are converted to the destination format and copied.
+   *
+   * This is used if the device does not support the
+   * geometry shader based SWVP emulation, and for small
+   * batches where waiting for the GPU to write the
+   * destination buffer would be more expensive.
+   */
+  class D3D9SWVPCpuProcessor {
+    constexpr static uint32_t BatchSize = 64;
+  public:
+
+    /**
+     * \brief Processes vertices
+     *
+     * \param [in] State Fixed-function state and vertex streams
+     * \param [in] pSrcDecl Vertex declaration of the source streams
+     * \param [in] pDstDecl Vertex declaration of the destination
+     * \param [in] SrcStartIndex Index of the first source vertex
+     * \param [in] VertexCount Number of vertices to process
+     * \param [out] pDstData Destination vertex data
+     * \param [in] Flags \c D3DPV_* flags
+     */
+    void ProcessVertices(
+      const D3D9SWVPCpuState&       State,
+      const D3D9VertexDecl*         pSrcDecl,
+      const D3D9VertexDecl*         pDstDecl,
+            UINT                    SrcStartIndex,
+            UINT                    VertexCount,
+            uint8_t*                pDstData,
+            DWORD                   Flags);
+
+  private:
+
+    struct ElementCopy {
+      uint32_t    SrcStream;
+      uint32_t    SrcOffset;
+      D3DDECLTYPE SrcType;
+      uint32_t    DstOffset;
+      D3DDECLTYPE DstType;
+      Vector4     Default;
+    };
+
+    std::vector<ElementCopy>        m_copies;
+    std::array<Vector4, BatchSize>  m_positions;
+
+    void BuildElementCopies(
+      const D3D9SWVPCpuState&       State,
+      const D3D9VertexDecl*         pSrcDecl,
+      const D3D9VertexDecl*         pDstDecl,
+            DWORD                   Flags);
+
+    static void TransformPositions(
+      const D3D9SWVPCpuState&       State,
+            uint32_t                Count,
+            Vector4*                pPositions);
+
+    static Vector4 ReadElement(
+      const D3D9SWVPCpuState&       State,
+      const ElementCopy&            Copy,
+            uint32_t                Index);
+
+  };
+
+}
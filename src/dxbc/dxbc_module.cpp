@@ -43,8 +43,15 @@ namespace dxvk {
   Rc<DxvkShader> DxbcModule::compile(
     const DxbcModuleInfo& moduleInfo,
     const std::string&    fileName) const {
+    DxbcAnalysisInfo analysisInfo = this->analyze(moduleInfo);
+    return this->compile(moduleInfo, analysisInfo, fileName);
+  }
+  
+  
+  DxbcAnalysisInfo DxbcModule::analyze(
+    const DxbcModuleInfo& moduleInfo) const {
     if (m_shexChunk == nullptr)
-      throw DxvkError("DxbcModule::compile: No SHDR/SHEX chunk");
+      throw DxvkError("DxbcModule::analyze: No SHDR/SHEX chunk");
     
     DxbcAnalysisInfo analysisInfo;
     
@@ -54,6 +61,16 @@ namespace dxvk {
       m_psgnChunk, analysisInfo);
     
     this->runAnalyzer(analyzer, m_shexChunk->slice());
+    return analysisInfo;
+  }
+  
+  
+  Rc<DxvkShader> DxbcModule::compile(
+    const DxbcModuleInfo&   moduleInfo,
+    const DxbcAnalysisInfo& analysisInfo,
+    const std::string&      fileName) const {
+    if (m_shexChunk == nullptr)
+      throw DxvkError("DxbcModule::compile: No SHDR/SHEX chunk");
     
     DxbcCompiler compiler(
       fileName, moduleInfo,
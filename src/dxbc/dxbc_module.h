@@ -2,6 +2,7 @@
 
 #include "../dxvk/dxvk_shader.h"
 
+#include "dxbc_analysis.h"
 #include "dxbc_chunk_isgn.h"
 #include "dxbc_chunk_shex.h"
 #include "dxbc_header.h"
@@ -59,6 +60,33 @@ namespace dxvk {
     Rc<DxvkShader> compile(
       const DxbcModuleInfo& moduleInfo,
       const std::string&    fileName) const;
+
+    /**
+     * \brief Analyzes the shader
+     *
+     * Decodes the entire instruction stream and gathers
+     * information required for compilation. Throws if
+     * the shader is invalid, so this can be used to
+     * validate a shader before compiling it later.
+     * \param [in] moduleInfo DXBC module info
+     * \returns Analysis info for \ref compile
+     */
+    DxbcAnalysisInfo analyze(
+      const DxbcModuleInfo& moduleInfo) const;
+
+    /**
+     * \brief Compiles analyzed DXBC shader to SPIR-V module
+     *
+     * \param [in] moduleInfo DXBC module info
+     * \param [in] analysisInfo Result of \ref analyze
+     * \param [in] fileName File name, will be added to
+     *        the compiled SPIR-V for debugging purposes.
+     * \returns The compiled shader object
+     */
+    Rc<DxvkShader> compile(
+      const DxbcModuleInfo&   moduleInfo,
+      const DxbcAnalysisInfo& analysisInfo,
+      const std::string&      fileName) const;
     
     /**
      * \brief Compiles a pass-through geometry shader
@@ -233,6 +233,14 @@ namespace dxvk {
         m_bufBarriers.data(),
         m_imgBarriers.size(),
         m_imgBarriers.data());
+
+      // Count individual barriers, with pure execution
+      // dependencies counting as one barrier as well
+      uint32_t barrierCount = (pMemBarrier ? 1 : 0)
+        + m_bufBarriers.size() + m_imgBarriers.size();
+
+      commandList->addStatCtr(DxvkStatCounter::CmdBarrierCount,
+        std::max(barrierCount, 1u));
       
       this->reset();
     }
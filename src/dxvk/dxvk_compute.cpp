@@ -67,6 +67,7 @@ namespace dxvk {
   
   DxvkComputePipelineInstance* DxvkComputePipeline::createInstance(
     const DxvkComputePipelineStateInfo& state) {
+    DxvkTraceScope trace(m_pipeMgr->m_device->tracer(), "pipeline", "CompileComputePipeline");
     VkPipeline newPipelineHandle = this->createPipeline(state);
 
     m_pipeMgr->m_numComputePipelines += 1;
@@ -77,6 +77,13 @@ namespace dxvk {
     m_initBarriers.recordCommands(m_cmd);
     m_execBarriers.recordCommands(m_cmd);
 
+    m_cmd->statCounters().merge(m_staging.takeStatCounters());
+
+    // Cached descriptor sets may reference resources
+    // that are only kept alive by this command list
+    m_descCache.clear();
+    this->updateDescriptorPoolSize();
+
     m_cmd->endRecording();
     return std::exchange(m_cmd, nullptr);
   }
@@ -2206,6 +2213,112 @@ namespace dxvk {
       buffer->info().access);
 
     m_cmd->trackResource<DxvkAccess::Write>(buffer);
+
+    m_cmd->addStatCtr(DxvkStatCounter::CmdBufferUpdates, 1);
+    m_cmd->addStatCtr(DxvkStatCounter::CmdBufferUpdateCopies, 1);
+    m_cmd->addStatCtr(DxvkStatCounter::CmdBufferUpdateBytes, size);
+  }
+  
+  
+  void DxvkContext::updateBuffers(
+          uint32_t                  count,
+    const DxvkBufferUpdate*         updates) {
+    // Full updates of device-local buffers are handled by
+    // the regular code path since they replace the buffer
+    // in the init command buffer and never need staging.
+    auto isReplaced = [] (const DxvkBufferSlice& slice) {
+      return slice.length() == slice.buffer()->info().size
+          && slice.length() <= (1 << 20)
+          && !(slice.buffer()->memFlags() & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+    };
+
+    VkDeviceSize stagingSize = 0;
+
+    for (uint32_t i = 0; i < count; i++) {
+      if (!isReplaced(updates[i].dstSlice))
+        stagingSize += align(updates[i].dstSlice.length(), 16);
+    }
+
+    DxvkBufferSliceHandle stagingHandle;
+
+    if (stagingSize) {
+      this->spillRenderPass(true);
+
+      auto stagingSlice = m_staging.alloc(CACHE_LINE_SIZE, stagingSize);
+      stagingHandle = stagingSlice.getSliceHandle();
+
+      m_cmd->trackResource<DxvkAccess::Read>(stagingSlice.buffer());
+    }
+
+    VkDeviceSize stagingOffset = 0;
+    VkDeviceSize copyBytes     = 0;
+    VkBuffer     copyBuffer    = VK_NULL_HANDLE;
+
+    small_vector<VkBufferCopy, 16> copyRegions;
+    uint32_t                       copyFirst = 0;
+    uint32_t                       copyCount = 0;
+
+    auto flushCopies = [&] () {
+      if (copyFirst == copyRegions.size())
+        return;
+
+      m_cmd->cmdCopyBuffer(DxvkCmdBuffer::ExecBuffer,
+        stagingHandle.handle, copyBuffer,
+        copyRegions.size() - copyFirst,
+        &copyRegions[copyFirst]);
+
+      copyFirst = copyRegions.size();
+      copyCount += 1;
+    };
+
+    for (uint32_t i = 0; i < count; i++) {
+      const auto& dstSlice = updates[i].dstSlice;
+
+      if (isReplaced(dstSlice)) {
+        this->updateBuffer(dstSlice.buffer(), dstSlice.offset(),
+          dstSlice.length(), updates[i].srcData.ptr());
+        continue;
+      }
+
+      auto dstHandle = dstSlice.getSliceHandle();
+
+      // Copies within a single command must not depend on each other,
+      // so submit pending copies before emitting any required barrier
+      if (m_execBarriers.isBufferDirty(dstHandle, DxvkAccess::Write)) {
+        flushCopies();
+        m_execBarriers.recordCommands(m_cmd);
+      } else if (dstHandle.handle != copyBuffer) {
+        flushCopies();
+      }
+
+      std::memcpy(reinterpret_cast<char*>(stagingHandle.mapPtr) + stagingOffset,
+        updates[i].srcData.ptr(), dstHandle.length);
+
+      VkBufferCopy region;
+      region.srcOffset = stagingHandle.offset + stagingOffset;
+      region.dstOffset = dstHandle.offset;
+      region.size      = dstHandle.length;
+
+      copyRegions.push_back(region);
+      copyBuffer = dstHandle.handle;
+
+      stagingOffset += align(dstHandle.length, 16);
+      copyBytes     += dstHandle.length;
+
+      m_execBarriers.accessBuffer(dstHandle,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_ACCESS_TRANSFER_WRITE_BIT,
+        dstSlice.buffer()->info().stages,
+        dstSlice.buffer()->info().access);
+
+      m_cmd->trackResource<DxvkAccess::Write>(dstSlice.buffer());
+    }
+
+    flushCopies();
+
+    m_cmd->addStatCtr(DxvkStatCounter::CmdBufferUpdates, copyRegions.size());
+    m_cmd->addStatCtr(DxvkStatCounter::CmdBufferUpdateCopies, copyCount);
+    m_cmd->addStatCtr(DxvkStatCounter::CmdBufferUpdateBytes, copyBytes);
   }
   
   
@@ -4227,6 +4340,58 @@ namespace dxvk {
       m_state.gp.state.ilBindings[i].setStride(m_state.vi.vertexStrides[binding]);
     }
     
+    // Retrieve and bind actual Vulkan pipeline handle. Check the
+    // instances that were recently used on this context first.
+    const DxvkRenderPass* renderPass = m_state.om.framebufferInfo.renderPass();
+    size_t stateHash = m_state.gp.state.hash();
+
+    auto instance = m_gpInstanceCache.find(m_state.gp.pipeline,
+      m_state.gp.state, renderPass, stateHash);
+
+    bool isFallback = false;
+
+    if (!instance) {
+      bool isPending = false;
+
+      if (m_device->config().asyncPipelineCompile) {
+        instance = m_state.gp.pipeline->getInstanceAsync(
+          m_state.gp.state, renderPass, stateHash, isPending);
+      } else {
+        instance = m_state.gp.pipeline->getInstance(
+          m_state.gp.state, renderPass, stateHash);
+      }
+
+      // If the pipeline is still being compiled, use a compatible
+      // variant if one exists and skip the draw otherwise.
+      if (unlikely(isPending) && m_device->config().asyncPipelineFallback) {
+        instance = m_state.gp.pipeline->getFallbackInstance(
+          m_state.gp.state, renderPass);
+        isFallback = instance != nullptr;
+      }
+
+      if (unlikely(!instance)) {
+        if (isPending)
+          m_cmd->addStatCtr(DxvkStatCounter::PipeSkippedDraws, 1);
+
+        m_gpActivePipeline = VK_NULL_HANDLE;
+        return false;
+      }
+
+      // Instances for which pipeline compilation failed stay in
+      // the table so that we don't retry, but we can't draw.
+      if (unlikely(!instance->pipeline())) {
+        m_gpActivePipeline = VK_NULL_HANDLE;
+        return false;
+      }
+
+      if (likely(!isFallback))
+        m_gpInstanceCache.insert(m_state.gp.pipeline, instance);
+    }
+
+    // Fallback pipelines use the same set of dynamic states,
+    // so the instance's state vector works in either case.
+    const DxvkGraphicsPipelineStateInfo& pipelineState = instance->state();
+
     // Check which dynamic states need to be active. States that
     // are not dynamic will be invalidated in the command buffer.
     m_flags.clr(DxvkContextFlag::GpDynamicBlendConstants,
@@ -4234,34 +4399,34 @@ namespace dxvk {
                 DxvkContextFlag::GpDynamicDepthBounds,
                 DxvkContextFlag::GpDynamicStencilRef);
     
-    m_flags.set(m_state.gp.state.useDynamicBlendConstants()
+    m_flags.set(pipelineState.useDynamicBlendConstants()
       ? DxvkContextFlag::GpDynamicBlendConstants
       : DxvkContextFlag::GpDirtyBlendConstants);
     
-    m_flags.set(m_state.gp.state.useDynamicDepthBias()
+    m_flags.set(pipelineState.useDynamicDepthBias()
       ? DxvkContextFlag::GpDynamicDepthBias
       : DxvkContextFlag::GpDirtyDepthBias);
     
-    m_flags.set(m_state.gp.state.useDynamicDepthBounds()
+    m_flags.set(pipelineState.useDynamicDepthBounds()
       ? DxvkContextFlag::GpDynamicDepthBounds
       : DxvkContextFlag::GpDirtyDepthBounds);
     
-    m_flags.set(m_state.gp.state.useDynamicStencilRef()
+    m_flags.set(pipelineState.useDynamicStencilRef()
       ? DxvkContextFlag::GpDynamicStencilRef
       : DxvkContextFlag::GpDirtyStencilRef);
     
-    // Retrieve and bind actual Vulkan pipeline handle
-    m_gpActivePipeline = m_state.gp.pipeline->getPipelineHandle(
-      m_state.gp.state, m_state.om.framebufferInfo.renderPass());
-
-    if (unlikely(!m_gpActivePipeline))
-      return false;
+    m_gpActivePipeline = instance->pipeline();
 
     m_cmd->cmdBindPipeline(
       VK_PIPELINE_BIND_POINT_GRAPHICS,
       m_gpActivePipeline);
 
-    m_flags.clr(DxvkContextFlag::GpDirtyPipelineState);
+    // Keep looking for the actual pipeline on subsequent draws
+    if (unlikely(isFallback))
+      m_cmd->addStatCtr(DxvkStatCounter::PipeFallbackDraws, 1);
+    else
+      m_flags.clr(DxvkContextFlag::GpDirtyPipelineState);
+
     return true;
   }
   
@@ -4435,10 +4600,19 @@ namespace dxvk {
     auto& set = BindPoint == VK_PIPELINE_BIND_POINT_GRAPHICS ? m_gpSet : m_cpSet;
 
     if (layout->bindingCount()) {
-      set = allocateDescriptorSet(layout->descriptorSetLayout());
+      // Reuse a previously written set if the descriptors
+      // are identical, which is common for repeated draws
+      size_t hash = DxvkDescriptorSetCache::hash(layout, descriptors.data());
+      set = m_descCache.lookup(layout, descriptors.data(), hash);
+
+      if (!set) {
+        set = allocateDescriptorSet(layout->descriptorSetLayout());
+
+        m_cmd->updateDescriptorSetWithTemplate(set,
+          layout->descriptorTemplate(), descriptors.data());
 
-      m_cmd->updateDescriptorSetWithTemplate(set,
-        layout->descriptorTemplate(), descriptors.data());
+        m_descCache.insert(layout, descriptors.data(), hash, set);
+      }
     } else {
       set = VK_NULL_HANDLE;
     }
@@ -5297,20 +5471,49 @@ namespace dxvk {
   }
 
 
+  void DxvkContext::updateDescriptorPoolSize() {
+    // Grow pools quickly if a single command list needs
+    // more than one of them, but only shrink them again
+    // if they have been mostly unused for a while.
+    constexpr uint32_t ShrinkDelay = 256;
+
+    if (m_descSetCount > m_descPoolSize) {
+      m_descPoolSize = std::min(m_descPoolSize * 2, DxvkDescriptorPool::MaxSetCount);
+      m_descUnderuseCount = 0;
+    } else if (m_descSetCount * 4 < m_descPoolSize) {
+      if (++m_descUnderuseCount >= ShrinkDelay) {
+        m_descPoolSize = std::max(m_descPoolSize / 2, DxvkDescriptorPool::MinSetCount);
+        m_descUnderuseCount = 0;
+      }
+    } else {
+      m_descUnderuseCount = 0;
+    }
+
+    m_descSetCount = 0;
+  }
+
+
   VkDescriptorSet DxvkContext::allocateDescriptorSet(
           VkDescriptorSetLayout     layout) {
-    if (m_descPool == nullptr)
-      m_descPool = m_device->createDescriptorPool();
+    if (m_descPool == nullptr) {
+      m_descPool = m_device->createDescriptorPool(m_descPoolSize);
+      m_cmd->addStatCtr(DxvkStatCounter::DescriptorPoolCount, 1);
+    }
     
     VkDescriptorSet set = m_descPool->alloc(layout);
 
     if (set == VK_NULL_HANDLE) {
       m_cmd->trackDescriptorPool(std::move(m_descPool));
+      m_descCache.clear();
+
+      m_descPool = m_device->createDescriptorPool(m_descPoolSize);
+      m_cmd->addStatCtr(DxvkStatCounter::DescriptorPoolCount, 1);
 
-      m_descPool = m_device->createDescriptorPool();
       set = m_descPool->alloc(layout);
     }
 
+    m_cmd->addStatCtr(DxvkStatCounter::DescriptorSetCount, 1);
+    m_descSetCount += 1;
     return set;
   }
 
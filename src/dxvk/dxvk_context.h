@@ -10,6 +10,17 @@
 #include "dxvk_util.h"
 
 namespace dxvk {
+
+  /**
+   * \brief Buffer update
+   * 
+   * Destination buffer range and source
+   * data for batched buffer updates.
+   */
+  struct DxvkBufferUpdate {
+    DxvkBufferSlice dstSlice;
+    DxvkDataSlice   srcData;
+  };
   
   /**
    * \brief DXVk context
@@ -781,6 +792,21 @@ namespace dxvk {
             VkDeviceSize              offset,
             VkDeviceSize              size,
       const void*                     data);
+
+    /**
+     * \brief Updates multiple buffers
+     * 
+     * Equivalent to calling \ref updateBuffer for each
+     * update in order, but copies all data that has to
+     * go through a staging buffer with one allocation,
+     * and merges copies to the same buffer into one
+     * copy command where possible.
+     * \param [in] count Number of updates
+     * \param [in] updates Buffer updates
+     */
+    void updateBuffers(
+            uint32_t                  count,
+      const DxvkBufferUpdate*         updates);
     
     /**
      * \brief Updates an image
@@ -1075,6 +1101,10 @@ namespace dxvk {
     
     Rc<DxvkCommandList>     m_cmd;
     Rc<DxvkDescriptorPool>  m_descPool;
+    DxvkDescriptorSetCache  m_descCache;
+    uint32_t                m_descPoolSize      = DxvkDescriptorPool::MinSetCount;
+    uint32_t                m_descSetCount      = 0;
+    uint32_t                m_descUnderuseCount = 0;
     Rc<DxvkBuffer>          m_zeroBuffer;
 
     DxvkContextFlags        m_flags;
@@ -1097,6 +1127,8 @@ namespace dxvk {
     VkPipeline m_gpActivePipeline = VK_NULL_HANDLE;
     VkPipeline m_cpActivePipeline = VK_NULL_HANDLE;
 
+    DxvkGraphicsPipelineInstanceCache m_gpInstanceCache;
+
     VkDescriptorSet m_gpSet = VK_NULL_HANDLE;
     VkDescriptorSet m_cpSet = VK_NULL_HANDLE;
 
@@ -1344,6 +1376,8 @@ namespace dxvk {
             VkPipelineStageFlags      dstStages,
             VkAccessFlags             dstAccess);
 
+    void updateDescriptorPoolSize();
+
     VkDescriptorSet allocateDescriptorSet(
             VkDescriptorSetLayout     layout);
 
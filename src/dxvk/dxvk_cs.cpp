@@ -1,4 +1,5 @@
 #include "dxvk_cs.h"
+#include "dxvk_device.h"
 
 namespace dxvk {
   
@@ -17,7 +18,8 @@ namespace dxvk {
   }
 
 
-  void DxvkCsChunk::executeAll(DxvkContext* ctx) {
+  template<typename Fn>
+  void DxvkCsChunk::executeAllWith(DxvkContext* ctx, const Fn& fn) {
     auto cmd = m_head;
     
     if (m_flags.test(DxvkCsChunkFlag::SingleUse)) {
@@ -25,7 +27,7 @@ namespace dxvk {
       
       while (cmd != nullptr) {
         auto next = cmd->next();
-        cmd->exec(ctx);
+        fn(cmd, ctx);
         cmd->~DxvkCsCmd();
         cmd = next;
       }
@@ -34,13 +36,27 @@ namespace dxvk {
       m_tail = nullptr;
     } else {
       while (cmd != nullptr) {
-        cmd->exec(ctx);
+        fn(cmd, ctx);
         cmd = cmd->next();
       }
     }
   }
   
   
+  void DxvkCsChunk::executeAll(DxvkContext* ctx) {
+    executeAllWith(ctx, [] (const DxvkCsCmd* cmd, DxvkContext* ctx) {
+      cmd->exec(ctx);
+    });
+  }
+
+
+  void DxvkCsChunk::executeAll(DxvkContext* ctx, DxvkCsCapture* capture) {
+    executeAllWith(ctx, [capture] (const DxvkCsCmd* cmd, DxvkContext* ctx) {
+      capture->executeCommand(cmd, ctx);
+    });
+  }
+  
+  
   void DxvkCsChunk::reset() {
     auto cmd = m_head;
 
@@ -95,8 +111,50 @@ namespace dxvk {
   }
   
   
-  DxvkCsThread::DxvkCsThread(const Rc<DxvkContext>& context)
-  : m_context(context), m_thread([this] { threadFunc(); }) {
+  /**
+   * \brief Spins until a condition is met
+   *
+   * Grows the spin count if the condition was met while
+   * spinning, and shrinks it otherwise, so that threads
+   * stop burning CPU time when the other side is slow.
+   * \param [in,out] spinCount Current spin count
+   * \param [in] minSpinCount Minimum spin count
+   * \param [in] maxSpinCount Maximum spin count
+   * \param [in] pred Condition to test
+   * \returns \c true if the condition was met
+   */
+  template<typename Pred>
+  static bool spinUntil(
+          std::atomic<uint32_t>& spinCount,
+          uint32_t              minSpinCount,
+          uint32_t              maxSpinCount,
+    const Pred&                 pred) {
+    // The spin count is only a heuristic, but the producer
+    // side may be used by multiple threads concurrently
+    uint32_t count = spinCount.load(std::memory_order_relaxed);
+
+    for (uint32_t i = 0; i < count; i++) {
+      if (pred()) {
+        spinCount.store(std::min(count * 2, maxSpinCount), std::memory_order_relaxed);
+        return true;
+      }
+
+      _mm_pause();
+    }
+
+    spinCount.store(std::max(count / 2, minSpinCount), std::memory_order_relaxed);
+    return pred();
+  }
+
+
+  DxvkCsThread::DxvkCsThread(
+    const Rc<DxvkDevice>&       device,
+    const Rc<DxvkContext>&      context)
+  : m_device (device),
+    m_context(context),
+    m_capture(DxvkCsCapture::create(device)),
+    m_tracer (device != nullptr ? device->tracer() : nullptr),
+    m_thread([this] { threadFunc(); }) {
     
   }
   
@@ -112,54 +170,150 @@ namespace dxvk {
   
   
   void DxvkCsThread::dispatchChunk(DxvkCsChunkRef&& chunk) {
-    { std::unique_lock<dxvk::mutex> lock(m_mutex);
-      m_chunksQueued.push(std::move(chunk));
-      m_chunksPending += 1;
+    if (unlikely(m_capture != nullptr))
+      m_capture->notifyDispatch();
+
+    uint32_t chunksPending = m_chunksPending++;
+
+    if (m_device != nullptr)
+      m_device->addStatSample(DxvkStatHistogramType::CsQueueDepth, chunksPending);
+
+    if (unlikely(!m_chunksQueued.tryPush(chunk))) {
+      // Wait for the CS thread to process a good number of chunks
+      // rather than waking up for every single one. Since the
+      // pending count includes the chunk we are about to submit,
+      // there must be room in the ring once this returns.
+      waitForConsumer([this] {
+        return m_chunksPending.load() <= ResumeThreshold;
+      });
+
+      m_chunksQueued.tryPush(chunk);
     }
-    
-    m_condOnAdd.notify_one();
+
+    notifyConsumer();
   }
   
   
   void DxvkCsThread::synchronize() {
-    std::unique_lock<dxvk::mutex> lock(m_mutex);
-    
-    m_condOnSync.wait(lock, [this] {
+    if (!m_chunksPending.load())
+      return;
+
+    DxvkTraceScope trace(m_tracer, "cs", "Synchronize");
+
+    auto t0 = dxvk::high_resolution_clock::now();
+
+    waitForConsumer([this] {
       return !m_chunksPending.load();
     });
+
+    if (m_device != nullptr) {
+      auto t1 = dxvk::high_resolution_clock::now();
+      auto us = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+
+      m_device->addStatCtr(DxvkStatCounter::CsSyncCount, 1);
+      m_device->addStatCtr(DxvkStatCounter::CsSyncTicks, us);
+      m_device->addStatSample(DxvkStatHistogramType::CsSyncTime, us);
+    }
   }
   
   
+  bool DxvkCsThread::waitForChunks() {
+    auto pred = [this] {
+      return !m_chunksQueued.empty()
+          || m_stopped.load();
+    };
+
+    // The application thread is likely to submit more
+    // chunks soon, so try to avoid a costly sleep/wake
+    // cycle for each individual chunk.
+    if (!spinUntil(m_consumerSpinCount, m_minSpinCount, m_maxSpinCount, pred)) {
+      std::unique_lock<dxvk::mutex> lock(m_mutex);
+
+      // Pairs with the fence in notifyConsumer. Either the
+      // producer sees the flag, or we see the new chunk.
+      m_consumerParked.store(true, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+
+      m_condOnAdd.wait(lock, pred);
+      m_consumerParked.store(false, std::memory_order_relaxed);
+    }
+
+    return !m_stopped.load();
+  }
+
+
+  template<typename Pred>
+  void DxvkCsThread::waitForConsumer(const Pred& pred) {
+    if (spinUntil(m_producerSpinCount, m_minSpinCount, m_maxSpinCount, pred))
+      return;
+
+    std::unique_lock<dxvk::mutex> lock(m_mutex);
+
+    // Pairs with the fence in notifyProducer. This uses a
+    // counter since synchronize may be called by threads
+    // other than the one that dispatches chunks.
+    m_producersParked.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    m_condOnSync.wait(lock, pred);
+    m_producersParked.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+
+  void DxvkCsThread::notifyConsumer() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (unlikely(m_consumerParked.load(std::memory_order_relaxed))) {
+      std::lock_guard<dxvk::mutex> lock(m_mutex);
+      m_condOnAdd.notify_one();
+    }
+  }
+
+
+  void DxvkCsThread::notifyProducer() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (unlikely(m_producersParked.load(std::memory_order_relaxed))) {
+      std::lock_guard<dxvk::mutex> lock(m_mutex);
+      m_condOnSync.notify_all();
+    }
+  }
+
+
+  uint32_t DxvkCsThread::getSpinCount(uint32_t spinCount) {
+    // Spinning is pointless if the other thread
+    // cannot run at the same time as this one
+    return dxvk::thread::hardware_concurrency() > 1 ? spinCount : 0;
+  }
+
+
   void DxvkCsThread::threadFunc() {
     env::setThreadName("dxvk-cs");
 
     DxvkCsChunkRef chunk;
 
     try {
-      while (!m_stopped.load()) {
-        { std::unique_lock<dxvk::mutex> lock(m_mutex);
-          if (chunk) {
-            if (--m_chunksPending == 0)
-              m_condOnSync.notify_one();
-            
-            chunk = DxvkCsChunkRef();
-          }
-          
-          if (m_chunksQueued.size() == 0) {
-            m_condOnAdd.wait(lock, [this] {
-              return (m_chunksQueued.size() != 0)
-                  || (m_stopped.load());
-            });
-          }
-          
-          if (m_chunksQueued.size() != 0) {
-            chunk = std::move(m_chunksQueued.front());
-            m_chunksQueued.pop();
+      while (waitForChunks()) {
+        while (m_chunksQueued.tryPop(chunk)) {
+          { DxvkTraceScope trace(m_tracer, "cs", "ExecuteChunk");
+
+            if (unlikely(m_capture != nullptr))
+              m_capture->executeChunk(chunk, m_context.ptr());
+            else
+              chunk->executeAll(m_context.ptr());
           }
+
+          chunk = DxvkCsChunkRef();
+
+          // Only wake up the producer if it can make progress
+          uint32_t chunksPending = --m_chunksPending;
+
+          if (!chunksPending || chunksPending == ResumeThreshold)
+            notifyProducer();
+
+          if (unlikely(m_stopped.load()))
+            break;
         }
-        
-        if (chunk)
-          chunk->executeAll(m_context.ptr());
       }
     } catch (const DxvkError& e) {
       Logger::err("Exception on CS thread!");
@@ -167,4 +321,4 @@ namespace dxvk {
     }
   }
   
-}
\ No newline at end of file
+}
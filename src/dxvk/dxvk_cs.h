@@ -3,10 +3,14 @@
 #include <atomic>
 #include <condition_variable>
 #include <mutex>
-#include <queue>
 
 #include "../util/thread.h"
+
+#include "../util/sync/sync_ring.h"
+
 #include "dxvk_context.h"
+#include "dxvk_cs_capture.h"
+#include "dxvk_trace.h"
 
 namespace dxvk {
   
@@ -46,6 +50,18 @@ namespace dxvk {
      * \param [in] ctx The target context
      */
     virtual void exec(DxvkContext* ctx) const = 0;
+
+    /**
+     * \brief Queries type of the embedded command
+     * \returns Type info of the function object
+     */
+    virtual const std::type_info& type() const = 0;
+
+    /**
+     * \brief Queries size of the command
+     * \returns Size of the command, in bytes
+     */
+    virtual size_t size() const = 0;
     
   private:
     
@@ -74,6 +90,14 @@ namespace dxvk {
     void exec(DxvkContext* ctx) const {
       m_command(ctx);
     }
+
+    const std::type_info& type() const {
+      return typeid(T);
+    }
+
+    size_t size() const {
+      return sizeof(*this);
+    }
     
   private:
     
@@ -106,6 +130,14 @@ namespace dxvk {
       m_command(ctx, &m_data);
     }
 
+    const std::type_info& type() const {
+      return typeid(T);
+    }
+
+    size_t size() const {
+      return sizeof(*this);
+    }
+
     M* data() {
       return &m_data;
     }
@@ -222,6 +254,16 @@ namespace dxvk {
      * \param [in] ctx The context
      */
     void executeAll(DxvkContext* ctx);
+
+    /**
+     * \brief Executes and captures all commands
+     *
+     * Same as \ref executeAll, but lets the
+     * capture object time each command.
+     * \param [in] ctx The context
+     * \param [in] capture The capture
+     */
+    void executeAll(DxvkContext* ctx, DxvkCsCapture* capture);
     
     /**
      * \brief Resets chunk
@@ -243,6 +285,9 @@ namespace dxvk {
     
     alignas(64)
     char m_data[MaxBlockSize];
+
+    template<typename Fn>
+    void executeAllWith(DxvkContext* ctx, const Fn& fn);
     
   };
   
@@ -374,13 +419,25 @@ namespace dxvk {
    * \brief Command stream thread
    * 
    * Spawns a thread that will execute
-   * commands on a DXVK context. 
+   * commands on a DXVK context. Chunks
+   * must be dispatched from one thread
+   * at a time.
    */
   class DxvkCsThread {
-    
+    // Maximum number of chunks that can be queued before
+    // the producer has to wait for the CS thread to catch up
+    constexpr static uint32_t MaxChunksInFlight = 1024;
+    constexpr static uint32_t ResumeThreshold   = MaxChunksInFlight / 2;
+
+    // Bounds for the number of iterations a thread spins
+    // before going to sleep when waiting for the other one
+    constexpr static uint32_t MinSpinCount = 32;
+    constexpr static uint32_t MaxSpinCount = 1024;
   public:
     
-    DxvkCsThread(const Rc<DxvkContext>& context);
+    DxvkCsThread(
+      const Rc<DxvkDevice>&       device,
+      const Rc<DxvkContext>&      context);
     ~DxvkCsThread();
     
     /**
@@ -416,18 +473,44 @@ namespace dxvk {
     
   private:
     
+    const Rc<DxvkDevice>        m_device;
     const Rc<DxvkContext>       m_context;
+    const Rc<DxvkCsCapture>     m_capture;
+    DxvkTracer* const           m_tracer;
     
     std::atomic<bool>           m_stopped = { false };
+    std::atomic<uint32_t>       m_chunksPending = { 0u };
+
+    // Only accessed when either thread needs to sleep
     dxvk::mutex                 m_mutex;
     dxvk::condition_variable    m_condOnAdd;
     dxvk::condition_variable    m_condOnSync;
-    std::queue<DxvkCsChunkRef>  m_chunksQueued;
-    std::atomic<uint32_t>       m_chunksPending = { 0u };
+    std::atomic<bool>           m_consumerParked = { false };
+    std::atomic<uint32_t>       m_producersParked = { 0u };
+
+    uint32_t                    m_minSpinCount = getSpinCount(MinSpinCount);
+    uint32_t                    m_maxSpinCount = getSpinCount(MaxSpinCount);
+    std::atomic<uint32_t>       m_consumerSpinCount = { m_minSpinCount };
+    std::atomic<uint32_t>       m_producerSpinCount = { m_minSpinCount };
+
+    sync::SpscRing<DxvkCsChunkRef, MaxChunksInFlight> m_chunksQueued;
+
     dxvk::thread                m_thread;
     
+    bool waitForChunks();
+
+    template<typename Pred>
+    void waitForConsumer(const Pred& pred);
+
+    void notifyConsumer();
+
+    void notifyProducer();
+
     void threadFunc();
+
+    static uint32_t getSpinCount(
+            uint32_t              spinCount);
     
   };
   
-}
+}
\ No newline at end of file
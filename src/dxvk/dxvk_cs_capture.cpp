@@ -0,0 +1,186 @@
+#include "dxvk_cs.h"
+#include "dxvk_cs_capture.h"
+#include "dxvk_device.h"
+
+#include "../util/util_time.h"
+
+namespace dxvk {
+
+  static std::atomic<bool> g_captureActive = { false };
+
+  DxvkCsCapture::DxvkCsCapture(
+    const Rc<DxvkDevice>&       device,
+          uint32_t              firstFrame,
+          uint32_t              lastFrame)
+  : m_device    (device),
+    m_firstFrame(firstFrame),
+    m_lastFrame (lastFrame) {
+    std::string fileName = getFileName();
+
+    m_file = std::ofstream(str::tows(fileName.c_str()).c_str(),
+      std::ios_base::binary | std::ios_base::trunc);
+
+    if (!m_file) {
+      Logger::err(str::format("DXVK: Failed to create CS capture file ", fileName));
+      m_done = true;
+      return;
+    }
+
+    DxvkCsCaptureHeader header;
+    m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    Logger::info(str::format("DXVK: Capturing frames ", firstFrame, "-", lastFrame, " to ", fileName));
+  }
+
+
+  DxvkCsCapture::~DxvkCsCapture() {
+
+  }
+
+
+  Rc<DxvkCsCapture> DxvkCsCapture::create(
+    const Rc<DxvkDevice>&       device) {
+    std::string frames = env::getEnvVar("DXVK_CS_CAPTURE");
+
+    if (frames.empty() || device == nullptr)
+      return nullptr;
+
+    uint32_t firstFrame = 0;
+    uint32_t lastFrame  = 0;
+
+    try {
+      size_t separator = frames.find('-');
+      firstFrame = std::stoul(frames.substr(0, separator));
+      lastFrame  = separator != std::string::npos
+        ? std::stoul(frames.substr(separator + 1))
+        : firstFrame;
+    } catch (const std::exception&) {
+      Logger::err(str::format("DXVK: Invalid CS capture range: ", frames));
+      return nullptr;
+    }
+
+    if (lastFrame < firstFrame) {
+      Logger::err(str::format("DXVK: Invalid CS capture range: ", frames));
+      return nullptr;
+    }
+
+    // Only capture one command stream per process,
+    // there is no way to tell them apart otherwise
+    if (g_captureActive.exchange(true))
+      return nullptr;
+
+    return new DxvkCsCapture(device, firstFrame, lastFrame);
+  }
+
+
+  void DxvkCsCapture::notifyDispatch() {
+    uint64_t presentCount = m_device->getStatCounters().getCtr(DxvkStatCounter::QueuePresentCount);
+
+    if (presentCount != m_presentCount) {
+      std::lock_guard<sync::Spinlock> lock(m_mutex);
+      m_frameStarts.push_back({ m_chunksDispatched, uint32_t(presentCount) });
+      m_presentCount = presentCount;
+    }
+
+    m_chunksDispatched += 1;
+  }
+
+
+  void DxvkCsCapture::executeChunk(
+    const DxvkCsChunkRef&       chunk,
+          DxvkContext*          ctx) {
+    { std::lock_guard<sync::Spinlock> lock(m_mutex);
+
+      while (!m_frameStarts.empty() && m_frameStarts.front().chunkId <= m_chunksExecuted) {
+        m_frameId = m_frameStarts.front().frameId;
+        m_frameStarts.pop_front();
+      }
+    }
+
+    m_chunksExecuted += 1;
+
+    if (!m_done && m_frameId > m_lastFrame) {
+      Logger::info("DXVK: CS capture finished");
+      m_file.close();
+      m_done = true;
+    }
+
+    if (m_done || m_frameId < m_firstFrame) {
+      chunk->executeAll(ctx);
+      return;
+    }
+
+    chunk->executeAll(ctx, this);
+    writeChunk();
+  }
+
+
+  void DxvkCsCapture::executeCommand(
+    const DxvkCsCmd*            cmd,
+          DxvkContext*          ctx) {
+    // Look up the type before starting the timer
+    // so that we only measure the command itself
+    DxvkCsCaptureCmd entry;
+    entry.typeId = getTypeId(cmd->type());
+    entry.size   = uint32_t(cmd->size());
+
+    auto t0 = dxvk::high_resolution_clock::now();
+    cmd->exec(ctx);
+    auto t1 = dxvk::high_resolution_clock::now();
+
+    entry.timeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+    m_commands.push_back(entry);
+  }
+
+
+  uint32_t DxvkCsCapture::getTypeId(
+    const std::type_info&       type) {
+    auto entry = m_typeIds.find(type);
+
+    if (entry != m_typeIds.end())
+      return entry->second;
+
+    uint32_t typeId = uint32_t(m_typeIds.size());
+    m_typeIds.insert({ type, typeId });
+
+    // Type names are written the first time a type is
+    // encountered, so they always precede the chunk
+    std::string name = type.name();
+
+    DxvkCsCaptureRecordType recordType = DxvkCsCaptureRecordType::TypeName;
+    uint32_t nameLength = uint32_t(name.size());
+
+    m_file.write(reinterpret_cast<const char*>(&recordType), sizeof(recordType));
+    m_file.write(reinterpret_cast<const char*>(&typeId), sizeof(typeId));
+    m_file.write(reinterpret_cast<const char*>(&nameLength), sizeof(nameLength));
+    m_file.write(name.data(), nameLength);
+    return typeId;
+  }
+
+
+  void DxvkCsCapture::writeChunk() {
+    DxvkCsCaptureRecordType recordType = DxvkCsCaptureRecordType::Chunk;
+
+    DxvkCsCaptureChunk chunk;
+    chunk.frameId  = m_frameId;
+    chunk.cmdCount = uint32_t(m_commands.size());
+
+    m_file.write(reinterpret_cast<const char*>(&recordType), sizeof(recordType));
+    m_file.write(reinterpret_cast<const char*>(&chunk), sizeof(chunk));
+    m_file.write(reinterpret_cast<const char*>(m_commands.data()),
+      sizeof(DxvkCsCaptureCmd) * m_commands.size());
+
+    m_commands.clear();
+  }
+
+
+  std::string DxvkCsCapture::getFileName() {
+    std::string path = env::getEnvVar("DXVK_CS_CAPTURE_PATH");
+
+    if (!path.empty() && *path.rbegin() != '/')
+      path += '/';
+
+    return path + env::getExeBaseName() + ".dxvk-cs";
+  }
+
+}
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <deque>
+#include <fstream>
+#include <typeindex>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+#include "dxvk_include.h"
+
+namespace dxvk {
+
+  class DxvkContext;
+  class DxvkCsChunkRef;
+  class DxvkCsCmd;
+  class DxvkDevice;
+
+  /**
+   * \brief CS capture file header
+   */
+  struct DxvkCsCaptureHeader {
+    char     magic[4] = { 'D', 'X', 'C', 'S' };
+    uint32_t version  = 1;
+  };
+
+
+  /**
+   * \brief CS capture record type
+   */
+  enum class DxvkCsCaptureRecordType : uint32_t {
+    /// Followed by the type ID and the length of
+    /// the type name, and the name itself.
+    TypeName  = 0,
+    /// Followed by a \ref DxvkCsCaptureChunk and
+    /// one \ref DxvkCsCaptureCmd per command.
+    Chunk     = 1,
+  };
+
+
+  /**
+   * \brief Captured chunk
+   */
+  struct DxvkCsCaptureChunk {
+    uint32_t frameId;
+    uint32_t cmdCount;
+  };
+
+
+  /**
+   * \brief Captured command
+   *
+   * Commands are type-erased function objects that
+   * cannot be serialized, so only the command type,
+   * its size within the chunk and the time it took
+   * to execute it on the context are stored.
+   */
+  struct DxvkCsCaptureCmd {
+    uint32_t typeId;
+    uint32_t size;
+    uint64_t timeNs;
+  };
+
+
+  /**
+   * \brief CS capture
+   *
+   * Writes the command stream executed by a CS thread
+   * within a given range of frames to a file, so that
+   * CS thread and context overhead can be analyzed
+   * offline. Enabled via \c DXVK_CS_CAPTURE, which
+   * takes either a single frame or a range of frames
+   * in the form \c first-last.
+   */
+  class DxvkCsCapture : public RcObject {
+
+  public:
+
+    DxvkCsCapture(
+      const Rc<DxvkDevice>&       device,
+            uint32_t              firstFrame,
+            uint32_t              lastFrame);
+
+    ~DxvkCsCapture();
+
+    /**
+     * \brief Creates capture if enabled
+     *
+     * \param [in] device The device
+     * \returns Capture object, or \c nullptr
+     *    if capturing is not enabled
+     */
+    static Rc<DxvkCsCapture> create(
+      const Rc<DxvkDevice>&       device);
+
+    /**
+     * \brief Notifies capture about a dispatched chunk
+     *
+     * Must be called by the thread that dispatches
+     * chunks, so that chunks can be assigned to the
+     * frame they were recorded for.
+     */
+    void notifyDispatch();
+
+    /**
+     * \brief Executes chunk
+     *
+     * Executes the chunk on the given context, and
+     * records it if it belongs to a captured frame.
+     * Must be called in dispatch order.
+     * \param [in] chunk The chunk
+     * \param [in] ctx The context
+     */
+    void executeChunk(
+      const DxvkCsChunkRef&       chunk,
+            DxvkContext*          ctx);
+
+    /**
+     * \brief Executes and records a single command
+     *
+     * \param [in] cmd The command
+     * \param [in] ctx The context
+     */
+    void executeCommand(
+      const DxvkCsCmd*            cmd,
+            DxvkContext*          ctx);
+
+  private:
+
+    struct FrameStart {
+      uint64_t chunkId;
+      uint32_t frameId;
+    };
+
+    Rc<DxvkDevice>                m_device;
+
+    uint32_t                      m_firstFrame;
+    uint32_t                      m_lastFrame;
+
+    // Producer state
+    uint64_t                      m_chunksDispatched = 0;
+    uint64_t                      m_presentCount     = 0;
+
+    sync::Spinlock                m_mutex;
+    std::deque<FrameStart>        m_frameStarts;
+
+    // Consumer state
+    uint64_t                      m_chunksExecuted = 0;
+    uint32_t                      m_frameId        = 0;
+    bool                          m_done           = false;
+
+    std::ofstream                 m_file;
+
+    std::unordered_map<std::type_index, uint32_t> m_typeIds;
+    std::vector<DxvkCsCaptureCmd> m_commands;
+
+    uint32_t getTypeId(
+      const std::type_info&       type);
+
+    void writeChunk();
+
+    static std::string getFileName();
+
+  };
+
+}
@@ -3,26 +3,26 @@
 
 namespace dxvk {
   
-  DxvkDescriptorPool::DxvkDescriptorPool(const Rc<vk::DeviceFn>& vkd)
-  : m_vkd(vkd) {
-    constexpr uint32_t MaxSets = 2048;
-
+  DxvkDescriptorPool::DxvkDescriptorPool(
+    const Rc<vk::DeviceFn>& vkd,
+          uint32_t          maxSets)
+  : m_vkd(vkd), m_maxSets(maxSets) {
     std::array<VkDescriptorPoolSize, 9> pools = {{
-      { VK_DESCRIPTOR_TYPE_SAMPLER,                MaxSets * 2 },
-      { VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,          MaxSets * 3 },
-      { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,          MaxSets / 8 },
-      { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,         MaxSets * 3 },
-      { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,         MaxSets / 8 },
-      { VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER,   MaxSets * 3 },
-      { VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER,   MaxSets / 8 },
-      { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, MaxSets * 3 },
-      { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, MaxSets * 2 } }};
+      { VK_DESCRIPTOR_TYPE_SAMPLER,                maxSets * 2 },
+      { VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,          maxSets * 3 },
+      { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,          maxSets / 8 },
+      { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,         maxSets * 3 },
+      { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,         maxSets / 8 },
+      { VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER,   maxSets * 3 },
+      { VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER,   maxSets / 8 },
+      { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, maxSets * 3 },
+      { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, maxSets * 2 } }};
     
     VkDescriptorPoolCreateInfo info;
     info.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
     info.pNext         = nullptr;
     info.flags         = 0;
-    info.maxSets       = MaxSets;
+    info.maxSets       = maxSets;
     info.poolSizeCount = pools.size();
     info.pPoolSizes    = pools.data();
     
@@ -60,6 +60,80 @@ namespace dxvk {
 
 
 
+  DxvkDescriptorPoolRecycler::DxvkDescriptorPoolRecycler(DxvkDevice* device)
+  : m_device(device) {
+
+  }
+
+
+  DxvkDescriptorPoolRecycler::~DxvkDescriptorPoolRecycler() {
+
+  }
+
+
+  Rc<DxvkDescriptorPool> DxvkDescriptorPoolRecycler::retrievePool(uint32_t maxSets) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    updateFrame();
+
+    // Prefer the most recently returned pool, since
+    // pools at the front of the list may get trimmed
+    Rc<DxvkDescriptorPool> result;
+
+    for (size_t i = m_pools.size(); i && result == nullptr; i--) {
+      if (m_pools[i - 1]->maxSets() >= maxSets) {
+        result = std::move(m_pools[i - 1]);
+        m_pools.erase(m_pools.begin() + (i - 1));
+      }
+    }
+
+    // Pools that are too small will never be used again
+    for (auto i = m_pools.begin(); i != m_pools.end(); ) {
+      if ((*i)->maxSets() < maxSets)
+        i = m_pools.erase(i);
+      else
+        i++;
+    }
+
+    m_minIdleCount = std::min(m_minIdleCount, m_pools.size());
+    return result;
+  }
+
+
+  void DxvkDescriptorPoolRecycler::returnPool(const Rc<DxvkDescriptorPool>& pool) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    updateFrame();
+
+    // Destroy the oldest pool if we have too many
+    if (m_pools.size() >= MaxPoolCount)
+      m_pools.erase(m_pools.begin());
+
+    m_pools.push_back(pool);
+  }
+
+
+  void DxvkDescriptorPoolRecycler::updateFrame() {
+    uint32_t frameId = m_device->getCurrentFrameId();
+
+    if (likely(frameId == m_frameId))
+      return;
+
+    m_frameId = frameId;
+
+    // Pools that remained idle every time a pool was
+    // requested within the trim interval are not needed
+    // for the current workload. Destroy the oldest ones.
+    if (++m_trimFrameCount >= TrimInterval) {
+      size_t count = std::min(m_minIdleCount, m_pools.size());
+      m_pools.erase(m_pools.begin(), m_pools.begin() + count);
+
+      m_trimFrameCount = 0;
+      m_minIdleCount   = ~size_t(0);
+    }
+  }
+
+
+
+
   DxvkDescriptorPoolTracker::DxvkDescriptorPoolTracker(DxvkDevice* device)
   : m_device(device) {
 
@@ -84,5 +158,146 @@ namespace dxvk {
 
     m_pools.clear();
   }
-  
-}
\ No newline at end of file
+
+
+  DxvkDescriptorSetCache::DxvkDescriptorSetCache()
+  : m_entries(EntryCount) {
+
+  }
+
+
+  DxvkDescriptorSetCache::~DxvkDescriptorSetCache() {
+
+  }
+
+
+  size_t DxvkDescriptorSetCache::hash(
+    const DxvkPipelineLayout*     layout,
+    const DxvkDescriptorInfo*     descriptors) {
+    DxvkHashState state;
+    state.add(std::hash<const DxvkPipelineLayout*>()(layout));
+
+    for (uint32_t i = 0; i < layout->bindingCount(); i++)
+      state.add(hashDescriptor(layout->binding(i).type, descriptors[i]));
+
+    return state;
+  }
+
+
+  VkDescriptorSet DxvkDescriptorSetCache::lookup(
+    const DxvkPipelineLayout*     layout,
+    const DxvkDescriptorInfo*     descriptors,
+          size_t                  hash) const {
+    const Entry& entry = m_entries[hash & (EntryCount - 1)];
+
+    if (entry.layout != layout || entry.hash != hash)
+      return VK_NULL_HANDLE;
+
+    const DxvkDescriptorInfo* cached = &m_descriptors[entry.offset];
+
+    for (uint32_t i = 0; i < layout->bindingCount(); i++) {
+      if (!compareDescriptors(layout->binding(i).type, descriptors[i], cached[i]))
+        return VK_NULL_HANDLE;
+    }
+
+    return entry.set;
+  }
+
+
+  void DxvkDescriptorSetCache::insert(
+    const DxvkPipelineLayout*     layout,
+    const DxvkDescriptorInfo*     descriptors,
+          size_t                  hash,
+          VkDescriptorSet         set) {
+    if (m_descriptors.size() + layout->bindingCount() > MaxDescriptorCount)
+      this->clear();
+
+    Entry& entry = m_entries[hash & (EntryCount - 1)];
+    entry.layout = layout;
+    entry.hash   = hash;
+    entry.offset = m_descriptors.size();
+    entry.set    = set;
+
+    m_descriptors.insert(m_descriptors.end(),
+      descriptors, descriptors + layout->bindingCount());
+  }
+
+
+  void DxvkDescriptorSetCache::clear() {
+    if (m_descriptors.empty())
+      return;
+
+    for (auto& entry : m_entries)
+      entry = Entry();
+
+    m_descriptors.clear();
+  }
+
+
+  size_t DxvkDescriptorSetCache::hashDescriptor(
+          VkDescriptorType        type,
+    const DxvkDescriptorInfo&     descriptor) {
+    // Only hash members that are relevant for the given
+    // descriptor type, since the others are undefined
+    DxvkHashState state;
+
+    switch (type) {
+      case VK_DESCRIPTOR_TYPE_SAMPLER:
+        state.add(std::hash<VkSampler>()(descriptor.image.sampler));
+        break;
+
+      case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+        state.add(std::hash<VkSampler>()(descriptor.image.sampler));
+        /* fall through */
+
+      case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+      case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+        state.add(std::hash<VkImageView>()(descriptor.image.imageView));
+        state.add(uint32_t(descriptor.image.imageLayout));
+        break;
+
+      case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+      case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+        state.add(std::hash<VkBufferView>()(descriptor.texelBuffer));
+        break;
+
+      default:
+        state.add(std::hash<VkBuffer>()(descriptor.buffer.buffer));
+        state.add(descriptor.buffer.offset);
+        state.add(descriptor.buffer.range);
+    }
+
+    return state;
+  }
+
+
+  bool DxvkDescriptorSetCache::compareDescriptors(
+          VkDescriptorType        type,
+    const DxvkDescriptorInfo&     a,
+    const DxvkDescriptorInfo&     b) {
+    switch (type) {
+      case VK_DESCRIPTOR_TYPE_SAMPLER:
+        return a.image.sampler == b.image.sampler;
+
+      case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+        return a.image.sampler     == b.image.sampler
+            && a.image.imageView   == b.image.imageView
+            && a.image.imageLayout == b.image.imageLayout;
+
+      case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+      case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+        return a.image.imageView   == b.image.imageView
+            && a.image.imageLayout == b.image.imageLayout;
+
+      case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+      case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+        return a.texelBuffer == b.texelBuffer;
+
+      default:
+        return a.buffer.buffer == b.buffer.buffer
+            && a.buffer.offset == b.buffer.offset
+            && a.buffer.range  == b.buffer.range;
+    }
+  }
+
+}
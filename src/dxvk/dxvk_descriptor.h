@@ -2,7 +2,9 @@
 
 #include <vector>
 
+#include "dxvk_hash.h"
 #include "dxvk_include.h"
+#include "dxvk_pipelayout.h"
 
 namespace dxvk {
 
@@ -25,15 +27,30 @@ namespace dxvk {
    * \brief Descriptor pool
    * 
    * Wrapper around a Vulkan descriptor pool that
-   * descriptor sets can be allocated from.
+   * descriptor sets can be allocated from. The
+   * number of descriptors of each type scales
+   * with the maximum number of sets.
    */
   class DxvkDescriptorPool : public RcObject {
     
   public:
+
+    /// Smallest and largest supported pool sizes, in sets
+    constexpr static uint32_t MinSetCount = 1024;
+    constexpr static uint32_t MaxSetCount = 16384;
     
     DxvkDescriptorPool(
-      const Rc<vk::DeviceFn>& vkd);
+      const Rc<vk::DeviceFn>& vkd,
+            uint32_t          maxSets);
     ~DxvkDescriptorPool();
+
+    /**
+     * \brief Maximum number of descriptor sets
+     * \returns Number of sets the pool was created for
+     */
+    uint32_t maxSets() const {
+      return m_maxSets;
+    }
     
     /**
      * \brief Allocates a descriptor set
@@ -56,10 +73,65 @@ namespace dxvk {
     
     Rc<vk::DeviceFn> m_vkd;
     VkDescriptorPool m_pool;
+    uint32_t         m_maxSets;
     
   };
 
 
+  /**
+   * \brief Descriptor pool recycler
+   * 
+   * Keeps pools that have been reset after the GPU
+   * finished using them, so that contexts can reuse
+   * them rather than creating new pools every time
+   * one runs full. Pools that were not needed for a
+   * number of frames get destroyed, and the number of
+   * idle pools is limited. Thread-safe.
+   */
+  class DxvkDescriptorPoolRecycler {
+    constexpr static uint32_t TrimInterval = 60; // frames
+    constexpr static size_t   MaxPoolCount = 16;
+  public:
+
+    DxvkDescriptorPoolRecycler(DxvkDevice* device);
+    ~DxvkDescriptorPoolRecycler();
+
+    /**
+     * \brief Retrieves a recycled pool
+     * 
+     * Idle pools that are smaller than the requested
+     * size are no longer useful and will be destroyed.
+     * \param [in] maxSets Minimum number of sets
+     * \returns A pool, or \c nullptr if none is available
+     */
+    Rc<DxvkDescriptorPool> retrievePool(uint32_t maxSets);
+
+    /**
+     * \brief Returns a pool to the recycler
+     * 
+     * The pool must have been reset already. Since this
+     * is called for every completed submission, this is
+     * also where unused pools get trimmed.
+     * \param [in] pool The descriptor pool
+     */
+    void returnPool(const Rc<DxvkDescriptorPool>& pool);
+
+  private:
+
+    DxvkDevice*                         m_device;
+
+    dxvk::mutex                         m_mutex;
+    std::vector<Rc<DxvkDescriptorPool>> m_pools;
+
+    uint32_t                            m_frameId         = 0;
+    uint32_t                            m_trimFrameCount  = 0;
+    size_t                              m_minIdleCount    = ~size_t(0);
+
+    void updateFrame();
+
+  };
+
+
   /**
    * \brief Descriptor pool tracker
    * 
@@ -97,4 +169,104 @@ namespace dxvk {
 
   };
   
-}
\ No newline at end of file
+
+
+  /**
+   * \brief Descriptor set cache
+   * 
+   * Remembers descriptor sets that were recently written
+   * for a given pipeline layout, along with the descriptors
+   * that were written to them, so that draws which use the
+   * exact same resources can reuse the set instead of
+   * allocating and updating a new one.
+   * 
+   * Descriptors only store raw Vulkan handles, which are
+   * only guaranteed to remain valid while the resources
+   * are tracked by the current command list. The cache
+   * must therefore be cleared when the command list is
+   * submitted, as well as when the descriptor pool that
+   * the cached sets were allocated from is retired.
+   */
+  class DxvkDescriptorSetCache {
+
+  public:
+
+    DxvkDescriptorSetCache();
+    ~DxvkDescriptorSetCache();
+
+    /**
+     * \brief Computes lookup hash
+     * 
+     * \param [in] layout Pipeline layout
+     * \param [in] descriptors Descriptor infos, one per binding
+     * \returns Hash of the layout and descriptors
+     */
+    static size_t hash(
+      const DxvkPipelineLayout*     layout,
+      const DxvkDescriptorInfo*     descriptors);
+
+    /**
+     * \brief Looks up a descriptor set
+     * 
+     * \param [in] layout Pipeline layout
+     * \param [in] descriptors Descriptor infos, one per binding
+     * \param [in] hash Hash computed by \ref hash
+     * \returns Matching descriptor set, or \c VK_NULL_HANDLE
+     */
+    VkDescriptorSet lookup(
+      const DxvkPipelineLayout*     layout,
+      const DxvkDescriptorInfo*     descriptors,
+            size_t                  hash) const;
+
+    /**
+     * \brief Adds a descriptor set to the cache
+     * 
+     * May replace a previously cached set with the
+     * same lookup hash.
+     * \param [in] layout Pipeline layout
+     * \param [in] descriptors Descriptors written to the set
+     * \param [in] hash Hash computed by \ref hash
+     * \param [in] set The descriptor set
+     */
+    void insert(
+      const DxvkPipelineLayout*     layout,
+      const DxvkDescriptorInfo*     descriptors,
+            size_t                  hash,
+            VkDescriptorSet         set);
+
+    /**
+     * \brief Removes all cached descriptor sets
+     */
+    void clear();
+
+  private:
+
+    /// Number of cache entries, must be a power of two
+    constexpr static size_t EntryCount = 1024;
+
+    /// Maximum number of descriptors to store before the
+    /// cache gets cleared in order to limit memory usage
+    constexpr static size_t MaxDescriptorCount = 65536;
+
+    struct Entry {
+      const DxvkPipelineLayout* layout = nullptr;
+      size_t                    hash   = 0;
+      size_t                    offset = 0;
+      VkDescriptorSet           set    = VK_NULL_HANDLE;
+    };
+
+    std::vector<Entry>              m_entries;
+    std::vector<DxvkDescriptorInfo> m_descriptors;
+
+    static size_t hashDescriptor(
+            VkDescriptorType        type,
+      const DxvkDescriptorInfo&     descriptor);
+
+    static bool compareDescriptors(
+            VkDescriptorType        type,
+      const DxvkDescriptorInfo&     a,
+      const DxvkDescriptorInfo&     b);
+
+  };
+  
+}
@@ -17,8 +17,13 @@ namespace dxvk {
     m_features          (features),
     m_properties        (adapter->devicePropertiesExt()),
     m_perfHints         (getPerfHints()),
+    m_tracer            (DxvkTracer::create()),
     m_objects           (this),
+    m_statDump          (DxvkStatDump::create()),
+    m_recycledDescriptorPools (this),
     m_submissionQueue   (this) {
+    Logger::acquireWriter();
+
     auto queueFamilies = m_adapter->findQueueFamilies();
     m_queues.graphics = getQueue(queueFamilies.graphics, 0);
     m_queues.transfer = getQueue(queueFamilies.transfer, 0);
@@ -33,6 +38,8 @@ namespace dxvk {
     // Stop workers explicitly in order to prevent
     // access to structures that are being destroyed.
     m_objects.pipelineManager().stopWorkerThreads();
+
+    Logger::releaseWriter();
   }
 
 
@@ -84,11 +91,12 @@ namespace dxvk {
   }
 
 
-  Rc<DxvkDescriptorPool> DxvkDevice::createDescriptorPool() {
-    Rc<DxvkDescriptorPool> pool = m_recycledDescriptorPools.retrieveObject();
+  Rc<DxvkDescriptorPool> DxvkDevice::createDescriptorPool(
+          uint32_t                maxSets) {
+    Rc<DxvkDescriptorPool> pool = m_recycledDescriptorPools.retrievePool(maxSets);
 
     if (pool == nullptr)
-      pool = new DxvkDescriptorPool(m_vkd);
+      pool = new DxvkDescriptorPool(m_vkd, maxSets);
     
     return pool;
   }
@@ -180,12 +188,26 @@ namespace dxvk {
     result.setCtr(DxvkStatCounter::PipeCompilerBusy,  m_objects.pipelineManager().isCompilingShaders());
     result.setCtr(DxvkStatCounter::GpuIdleTicks,      m_submissionQueue.gpuIdleTicks());
 
+    m_objects.memoryManager().getStatCounters(result);
+
     std::lock_guard<sync::Spinlock> lock(m_statLock);
     result.merge(m_statCounters);
     return result;
   }
   
   
+  DxvkStatHistograms DxvkDevice::getStatHistograms() {
+    DxvkStatHistograms result;
+
+    for (uint32_t i = 0; i < result.size(); i++) {
+      for (uint32_t j = 0; j < DxvkStatHistogram::BucketCount; j++)
+        result[i].setBucket(j, m_statHistograms[i][j].load(std::memory_order_relaxed));
+    }
+
+    return result;
+  }
+  
+  
   DxvkMemoryStats DxvkDevice::getMemoryStats(uint32_t heap) {
     return m_objects.memoryManager().getMemoryStats(heap);
   }
@@ -204,6 +226,11 @@ namespace dxvk {
   void DxvkDevice::registerShader(const Rc<DxvkShader>& shader) {
     m_objects.pipelineManager().registerShader(shader);
   }
+
+
+  DxvkWorkerPool& DxvkDevice::compilerWorkers() {
+    return m_objects.pipelineManager().workers();
+  }
   
   
   void DxvkDevice::presentImage(
@@ -214,9 +241,16 @@ namespace dxvk {
     DxvkPresentInfo presentInfo;
     presentInfo.presenter = presenter;
     m_submissionQueue.present(presentInfo, status);
+
+    if (unlikely(m_tracer != nullptr))
+      m_tracer->notifyPresent();
     
-    std::lock_guard<sync::Spinlock> statLock(m_statLock);
-    m_statCounters.addCtr(DxvkStatCounter::QueuePresentCount, 1);
+    { std::lock_guard<sync::Spinlock> statLock(m_statLock);
+      m_statCounters.addCtr(DxvkStatCounter::QueuePresentCount, 1);
+    }
+
+    if (unlikely(m_statDump != nullptr))
+      m_statDump->writeFrame(getStatCounters(), getStatHistograms());
   }
 
 
@@ -275,7 +309,7 @@ namespace dxvk {
   
 
   void DxvkDevice::recycleDescriptorPool(const Rc<DxvkDescriptorPool>& pool) {
-    m_recycledDescriptorPools.returnObject(pool);
+    m_recycledDescriptorPools.returnPool(pool);
   }
 
 
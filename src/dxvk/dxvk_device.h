@@ -21,6 +21,7 @@
 #include "dxvk_sampler.h"
 #include "dxvk_shader.h"
 #include "dxvk_stats.h"
+#include "dxvk_trace.h"
 #include "dxvk_unbound.h"
 
 #include "../vulkan/vulkan_presenter.h"
@@ -222,6 +223,16 @@ namespace dxvk {
     DxvkDevicePerfHints perfHints() const {
       return m_perfHints;
     }
+
+    /**
+     * \brief Retrieves tracer
+     *
+     * Used to record trace events. See \ref DxvkTraceScope.
+     * \returns Tracer, or \c nullptr if tracing is disabled
+     */
+    DxvkTracer* tracer() const {
+      return m_tracer.ptr();
+    }
     
     /**
      * \brief Creates a command list
@@ -235,9 +246,11 @@ namespace dxvk {
      * Returns a previously recycled pool, or creates
      * a new one if necessary. The context should take
      * ownership of the returned pool.
+     * \param [in] maxSets Minimum number of sets
      * \returns Descriptor pool
      */
-    Rc<DxvkDescriptorPool> createDescriptorPool();
+    Rc<DxvkDescriptorPool> createDescriptorPool(
+            uint32_t                maxSets);
     
     /**
      * \brief Creates a context
@@ -366,6 +379,42 @@ namespace dxvk {
      */
     DxvkStatCounters getStatCounters();
 
+    /**
+     * \brief Retrieves stat histograms
+     *
+     * Returns a snapshot of all histograms. Like
+     * stat counters, these accumulate over time.
+     * \returns Stat histograms
+     */
+    DxvkStatHistograms getStatHistograms();
+
+    /**
+     * \brief Adds to a stat counter
+     *
+     * Used for events that are not tied to a
+     * command list, such as the application
+     * waiting for the CS thread or a resource.
+     * \param [in] ctr The counter
+     * \param [in] value Value to add
+     */
+    void addStatCtr(DxvkStatCounter ctr, uint64_t value) {
+      std::lock_guard<sync::Spinlock> lock(m_statLock);
+      m_statCounters.addCtr(ctr, value);
+    }
+
+    /**
+     * \brief Adds a sample to a stat histogram
+     *
+     * Lock-free, so that this can be called
+     * from hot paths on any thread.
+     * \param [in] type The histogram
+     * \param [in] value Sample value
+     */
+    void addStatSample(DxvkStatHistogramType type, uint64_t value) {
+      m_statHistograms[uint32_t(type)][DxvkStatHistogram::getBucketIndex(value)]
+        .fetch_add(1, std::memory_order_relaxed);
+    }
+
     /**
      * \brief Retrieves memors statistics
      *
@@ -395,6 +444,19 @@ namespace dxvk {
      */
     void registerShader(
       const Rc<DxvkShader>&         shader);
+
+    /**
+     * \brief Compiler worker pool
+     *
+     * Shared between pipeline compilation and shader
+     * translation, so that client APIs do not have to
+     * spawn their own threads. Jobs must not outlive
+     * any objects they access, so clients need to
+     * cancel or finish their jobs before destroying
+     * those objects.
+     * \returns Compiler worker pool
+     */
+    DxvkWorkerPool& compilerWorkers();
     
     /**
      * \brief Presents a swap chain image
@@ -487,15 +549,21 @@ namespace dxvk {
     DxvkDeviceInfo              m_properties;
     
     DxvkDevicePerfHints         m_perfHints;
+    Rc<DxvkTracer>              m_tracer;
     DxvkObjects                 m_objects;
 
     sync::Spinlock              m_statLock;
     DxvkStatCounters            m_statCounters;
+    Rc<DxvkStatDump>            m_statDump;
+
+    std::array<std::array<std::atomic<uint64_t>,
+      DxvkStatHistogram::BucketCount>,
+      uint32_t(DxvkStatHistogramType::NumHistograms)> m_statHistograms = { };
     
     DxvkDeviceQueueSet          m_queues;
     
     DxvkRecycler<DxvkCommandList,    16> m_recycledCommandLists;
-    DxvkRecycler<DxvkDescriptorPool, 16> m_recycledDescriptorPools;
+    DxvkDescriptorPoolRecycler           m_recycledDescriptorPools;
     
     DxvkSubmissionQueue m_submissionQueue;
 
@@ -41,8 +41,9 @@ namespace dxvk {
   
   
   DxvkGraphicsPipeline::~DxvkGraphicsPipeline() {
-    for (const auto& instance : m_pipelines)
+    m_pipelines.forEach([this] (const DxvkGraphicsPipelineInstance& instance) {
       this->destroyPipeline(instance.pipeline());
+    });
   }
   
   
@@ -63,60 +64,151 @@ namespace dxvk {
   VkPipeline DxvkGraphicsPipeline::getPipelineHandle(
     const DxvkGraphicsPipelineStateInfo& state,
     const DxvkRenderPass*                renderPass) {
-    DxvkGraphicsPipelineInstance* instance = nullptr;
+    auto instance = this->getInstance(state, renderPass, state.hash());
+
+    return instance != nullptr
+      ? instance->pipeline()
+      : VK_NULL_HANDLE;
+  }
+
+
+  const DxvkGraphicsPipelineInstance* DxvkGraphicsPipeline::getInstance(
+    const DxvkGraphicsPipelineStateInfo& state,
+    const DxvkRenderPass*                renderPass,
+          size_t                         hash) {
+    auto instance = m_pipelines.find(state, renderPass, hash);
+
+    if (likely(instance != nullptr))
+      return instance;
+
+    { std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+      // Another thread may have created the
+      // instance while we were waiting for the lock
+      instance = m_pipelines.find(state, renderPass, hash);
 
-    { std::lock_guard<sync::Spinlock> lock(m_mutex);
-    
-      instance = this->findInstance(state, renderPass);
-      
       if (instance)
-        return instance->pipeline();
-      
-      instance = this->createInstance(state, renderPass);
+        return instance;
+
+      instance = this->createInstance(state, renderPass, hash);
     }
     
     if (!instance)
-      return VK_NULL_HANDLE;
+      return nullptr;
 
     this->writePipelineStateToCache(state, renderPass->format());
-    return instance->pipeline();
+    return instance;
+  }
+
+
+  const DxvkGraphicsPipelineInstance* DxvkGraphicsPipeline::getInstanceAsync(
+    const DxvkGraphicsPipelineStateInfo& state,
+    const DxvkRenderPass*                renderPass,
+          size_t                         hash,
+          bool&                          pending) {
+    pending = false;
+
+    auto instance = m_pipelines.find(state, renderPass, hash);
+
+    if (likely(instance != nullptr))
+      return instance;
+
+    // We need the state cache's worker threads
+    DxvkStateCache* stateCache = m_pipeMgr->m_stateCache.ptr();
+
+    if (!stateCache)
+      return this->getInstance(state, renderPass, hash);
+
+    // Don't queue jobs for pipelines that can never be
+    // compiled, or we would do so again on every draw
+    if (!this->validatePipelineState(state))
+      return nullptr;
+
+    pending = true;
+
+    { std::lock_guard<sync::Spinlock> lock(m_pendingLock);
+
+      for (const auto& entry : m_pending) {
+        if (entry.isCompatible(state, renderPass, hash))
+          return nullptr;
+      }
+
+      m_pending.emplace_back(state, renderPass, hash, VK_NULL_HANDLE);
+    }
+
+    // The instance may have been added to the table
+    // after our lookup, in which case the job will
+    // find it and return early
+    stateCache->compileGraphicsPipeline(this, state, renderPass);
+    return nullptr;
+  }
+
+
+  const DxvkGraphicsPipelineInstance* DxvkGraphicsPipeline::getFallbackInstance(
+    const DxvkGraphicsPipelineStateInfo& state,
+    const DxvkRenderPass*                renderPass) const {
+    const DxvkGraphicsPipelineInstance* result = nullptr;
+
+    m_pipelines.forEach([&] (const DxvkGraphicsPipelineInstance& instance) {
+      if (result || instance.renderPass() != renderPass || !instance.pipeline())
+        return;
+
+      if (isFallbackCompatible(state, instance.state()))
+        result = &instance;
+    });
+
+    return result;
   }
 
 
   void DxvkGraphicsPipeline::compilePipeline(
     const DxvkGraphicsPipelineStateInfo& state,
     const DxvkRenderPass*                renderPass) {
-    std::lock_guard<sync::Spinlock> lock(m_mutex);
+    size_t hash = state.hash();
+
+    if (m_pipelines.find(state, renderPass, hash))
+      return;
+
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
 
-    if (!this->findInstance(state, renderPass))
-      this->createInstance(state, renderPass);
+    if (!m_pipelines.find(state, renderPass, hash))
+      this->createInstance(state, renderPass, hash);
   }
 
 
-  DxvkGraphicsPipelineInstance* DxvkGraphicsPipeline::createInstance(
+  void DxvkGraphicsPipeline::compilePendingInstance(
     const DxvkGraphicsPipelineStateInfo& state,
     const DxvkRenderPass*                renderPass) {
+    size_t hash = state.hash();
+
+    this->getInstance(state, renderPass, hash);
+
+    std::lock_guard<sync::Spinlock> lock(m_pendingLock);
+
+    for (size_t i = 0; i < m_pending.size(); i++) {
+      if (m_pending[i].isCompatible(state, renderPass, hash)) {
+        m_pending[i] = m_pending.back();
+        m_pending.pop_back();
+        break;
+      }
+    }
+  }
+
+
+  const DxvkGraphicsPipelineInstance* DxvkGraphicsPipeline::createInstance(
+    const DxvkGraphicsPipelineStateInfo& state,
+    const DxvkRenderPass*                renderPass,
+          size_t                         hash) {
     // If the pipeline state vector is invalid, don't try
     // to create a new pipeline, it won't work anyway.
     if (!this->validatePipelineState(state))
       return nullptr;
 
+    DxvkTraceScope trace(m_pipeMgr->m_device->tracer(), "pipeline", "CompileGraphicsPipeline");
     VkPipeline newPipelineHandle = this->createPipeline(state, renderPass);
 
     m_pipeMgr->m_numGraphicsPipelines += 1;
-    return &m_pipelines.emplace_back(state, renderPass, newPipelineHandle);
-  }
-  
-  
-  DxvkGraphicsPipelineInstance* DxvkGraphicsPipeline::findInstance(
-    const DxvkGraphicsPipelineStateInfo& state,
-    const DxvkRenderPass*                renderPass) {
-    for (auto& instance : m_pipelines) {
-      if (instance.isCompatible(state, renderPass))
-        return &instance;
-    }
-    
-    return nullptr;
+    return m_pipelines.insert(state, renderPass, hash, newPipelineHandle);
   }
   
   
@@ -432,6 +524,62 @@ namespace dxvk {
   }
 
 
+  bool DxvkGraphicsPipeline::isFallbackCompatible(
+    const DxvkGraphicsPipelineStateInfo& state,
+    const DxvkGraphicsPipelineStateInfo& other) {
+    // Everything except for depth-stencil and blend state must
+    // match exactly. Dynamic state values are not part of the
+    // state vector, but the set of dynamic states is derived
+    // from it, so comparing the rest covers that as well.
+    if (std::memcmp(&state.bsBindingMask, &other.bsBindingMask, sizeof(state.bsBindingMask))
+     || std::memcmp(&state.ia, &other.ia, sizeof(state.ia))
+     || std::memcmp(&state.il, &other.il, sizeof(state.il))
+     || std::memcmp(&state.rs, &other.rs, sizeof(state.rs))
+     || std::memcmp(&state.ms, &other.ms, sizeof(state.ms))
+     || std::memcmp(&state.om, &other.om, sizeof(state.om))
+     || std::memcmp(&state.sc, &other.sc, sizeof(state.sc))
+     || std::memcmp(&state.omSwizzle,    &other.omSwizzle,    sizeof(state.omSwizzle))
+     || std::memcmp(&state.ilAttributes, &other.ilAttributes, sizeof(state.ilAttributes))
+     || std::memcmp(&state.ilBindings,   &other.ilBindings,   sizeof(state.ilBindings)))
+      return false;
+
+    // Depth and stencil parameters only matter if
+    // the corresponding test is actually enabled
+    if (state.ds.enableDepthTest()       != other.ds.enableDepthTest()
+     || state.ds.enableDepthBoundsTest() != other.ds.enableDepthBoundsTest()
+     || state.ds.enableStencilTest()     != other.ds.enableStencilTest())
+      return false;
+
+    if (state.ds.enableDepthTest()) {
+      if (state.ds.enableDepthWrite() != other.ds.enableDepthWrite()
+       || state.ds.depthCompareOp()   != other.ds.depthCompareOp())
+        return false;
+    }
+
+    if (state.ds.enableStencilTest()) {
+      if (std::memcmp(&state.dsFront, &other.dsFront, sizeof(state.dsFront))
+       || std::memcmp(&state.dsBack,  &other.dsBack,  sizeof(state.dsBack)))
+        return false;
+    }
+
+    // Likewise, blend factors and ops are
+    // ignored if blending is disabled
+    for (uint32_t i = 0; i < MaxNumRenderTargets; i++) {
+      const auto& a = state.omBlend[i];
+      const auto& b = other.omBlend[i];
+
+      if (a.blendEnable()    != b.blendEnable()
+       || a.colorWriteMask() != b.colorWriteMask())
+        return false;
+
+      if (a.blendEnable() && std::memcmp(&a, &b, sizeof(a)))
+        return false;
+    }
+
+    return true;
+  }
+
+
   DxvkShaderModule DxvkGraphicsPipeline::createShaderModule(
     const Rc<DxvkShader>&                shader,
     const DxvkGraphicsPipelineStateInfo& state) const {
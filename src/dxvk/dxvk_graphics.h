@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <mutex>
 
 #include "dxvk_bind_mask.h"
@@ -12,9 +13,12 @@
 #include "dxvk_shader.h"
 #include "dxvk_stats.h"
 
+#include "../util/sync/sync_list.h"
+
 namespace dxvk {
   
   class DxvkDevice;
+  class DxvkGraphicsPipeline;
   class DxvkPipelineManager;
 
   /**
@@ -81,14 +85,17 @@ namespace dxvk {
     DxvkGraphicsPipelineInstance()
     : m_stateVector (),
       m_renderPass  (VK_NULL_HANDLE),
+      m_hash        (0),
       m_pipeline    (VK_NULL_HANDLE) { }
 
     DxvkGraphicsPipelineInstance(
       const DxvkGraphicsPipelineStateInfo&  state,
       const DxvkRenderPass*                 rp,
+            size_t                          hash,
             VkPipeline                      pipe)
     : m_stateVector (state),
       m_renderPass  (rp),
+      m_hash        (hash),
       m_pipeline    (pipe) { }
 
     /**
@@ -96,12 +103,15 @@ namespace dxvk {
      * 
      * \param [in] stateVector Graphics pipeline state
      * \param [in] renderPass Render pass handle
+     * \param [in] hash Hash of the state vector
      * \returns \c true if the specialization is compatible
      */
     bool isCompatible(
       const DxvkGraphicsPipelineStateInfo&  state,
-      const DxvkRenderPass*                 rp) {
-      return m_renderPass  == rp
+      const DxvkRenderPass*                 rp,
+            size_t                          hash) const {
+      return m_hash        == hash
+          && m_renderPass  == rp
           && m_stateVector == state;
     }
 
@@ -113,14 +123,185 @@ namespace dxvk {
       return m_pipeline;
     }
 
+    /**
+     * \brief Retrieves state vector
+     * \returns Pipeline state vector
+     */
+    const DxvkGraphicsPipelineStateInfo& state() const {
+      return m_stateVector;
+    }
+
+    /**
+     * \brief Retrieves render pass
+     * \returns The render pass
+     */
+    const DxvkRenderPass* renderPass() const {
+      return m_renderPass;
+    }
+
+    /**
+     * \brief Retrieves state vector hash
+     * \returns Hash of the state vector
+     */
+    size_t hash() const {
+      return m_hash;
+    }
+
   private:
 
     DxvkGraphicsPipelineStateInfo m_stateVector;
     const DxvkRenderPass*         m_renderPass;
+    size_t                        m_hash;
     VkPipeline                    m_pipeline;
 
   };
 
+
+  /**
+   * \brief Graphics pipeline instance table
+   *
+   * Hash table of pipeline instances. Instances are
+   * never removed, so lookups do not need to take a
+   * lock and can run concurrently with insertions.
+   * Callers must make sure that the same state vector
+   * is not inserted twice.
+   */
+  class DxvkGraphicsPipelineInstanceTable {
+    constexpr static uint32_t BucketCount = 16;
+  public:
+
+    /**
+     * \brief Looks up a pipeline instance
+     *
+     * \param [in] state Pipeline state vector
+     * \param [in] rp The render pass
+     * \param [in] hash Hash of the state vector
+     * \returns Pipeline instance, or \c nullptr
+     */
+    const DxvkGraphicsPipelineInstance* find(
+      const DxvkGraphicsPipelineStateInfo&  state,
+      const DxvkRenderPass*                 rp,
+            size_t                          hash) const {
+      for (const auto& instance : m_buckets[hash % BucketCount]) {
+        if (instance.isCompatible(state, rp, hash))
+          return &instance;
+      }
+
+      return nullptr;
+    }
+
+    /**
+     * \brief Adds a pipeline instance
+     *
+     * \param [in] state Pipeline state vector
+     * \param [in] rp The render pass
+     * \param [in] hash Hash of the state vector
+     * \param [in] pipe Pipeline handle
+     * \returns The new pipeline instance
+     */
+    const DxvkGraphicsPipelineInstance* insert(
+      const DxvkGraphicsPipelineStateInfo&  state,
+      const DxvkRenderPass*                 rp,
+            size_t                          hash,
+            VkPipeline                      pipe) {
+      return &(*m_buckets[hash % BucketCount].emplace(state, rp, hash, pipe));
+    }
+
+    /**
+     * \brief Iterates over all instances
+     * \param [in] fn Function to call for each instance
+     */
+    template<typename Fn>
+    void forEach(const Fn& fn) const {
+      for (const auto& bucket : m_buckets) {
+        for (const auto& instance : bucket)
+          fn(instance);
+      }
+    }
+
+  private:
+
+    std::array<sync::List<DxvkGraphicsPipelineInstance>, BucketCount> m_buckets;
+
+  };
+
+
+  /**
+   * \brief Graphics pipeline instance cache
+   *
+   * Small most-recently-used list of pipeline instances
+   * that a context has looked up, so that switching back
+   * and forth between a few pipeline states does not need
+   * to go through the pipeline's instance table. Not
+   * thread-safe, each context owns its own cache.
+   */
+  class DxvkGraphicsPipelineInstanceCache {
+    constexpr static uint32_t EntryCount = 8;
+  public:
+
+    /**
+     * \brief Looks up a pipeline instance
+     *
+     * Moves the instance to the front of the
+     * list if it is found.
+     * \param [in] pipeline The graphics pipeline
+     * \param [in] state Pipeline state vector
+     * \param [in] rp The render pass
+     * \param [in] hash Hash of the state vector
+     * \returns Pipeline instance, or \c nullptr
+     */
+    const DxvkGraphicsPipelineInstance* find(
+      const DxvkGraphicsPipeline*           pipeline,
+      const DxvkGraphicsPipelineStateInfo&  state,
+      const DxvkRenderPass*                 rp,
+            size_t                          hash) {
+      for (uint32_t i = 0; i < EntryCount; i++) {
+        Entry entry = m_entries[i];
+
+        if (entry.pipeline == pipeline
+         && entry.instance->isCompatible(state, rp, hash)) {
+          for (uint32_t j = i; j > 0; j--)
+            m_entries[j] = m_entries[j - 1];
+
+          m_entries[0] = entry;
+          return entry.instance;
+        }
+      }
+
+      return nullptr;
+    }
+
+    /**
+     * \brief Adds a pipeline instance
+     *
+     * Evicts the least recently used instance. Instances
+     * without a valid pipeline handle are not cached.
+     * \param [in] pipeline The graphics pipeline
+     * \param [in] instance The pipeline instance
+     */
+    void insert(
+      const DxvkGraphicsPipeline*           pipeline,
+      const DxvkGraphicsPipelineInstance*   instance) {
+      if (unlikely(!instance->pipeline()))
+        return;
+
+      for (uint32_t j = EntryCount - 1; j > 0; j--)
+        m_entries[j] = m_entries[j - 1];
+
+      m_entries[0] = { pipeline, instance };
+    }
+
+  private:
+
+    struct Entry {
+      const DxvkGraphicsPipeline*         pipeline = nullptr;
+      const DxvkGraphicsPipelineInstance* instance = nullptr;
+    };
+
+    std::array<Entry, EntryCount> m_entries;
+
+  };
+
   
   /**
    * \brief Graphics pipeline
@@ -190,6 +371,62 @@ namespace dxvk {
     VkPipeline getPipelineHandle(
       const DxvkGraphicsPipelineStateInfo&    state,
       const DxvkRenderPass*                   renderPass);
+
+    /**
+     * \brief Pipeline instance
+     * 
+     * Same as \ref getPipelineHandle, but takes a
+     * precomputed hash of the state vector and returns
+     * the pipeline instance, which remains valid for
+     * the lifetime of the pipeline object.
+     * \param [in] state Pipeline state vector
+     * \param [in] renderPass The render pass
+     * \param [in] hash Hash of the state vector
+     * \returns Pipeline instance, or \c nullptr
+     *    if the state vector is invalid
+     */
+    const DxvkGraphicsPipelineInstance* getInstance(
+      const DxvkGraphicsPipelineStateInfo&    state,
+      const DxvkRenderPass*                   renderPass,
+            size_t                            hash);
+    
+    /**
+     * \brief Pipeline instance, compiled asynchronously
+     *
+     * Same as \ref getInstance, but if the pipeline instance
+     * does not exist yet, it will be compiled on the state
+     * cache's worker threads and \c nullptr is returned until
+     * the instance is ready. Compiles the pipeline on the
+     * calling thread if the state cache is disabled.
+     * \param [in] state Pipeline state vector
+     * \param [in] renderPass The render pass
+     * \param [in] hash Hash of the state vector
+     * \param [out] pending Set to \c true if the instance
+     *    is still being compiled
+     * \returns Pipeline instance, or \c nullptr
+     */
+    const DxvkGraphicsPipelineInstance* getInstanceAsync(
+      const DxvkGraphicsPipelineStateInfo&    state,
+      const DxvkRenderPass*                   renderPass,
+            size_t                            hash,
+            bool&                             pending);
+
+    /**
+     * \brief Finds a compatible pipeline instance
+     *
+     * Looks for an existing instance that uses the same
+     * render pass and the same state, except for depth,
+     * stencil or blend parameters that are not used since
+     * the corresponding test or blending is disabled. Such
+     * an instance renders the same way as the requested
+     * one and can be used while that is being compiled.
+     * \param [in] state Pipeline state vector
+     * \param [in] renderPass The render pass
+     * \returns Pipeline instance, or \c nullptr
+     */
+    const DxvkGraphicsPipelineInstance* getFallbackInstance(
+      const DxvkGraphicsPipelineStateInfo&    state,
+      const DxvkRenderPass*                   renderPass) const;
     
     /**
      * \brief Compiles a pipeline
@@ -202,6 +439,20 @@ namespace dxvk {
     void compilePipeline(
       const DxvkGraphicsPipelineStateInfo&    state,
       const DxvkRenderPass*                   renderPass);
+
+    /**
+     * \brief Compiles a pending pipeline instance
+     *
+     * Used by worker threads to compile instances that
+     * were requested through \ref getInstanceAsync. Adds
+     * the state vector to the state cache and removes the
+     * instance from the list of pending instances.
+     * \param [in] state Pipeline state vector
+     * \param [in] renderPass The render pass
+     */
+    void compilePendingInstance(
+      const DxvkGraphicsPipelineStateInfo&    state,
+      const DxvkRenderPass*                   renderPass);
     
   private:
     
@@ -219,17 +470,21 @@ namespace dxvk {
     DxvkGraphicsPipelineFlags           m_flags;
     DxvkGraphicsCommonPipelineStateInfo m_common;
     
-    // List of pipeline instances, shared between threads
-    alignas(CACHE_LINE_SIZE) sync::Spinlock   m_mutex;
-    std::vector<DxvkGraphicsPipelineInstance> m_pipelines;
-    
-    DxvkGraphicsPipelineInstance* createInstance(
-      const DxvkGraphicsPipelineStateInfo& state,
-      const DxvkRenderPass*                renderPass);
+    // Table of pipeline instances, shared between threads.
+    // Lookups are lock-free, the lock is only taken in order
+    // to not compile the same pipeline on multiple threads.
+    alignas(CACHE_LINE_SIZE) dxvk::mutex m_mutex;
+    DxvkGraphicsPipelineInstanceTable    m_pipelines;
+
+    // Instances that have been queued for asynchronous
+    // compilation. Pipeline handles are always null.
+    alignas(CACHE_LINE_SIZE) sync::Spinlock m_pendingLock;
+    std::vector<DxvkGraphicsPipelineInstance> m_pending;
     
-    DxvkGraphicsPipelineInstance* findInstance(
+    const DxvkGraphicsPipelineInstance* createInstance(
       const DxvkGraphicsPipelineStateInfo& state,
-      const DxvkRenderPass*                renderPass);
+      const DxvkRenderPass*                renderPass,
+            size_t                         hash);
     
     VkPipeline createPipeline(
       const DxvkGraphicsPipelineStateInfo& state,
@@ -237,6 +492,10 @@ namespace dxvk {
     
     void destroyPipeline(
             VkPipeline                     pipeline) const;
+
+    static bool isFallbackCompatible(
+      const DxvkGraphicsPipelineStateInfo& state,
+      const DxvkGraphicsPipelineStateInfo& other);
     
     DxvkShaderModule createShaderModule(
       const Rc<DxvkShader>&                shader,
@@ -10,6 +10,8 @@
 namespace dxvk {
   
   DxvkInstance::DxvkInstance() {
+    Logger::acquireWriter();
+
     Logger::info(str::format("Game: ", env::getExeName()));
     Logger::info(str::format("DXVK: ", DXVK_VERSION));
 
@@ -52,7 +54,7 @@ namespace dxvk {
   
   
   DxvkInstance::~DxvkInstance() {
-    
+    Logger::releaseWriter();
   }
   
   
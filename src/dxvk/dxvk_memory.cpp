@@ -11,6 +11,7 @@ namespace dxvk {
           VkDeviceMemory        memory,
           VkDeviceSize          offset,
           VkDeviceSize          length,
+          uint32_t              block,
           void*                 mapPtr)
   : m_alloc   (alloc),
     m_chunk   (chunk),
@@ -18,6 +19,7 @@ namespace dxvk {
     m_memory  (memory),
     m_offset  (offset),
     m_length  (length),
+    m_block   (block),
     m_mapPtr  (mapPtr) { }
   
   
@@ -28,6 +30,7 @@ namespace dxvk {
     m_memory  (std::exchange(other.m_memory, VkDeviceMemory(VK_NULL_HANDLE))),
     m_offset  (std::exchange(other.m_offset, 0)),
     m_length  (std::exchange(other.m_length, 0)),
+    m_block   (std::exchange(other.m_block,  0)),
     m_mapPtr  (std::exchange(other.m_mapPtr, nullptr)) { }
   
   
@@ -39,6 +42,7 @@ namespace dxvk {
     m_memory  = std::exchange(other.m_memory, VkDeviceMemory(VK_NULL_HANDLE));
     m_offset  = std::exchange(other.m_offset, 0);
     m_length  = std::exchange(other.m_length, 0);
+    m_block   = std::exchange(other.m_block,  0);
     m_mapPtr  = std::exchange(other.m_mapPtr, nullptr);
     return *this;
   }
@@ -59,9 +63,9 @@ namespace dxvk {
           DxvkMemoryAllocator*  alloc,
           DxvkMemoryType*       type,
           DxvkDeviceMemory      memory)
-  : m_alloc(alloc), m_type(type), m_memory(memory) {
-    // Mark the entire chunk as free
-    m_freeList.push_back(FreeSlice { 0, memory.memSize });
+  : m_alloc(alloc), m_type(type), m_memory(memory),
+    m_allocator(memory.memSize) {
+
   }
   
   
@@ -79,76 +83,36 @@ namespace dxvk {
           float                 priority) {
     // Property flags must be compatible. This could
     // be refined a bit in the future if necessary.
-    if (m_memory.memFlags != flags
-     || m_memory.priority != priority)
+    if (!isCompatible(flags, priority))
       return DxvkMemory();
     
     // If the chunk is full, return
-    if (m_freeList.size() == 0)
+    if (m_allocator.used() == m_allocator.size())
       return DxvkMemory();
     
-    // Select the slice to allocate from in a worst-fit
-    // manner. This may help keep fragmentation low.
-    auto bestSlice = m_freeList.begin();
-    
-    for (auto slice = m_freeList.begin(); slice != m_freeList.end(); slice++) {
-      if (slice->length == size) {
-        bestSlice = slice;
-        break;
-      } else if (slice->length > bestSlice->length) {
-        bestSlice = slice;
-      }
-    }
-    
-    // We need to align the allocation to the requested alignment
-    const VkDeviceSize sliceStart = bestSlice->offset;
-    const VkDeviceSize sliceEnd   = bestSlice->offset + bestSlice->length;
-    
-    const VkDeviceSize allocStart = dxvk::align(sliceStart,        align);
-    const VkDeviceSize allocEnd   = dxvk::align(allocStart + size, align);
-    
-    if (allocEnd > sliceEnd)
+    DxvkTlsfAllocation allocation = m_allocator.alloc(size, align);
+
+    if (allocation.offset == DxvkTlsfAllocator::InvalidOffset)
       return DxvkMemory();
     
-    // We can use this slice, but we'll have to add
-    // the unused parts of it back to the free list.
-    m_freeList.erase(bestSlice);
-    
-    if (allocStart != sliceStart)
-      m_freeList.push_back({ sliceStart, allocStart - sliceStart });
-    
-    if (allocEnd != sliceEnd)
-      m_freeList.push_back({ allocEnd, sliceEnd - allocEnd });
-    
-    // Create the memory object with the aligned slice
+    // The sub-allocator pads the size to the alignment
+    return getSlice(allocation.offset, dxvk::align(size, align), allocation.block);
+  }
+
+
+  DxvkMemory DxvkMemoryChunk::getSlice(
+          VkDeviceSize          offset,
+          VkDeviceSize          length,
+          uint32_t              block) {
     return DxvkMemory(m_alloc, this, m_type,
-      m_memory.memHandle, allocStart, allocEnd - allocStart,
-      reinterpret_cast<char*>(m_memory.memPointer) + allocStart);
+      m_memory.memHandle, offset, length, block,
+      reinterpret_cast<char*>(m_memory.memPointer) + offset);
   }
   
   
   void DxvkMemoryChunk::free(
-          VkDeviceSize  offset,
-          VkDeviceSize  length) {
-    // Remove adjacent entries from the free list and then add
-    // a new slice that covers all those entries. Without doing
-    // so, the slice could not be reused for larger allocations.
-    auto curr = m_freeList.begin();
-    
-    while (curr != m_freeList.end()) {
-      if (curr->offset == offset + length) {
-        length += curr->length;
-        curr = m_freeList.erase(curr);
-      } else if (curr->offset + curr->length == offset) {
-        offset -= curr->length;
-        length += curr->length;
-        curr = m_freeList.erase(curr);
-      } else {
-        curr++;
-      }
-    }
-    
-    m_freeList.push_back({ offset, length });
+          uint32_t      block) {
+    m_allocator.free(block);
   }
   
   
@@ -159,7 +123,6 @@ namespace dxvk {
     m_memProps        (device->adapter()->memoryProperties()) {
     for (uint32_t i = 0; i < m_memProps.memoryHeapCount; i++) {
       m_memHeaps[i].properties = m_memProps.memoryHeaps[i];
-      m_memHeaps[i].stats      = DxvkMemoryStats { 0, 0 };
       m_memHeaps[i].budget     = 0;
 
       /* Target 80% of a heap on systems where we want
@@ -210,30 +173,16 @@ namespace dxvk {
     const VkMemoryDedicatedAllocateInfo&    dedAllocInfo,
           VkMemoryPropertyFlags             flags,
           float                             priority) {
-    std::lock_guard<dxvk::mutex> lock(m_mutex);
-
-    // Try to allocate from a memory type which supports the given flags exactly
-    auto dedAllocPtr = dedAllocReq.prefersDedicatedAllocation ? &dedAllocInfo : nullptr;
-    DxvkMemory result = this->tryAlloc(req, dedAllocPtr, flags, priority);
-
-    // If the first attempt failed, try ignoring the dedicated allocation
-    if (!result && dedAllocPtr && !dedAllocReq.requiresDedicatedAllocation) {
-      result = this->tryAlloc(req, nullptr, flags, priority);
-      dedAllocPtr = nullptr;
+    DxvkMemory result = this->tryAllocWithFallback(
+      req, dedAllocReq, dedAllocInfo, flags, priority);
+
+    // Cached slices may keep chunks from serving larger
+    // allocations, so return them and try again
+    if (!result && this->freeCachedMemory()) {
+      result = this->tryAllocWithFallback(
+        req, dedAllocReq, dedAllocInfo, flags, priority);
     }
 
-    // If that still didn't work, probe slower memory types as well
-    VkMemoryPropertyFlags optFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
-                                   | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
-    VkMemoryPropertyFlags remFlags = 0;
-    
-    while (!result && (flags & optFlags)) {
-      remFlags |= optFlags & -optFlags;
-      optFlags &= ~remFlags;
-
-      result = this->tryAlloc(req, dedAllocPtr, flags & ~remFlags, priority);
-    }
-    
     if (!result) {
       DxvkAdapterMemoryInfo memHeapInfo = m_device->adapter()->getMemoryHeapInfo();
 
@@ -245,9 +194,11 @@ namespace dxvk {
         "\n  Mem types: ", "0x", std::hex, req->memoryTypeBits));
 
       for (uint32_t i = 0; i < m_memProps.memoryHeapCount; i++) {
+        DxvkMemoryStats stats = getMemoryStats(i);
+
         Logger::err(str::format("Heap ", i, ": ",
-          (m_memHeaps[i].stats.memoryAllocated >> 20), " MB allocated, ",
-          (m_memHeaps[i].stats.memoryUsed      >> 20), " MB used, ",
+          (stats.memoryAllocated >> 20), " MB allocated, ",
+          (stats.memoryUsed      >> 20), " MB used, ",
           m_device->extensions().extMemoryBudget
             ? str::format(
                 (memHeapInfo.heaps[i].memoryAllocated >> 20), " MB allocated (driver), ",
@@ -259,11 +210,123 @@ namespace dxvk {
 
       throw DxvkError("DxvkMemoryAllocator: Memory allocation failed");
     }
-    
+
+    m_allocCount.fetch_add(1, std::memory_order_relaxed);
     return result;
   }
   
   
+  DxvkMemory DxvkMemoryAllocator::tryAllocWithFallback(
+    const VkMemoryRequirements*             req,
+    const VkMemoryDedicatedRequirements&    dedAllocReq,
+    const VkMemoryDedicatedAllocateInfo&    dedAllocInfo,
+          VkMemoryPropertyFlags             flags,
+          float                             priority) {
+    // Small allocations are served from the
+    // slice caches whenever possible
+    auto dedAllocPtr = dedAllocReq.prefersDedicatedAllocation ? &dedAllocInfo : nullptr;
+    DxvkMemory result;
+
+    if (!dedAllocPtr)
+      result = this->tryAllocCached(req, flags, priority);
+
+    // Try to allocate from a memory type which supports the given flags exactly
+    if (!result)
+      result = this->tryAlloc(req, dedAllocPtr, flags, priority);
+
+    // If the first attempt failed, try ignoring the dedicated allocation
+    if (!result && dedAllocPtr && !dedAllocReq.requiresDedicatedAllocation) {
+      result = this->tryAlloc(req, nullptr, flags, priority);
+      dedAllocPtr = nullptr;
+    }
+
+    // If that still didn't work, probe slower memory types as well
+    VkMemoryPropertyFlags optFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+                                   | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+    VkMemoryPropertyFlags remFlags = 0;
+    
+    while (!result && (flags & optFlags)) {
+      remFlags |= optFlags & -optFlags;
+      optFlags &= ~remFlags;
+
+      result = this->tryAlloc(req, dedAllocPtr, flags & ~remFlags, priority);
+    }
+
+    return result;
+  }
+
+
+  DxvkMemory DxvkMemoryAllocator::tryAllocCached(
+    const VkMemoryRequirements*             req,
+          VkMemoryPropertyFlags             flags,
+          float                             priority) {
+    if (req->size > DxvkMemoryCacheMaxSize
+     || req->alignment > DxvkMemoryCacheMaxSize)
+      return DxvkMemory();
+
+    // Cached slices are aligned to their size, so any slice
+    // of the given size class can serve the allocation
+    uint32_t sizeClass = getSizeClass(std::max(req->size, req->alignment));
+    VkDeviceSize size = DxvkMemoryCacheMinSize << sizeClass;
+
+    if (!(flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT))
+      priority = 0.0f;
+
+    for (uint32_t i = 0; i < m_memProps.memoryTypeCount; i++) {
+      const bool supported = (req->memoryTypeBits & (1u << i)) != 0;
+      const bool adequate  = (m_memTypes[i].memType.propertyFlags & flags) == flags;
+
+      if (!supported || !adequate)
+        continue;
+
+      DxvkMemoryType* type = &m_memTypes[i];
+      DxvkMemorySlice slice = { nullptr, 0, 0 };
+
+      { DxvkMemoryCache& cache = getCache();
+        std::lock_guard<dxvk::mutex> cacheLock(cache.lock);
+
+        auto& magazine = cache.magazines[type->memTypeId * DxvkMemoryCacheClassCount + sizeClass];
+
+        if (magazine.empty()) {
+          std::lock_guard<dxvk::mutex> typeLock(type->mutex);
+          auto& depot = type->depot[sizeClass];
+
+          if (!depot.empty()) {
+            magazine = std::move(depot.back());
+            depot.pop_back();
+          }
+        }
+
+        // Chunks of the same memory type may have been allocated
+        // with different flags or priorities, so a single slice
+        // that we cannot use must not block the entire magazine
+        for (size_t j = magazine.size(); j; j--) {
+          if (magazine[j - 1].chunk->isCompatible(flags, priority)) {
+            slice = magazine[j - 1];
+            magazine[j - 1] = magazine.back();
+            magazine.pop_back();
+            break;
+          }
+        }
+      }
+
+      if (slice.chunk) {
+        type->heap->memoryUsed += size;
+        return slice.chunk->getSlice(slice.offset, size, slice.block);
+      }
+
+      // Allocate a full slice of the size class so
+      // that it can be cached once it gets freed
+      DxvkMemory memory = this->tryAllocFromType(type, flags, size, size, priority, nullptr);
+
+      if (memory)
+        return memory;
+    }
+
+    return DxvkMemory();
+  }
+
+
   DxvkMemory DxvkMemoryAllocator::tryAlloc(
     const VkMemoryRequirements*             req,
     const VkMemoryDedicatedAllocateInfo*    dedAllocInfo,
@@ -305,8 +368,10 @@ namespace dxvk {
         type, flags, size, priority, dedAllocInfo);
 
       if (devMem.memHandle != VK_NULL_HANDLE)
-        memory = DxvkMemory(this, nullptr, type, devMem.memHandle, 0, size, devMem.memPointer);
+        memory = DxvkMemory(this, nullptr, type, devMem.memHandle, 0, size, 0, devMem.memPointer);
     } else {
+      std::lock_guard<dxvk::mutex> lock(type->mutex);
+
       for (uint32_t i = 0; i < type->chunks.size() && !memory; i++)
         memory = type->chunks[i]->alloc(flags, size, align, priority);
       
@@ -326,7 +391,7 @@ namespace dxvk {
     }
 
     if (memory)
-      type->heap->stats.memoryUsed += memory.m_length;
+      type->heap->memoryUsed += memory.m_length;
 
     return memory;
   }
@@ -341,8 +406,14 @@ namespace dxvk {
     bool useMemoryPriority = (flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
                           && (m_device->features().extMemoryPriority.memoryPriority);
     
-    if (type->heap->budget && type->heap->stats.memoryAllocated + size > type->heap->budget)
+    // Reserve the memory up front so that concurrent
+    // allocations on the same heap respect the budget
+    VkDeviceSize allocated = type->heap->memoryAllocated.fetch_add(size) + size;
+
+    if (type->heap->budget && allocated > type->heap->budget) {
+      type->heap->memoryAllocated -= size;
       return DxvkDeviceMemory();
+    }
 
     DxvkDeviceMemory result;
     result.memSize  = size;
@@ -360,8 +431,10 @@ namespace dxvk {
     info.allocationSize   = size;
     info.memoryTypeIndex  = type->memTypeId;
 
-    if (m_vkd->vkAllocateMemory(m_vkd->device(), &info, nullptr, &result.memHandle) != VK_SUCCESS)
+    if (m_vkd->vkAllocateMemory(m_vkd->device(), &info, nullptr, &result.memHandle) != VK_SUCCESS) {
+      type->heap->memoryAllocated -= size;
       return DxvkDeviceMemory();
+    }
     
     if (flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
       VkResult status = m_vkd->vkMapMemory(m_vkd->device(), result.memHandle, 0, VK_WHOLE_SIZE, 0, &result.memPointer);
@@ -369,27 +442,32 @@ namespace dxvk {
       if (status != VK_SUCCESS) {
         Logger::err(str::format("DxvkMemoryAllocator: Mapping memory failed with ", status));
         m_vkd->vkFreeMemory(m_vkd->device(), result.memHandle, nullptr);
+        type->heap->memoryAllocated -= size;
         return DxvkDeviceMemory();
       }
     }
 
-    type->heap->stats.memoryAllocated += size;
     m_device->adapter()->notifyHeapMemoryAlloc(type->heapId, size);
+    m_deviceAllocCount.fetch_add(1, std::memory_order_relaxed);
     return result;
   }
 
 
   void DxvkMemoryAllocator::free(
     const DxvkMemory&           memory) {
-    std::lock_guard<dxvk::mutex> lock(m_mutex);
-    memory.m_type->heap->stats.memoryUsed -= memory.m_length;
+    memory.m_type->heap->memoryUsed -= memory.m_length;
+    m_freeCount.fetch_add(1, std::memory_order_relaxed);
 
     if (memory.m_chunk != nullptr) {
+      if (this->tryFreeCached(memory))
+        return;
+
+      std::lock_guard<dxvk::mutex> lock(memory.m_type->mutex);
+
       this->freeChunkMemory(
         memory.m_type,
         memory.m_chunk,
-        memory.m_offset,
-        memory.m_length);
+        memory.m_block);
     } else {
       DxvkDeviceMemory devMem;
       devMem.memHandle  = memory.m_memory;
@@ -399,13 +477,120 @@ namespace dxvk {
     }
   }
 
+
+  bool DxvkMemoryAllocator::tryFreeCached(
+    const DxvkMemory&           memory) {
+    // Only slices that match a size class exactly and are
+    // aligned to their size can be used to serve any
+    // allocation of that size class later on
+    if (memory.m_length < DxvkMemoryCacheMinSize
+     || memory.m_length > DxvkMemoryCacheMaxSize
+     || (memory.m_length & (memory.m_length - 1))
+     || (memory.m_offset & (memory.m_length - 1)))
+      return false;
+
+    uint32_t sizeClass = getSizeClass(memory.m_length);
+    uint32_t capacity = getMagazineCapacity(sizeClass);
+
+    DxvkMemoryCache& cache = getCache();
+    std::lock_guard<dxvk::mutex> cacheLock(cache.lock);
+
+    auto& magazine = cache.magazines[memory.m_type->memTypeId * DxvkMemoryCacheClassCount + sizeClass];
+
+    if (magazine.size() >= capacity) {
+      // Move full magazines to the depot so that other
+      // threads can use them, or return the slices to
+      // their chunks if the depot is full as well
+      std::lock_guard<dxvk::mutex> typeLock(memory.m_type->mutex);
+      auto& depot = memory.m_type->depot[sizeClass];
+
+      if (depot.size() < DepotCapacity) {
+        depot.push_back(std::move(magazine));
+        magazine = DxvkMemoryMagazine();
+      } else {
+        freeMagazine(memory.m_type, magazine);
+      }
+    }
+
+    if (magazine.empty())
+      magazine.reserve(capacity);
+
+    magazine.push_back({ memory.m_chunk, memory.m_offset, memory.m_block });
+    return true;
+  }
+
+
+  bool DxvkMemoryAllocator::freeCachedMemory() {
+    bool freed = false;
+
+    for (auto& cache : m_caches) {
+      std::lock_guard<dxvk::mutex> cacheLock(cache.lock);
+
+      for (uint32_t i = 0; i < m_memProps.memoryTypeCount; i++) {
+        DxvkMemoryType* type = &m_memTypes[i];
+        std::lock_guard<dxvk::mutex> typeLock(type->mutex);
+
+        for (uint32_t j = 0; j < DxvkMemoryCacheClassCount; j++) {
+          auto& magazine = cache.magazines[i * DxvkMemoryCacheClassCount + j];
+          freed |= !magazine.empty();
+          freeMagazine(type, magazine);
+
+          for (auto& depotMagazine : type->depot[j]) {
+            freed |= !depotMagazine.empty();
+            freeMagazine(type, depotMagazine);
+          }
+
+          type->depot[j].clear();
+        }
+      }
+    }
+
+    return freed;
+  }
+
+
+  void DxvkMemoryAllocator::freeMagazine(
+          DxvkMemoryType*       type,
+          DxvkMemoryMagazine&   magazine) {
+    for (const auto& slice : magazine)
+      this->freeChunkMemory(type, slice.chunk, slice.block);
+
+    magazine.clear();
+  }
+
+
+  DxvkMemoryCache& DxvkMemoryAllocator::getCache() {
+    // Win32 thread IDs are multiples of four
+    return m_caches[(dxvk::this_thread::get_id() >> 2) % CacheCount];
+  }
+
+
+  uint32_t DxvkMemoryAllocator::getMagazineCapacity(
+          uint32_t              sizeClass) {
+    // Limit the amount of memory held by a single magazine
+    constexpr VkDeviceSize MagazineSize = 128 << 10;
+
+    VkDeviceSize size = DxvkMemoryCacheMinSize << sizeClass;
+    return uint32_t(std::clamp<VkDeviceSize>(MagazineSize / size, 4, 64));
+  }
+
+
+  uint32_t DxvkMemoryAllocator::getSizeClass(
+          VkDeviceSize          size) {
+    uint32_t sizeClass = 0;
+
+    while ((DxvkMemoryCacheMinSize << sizeClass) < size)
+      sizeClass += 1;
+
+    return sizeClass;
+  }
+
   
   void DxvkMemoryAllocator::freeChunkMemory(
           DxvkMemoryType*       type,
           DxvkMemoryChunk*      chunk,
-          VkDeviceSize          offset,
-          VkDeviceSize          length) {
-    chunk->free(offset, length);
+          uint32_t              block) {
+    chunk->free(block);
   }
   
 
@@ -413,8 +598,9 @@ namespace dxvk {
           DxvkMemoryType*       type,
           DxvkDeviceMemory      memory) {
     m_vkd->vkFreeMemory(m_vkd->device(), memory.memHandle, nullptr);
-    type->heap->stats.memoryAllocated -= memory.memSize;
+    type->heap->memoryAllocated -= memory.memSize;
     m_device->adapter()->notifyHeapMemoryFree(type->heapId, memory.memSize);
+    m_deviceFreeCount.fetch_add(1, std::memory_order_relaxed);
   }
 
 
@@ -1,11 +1,23 @@
 #pragma once
 
 #include "dxvk_adapter.h"
+#include "dxvk_stats.h"
+#include "dxvk_tlsf.h"
 
 namespace dxvk {
   
   class DxvkMemoryAllocator;
   class DxvkMemoryChunk;
+
+  /**
+   * \brief Number of cached size classes
+   *
+   * Size classes are powers of two, starting at
+   * \c DxvkMemoryCacheMinSize.
+   */
+  constexpr uint32_t     DxvkMemoryCacheClassCount = 9;
+  constexpr VkDeviceSize DxvkMemoryCacheMinSize    = 256;
+  constexpr VkDeviceSize DxvkMemoryCacheMaxSize    = DxvkMemoryCacheMinSize << (DxvkMemoryCacheClassCount - 1);
   
   /**
    * \brief Memory stats
@@ -42,18 +54,43 @@ namespace dxvk {
    * its properties as well as allocation statistics.
    */
   struct DxvkMemoryHeap {
-    VkMemoryHeap      properties;
-    DxvkMemoryStats   stats;
-    VkDeviceSize      budget;
+    VkMemoryHeap              properties;
+    std::atomic<VkDeviceSize> memoryAllocated = { 0ull };
+    std::atomic<VkDeviceSize> memoryUsed      = { 0ull };
+    VkDeviceSize              budget;
+  };
+
+
+  /**
+   * \brief Cached memory slice
+   *
+   * Chunk slice that has been freed by the application,
+   * but not yet returned to the chunk. The slice size is
+   * implied by the size class it is stored under.
+   */
+  struct DxvkMemorySlice {
+    DxvkMemoryChunk*  chunk;
+    VkDeviceSize      offset;
+    uint32_t          block;
   };
 
 
+  /**
+   * \brief Memory magazine
+   *
+   * Stack of cached slices of one memory
+   * type and one size class.
+   */
+  using DxvkMemoryMagazine = std::vector<DxvkMemorySlice>;
+
+
   /**
    * \brief Memory type
    * 
    * Corresponds to a Vulkan memory type and stores
    * memory chunks used to sub-allocate memory on
-   * this memory type.
+   * this memory type. The chunk list and the magazine
+   * depot are protected by the memory type's lock.
    */
   struct DxvkMemoryType {
     DxvkMemoryHeap*   heap;
@@ -64,7 +101,26 @@ namespace dxvk {
 
     VkDeviceSize      chunkSize;
 
+    dxvk::mutex       mutex;
+
     std::vector<Rc<DxvkMemoryChunk>> chunks;
+
+    std::array<std::vector<DxvkMemoryMagazine>, DxvkMemoryCacheClassCount> depot;
+  };
+
+
+  /**
+   * \brief Memory cache
+   *
+   * Stores one magazine per memory type and size class.
+   * Threads are mapped to one of several caches based
+   * on their thread ID, so that threads recycling small
+   * allocations mostly do not contend on a lock.
+   */
+  struct alignas(CACHE_LINE_SIZE) DxvkMemoryCache {
+    dxvk::mutex       lock;
+
+    std::array<DxvkMemoryMagazine, VK_MAX_MEMORY_TYPES * DxvkMemoryCacheClassCount> magazines;
   };
   
   
@@ -86,6 +142,7 @@ namespace dxvk {
       VkDeviceMemory        memory,
       VkDeviceSize          offset,
       VkDeviceSize          length,
+      uint32_t              block,
       void*                 mapPtr);
     DxvkMemory             (DxvkMemory&& other);
     DxvkMemory& operator = (DxvkMemory&& other);
@@ -150,6 +207,7 @@ namespace dxvk {
     VkDeviceMemory        m_memory = VK_NULL_HANDLE;
     VkDeviceSize          m_offset = 0;
     VkDeviceSize          m_length = 0;
+    uint32_t              m_block  = 0;
     void*                 m_mapPtr = nullptr;
     
     void free();
@@ -162,6 +220,7 @@ namespace dxvk {
    * 
    * A single chunk of memory that provides a
    * sub-allocator. This is not thread-safe.
+   * \sa DxvkTlsfAllocator
    */
   class DxvkMemoryChunk : public RcObject {
     
@@ -174,6 +233,33 @@ namespace dxvk {
     
     ~DxvkMemoryChunk();
 
+    /**
+     * \brief Checks whether the chunk can serve an allocation
+     *
+     * \param [in] flags Requested memory flags
+     * \param [in] priority Requested priority
+     * \returns \c true if flags and priority match
+     */
+    bool isCompatible(
+            VkMemoryPropertyFlags flags,
+            float                 priority) const {
+      return m_memory.memFlags == flags
+          && m_memory.priority == priority;
+    }
+
+    /**
+     * \brief Creates a memory slice for a chunk range
+     *
+     * \param [in] offset Slice offset
+     * \param [in] length Slice length
+     * \param [in] block Sub-allocator block index
+     * \returns Memory slice
+     */
+    DxvkMemory getSlice(
+            VkDeviceSize          offset,
+            VkDeviceSize          length,
+            uint32_t              block);
+
     /**
      * \brief Allocates memory from the chunk
      * 
@@ -197,25 +283,18 @@ namespace dxvk {
      * Returns a slice back to the chunk.
      * Called automatically when a memory
      * slice runs out of scope.
-     * \param [in] offset Slice offset
-     * \param [in] length Slice length
+     * \param [in] block Sub-allocator block index
      */
     void free(
-            VkDeviceSize  offset,
-            VkDeviceSize  length);
+            uint32_t      block);
     
   private:
     
-    struct FreeSlice {
-      VkDeviceSize offset;
-      VkDeviceSize length;
-    };
-    
     DxvkMemoryAllocator*  m_alloc;
     DxvkMemoryType*       m_type;
     DxvkDeviceMemory      m_memory;
     
-    std::vector<FreeSlice> m_freeList;
+    DxvkTlsfAllocator     m_allocator;
     
   };
   
@@ -272,7 +351,25 @@ namespace dxvk {
      * \returns Memory stats for this heap
      */
     DxvkMemoryStats getMemoryStats(uint32_t heap) const {
-      return m_memHeaps[heap].stats;
+      DxvkMemoryStats result;
+      result.memoryAllocated = m_memHeaps[heap].memoryAllocated.load();
+      result.memoryUsed      = m_memHeaps[heap].memoryUsed.load();
+      return result;
+    }
+
+    /**
+     * \brief Queries allocation counters
+     *
+     * Stores the total number of allocations and frees,
+     * as well as the number of Vulkan device memory
+     * allocations and frees, in the given counters.
+     * \param [in,out] counters Stat counters
+     */
+    void getStatCounters(DxvkStatCounters& counters) const {
+      counters.setCtr(DxvkStatCounter::MemoryAllocCount,       m_allocCount.load(std::memory_order_relaxed));
+      counters.setCtr(DxvkStatCounter::MemoryFreeCount,        m_freeCount.load(std::memory_order_relaxed));
+      counters.setCtr(DxvkStatCounter::MemoryDeviceAllocCount, m_deviceAllocCount.load(std::memory_order_relaxed));
+      counters.setCtr(DxvkStatCounter::MemoryDeviceFreeCount,  m_deviceFreeCount.load(std::memory_order_relaxed));
     }
     
   private:
@@ -282,10 +379,31 @@ namespace dxvk {
     const VkPhysicalDeviceProperties       m_devProps;
     const VkPhysicalDeviceMemoryProperties m_memProps;
     
-    dxvk::mutex                                     m_mutex;
+    constexpr static uint32_t CacheCount    = 8;
+    constexpr static uint32_t DepotCapacity = 2;
+
     std::array<DxvkMemoryHeap, VK_MAX_MEMORY_HEAPS> m_memHeaps;
     std::array<DxvkMemoryType, VK_MAX_MEMORY_TYPES> m_memTypes;
 
+    std::array<DxvkMemoryCache, CacheCount>         m_caches;
+
+    std::atomic<uint64_t>                           m_allocCount       = { 0ull };
+    std::atomic<uint64_t>                           m_freeCount        = { 0ull };
+    std::atomic<uint64_t>                           m_deviceAllocCount = { 0ull };
+    std::atomic<uint64_t>                           m_deviceFreeCount  = { 0ull };
+
+    DxvkMemory tryAllocWithFallback(
+      const VkMemoryRequirements*             req,
+      const VkMemoryDedicatedRequirements&    dedAllocReq,
+      const VkMemoryDedicatedAllocateInfo&    dedAllocInfo,
+            VkMemoryPropertyFlags             flags,
+            float                             priority);
+
+    DxvkMemory tryAllocCached(
+      const VkMemoryRequirements*             req,
+            VkMemoryPropertyFlags             flags,
+            float                             priority);
+
     DxvkMemory tryAlloc(
       const VkMemoryRequirements*             req,
       const VkMemoryDedicatedAllocateInfo*    dedAllocInfo,
@@ -310,11 +428,27 @@ namespace dxvk {
     void free(
       const DxvkMemory&           memory);
     
+    bool tryFreeCached(
+      const DxvkMemory&           memory);
+
+    bool freeCachedMemory();
+
+    void freeMagazine(
+            DxvkMemoryType*       type,
+            DxvkMemoryMagazine&   magazine);
+
+    DxvkMemoryCache& getCache();
+
+    static uint32_t getMagazineCapacity(
+            uint32_t              sizeClass);
+
+    static uint32_t getSizeClass(
+            VkDeviceSize          size);
+    
     void freeChunkMemory(
             DxvkMemoryType*       type,
             DxvkMemoryChunk*      chunk,
-            VkDeviceSize          offset,
-            VkDeviceSize          length);
+            uint32_t              block);
     
     void freeDeviceMemory(
             DxvkMemoryType*       type,
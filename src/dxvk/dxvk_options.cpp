@@ -7,6 +7,8 @@ namespace dxvk {
     enableOpenVR          = config.getOption<bool>    ("dxvk.enableOpenVR",           true);
     enableOpenXR          = config.getOption<bool>    ("dxvk.enableOpenXR",           true);
     numCompilerThreads    = config.getOption<int32_t> ("dxvk.numCompilerThreads",     0);
+    asyncPipelineCompile  = config.getOption<bool>    ("dxvk.asyncPipelineCompile",   false);
+    asyncPipelineFallback = config.getOption<bool>    ("dxvk.asyncPipelineFallback",  false);
     useRawSsbo            = config.getOption<Tristate>("dxvk.useRawSsbo",             Tristate::Auto);
     shrinkNvidiaHvvHeap   = config.getOption<Tristate>("dxvk.shrinkNvidiaHvvHeap",    Tristate::Auto);
     hud                   = config.getOption<std::string>("dxvk.hud", "");
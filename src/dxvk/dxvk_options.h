@@ -21,6 +21,14 @@ namespace dxvk {
     /// when using the state cache
     int32_t numCompilerThreads;
 
+    /// Compile missing graphics pipelines on the
+    /// compiler threads instead of stalling draws
+    bool asyncPipelineCompile;
+
+    /// Use a compatible pipeline variant while
+    /// the actual pipeline is being compiled
+    bool asyncPipelineFallback;
+
     /// Shader-related options
     Tristate useRawSsbo;
 
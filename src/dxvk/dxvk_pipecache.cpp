@@ -1,26 +1,199 @@
+#include "dxvk_device.h"
 #include "dxvk_pipecache.h"
 
 namespace dxvk {
   
   DxvkPipelineCache::DxvkPipelineCache(
-    const Rc<vk::DeviceFn>& vkd)
-  : m_vkd(vkd) {
+    const DxvkDevice*         device,
+          bool                persistent)
+  : m_vkd(device->vkd()) {
+    const auto& properties = device->properties().core.properties;
+
+    m_header.vendorId      = properties.vendorID;
+    m_header.deviceId      = properties.deviceID;
+    m_header.driverVersion = properties.driverVersion;
+
+    std::memcpy(m_header.uuid, properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+    std::vector<char> data;
+
+    if (persistent)
+      data = readCacheFile();
+
     VkPipelineCacheCreateInfo info;
     info.sType            = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
     info.pNext            = nullptr;
     info.flags            = 0;
-    info.initialDataSize  = 0;
-    info.pInitialData     = nullptr;
+    info.initialDataSize  = data.size();
+    info.pInitialData     = data.data();
     
-    if (m_vkd->vkCreatePipelineCache(m_vkd->device(),
-        &info, nullptr, &m_handle) != VK_SUCCESS)
+    VkResult status = m_vkd->vkCreatePipelineCache(
+      m_vkd->device(), &info, nullptr, &m_handle);
+
+    // Drivers are supposed to ignore incompatible data,
+    // but retry without initial data just in case
+    if (status != VK_SUCCESS && info.initialDataSize) {
+      Logger::warn("DXVK: Failed to create pipeline cache from file data");
+
+      info.initialDataSize  = 0;
+      info.pInitialData     = nullptr;
+
+      status = m_vkd->vkCreatePipelineCache(
+        m_vkd->device(), &info, nullptr, &m_handle);
+    }
+
+    if (status != VK_SUCCESS)
       throw DxvkError("DxvkPipelineCache: Failed to create cache");
+
+    m_dataSize = info.initialDataSize;
+
+    if (persistent)
+      m_writerThread = dxvk::thread([this] () { writerFunc(); });
   }
   
   
   DxvkPipelineCache::~DxvkPipelineCache() {
+    if (m_writerThread.joinable()) {
+      { std::lock_guard<dxvk::mutex> lock(m_writerLock);
+        m_stopThread = true;
+        m_writerCond.notify_one();
+      }
+
+      m_writerThread.join();
+    }
+
     m_vkd->vkDestroyPipelineCache(
       m_vkd->device(), m_handle, nullptr);
   }
+
+
+  std::vector<char> DxvkPipelineCache::readCacheFile() const {
+    std::ifstream file(getCacheFileName().c_str(), std::ios_base::binary);
+
+    if (!file)
+      return std::vector<char>();
+
+    DxvkPipelineCacheHeader header;
+
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))
+     || std::memcmp(header.magic, m_header.magic, sizeof(header.magic))
+     || header.version       != m_header.version
+     || header.vendorId      != m_header.vendorId
+     || header.deviceId      != m_header.deviceId
+     || header.driverVersion != m_header.driverVersion
+     || std::memcmp(header.uuid, m_header.uuid, VK_UUID_SIZE)) {
+      Logger::warn("DXVK: Pipeline cache file outdated, discarding");
+      return std::vector<char>();
+    }
+
+    // Don't trust the size stored in the file, a corrupted
+    // header could otherwise make us allocate huge amounts
+    // of memory. The data must take up the rest of the file.
+    std::streamoff dataOffset = file.tellg();
+    file.seekg(0, std::ios_base::end);
+    std::streamoff fileSize = file.tellg();
+    file.seekg(dataOffset, std::ios_base::beg);
+
+    if (dataOffset < 0 || fileSize < 0
+     || uint64_t(fileSize - dataOffset) != uint64_t(header.dataSize)) {
+      Logger::warn("DXVK: Pipeline cache file corrupted, discarding");
+      return std::vector<char>();
+    }
+
+    std::vector<char> data(header.dataSize);
+
+    if (!file.read(data.data(), data.size())
+     || header.dataHash != Sha1Hash::compute(data.data(), data.size())) {
+      Logger::warn("DXVK: Pipeline cache file corrupted, discarding");
+      return std::vector<char>();
+    }
+
+    Logger::info(str::format("DXVK: Read ", data.size(), " bytes of pipeline cache data"));
+    return data;
+  }
+
+
+  void DxvkPipelineCache::writeCacheFile() {
+    size_t size = 0;
+
+    if (m_vkd->vkGetPipelineCacheData(m_vkd->device(), m_handle, &size, nullptr) != VK_SUCCESS)
+      return;
+
+    // Pipeline caches only ever grow, so skip
+    // writing the file if nothing has changed
+    if (size == m_dataSize)
+      return;
+
+    std::vector<char> data(size);
+
+    if (m_vkd->vkGetPipelineCacheData(m_vkd->device(), m_handle, &size, data.data()) < 0)
+      return;
+
+    DxvkPipelineCacheHeader header = m_header;
+    header.dataSize = size;
+    header.dataHash = Sha1Hash::compute(data.data(), size);
+
+    // Write to a temporary file first so that the existing
+    // cache file remains intact if writing fails midway
+    std::wstring fileName = getCacheFileName();
+    std::wstring tempName = fileName + L".tmp";
+
+    std::ofstream file(tempName.c_str(),
+      std::ios_base::binary |
+      std::ios_base::trunc);
+
+    if (!file && env::createDirectory(getCacheDir())) {
+      file = std::ofstream(tempName.c_str(),
+        std::ios_base::binary |
+        std::ios_base::trunc);
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(data.data(), size);
+    file.close();
+
+    if (!file) {
+      Logger::warn("DXVK: Failed to write pipeline cache file");
+      return;
+    }
+
+    if (!env::replaceFile(tempName, fileName)) {
+      Logger::warn("DXVK: Failed to replace pipeline cache file");
+      return;
+    }
+
+    m_dataSize = size;
+  }
+
+
+  void DxvkPipelineCache::writerFunc() {
+    env::setThreadName("dxvk-pcache");
+
+    std::unique_lock<dxvk::mutex> lock(m_writerLock);
+
+    while (!m_stopThread) {
+      m_writerCond.wait_for(lock, std::chrono::seconds(10),
+        [this] () { return m_stopThread; });
+
+      writeCacheFile();
+    }
+  }
+
+
+  std::wstring DxvkPipelineCache::getCacheFileName() const {
+    std::string path = getCacheDir();
+
+    if (!path.empty() && *path.rbegin() != '/')
+      path += '/';
+    
+    std::string exeName = env::getExeBaseName();
+    path += exeName + ".dxvk-pipecache";
+    return str::tows(path.c_str());
+  }
+
+
+  std::string DxvkPipelineCache::getCacheDir() const {
+    return env::getEnvVar("DXVK_STATE_CACHE_PATH");
+  }
   
 }
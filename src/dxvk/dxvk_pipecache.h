@@ -11,18 +11,54 @@
 #include "../util/util_time.h"
 
 namespace dxvk {
+
+  class DxvkDevice;
+
+  /**
+   * \brief Pipeline cache file header
+   *
+   * Identifies the device and driver that created
+   * the cache data, as well as the data size and
+   * hash so that corrupted files can be rejected
+   * before passing any data to the driver. The
+   * header is written to disk as-is, so it must
+   * not contain any implicit padding.
+   */
+  struct DxvkPipelineCacheHeader {
+    char      magic[4]      = { 'D', 'X', 'P', 'C' };
+    uint32_t  version       = 2;
+    uint32_t  vendorId      = 0;
+    uint32_t  deviceId      = 0;
+    uint32_t  driverVersion = 0;
+    uint32_t  reserved0     = 0;
+    uint8_t   uuid[VK_UUID_SIZE] = { };
+    Sha1Hash  dataHash      = { };
+    uint32_t  reserved1     = 0;
+    uint64_t  dataSize      = 0;
+  };
+
+  static_assert(sizeof(DxvkPipelineCacheHeader) == 72);
   
   /**
    * \brief Pipeline cache
    * 
    * Allows the Vulkan implementation to
    * re-use previously compiled pipelines.
+   *
+   * If persistent, the cache data is loaded from
+   * disk on creation and periodically written back
+   * by a background thread, so that pipelines that
+   * get compiled from the state cache on subsequent
+   * runs can be retrieved from the driver cache.
    */
   class DxvkPipelineCache : public RcObject {
     
   public:
     
-    DxvkPipelineCache(const Rc<vk::DeviceFn>& vkd);
+    DxvkPipelineCache(
+      const DxvkDevice*         device,
+            bool                persistent);
+
     ~DxvkPipelineCache();
     
     /**
@@ -35,9 +71,27 @@ namespace dxvk {
     
   private:
     
-    Rc<vk::DeviceFn>        m_vkd;
-    VkPipelineCache         m_handle;
-    
+    Rc<vk::DeviceFn>          m_vkd;
+    VkPipelineCache           m_handle = VK_NULL_HANDLE;
+
+    DxvkPipelineCacheHeader   m_header;
+    size_t                    m_dataSize = 0;
+
+    bool                      m_stopThread = false;
+    dxvk::mutex               m_writerLock;
+    dxvk::condition_variable  m_writerCond;
+    dxvk::thread              m_writerThread;
+
+    std::vector<char> readCacheFile() const;
+
+    void writeCacheFile();
+
+    void writerFunc();
+
+    std::wstring getCacheFileName() const;
+
+    std::string getCacheDir() const;
+
   };
   
 }
@@ -8,16 +8,37 @@ namespace dxvk {
     const DxvkDevice*         device,
           DxvkRenderPassPool* passManager)
   : m_device    (device),
-    m_cache     (new DxvkPipelineCache(device->vkd())) {
+    m_workers   ("dxvk-shader", ThreadPriority::Lowest) {
     std::string useStateCache = env::getEnvVar("DXVK_STATE_CACHE");
+    bool enableStateCache = useStateCache != "0" && device->config().enableStateCache;
+
+    // Only persist the driver's pipeline cache if the state
+    // cache is enabled, since otherwise pipelines will not
+    // be compiled ahead of time on subsequent runs anyway
+    m_cache = new DxvkPipelineCache(device, enableStateCache);
+
+    // Leave some CPU cores for the application. Worker threads
+    // run at a low priority unless they are compiling something
+    // that the application is waiting for.
+    uint32_t numCpuCores = dxvk::thread::hardware_concurrency();
+    uint32_t numWorkers  = ((std::max(1u, numCpuCores) - 1) * 5) / 7;
+
+    if (numWorkers <  1) numWorkers =  1;
+    if (numWorkers > 32) numWorkers = 32;
+
+    if (device->config().numCompilerThreads > 0)
+      numWorkers = device->config().numCompilerThreads;
     
-    if (useStateCache != "0" && device->config().enableStateCache)
-      m_stateCache = new DxvkStateCache(device, this, passManager);
+    Logger::info(str::format("DXVK: Using ", numWorkers, " compiler threads"));
+    m_workers.startWorkers(numWorkers);
+
+    if (enableStateCache)
+      m_stateCache = new DxvkStateCache(device, this, passManager, &m_workers);
   }
   
   
   DxvkPipelineManager::~DxvkPipelineManager() {
-    
+    this->stopWorkerThreads();
   }
   
   
@@ -26,17 +47,27 @@ namespace dxvk {
     if (shaders.cs == nullptr)
       return nullptr;
     
-    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    DxvkComputePipeline* pipeline;
+
+    { std::lock_guard<dxvk::mutex> lock(m_mutex);
     
-    auto pair = m_computePipelines.find(shaders);
-    if (pair != m_computePipelines.end())
-      return &pair->second;
+      auto pair = m_computePipelines.find(shaders);
+      if (pair != m_computePipelines.end())
+        return &pair->second;
     
-    auto iter = m_computePipelines.emplace(
-      std::piecewise_construct,
-      std::tuple(shaders),
-      std::tuple(this, shaders));
-    return &iter.first->second;
+      auto iter = m_computePipelines.emplace(
+        std::piecewise_construct,
+        std::tuple(shaders),
+        std::tuple(this, shaders));
+      pipeline = &iter.first->second;
+    }
+
+    // The application is about to use this pipeline, so make sure
+    // that cached pipelines for it get compiled as soon as possible
+    if (m_stateCache != nullptr)
+      m_stateCache->prioritizeComputePipelines(shaders);
+
+    return pipeline;
   }
   
   
@@ -45,17 +76,27 @@ namespace dxvk {
     if (shaders.vs == nullptr)
       return nullptr;
     
-    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    DxvkGraphicsPipeline* pipeline;
+
+    { std::lock_guard<dxvk::mutex> lock(m_mutex);
     
-    auto pair = m_graphicsPipelines.find(shaders);
-    if (pair != m_graphicsPipelines.end())
-      return &pair->second;
+      auto pair = m_graphicsPipelines.find(shaders);
+      if (pair != m_graphicsPipelines.end())
+        return &pair->second;
     
-    auto iter = m_graphicsPipelines.emplace(
-      std::piecewise_construct,
-      std::tuple(shaders),
-      std::tuple(this, shaders));
-    return &iter.first->second;
+      auto iter = m_graphicsPipelines.emplace(
+        std::piecewise_construct,
+        std::tuple(shaders),
+        std::tuple(this, shaders));
+      pipeline = &iter.first->second;
+    }
+
+    // The application is about to use this pipeline, so make sure
+    // that cached pipelines for it get compiled as soon as possible
+    if (m_stateCache != nullptr)
+      m_stateCache->prioritizeGraphicsPipelines(shaders);
+
+    return pipeline;
   }
 
   
@@ -75,12 +116,13 @@ namespace dxvk {
 
 
   bool DxvkPipelineManager::isCompilingShaders() const {
-    return m_stateCache != nullptr
-        && m_stateCache->isCompilingShaders();
+    return m_workers.isBusy();
   }
 
 
-  void DxvkPipelineManager::stopWorkerThreads() const {
+  void DxvkPipelineManager::stopWorkerThreads() {
+    m_workers.stopWorkers();
+
     if (m_stateCache != nullptr)
       m_stateCache->stopWorkerThreads();
   }
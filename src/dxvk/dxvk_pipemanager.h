@@ -6,6 +6,7 @@
 
 #include "dxvk_compute.h"
 #include "dxvk_graphics.h"
+#include "dxvk_worker_pool.h"
 
 namespace dxvk {
 
@@ -84,6 +85,17 @@ namespace dxvk {
      */
     DxvkPipelineCount getPipelineCount() const;
 
+    /**
+     * \brief Compiler worker pool
+     *
+     * Used for pipeline compilation as well as
+     * shader translation in client APIs.
+     * \returns Compiler worker pool
+     */
+    DxvkWorkerPool& workers() {
+      return m_workers;
+    }
+
     /**
      * \brief Checks whether async compiler is busy
      * \returns \c true if shaders are being compiled
@@ -93,12 +105,13 @@ namespace dxvk {
     /**
      * \brief Stops async compiler threads
      */
-    void stopWorkerThreads() const;
+    void stopWorkerThreads();
     
   private:
     
     const DxvkDevice*         m_device;
     Rc<DxvkPipelineCache>     m_cache;
+    DxvkWorkerPool            m_workers;
     Rc<DxvkStateCache>        m_stateCache;
 
     std::atomic<uint32_t>     m_numComputePipelines  = { 0 };
@@ -103,6 +103,9 @@ namespace dxvk {
       if (m_lastError != VK_ERROR_DEVICE_LOST) {
         std::lock_guard<dxvk::mutex> lock(m_mutexQueue);
 
+        DxvkTraceScope trace(m_device->tracer(), "queue",
+          entry.submit.cmdList != nullptr ? "Submit" : "Present");
+
         if (entry.submit.cmdList != nullptr) {
           status = entry.submit.cmdList->submit(
             entry.submit.waitSync,
@@ -162,8 +165,10 @@ namespace dxvk {
       
       VkResult status = m_lastError.load();
       
-      if (status != VK_ERROR_DEVICE_LOST)
+      if (status != VK_ERROR_DEVICE_LOST) {
+        DxvkTraceScope trace(m_device->tracer(), "queue", "WaitForFence");
         status = entry.submit.cmdList->synchronize();
+      }
       
       if (status != VK_SUCCESS) {
         Logger::err(str::format("DxvkSubmissionQueue: Failed to sync fence: ", status));
@@ -149,8 +149,12 @@ namespace dxvk {
   }
   
   
+  std::atomic<size_t> DxvkShader::s_moduleCacheSize = { 0ull };
+
+
   DxvkShader::~DxvkShader() {
-    
+    for (const auto& entry : m_moduleCache)
+      s_moduleCacheSize -= entry.code.size();
   }
   
   
@@ -171,13 +175,54 @@ namespace dxvk {
     const Rc<vk::DeviceFn>&          vkd,
     const DxvkDescriptorSlotMapping& mapping,
     const DxvkShaderModuleCreateInfo& info) {
-    SpirvCodeBuffer spirvCode = m_code.decompress();
+    // Shaders are commonly linked into many pipelines with
+    // identical bindings, e.g. vertex shaders that are used
+    // with different pixel shaders, so reuse patched code
+    std::vector<uint32_t> key = getModuleKey(mapping, info);
+    SpirvCodeBuffer spirvCode;
+
+    if (!lookupModuleCode(key, spirvCode)) {
+      spirvCode = patchCode(mapping, info);
+      insertModuleCode(std::move(key), spirvCode);
+    }
+
+    return DxvkShaderModule(vkd, this, spirvCode);
+  }
+  
+  
+  std::vector<uint32_t> DxvkShader::getModuleKey(
+    const DxvkDescriptorSlotMapping& mapping,
+    const DxvkShaderModuleCreateInfo& info) const {
+    // The patched code only depends on the binding IDs
+    // of the shader's own slots, not the entire mapping
+    std::vector<uint32_t> key;
+    key.reserve(m_slots.size() + 2);
+    key.push_back(info.fsDualSrcBlend ? 1 : 0);
+    key.push_back(info.undefinedInputs);
+
+    for (const auto& slot : m_slots)
+      key.push_back(mapping.getBindingId(slot.slot));
+
+    return key;
+  }
+
+
+  SpirvCodeBuffer DxvkShader::patchCode(
+    const DxvkDescriptorSlotMapping& mapping,
+    const DxvkShaderModuleCreateInfo& info) const {
+    SpirvCodeBuffer spirvCode(m_code.dwords());
     uint32_t* code = spirvCode.data();
     
-    // Remap resource binding IDs
-    for (uint32_t ofs : m_idOffsets) {
-      if (code[ofs] < MaxNumResourceSlots)
-        code[ofs] = mapping.getBindingId(code[ofs]);
+    // Decode one instruction at a time and remap resource
+    // binding IDs while the instruction is still in cache
+    SpirvCompressedReader reader(m_code);
+    auto idOffset = m_idOffsets.begin();
+
+    while (reader.readInstruction(&code[reader.offset()])) {
+      for (; idOffset != m_idOffsets.end() && *idOffset < reader.offset(); idOffset++) {
+        if (code[*idOffset] < MaxNumResourceSlots)
+          code[*idOffset] = mapping.getBindingId(code[*idOffset]);
+      }
     }
 
     // For dual-source blending we need to re-map
@@ -189,10 +234,68 @@ namespace dxvk {
     for (uint32_t u : bit::BitMask(info.undefinedInputs))
       eliminateInput(spirvCode, u);
 
-    return DxvkShaderModule(vkd, this, spirvCode);
+    return spirvCode;
   }
-  
-  
+
+
+  bool DxvkShader::lookupModuleCode(
+    const std::vector<uint32_t>&     key,
+          SpirvCodeBuffer&           code) {
+    std::lock_guard<dxvk::mutex> lock(m_moduleMutex);
+
+    for (auto& entry : m_moduleCache) {
+      if (entry.key == key) {
+        entry.lastUse = ++m_moduleUseCount;
+        code = entry.code;
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+
+  void DxvkShader::insertModuleCode(
+          std::vector<uint32_t>&&    key,
+    const SpirvCodeBuffer&           code) {
+    std::lock_guard<dxvk::mutex> lock(m_moduleMutex);
+
+    // Another thread may have patched the
+    // same code while the lock was released
+    for (const auto& entry : m_moduleCache) {
+      if (entry.key == key)
+        return;
+    }
+
+    // Reserve space in the global budget first. Other shaders
+    // own most of it, so evicting our own entries would not
+    // necessarily make room and just throw away useful code.
+    size_t codeSize = code.size();
+
+    if (s_moduleCacheSize.fetch_add(codeSize) + codeSize > MaxModuleCacheSize) {
+      s_moduleCacheSize -= codeSize;
+      return;
+    }
+
+    // Evict the least recently used entry if this
+    // shader already has the maximum number of entries
+    if (m_moduleCache.size() >= MaxModuleCacheEntries) {
+      auto lru = std::min_element(m_moduleCache.begin(), m_moduleCache.end(),
+        [] (const ModuleCacheEntry& a, const ModuleCacheEntry& b) {
+          return a.lastUse < b.lastUse;
+        });
+
+      s_moduleCacheSize -= lru->code.size();
+      m_moduleCache.erase(lru);
+    }
+
+    ModuleCacheEntry& entry = m_moduleCache.emplace_back();
+    entry.key     = std::move(key);
+    entry.code    = code;
+    entry.lastUse = ++m_moduleUseCount;
+  }
+
+
   void DxvkShader::dump(std::ostream& outputStream) const {
     m_code.decompress().store(outputStream);
   }
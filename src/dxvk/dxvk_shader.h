@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <vector>
 
 #include "dxvk_include.h"
@@ -10,6 +11,8 @@
 #include "../spirv/spirv_code_buffer.h"
 #include "../spirv/spirv_compression.h"
 
+#include "../util/thread.h"
+
 namespace dxvk {
   
   class DxvkShader;
@@ -178,7 +181,11 @@ namespace dxvk {
     /**
      * \brief Creates a shader module
      * 
-     * Maps the binding slot numbers 
+     * Maps the binding slot numbers to the binding IDs
+     * of the given mapping. The resulting code is cached,
+     * so that creating another module with the same
+     * bindings and create info does not need to decode
+     * and patch the shader again.
      * \param [in] vkd Vulkan device functions
      * \param [in] mapping Resource slot mapping
      * \param [in] info Module create info
@@ -200,6 +207,17 @@ namespace dxvk {
       return m_interface;
     }
 
+    /**
+     * \brief Resource slots
+     *
+     * Retrieves the resource slot definitions
+     * that the shader was created with.
+     * \returns Resource slots
+     */
+    const std::vector<DxvkResourceSlot>& resourceSlots() const {
+      return m_slots;
+    }
+
     /**
      * \brief Shader options
      * \returns Shader options
@@ -276,8 +294,30 @@ namespace dxvk {
     static size_t getHash(const Rc<DxvkShader>& shader) {
       return shader != nullptr ? shader->getHash() : 0;
     }
+
+    /**
+     * \brief Total size of cached module code
+     * \returns Size of all cached code, in bytes
+     */
+    static size_t getModuleCacheSize() {
+      return s_moduleCacheSize.load();
+    }
     
   private:
+
+    /// Maximum number of patched modules per shader. Each
+    /// shader evicts its own least recently used entries.
+    constexpr static size_t MaxModuleCacheEntries = 8;
+
+    /// Upper bound for patched code across all shaders. Once
+    /// this is reached, new modules are simply not cached.
+    constexpr static size_t MaxModuleCacheSize = 64ull << 20;
+
+    struct ModuleCacheEntry {
+      std::vector<uint32_t> key;
+      SpirvCodeBuffer       code;
+      uint64_t              lastUse;
+    };
     
     VkShaderStageFlagBits m_stage;
     SpirvCompressedBuffer m_code;
@@ -294,6 +334,28 @@ namespace dxvk {
     size_t m_o1IdxOffset = 0;
     size_t m_o1LocOffset = 0;
 
+    dxvk::mutex                   m_moduleMutex;
+    std::vector<ModuleCacheEntry> m_moduleCache;
+    uint64_t                      m_moduleUseCount = 0;
+
+    static std::atomic<size_t>    s_moduleCacheSize;
+
+    std::vector<uint32_t> getModuleKey(
+      const DxvkDescriptorSlotMapping& mapping,
+      const DxvkShaderModuleCreateInfo& info) const;
+
+    SpirvCodeBuffer patchCode(
+      const DxvkDescriptorSlotMapping& mapping,
+      const DxvkShaderModuleCreateInfo& info) const;
+
+    bool lookupModuleCode(
+      const std::vector<uint32_t>&     key,
+            SpirvCodeBuffer&           code);
+
+    void insertModuleCode(
+            std::vector<uint32_t>&&    key,
+      const SpirvCodeBuffer&           code);
+
     static void eliminateInput(SpirvCodeBuffer& code, uint32_t location);
 
   };
@@ -0,0 +1,346 @@
+#include <sstream>
+
+#include <version.h>
+
+#include "dxvk_device.h"
+#include "dxvk_shader_cache.h"
+
+namespace dxvk {
+
+  DxvkShaderCache::DxvkShaderCache(
+    const Rc<DxvkDevice>&         device,
+    const std::string&            fileExt) {
+    std::string useStateCache = env::getEnvVar("DXVK_STATE_CACHE");
+    m_enabled = useStateCache != "0" && device->config().enableStateCache;
+
+    if (!m_enabled)
+      return;
+
+    std::string path = getCacheDir();
+
+    if (!path.empty() && *path.rbegin() != '/')
+      path += '/';
+
+    path += env::getExeBaseName() + fileExt;
+    m_fileName = str::tows(path.c_str());
+
+    // If the file is missing or unusable, start a new one. The
+    // mapping must be closed before the file can be truncated.
+    bool valid = readCacheFile();
+
+    if (!valid) {
+      m_entries.clear();
+      m_file.close();
+    }
+
+    if (!openWriter(!valid)) {
+      Logger::warn("DXVK: Failed to open shader cache file for writing");
+      m_enabled = false;
+    }
+
+    m_fileSize = valid ? m_file.size() : sizeof(DxvkShaderCacheHeader);
+  }
+
+
+  DxvkShaderCache::~DxvkShaderCache() {
+
+  }
+
+
+  Rc<DxvkShader> DxvkShaderCache::lookupShader(
+    const DxvkShaderKey&          key,
+          std::vector<uint8_t>*   metadata) {
+    if (!m_enabled)
+      return nullptr;
+
+    Entry entry;
+    std::string buffer;
+    const char* data = nullptr;
+
+    { std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+      auto iter = m_entries.find(key);
+
+      if (iter == m_entries.end())
+        return nullptr;
+
+      entry = iter->second;
+
+      // The mapped view does not change after the cache
+      // is opened, so pointers into it remain valid
+      if (entry.offset + entry.size <= m_file.size())
+        data = m_file.data() + entry.offset;
+      else if (readEntry(entry, buffer))
+        data = buffer.data();
+      else
+        return nullptr;
+    }
+
+    if (entry.hash != Sha1Hash::compute(data, entry.size)) {
+      Logger::warn(str::format("DXVK: Shader cache entry for ", key.toString(), " corrupted"));
+
+      std::lock_guard<dxvk::mutex> lock(m_mutex);
+      m_entries.erase(key);
+      return nullptr;
+    }
+
+    return deserializeShader(data, entry.size, metadata);
+  }
+
+
+  void DxvkShaderCache::storeShader(
+    const DxvkShaderKey&          key,
+    const Rc<DxvkShader>&         shader,
+    const std::vector<uint8_t>&   metadata) {
+    if (!m_enabled)
+      return;
+
+    std::string data = serializeShader(shader, metadata);
+
+    DxvkShaderCacheEntryHeader header;
+    header.key      = key;
+    header.dataHash = Sha1Hash::compute(data.data(), data.size());
+    header.dataSize = data.size();
+
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    if (m_entries.find(key) != m_entries.end())
+      return;
+
+    m_writer.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    m_writer.write(data.data(), data.size());
+    m_writer.flush();
+
+    // Subsequent entries would end up at the wrong offset
+    // anyway, so don't record anything if writing failed
+    if (!m_writer)
+      return;
+
+    Entry entry;
+    entry.offset  = m_fileSize + sizeof(header);
+    entry.size    = header.dataSize;
+    entry.hash    = header.dataHash;
+
+    m_entries.insert({ key, entry });
+    m_fileSize = entry.offset + entry.size;
+  }
+
+
+  std::vector<DxvkShaderKey> DxvkShaderCache::getKeys() {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    std::vector<DxvkShaderKey> result;
+    result.reserve(m_entries.size());
+
+    for (const auto& entry : m_entries)
+      result.push_back(entry.first);
+
+    return result;
+  }
+
+
+  bool DxvkShaderCache::readCacheFile() {
+    if (!m_file.open(m_fileName))
+      return false;
+
+    DxvkShaderCacheHeader expected = getHeader();
+    DxvkShaderCacheHeader header;
+
+    if (m_file.size() < sizeof(header))
+      return false;
+
+    std::memcpy(&header, m_file.data(), sizeof(header));
+
+    if (std::memcmp(header.magic, expected.magic, sizeof(header.magic))
+     || header.version != expected.version
+     || header.build   != expected.build) {
+      Logger::warn("DXVK: Shader cache file outdated");
+      return false;
+    }
+
+    // Only index the entries here, shader data is
+    // validated when the shader is first looked up
+    size_t offset = sizeof(header);
+
+    while (offset < m_file.size()) {
+      DxvkShaderCacheEntryHeader entryHeader;
+
+      if (m_file.size() - offset < sizeof(entryHeader))
+        break;
+
+      std::memcpy(&entryHeader, m_file.data() + offset, sizeof(entryHeader));
+      offset += sizeof(entryHeader);
+
+      if (m_file.size() - offset < entryHeader.dataSize)
+        break;
+
+      Entry entry;
+      entry.offset  = offset;
+      entry.size    = entryHeader.dataSize;
+      entry.hash    = entryHeader.dataHash;
+
+      m_entries.insert({ entryHeader.key, entry });
+      offset += entryHeader.dataSize;
+    }
+
+    // Appending to a file with a truncated entry
+    // would make all subsequent entries unusable
+    if (offset != m_file.size()) {
+      Logger::warn("DXVK: Shader cache file corrupted");
+      return false;
+    }
+
+    Logger::info(str::format("DXVK: Found ", m_entries.size(), " cached shaders"));
+    return true;
+  }
+
+
+  bool DxvkShaderCache::openWriter(
+          bool                    truncate) {
+    auto mode = std::ios_base::binary | (truncate
+      ? std::ios_base::trunc
+      : std::ios_base::app);
+
+    m_writer = std::ofstream(m_fileName.c_str(), mode);
+
+    if (!m_writer && env::createDirectory(getCacheDir()))
+      m_writer = std::ofstream(m_fileName.c_str(), mode);
+
+    if (truncate) {
+      DxvkShaderCacheHeader header = getHeader();
+      m_writer.write(reinterpret_cast<const char*>(&header), sizeof(header));
+      m_writer.flush();
+    }
+
+    return bool(m_writer);
+  }
+
+
+  bool DxvkShaderCache::readEntry(
+    const Entry&                  entry,
+          std::string&            data) {
+    if (!m_reader.is_open())
+      m_reader = std::ifstream(m_fileName.c_str(), std::ios_base::binary);
+
+    data.resize(entry.size);
+
+    m_reader.clear();
+    m_reader.seekg(entry.offset);
+    m_reader.read(&data[0], entry.size);
+    return bool(m_reader);
+  }
+
+
+  std::string DxvkShaderCache::serializeShader(
+    const Rc<DxvkShader>&         shader,
+    const std::vector<uint8_t>&   metadata) {
+    std::ostringstream stream;
+
+    auto write = [&stream] (const auto& value) {
+      stream.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+
+    const auto& slots = shader->resourceSlots();
+    const auto& constData = shader->shaderConstants();
+
+    write(uint32_t(shader->stage()));
+    write(shader->getShaderKey());
+    write(uint32_t(slots.size()));
+
+    for (const auto& slot : slots)
+      write(slot);
+
+    write(shader->interfaceSlots());
+    write(shader->shaderOptions());
+
+    write(uint32_t(constData.sizeInBytes() / sizeof(uint32_t)));
+    stream.write(reinterpret_cast<const char*>(constData.data()), constData.sizeInBytes());
+
+    write(uint32_t(metadata.size()));
+    stream.write(reinterpret_cast<const char*>(metadata.data()), metadata.size());
+
+    // The SPIR-V code takes up the rest of the entry
+    shader->dump(stream);
+    return stream.str();
+  }
+
+
+  Rc<DxvkShader> DxvkShaderCache::deserializeShader(
+    const char*                   data,
+          size_t                  size,
+          std::vector<uint8_t>*   metadata) {
+    size_t offset = 0;
+
+    auto read = [&] (void* dst, size_t count) {
+      if (size - offset < count)
+        return false;
+
+      std::memcpy(dst, data + offset, count);
+      offset += count;
+      return true;
+    };
+
+    uint32_t      stage     = 0;
+    DxvkShaderKey shaderKey;
+    uint32_t      slotCount = 0;
+
+    if (!read(&stage,     sizeof(stage))
+     || !read(&shaderKey, sizeof(shaderKey))
+     || !read(&slotCount, sizeof(slotCount))
+     || slotCount > MaxNumResourceSlots)
+      return nullptr;
+
+    std::vector<DxvkResourceSlot> slots(slotCount);
+
+    DxvkInterfaceSlots iface;
+    DxvkShaderOptions  options;
+    uint32_t           constDwords = 0;
+
+    if (!read(slots.data(), slots.size() * sizeof(DxvkResourceSlot))
+     || !read(&iface,       sizeof(iface))
+     || !read(&options,     sizeof(options))
+     || !read(&constDwords, sizeof(constDwords))
+     || size - offset < constDwords * sizeof(uint32_t))
+      return nullptr;
+
+    std::vector<uint32_t> constData(constDwords);
+    read(constData.data(), constData.size() * sizeof(uint32_t));
+
+    uint32_t metadataSize = 0;
+
+    if (!read(&metadataSize, sizeof(metadataSize))
+     || size - offset < metadataSize)
+      return nullptr;
+
+    if (metadata != nullptr) {
+      metadata->resize(metadataSize);
+      read(metadata->data(), metadataSize);
+    } else {
+      offset += metadataSize;
+    }
+
+    std::vector<uint32_t> code((size - offset) / sizeof(uint32_t));
+    read(code.data(), code.size() * sizeof(uint32_t));
+
+    Rc<DxvkShader> shader = new DxvkShader(VkShaderStageFlagBits(stage),
+      slots.size(), slots.data(), iface,
+      SpirvCodeBuffer(code.size(), code.data()), options,
+      constDwords ? DxvkShaderConstData(constData.size(), constData.data()) : DxvkShaderConstData());
+
+    shader->setShaderKey(shaderKey);
+    return shader;
+  }
+
+
+  DxvkShaderCacheHeader DxvkShaderCache::getHeader() {
+    DxvkShaderCacheHeader header;
+    header.build = Sha1Hash::compute(DXVK_VERSION, std::strlen(DXVK_VERSION));
+    return header;
+  }
+
+
+  std::string DxvkShaderCache::getCacheDir() {
+    return env::getEnvVar("DXVK_STATE_CACHE_PATH");
+  }
+
+}
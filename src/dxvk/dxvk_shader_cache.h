@@ -0,0 +1,175 @@
+#pragma once
+
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "dxvk_hash.h"
+#include "dxvk_shader.h"
+
+#include "../util/util_mapped_file.h"
+
+namespace dxvk {
+
+  class DxvkDevice;
+
+  /**
+   * \brief Shader cache file header
+   *
+   * The version must be increased whenever the entry
+   * format changes. The file also stores a hash of the
+   * DXVK version string, so that files written by a
+   * different build get discarded. Changes to the output
+   * of a shader compiler between releases must also be
+   * reflected in the lookup keys, since entries are not
+   * validated against it.
+   */
+  struct DxvkShaderCacheHeader {
+    char      magic[4]  = { 'D', 'X', 'S', 'C' };
+    uint32_t  version   = 4;
+    Sha1Hash  build;
+  };
+
+
+  /**
+   * \brief Shader cache entry header
+   *
+   * Stores the lookup key of the entry as well as
+   * a hash of the serialized shader, which follows
+   * immediately after the header.
+   */
+  struct DxvkShaderCacheEntryHeader {
+    DxvkShaderKey key;
+    Sha1Hash      dataHash;
+    uint32_t      dataSize;
+  };
+
+
+  /**
+   * \brief Translated shader cache
+   *
+   * Stores the SPIR-V code, resource slot info and
+   * shader key of translated shaders on disk, along
+   * with optional metadata provided by the client
+   * API implementation, so that
+   * shaders do not have to be translated again on
+   * subsequent runs. New entries are appended to the
+   * file, and existing entries are read from a mapped
+   * view, so only shaders that are actually used get
+   * loaded. Entries appended since the file was mapped
+   * are read back from the file when looked up.
+   *
+   * The file is stored next to the state cache, and
+   * the cache is only enabled if the state cache is.
+   * Lookup keys are provided by the client API and
+   * must take all compiler options into account.
+   * This class is thread-safe.
+   */
+  class DxvkShaderCache {
+
+  public:
+
+    /**
+     * \brief Opens shader cache
+     *
+     * \param [in] device DXVK device
+     * \param [in] fileExt File name extension, which
+     *    must be unique for each client API cache
+     */
+    DxvkShaderCache(
+      const Rc<DxvkDevice>&         device,
+      const std::string&            fileExt);
+
+    ~DxvkShaderCache();
+
+    /**
+     * \brief Checks whether the cache is enabled
+     * \returns \c true if shaders are cached
+     */
+    bool isEnabled() const {
+      return m_enabled;
+    }
+
+    /**
+     * \brief Looks up a shader
+     *
+     * The returned shader has the shader key
+     * that it was originally stored with.
+     * \param [in] key Cache key
+     * \param [out] metadata Metadata that was stored
+     *    with the shader. May be \c nullptr.
+     * \returns The shader, or \c nullptr
+     *    if the shader is not cached
+     */
+    Rc<DxvkShader> lookupShader(
+      const DxvkShaderKey&          key,
+            std::vector<uint8_t>*   metadata = nullptr);
+
+    /**
+     * \brief Adds a shader to the cache
+     *
+     * Does nothing if the shader is already cached.
+     * \param [in] key Cache key
+     * \param [in] shader The shader
+     * \param [in] metadata Additional data to store
+     */
+    void storeShader(
+      const DxvkShaderKey&          key,
+      const Rc<DxvkShader>&         shader,
+      const std::vector<uint8_t>&   metadata = std::vector<uint8_t>());
+
+    /**
+     * \brief Retrieves keys of all cached shaders
+     *
+     * Can be used to load shaders ahead of time.
+     * \returns Cache keys
+     */
+    std::vector<DxvkShaderKey> getKeys();
+
+  private:
+
+    struct Entry {
+      size_t      offset;
+      uint32_t    size;
+      Sha1Hash    hash;
+    };
+
+    bool                          m_enabled = false;
+    std::wstring                  m_fileName;
+
+    dxvk::mutex                   m_mutex;
+    MappedFile                    m_file;
+    std::ofstream                 m_writer;
+    std::ifstream                 m_reader;
+    size_t                        m_fileSize = 0;
+
+    std::unordered_map<
+      DxvkShaderKey, Entry,
+      DxvkHash, DxvkEq>           m_entries;
+
+    bool readCacheFile();
+
+    bool openWriter(
+            bool                    truncate);
+
+    bool readEntry(
+      const Entry&                  entry,
+            std::string&            data);
+
+    static std::string serializeShader(
+      const Rc<DxvkShader>&         shader,
+      const std::vector<uint8_t>&   metadata);
+
+    static Rc<DxvkShader> deserializeShader(
+      const char*                   data,
+            size_t                  size,
+            std::vector<uint8_t>*   metadata);
+
+    static DxvkShaderCacheHeader getHeader();
+
+    static std::string getCacheDir();
+
+  };
+
+}
@@ -15,29 +15,29 @@ namespace dxvk {
 
 
   DxvkBufferSlice DxvkStagingDataAlloc::alloc(VkDeviceSize align, VkDeviceSize size) {
-    if (size > MaxBufferSize)
+    updateFrame();
+
+    m_frameSize += size;
+    m_statCounters.addCtr(DxvkStatCounter::StagingAllocSize, size);
+
+    if (size > MaxBufferSize) {
+      m_statCounters.addCtr(DxvkStatCounter::StagingBufferCount, 1);
       return DxvkBufferSlice(createBuffer(size));
+    }
     
-    if (m_buffer == nullptr)
-      m_buffer = createBuffer(MaxBufferSize);
-    
-    if (!m_buffer->isInUse())
+    if (m_buffer != nullptr && !m_buffer->isInUse())
       m_offset = 0;
     
     m_offset = dxvk::align(m_offset, align);
 
-    if (m_offset + size > MaxBufferSize) {
-      m_offset = 0;
-
-      if (m_buffers.size() < MaxBufferCount)
-        m_buffers.push(std::move(m_buffer));
-
-      if (!m_buffers.front()->isInUse()) {
-        m_buffer = std::move(m_buffers.front());
-        m_buffers.pop();
-      } else {
-        m_buffer = createBuffer(MaxBufferSize);
+    if (m_buffer == nullptr || m_offset + size > m_buffer->info().size) {
+      if (m_buffer != nullptr) {
+        m_statCounters.addCtr(DxvkStatCounter::StagingRetiredSize, m_buffer->info().size);
+        m_buffers.push_back(std::move(m_buffer));
       }
+
+      m_buffer = getBuffer(size);
+      m_offset = 0;
     }
 
     DxvkBufferSlice slice(m_buffer, m_offset, size);
@@ -50,8 +50,95 @@ namespace dxvk {
     m_buffer = nullptr;
     m_offset = 0;
 
-    while (!m_buffers.empty())
-      m_buffers.pop();
+    m_buffers.clear();
+  }
+
+
+  void DxvkStagingDataAlloc::updateFrame() {
+    uint32_t frameId = m_device->getCurrentFrameId();
+
+    if (likely(frameId == m_frameId))
+      return;
+
+    // Track the peak upload size per frame, but let it decay
+    // slowly so that buffers shrink after loading screens
+    m_frameSizeEstimate = std::max(m_frameSize,
+      m_frameSizeEstimate - m_frameSizeEstimate / 16);
+
+    m_frameId   = frameId;
+    m_frameSize = 0;
+
+    // Buffers that were idle every time we needed a new
+    // buffer during the last couple of frames are not
+    // needed for the current workload, so free them.
+    if (++m_trimFrameCount >= TrimInterval) {
+      freeIdleBuffers(m_minIdleBufferCount);
+
+      m_trimFrameCount     = 0;
+      m_minIdleBufferCount = ~0u;
+    }
+  }
+
+
+  Rc<DxvkBuffer> DxvkStagingDataAlloc::getBuffer(VkDeviceSize size) {
+    VkDeviceSize bufferSize = getBufferSize(size);
+
+    Rc<DxvkBuffer> result;
+    uint32_t idleCount = 0;
+
+    // Buffers are retired in submission order, so the first
+    // idle buffer is the one that has been idle the longest.
+    // Idle buffers with an outdated size are no longer useful.
+    for (auto i = m_buffers.begin(); i != m_buffers.end(); ) {
+      if ((*i)->isInUse()) {
+        i++;
+      } else if ((*i)->info().size != bufferSize) {
+        i = m_buffers.erase(i);
+      } else if (result == nullptr) {
+        result = std::move(*i);
+        i = m_buffers.erase(i);
+      } else {
+        idleCount += 1;
+        i++;
+      }
+    }
+
+    m_minIdleBufferCount = std::min(m_minIdleBufferCount, idleCount);
+
+    if (result == nullptr) {
+      if (!m_buffers.empty())
+        m_statCounters.addCtr(DxvkStatCounter::StagingStallCount, 1);
+
+      m_statCounters.addCtr(DxvkStatCounter::StagingBufferCount, 1);
+      result = createBuffer(bufferSize);
+    }
+
+    return result;
+  }
+
+
+  VkDeviceSize DxvkStagingDataAlloc::getBufferSize(VkDeviceSize size) const {
+    // Aim for a few buffers per frame, so that buffers
+    // used early in a frame can be reused sooner
+    VkDeviceSize bufferSize = MinBufferSize;
+
+    while (bufferSize < MaxBufferSize
+        && (bufferSize < size || bufferSize * 4 < m_frameSizeEstimate))
+      bufferSize *= 2;
+
+    return bufferSize;
+  }
+
+
+  void DxvkStagingDataAlloc::freeIdleBuffers(uint32_t count) {
+    for (auto i = m_buffers.begin(); i != m_buffers.end() && count; ) {
+      if (!(*i)->isInUse()) {
+        i = m_buffers.erase(i);
+        count -= 1;
+      } else {
+        i++;
+      }
+    }
   }
 
 
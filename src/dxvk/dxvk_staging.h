@@ -1,8 +1,9 @@
 #pragma once
 
-#include <queue>
+#include <vector>
 
 #include "dxvk_buffer.h"
+#include "dxvk_stats.h"
 
 namespace dxvk {
   
@@ -14,10 +15,17 @@ namespace dxvk {
    * Allocates buffer slices for resource uploads,
    * while trying to keep the number of allocations
    * but also the amount of allocated memory low.
+   *
+   * Filled buffers are recycled as soon as the GPU
+   * is done with them. The size of newly created
+   * buffers depends on the amount of data uploaded
+   * per frame, and buffers that remain unused for a
+   * while get freed.
    */
   class DxvkStagingDataAlloc {
+    constexpr static VkDeviceSize MinBufferSize  = 1 << 22; // 4 MiB
     constexpr static VkDeviceSize MaxBufferSize  = 1 << 25; // 32 MiB
-    constexpr static uint32_t     MaxBufferCount = 2;
+    constexpr static uint32_t     TrimInterval   = 60;      // frames
   public:
 
     DxvkStagingDataAlloc(const Rc<DxvkDevice>& device);
@@ -41,13 +49,40 @@ namespace dxvk {
      */
     void trim();
 
+    /**
+     * \brief Retrieves and resets stat counters
+     *
+     * Only the staging counters will be set.
+     * \returns Counters since the last call
+     */
+    DxvkStatCounters takeStatCounters() {
+      return std::exchange(m_statCounters, DxvkStatCounters());
+    }
+
   private:
 
     Rc<DxvkDevice>  m_device;
     Rc<DxvkBuffer>  m_buffer;
     VkDeviceSize    m_offset = 0;
 
-    std::queue<Rc<DxvkBuffer>> m_buffers;
+    std::vector<Rc<DxvkBuffer>> m_buffers;
+
+    uint32_t        m_frameId             = 0;
+    VkDeviceSize    m_frameSize           = 0;
+    VkDeviceSize    m_frameSizeEstimate   = 0;
+
+    uint32_t        m_trimFrameCount      = 0;
+    uint32_t        m_minIdleBufferCount  = ~0u;
+
+    DxvkStatCounters m_statCounters;
+
+    void updateFrame();
+
+    Rc<DxvkBuffer> getBuffer(VkDeviceSize size);
+
+    VkDeviceSize getBufferSize(VkDeviceSize size) const;
+
+    void freeIdleBuffers(uint32_t count);
 
     Rc<DxvkBuffer> createBuffer(VkDeviceSize size);
 
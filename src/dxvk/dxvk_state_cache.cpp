@@ -152,59 +152,15 @@ namespace dxvk {
   DxvkStateCache::DxvkStateCache(
     const DxvkDevice*           device,
           DxvkPipelineManager*  pipeManager,
-          DxvkRenderPassPool*   passManager)
+          DxvkRenderPassPool*   passManager,
+          DxvkWorkerPool*       workers)
   : m_pipeManager(pipeManager),
-    m_passManager(passManager) {
-    bool newFile = !readCacheFile();
+    m_passManager(passManager),
+    m_tracer     (device->tracer()),
+    m_workers    (workers) {
+    if (!readCacheFile())
+      writeCacheFile();
 
-    if (newFile) {
-      Logger::warn("DXVK: Creating new state cache file");
-
-      // Start with an empty file
-      std::ofstream file(getCacheFileName().c_str(),
-        std::ios_base::binary |
-        std::ios_base::trunc);
-
-      if (!file && env::createDirectory(getCacheDir())) {
-        file = std::ofstream(getCacheFileName().c_str(),
-          std::ios_base::binary |
-          std::ios_base::trunc);
-      }
-
-      // Write header with the current version number
-      DxvkStateCacheHeader header;
-
-      auto data = reinterpret_cast<const char*>(&header);
-      auto size = sizeof(header);
-
-      file.write(data, size);
-
-      // Write all valid entries to the cache file in
-      // case we're recovering a corrupted cache file
-      for (auto& e : m_entries)
-        writeCacheEntry(file, e);
-    }
-
-    // Use half the available CPU cores for pipeline compilation
-    uint32_t numCpuCores = dxvk::thread::hardware_concurrency();
-    uint32_t numWorkers  = ((std::max(1u, numCpuCores) - 1) * 5) / 7;
-
-    if (numWorkers <  1) numWorkers =  1;
-    if (numWorkers > 32) numWorkers = 32;
-
-    if (device->config().numCompilerThreads > 0)
-      numWorkers = device->config().numCompilerThreads;
-    
-    Logger::info(str::format("DXVK: Using ", numWorkers, " compiler threads"));
-    
-    // Start the worker threads and the file writer
-    m_workerBusy.store(numWorkers);
-
-    for (uint32_t i = 0; i < numWorkers; i++) {
-      m_workerThreads.emplace_back([this] () { workerFunc(); });
-      m_workerThreads[i].set_priority(ThreadPriority::Lowest);
-    }
-    
     m_writerThread = dxvk::thread([this] () { writerFunc(); });
   }
   
@@ -222,13 +178,17 @@ namespace dxvk {
       return;
     
     // Do not add an entry that is already in the cache
-    auto entries = m_entryMap.equal_range(shaders);
+    { std::lock_guard<dxvk::mutex> entryLock(m_entryLock);
+      decodePackedEntries(shaders);
 
-    for (auto e = entries.first; e != entries.second; e++) {
-      const DxvkStateCacheEntry& entry = m_entries[e->second];
+      auto entries = m_entryMap.equal_range(shaders);
 
-      if (entry.format.eq(format) && entry.gpState == state)
-        return;
+      for (auto e = entries.first; e != entries.second; e++) {
+        const DxvkStateCacheEntry& entry = m_entries[e->second];
+
+        if (entry.format.eq(format) && entry.gpState == state)
+          return;
+      }
     }
 
     // Queue a job to write this pipeline to the cache
@@ -248,11 +208,15 @@ namespace dxvk {
       return;
 
     // Do not add an entry that is already in the cache
-    auto entries = m_entryMap.equal_range(shaders);
+    { std::lock_guard<dxvk::mutex> entryLock(m_entryLock);
+      decodePackedEntries(shaders);
 
-    for (auto e = entries.first; e != entries.second; e++) {
-      if (m_entries[e->second].cpState == state)
-        return;
+      auto entries = m_entryMap.equal_range(shaders);
+
+      for (auto e = entries.first; e != entries.second; e++) {
+        if (m_entries[e->second].cpState == state)
+          return;
+      }
     }
 
     // Queue a job to write this pipeline to the cache
@@ -275,47 +239,85 @@ namespace dxvk {
     std::unique_lock<dxvk::mutex> entryLock(m_entryLock);
     m_shaderMap.insert({ key, shader });
 
-    // Deferred lock, don't stall workers unless we have to
-    std::unique_lock<dxvk::mutex> workerLock;
+    // Look up pipelines that use this shader in both the
+    // packed data and the entries appended to the file
+    std::vector<DxvkStateCacheKey> pipelines;
+
+    auto entries = m_pipelineMap.equal_range(key);
 
-    auto pipelines = m_pipelineMap.equal_range(key);
+    for (auto e = entries.first; e != entries.second; e++)
+      pipelines.push_back(e->second);
 
-    for (auto p = pipelines.first; p != pipelines.second; p++) {
+    m_packedData.findPipelines(key, pipelines);
+
+    for (const auto& p : pipelines) {
       WorkerItem item;
 
-      if (!getShaderByKey(p->second.vs,  item.gp.vs)
-       || !getShaderByKey(p->second.tcs, item.gp.tcs)
-       || !getShaderByKey(p->second.tes, item.gp.tes)
-       || !getShaderByKey(p->second.gs,  item.gp.gs)
-       || !getShaderByKey(p->second.fs,  item.gp.fs)
-       || !getShaderByKey(p->second.cs,  item.cp.cs))
+      if (!getShaderByKey(p.vs,  item.gp.vs)
+       || !getShaderByKey(p.tcs, item.gp.tcs)
+       || !getShaderByKey(p.tes, item.gp.tes)
+       || !getShaderByKey(p.gs,  item.gp.gs)
+       || !getShaderByKey(p.fs,  item.gp.fs)
+       || !getShaderByKey(p.cs,  item.cp.cs))
         continue;
       
-      if (!workerLock)
-        workerLock = std::unique_lock<dxvk::mutex>(m_workerLock);
-      
-      m_workerQueue.push(item);
+      // Only queue one job per shader combination. If the item
+      // is still pending, just update it with the new shaders.
+      auto result = m_workerItems.insert({ p, item });
+
+      if (result.second) {
+        m_workers->enqueue([this, key = p] () {
+          compilePipelines(key);
+        }, DxvkWorkerPriority::Low);
+      } else {
+        result.first->second.gp = item.gp;
+        result.first->second.cp = item.cp;
+      }
     }
+  }
+
+
+  void DxvkStateCache::prioritizeGraphicsPipelines(
+    const DxvkGraphicsPipelineShaders&    shaders) {
+    DxvkStateCacheKey key;
+    key.vs  = getShaderKey(shaders.vs);
+    key.tcs = getShaderKey(shaders.tcs);
+    key.tes = getShaderKey(shaders.tes);
+    key.gs  = getShaderKey(shaders.gs);
+    key.fs  = getShaderKey(shaders.fs);
+
+    prioritizePipelines(key);
+  }
+
+
+  void DxvkStateCache::prioritizeComputePipelines(
+    const DxvkComputePipelineShaders&     shaders) {
+    DxvkStateCacheKey key;
+    key.cs  = getShaderKey(shaders.cs);
+
+    prioritizePipelines(key);
+  }
 
-    if (workerLock)
-      m_workerCond.notify_all();
+
+  void DxvkStateCache::compileGraphicsPipeline(
+          DxvkGraphicsPipeline*           pipeline,
+    const DxvkGraphicsPipelineStateInfo&  state,
+    const DxvkRenderPass*                 renderPass) {
+    m_workers->enqueue([pipeline, state, renderPass] () {
+      pipeline->compilePendingInstance(state, renderPass);
+    }, DxvkWorkerPriority::High);
   }
 
 
   void DxvkStateCache::stopWorkerThreads() {
-    { std::lock_guard<dxvk::mutex> workerLock(m_workerLock);
-      std::lock_guard<dxvk::mutex> writerLock(m_writerLock);
+    { std::lock_guard<dxvk::mutex> writerLock(m_writerLock);
 
       if (m_stopThreads.exchange(true))
         return;
 
-      m_workerCond.notify_all();
       m_writerCond.notify_all();
     }
 
-    for (auto& worker : m_workerThreads)
-      worker.join();
-    
     m_writerThread.join();
   }
 
@@ -355,7 +357,46 @@ namespace dxvk {
   }
 
 
+  void DxvkStateCache::prioritizePipelines(
+    const DxvkStateCacheKey&        key) {
+    std::lock_guard<dxvk::mutex> lock(m_entryLock);
+
+    // The low-priority job for this item stays in the queue,
+    // but whichever job runs first will claim the item. Only
+    // queue one high-priority job per item.
+    auto entry = m_workerItems.find(key);
+
+    if (entry != m_workerItems.end() && !entry->second.prioritized) {
+      entry->second.prioritized = true;
+
+      m_workers->enqueue([this, key] () {
+        compilePipelines(key);
+      }, DxvkWorkerPriority::High);
+    }
+  }
+
+
+  void DxvkStateCache::compilePipelines(
+    const DxvkStateCacheKey&        key) {
+    WorkerItem item;
+
+    { std::lock_guard<dxvk::mutex> lock(m_entryLock);
+      auto entry = m_workerItems.find(key);
+
+      if (entry == m_workerItems.end())
+        return;
+
+      item = std::move(entry->second);
+      m_workerItems.erase(entry);
+    }
+
+    compilePipelines(item);
+  }
+
+
   void DxvkStateCache::compilePipelines(const WorkerItem& item) {
+    DxvkTraceScope trace(m_tracer, "pipeline", "CompilePipelines");
+
     DxvkStateCacheKey key;
     key.vs  = getShaderKey(item.gp.vs);
     key.tcs = getShaderKey(item.gp.tcs);
@@ -366,23 +407,120 @@ namespace dxvk {
 
     if (item.cp.cs == nullptr) {
       auto pipeline = m_pipeManager->createGraphicsPipeline(item.gp);
-      auto entries = m_entryMap.equal_range(key);
-
-      for (auto e = entries.first; e != entries.second; e++) {
-        const auto& entry = m_entries[e->second];
 
+      for (const auto& entry : getEntries(key)) {
         auto rp = m_passManager->getRenderPass(entry.format);
         pipeline->compilePipeline(entry.gpState, rp);
       }
     } else {
       auto pipeline = m_pipeManager->createComputePipeline(item.cp);
-      auto entries = m_entryMap.equal_range(key);
 
-      for (auto e = entries.first; e != entries.second; e++) {
-        const auto& entry = m_entries[e->second];
+      for (const auto& entry : getEntries(key))
         pipeline->compilePipeline(entry.cpState);
+    }
+  }
+
+
+  std::vector<DxvkStateCacheEntry> DxvkStateCache::getEntries(
+    const DxvkStateCacheKey&        key) {
+    std::lock_guard<dxvk::mutex> lock(m_entryLock);
+    decodePackedEntries(key);
+
+    std::vector<DxvkStateCacheEntry> result;
+
+    auto entries = m_entryMap.equal_range(key);
+
+    for (auto e = entries.first; e != entries.second; e++)
+      result.push_back(m_entries[e->second]);
+
+    return result;
+  }
+
+
+  void DxvkStateCache::decodePackedEntries(
+    const DxvkStateCacheKey&        key) {
+    uint32_t index = m_packedData.findPipeline(key);
+
+    if (index == DxvkStateCachePackedReader::InvalidIndex
+     || m_packedDecoded[index])
+      return;
+
+    // Decoding and validating packed entries is expensive, so
+    // only do it once and add the entries to the entry table.
+    // Pipelines using packed entries are already found through
+    // the packed shader index, so don't map shaders here.
+    std::vector<DxvkStateCacheEntry> entries;
+    DxvkStateCacheKey packedKey;
+
+    if (readPackedEntries(index, packedKey, entries)) {
+      for (const auto& e : entries) {
+        mapPipelineToEntry(e.shaders, m_entries.size());
+        m_entries.push_back(e);
       }
     }
+
+    m_packedDecoded[index] = true;
+  }
+
+
+  bool DxvkStateCache::readPackedEntries(
+          uint32_t                  index,
+          DxvkStateCacheKey&        key,
+          std::vector<DxvkStateCacheEntry>& entries) const {
+    std::string data;
+
+    if (!m_packedData.readPipeline(index, key, data))
+      return false;
+
+    // Packed entries use the same encoding as unpacked ones
+    std::istringstream stream(data);
+
+    while (stream) {
+      DxvkStateCacheEntry entry;
+
+      if (readCacheEntry(DxvkStateCacheHeader().version, stream, entry)
+       && entry.shaders.eq(key))
+        entries.push_back(entry);
+    }
+
+    return true;
+  }
+
+
+  void DxvkStateCache::addCacheEntry(
+    const DxvkStateCacheEntry&      entry) {
+    size_t entryId = m_entries.size();
+    m_entries.push_back(entry);
+
+    mapPipelineToEntry(entry.shaders, entryId);
+
+    mapShaderToPipeline(entry.shaders.vs,  entry.shaders);
+    mapShaderToPipeline(entry.shaders.tcs, entry.shaders);
+    mapShaderToPipeline(entry.shaders.tes, entry.shaders);
+    mapShaderToPipeline(entry.shaders.gs,  entry.shaders);
+    mapShaderToPipeline(entry.shaders.fs,  entry.shaders);
+    mapShaderToPipeline(entry.shaders.cs,  entry.shaders);
+  }
+
+
+  bool DxvkStateCache::mapCacheFile() {
+    if (!m_packedFile.open(getCacheFileName()))
+      return false;
+
+    if (!m_packedData.init(m_packedFile.data(), m_packedFile.size())) {
+      unmapCacheFile();
+      return false;
+    }
+
+    m_packedDecoded.assign(m_packedData.pipelineCount(), false);
+    return true;
+  }
+
+
+  void DxvkStateCache::unmapCacheFile() {
+    m_packedData = DxvkStateCachePackedReader();
+    m_packedDecoded.clear();
+    m_packedFile.close();
   }
 
 
@@ -432,6 +570,16 @@ namespace dxvk {
     if (curHeader.version != newHeader.version)
       Logger::warn(str::format("DXVK: Updating state cache version to v", newHeader.version));
 
+    // Packed entries are only decoded on demand, but any
+    // entries written after packing the file follow the
+    // packed data and need to be read right away.
+    if (curHeader.version == newHeader.version) {
+      if (!mapCacheFile() || !ifile.seekg(m_packedData.dataSize())) {
+        Logger::warn("DXVK: Failed to read packed state cache data");
+        return false;
+      }
+    }
+
     // Read actual cache entries from the file.
     // If we encounter invalid entries, we should
     // regenerate the entire state cache file.
@@ -441,17 +589,7 @@ namespace dxvk {
       DxvkStateCacheEntry entry;
 
       if (readCacheEntry(curHeader.version, ifile, entry)) {
-        size_t entryId = m_entries.size();
-        m_entries.push_back(entry);
-
-        mapPipelineToEntry(entry.shaders, entryId);
-
-        mapShaderToPipeline(entry.shaders.vs,  entry.shaders);
-        mapShaderToPipeline(entry.shaders.tcs, entry.shaders);
-        mapShaderToPipeline(entry.shaders.tes, entry.shaders);
-        mapShaderToPipeline(entry.shaders.gs,  entry.shaders);
-        mapShaderToPipeline(entry.shaders.fs,  entry.shaders);
-        mapShaderToPipeline(entry.shaders.cs,  entry.shaders);
+        addCacheEntry(entry);
       } else if (ifile) {
         numInvalidEntries += 1;
       }
@@ -459,7 +597,8 @@ namespace dxvk {
 
     Logger::info(str::format(
       "DXVK: Read ", m_entries.size(),
-      " valid state cache entries"));
+      " valid state cache entries, ", m_packedData.entryCount(),
+      " packed entries"));
 
     if (numInvalidEntries) {
       Logger::warn(str::format(
@@ -468,11 +607,75 @@ namespace dxvk {
       return false;
     }
     
+    // Repack the file if too many entries were appended
+    if (m_entries.size() > std::max<size_t>(MaxUnpackedEntries, m_packedData.entryCount() / 8))
+      return false;
+
     // Rewrite entire state cache if it is outdated
     return curHeader.version == newHeader.version;
   }
 
 
+  void DxvkStateCache::writeCacheFile() {
+    // Decode all packed entries so that the
+    // file can be unmapped and overwritten
+    for (uint32_t i = 0; i < m_packedData.pipelineCount(); i++) {
+      if (m_packedDecoded[i])
+        continue;
+
+      std::vector<DxvkStateCacheEntry> entries;
+      DxvkStateCacheKey key;
+
+      if (readPackedEntries(i, key, entries)) {
+        for (const auto& e : entries)
+          addCacheEntry(e);
+      }
+    }
+
+    unmapCacheFile();
+
+    Logger::info(str::format("DXVK: Writing ", m_entries.size(), " entries to state cache file"));
+
+    DxvkStateCachePackedWriter writer;
+
+    for (auto& e : m_entries) {
+      std::ostringstream stream;
+      writeCacheEntry(stream, e);
+      writer.addEntry(e.shaders, stream.str());
+    }
+
+    std::ofstream file(getCacheFileName().c_str(),
+      std::ios_base::binary |
+      std::ios_base::trunc);
+
+    if (!file && env::createDirectory(getCacheDir())) {
+      file = std::ofstream(getCacheFileName().c_str(),
+        std::ios_base::binary |
+        std::ios_base::trunc);
+    }
+
+    // Write header with the current version number
+    DxvkStateCacheHeader header;
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    if (!writer.write(file)) {
+      Logger::warn("DXVK: Failed to write state cache file");
+      return;
+    }
+
+    file.close();
+
+    // Entries are now stored in the packed
+    // file, so we do not need to keep them
+    if (mapCacheFile()) {
+      m_entries.clear();
+      m_entryMap.clear();
+      m_pipelineMap.clear();
+    }
+  }
+
+
   bool DxvkStateCache::readCacheHeader(
           std::istream&             stream,
           DxvkStateCacheHeader&     header) const {
@@ -921,37 +1124,6 @@ namespace dxvk {
   }
 
 
-  void DxvkStateCache::workerFunc() {
-    env::setThreadName("dxvk-shader");
-
-    while (!m_stopThreads.load()) {
-      WorkerItem item;
-
-      { std::unique_lock<dxvk::mutex> lock(m_workerLock);
-
-        if (m_workerQueue.empty()) {
-          m_workerBusy -= 1;
-          m_workerCond.wait(lock, [this] () {
-            return m_workerQueue.size()
-                || m_stopThreads.load();
-          });
-
-          if (!m_workerQueue.empty())
-            m_workerBusy += 1;
-        }
-
-        if (m_workerQueue.empty())
-          break;
-        
-        item = m_workerQueue.front();
-        m_workerQueue.pop();
-      }
-
-      compilePipelines(item);
-    }
-  }
-
-
   void DxvkStateCache::writerFunc() {
     env::setThreadName("dxvk-writer");
 
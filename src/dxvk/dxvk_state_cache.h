@@ -5,10 +5,16 @@
 #include <fstream>
 #include <mutex>
 #include <queue>
+#include <sstream>
 #include <unordered_map>
 #include <vector>
 
+#include "dxvk_state_cache_packed.h"
 #include "dxvk_state_cache_types.h"
+#include "dxvk_trace.h"
+#include "dxvk_worker_pool.h"
+
+#include "../util/util_mapped_file.h"
 
 namespace dxvk {
 
@@ -22,15 +28,22 @@ namespace dxvk {
    * game, which allows DXVK to compile them ahead
    * of time instead of compiling them on the first
    * draw.
+   *
+   * Entries from previous runs are stored in a packed
+   * format which is memory-mapped and only decoded on
+   * demand, so that large caches do not delay startup.
+   * Each packed pipeline is decoded at most once, after
+   * which its entries are kept in the entry table.
    */
   class DxvkStateCache : public RcObject {
-
+    constexpr static size_t MaxUnpackedEntries = 1024;
   public:
 
     DxvkStateCache(
       const DxvkDevice*           device,
             DxvkPipelineManager*  pipeManager,
-            DxvkRenderPassPool*   passManager);
+            DxvkRenderPassPool*   passManager,
+            DxvkWorkerPool*       workers);
     
     ~DxvkStateCache();
 
@@ -72,17 +85,48 @@ namespace dxvk {
       const Rc<DxvkShader>&                 shader);
 
     /**
-     * \brief Explicitly stops worker threads
+     * \brief Prioritizes graphics pipelines
+     *
+     * Called when the application is about to use the given
+     * set of shaders. If pipelines for these shaders are still
+     * waiting to be compiled, they will be compiled before any
+     * other pipelines that are only compiled speculatively.
+     * \param [in] shaders Pipeline shaders
      */
-    void stopWorkerThreads();
+    void prioritizeGraphicsPipelines(
+      const DxvkGraphicsPipelineShaders&    shaders);
+
+    /**
+     * \brief Prioritizes compute pipelines
+     *
+     * \param [in] shaders Pipeline shaders
+     */
+    void prioritizeComputePipelines(
+      const DxvkComputePipelineShaders&     shaders);
 
     /**
-     * \brief Checks whether compiler threads are busy
-     * \returns \c true if we're compiling shaders
+     * \brief Compiles a graphics pipeline on a worker thread
+     *
+     * Used when the application needs a pipeline that has
+     * not been compiled yet, so the job is queued with high
+     * priority. The state vector is added to the cache once
+     * the pipeline has been compiled.
+     * \param [in] pipeline The graphics pipeline
+     * \param [in] state Graphics pipeline state
+     * \param [in] renderPass The render pass
      */
-    bool isCompilingShaders() {
-      return m_workerBusy.load() > 0;
-    }
+    void compileGraphicsPipeline(
+            DxvkGraphicsPipeline*           pipeline,
+      const DxvkGraphicsPipelineStateInfo&  state,
+      const DxvkRenderPass*                 renderPass);
+
+    /**
+     * \brief Explicitly stops the writer thread
+     *
+     * Compiler jobs run on the pipeline manager's
+     * worker pool, which must be stopped first.
+     */
+    void stopWorkerThreads();
 
   private:
 
@@ -91,10 +135,12 @@ namespace dxvk {
     struct WorkerItem {
       DxvkGraphicsPipelineShaders gp;
       DxvkComputePipelineShaders  cp;
+      bool                        prioritized = false;
     };
 
     DxvkPipelineManager*              m_pipeManager;
     DxvkRenderPassPool*               m_passManager;
+    DxvkTracer*                       m_tracer;
 
     std::vector<DxvkStateCacheEntry>  m_entries;
     std::atomic<bool>                 m_stopThreads = { false };
@@ -113,11 +159,15 @@ namespace dxvk {
       DxvkShaderKey, Rc<DxvkShader>,
       DxvkHash, DxvkEq> m_shaderMap;
 
-    dxvk::mutex                       m_workerLock;
-    dxvk::condition_variable          m_workerCond;
-    std::queue<WorkerItem>            m_workerQueue;
-    std::atomic<uint32_t>             m_workerBusy;
-    std::vector<dxvk::thread>         m_workerThreads;
+    std::unordered_map<
+      DxvkStateCacheKey, WorkerItem,
+      DxvkHash, DxvkEq> m_workerItems;
+
+    MappedFile                        m_packedFile;
+    DxvkStateCachePackedReader        m_packedData;
+    std::vector<bool>                 m_packedDecoded;
+
+    DxvkWorkerPool*                   m_workers;
 
     dxvk::mutex                       m_writerLock;
     dxvk::condition_variable          m_writerCond;
@@ -139,11 +189,37 @@ namespace dxvk {
       const DxvkShaderKey&            shader,
       const DxvkStateCacheKey&        key);
 
+    void prioritizePipelines(
+      const DxvkStateCacheKey&        key);
+
+    void compilePipelines(
+      const DxvkStateCacheKey&        key);
+
     void compilePipelines(
       const WorkerItem&               item);
 
+    void addCacheEntry(
+      const DxvkStateCacheEntry&      entry);
+
+    std::vector<DxvkStateCacheEntry> getEntries(
+      const DxvkStateCacheKey&        key);
+
+    void decodePackedEntries(
+      const DxvkStateCacheKey&        key);
+
+    bool readPackedEntries(
+            uint32_t                  index,
+            DxvkStateCacheKey&        key,
+            std::vector<DxvkStateCacheEntry>& entries) const;
+
+    bool mapCacheFile();
+
+    void unmapCacheFile();
+
     bool readCacheFile();
 
+    void writeCacheFile();
+
     bool readCacheHeader(
             std::istream&             stream,
             DxvkStateCacheHeader&     header) const;
@@ -177,8 +253,6 @@ namespace dxvk {
       const DxvkStateCacheEntryV6&    in,
             DxvkStateCacheEntry&      out) const;
     
-    void workerFunc();
-
     void writerFunc();
 
     std::wstring getCacheFileName() const;
@@ -0,0 +1,370 @@
+#include "dxvk_state_cache_packed.h"
+
+#include "../util/util_lz.h"
+
+namespace dxvk {
+
+  static uint32_t getBucketCount(uint32_t count) {
+    uint32_t result = 1;
+
+    while (result < 2 * count)
+      result <<= 1;
+
+    return result;
+  }
+
+
+  template<typename T>
+  static void writeTable(std::ostream& stream, const std::vector<T>& table) {
+    stream.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(T));
+  }
+
+
+  uint32_t getPackedHash(
+    const DxvkShaderKey&            key) {
+    uint32_t hash = 2166136261u;
+    hash = (hash ^ uint32_t(key.type())) * 16777619u;
+
+    for (uint32_t i = 0; i < 5; i++)
+      hash = (hash ^ key.sha1().dword(i)) * 16777619u;
+
+    return hash;
+  }
+
+
+  uint32_t getPackedHash(
+    const DxvkStateCacheKey&        key) {
+    const DxvkShaderKey* keys = &key.vs;
+    uint32_t hash = 0;
+
+    for (uint32_t i = 0; i < 6; i++)
+      hash = (hash * 31) ^ getPackedHash(keys[i]);
+
+    return hash;
+  }
+
+
+  DxvkStateCachePackedWriter::DxvkStateCachePackedWriter() {
+
+  }
+
+
+  DxvkStateCachePackedWriter::~DxvkStateCachePackedWriter() {
+
+  }
+
+
+  void DxvkStateCachePackedWriter::addEntry(
+    const DxvkStateCacheKey&        key,
+    const std::string&              data) {
+    auto entry = m_pipelineMap.insert({ key, uint32_t(m_pipelines.size()) });
+
+    if (entry.second)
+      m_pipelines.push_back({ key, std::string(), 0u });
+
+    Pipeline& pipeline = m_pipelines[entry.first->second];
+    pipeline.data += data;
+    pipeline.entryCount += 1;
+  }
+
+
+  bool DxvkStateCachePackedWriter::write(
+          std::ostream&             stream) const {
+    std::vector<DxvkStateCachePackedBlock>    blocks;
+    std::vector<DxvkStateCachePackedPipeline> pipelines;
+    std::vector<DxvkStateCachePackedShader>   shaders;
+    std::vector<uint32_t>                     pipelineRefs;
+    std::vector<uint32_t>                     pipelineBuckets;
+    std::vector<uint32_t>                     shaderBuckets;
+
+    // Assign pipelines to blocks. Pipelines are never split
+    // across blocks, so that any pipeline lookup needs to
+    // decompress at most one block.
+    std::vector<std::string> blockData;
+
+    for (const auto& p : m_pipelines) {
+      if (blockData.empty() || blockData.back().size() + p.data.size() > BlockSize)
+        blockData.emplace_back();
+
+      DxvkStateCachePackedPipeline pipeline;
+      pipeline.key        = p.key;
+      pipeline.blockId    = uint32_t(blockData.size() - 1);
+      pipeline.offset     = uint32_t(blockData.back().size());
+      pipeline.size       = uint32_t(p.data.size());
+      pipeline.entryCount = p.entryCount;
+      pipelines.push_back(pipeline);
+
+      blockData.back() += p.data;
+    }
+
+    // Collect all pipelines that use any given shader
+    std::unordered_map<DxvkShaderKey, uint32_t, DxvkHash, DxvkEq> shaderMap;
+    std::vector<std::vector<uint32_t>> shaderPipelines;
+
+    for (uint32_t i = 0; i < pipelines.size(); i++) {
+      const DxvkShaderKey* keys = &pipelines[i].key.vs;
+
+      for (uint32_t j = 0; j < 6; j++) {
+        if (keys[j].eq(DxvkShaderKey()))
+          continue;
+
+        auto entry = shaderMap.insert({ keys[j], uint32_t(shaders.size()) });
+
+        if (entry.second) {
+          shaders.push_back({ keys[j], 0u, 0u });
+          shaderPipelines.emplace_back();
+        }
+
+        shaderPipelines[entry.first->second].push_back(i);
+      }
+    }
+
+    for (uint32_t i = 0; i < shaders.size(); i++) {
+      shaders[i].refIndex = uint32_t(pipelineRefs.size());
+      shaders[i].refCount = uint32_t(shaderPipelines[i].size());
+      pipelineRefs.insert(pipelineRefs.end(),
+        shaderPipelines[i].begin(),
+        shaderPipelines[i].end());
+    }
+
+    // Build hash tables with linear probing. Buckets store
+    // the index of the referenced object plus one, so that
+    // empty buckets can be identified by a value of zero.
+    pipelineBuckets.resize(getBucketCount(pipelines.size()));
+    shaderBuckets.resize(getBucketCount(shaders.size()));
+
+    for (uint32_t i = 0; i < pipelines.size(); i++) {
+      uint32_t mask = pipelineBuckets.size() - 1;
+      uint32_t index = getPackedHash(pipelines[i].key) & mask;
+
+      while (pipelineBuckets[index])
+        index = (index + 1) & mask;
+
+      pipelineBuckets[index] = i + 1;
+    }
+
+    for (uint32_t i = 0; i < shaders.size(); i++) {
+      uint32_t mask = shaderBuckets.size() - 1;
+      uint32_t index = getPackedHash(shaders[i].key) & mask;
+
+      while (shaderBuckets[index])
+        index = (index + 1) & mask;
+
+      shaderBuckets[index] = i + 1;
+    }
+
+    // Compress blocks and compute the file layout
+    uint64_t offset = sizeof(DxvkStateCacheHeader)
+                    + sizeof(DxvkStateCachePackedHeader);
+
+    std::vector<std::vector<char>> compressedData(blockData.size());
+
+    for (uint32_t i = 0; i < blockData.size(); i++) {
+      compressedData[i].resize(lz::compressBound(blockData[i].size()));
+
+      size_t compressedSize = lz::compress(
+        blockData[i].data(), blockData[i].size(),
+        compressedData[i].data(), compressedData[i].size());
+
+      if (!compressedSize)
+        return false;
+
+      compressedData[i].resize(compressedSize);
+
+      DxvkStateCachePackedBlock block;
+      block.offset         = offset;
+      block.compressedSize = uint32_t(compressedSize);
+      block.rawSize        = uint32_t(blockData[i].size());
+      blocks.push_back(block);
+
+      offset += compressedSize;
+    }
+
+    DxvkStateCachePackedHeader header;
+    header.blockCount           = uint32_t(blocks.size());
+    header.pipelineCount        = uint32_t(pipelines.size());
+    header.shaderCount          = uint32_t(shaders.size());
+    header.pipelineRefCount     = uint32_t(pipelineRefs.size());
+    header.pipelineBucketCount  = uint32_t(pipelineBuckets.size());
+    header.shaderBucketCount    = uint32_t(shaderBuckets.size());
+    header.indexOffset          = align(offset, 8);
+    header.indexSize            = sizeof(DxvkStateCachePackedBlock)    * blocks.size()
+                                + sizeof(DxvkStateCachePackedPipeline) * pipelines.size()
+                                + sizeof(DxvkStateCachePackedShader)   * shaders.size()
+                                + sizeof(uint32_t) * pipelineRefs.size()
+                                + sizeof(uint32_t) * pipelineBuckets.size()
+                                + sizeof(uint32_t) * shaderBuckets.size();
+    header.dataSize             = header.indexOffset + header.indexSize;
+
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    for (const auto& data : compressedData)
+      stream.write(data.data(), data.size());
+
+    const char padding[8] = { };
+    stream.write(padding, header.indexOffset - offset);
+
+    writeTable(stream, blocks);
+    writeTable(stream, pipelines);
+    writeTable(stream, shaders);
+    writeTable(stream, pipelineRefs);
+    writeTable(stream, pipelineBuckets);
+    writeTable(stream, shaderBuckets);
+
+    stream.flush();
+    return bool(stream);
+  }
+
+
+  DxvkStateCachePackedReader::DxvkStateCachePackedReader() {
+
+  }
+
+
+  DxvkStateCachePackedReader::~DxvkStateCachePackedReader() {
+
+  }
+
+
+  bool DxvkStateCachePackedReader::init(
+    const char*                     data,
+          size_t                    size) {
+    DxvkStateCachePackedHeader header;
+
+    if (size < sizeof(DxvkStateCacheHeader) + sizeof(header))
+      return false;
+
+    std::memcpy(&header, data + sizeof(DxvkStateCacheHeader), sizeof(header));
+
+    // Validate the layout of the index tables, everything
+    // else will be validated when looking up entries
+    uint64_t blockSize    = sizeof(DxvkStateCachePackedBlock)    * uint64_t(header.blockCount);
+    uint64_t pipelineSize = sizeof(DxvkStateCachePackedPipeline) * uint64_t(header.pipelineCount);
+    uint64_t shaderSize   = sizeof(DxvkStateCachePackedShader)   * uint64_t(header.shaderCount);
+    uint64_t refSize      = sizeof(uint32_t) * uint64_t(header.pipelineRefCount);
+    uint64_t bucketSize   = sizeof(uint32_t) * (uint64_t(header.pipelineBucketCount)
+                                             +  uint64_t(header.shaderBucketCount));
+
+    if (header.indexOffset % 8
+     || header.indexSize != blockSize + pipelineSize + shaderSize + refSize + bucketSize
+     || header.indexOffset + header.indexSize != header.dataSize
+     || header.dataSize > size)
+      return false;
+
+    if (header.pipelineBucketCount < header.pipelineCount
+     || header.shaderBucketCount   < header.shaderCount
+     || !header.pipelineBucketCount || (header.pipelineBucketCount & (header.pipelineBucketCount - 1))
+     || !header.shaderBucketCount   || (header.shaderBucketCount   & (header.shaderBucketCount   - 1)))
+      return false;
+
+    const char* index = data + header.indexOffset;
+
+    m_data    = data;
+    m_header  = header;
+
+    m_blocks          = reinterpret_cast<const DxvkStateCachePackedBlock*>(index);
+    m_pipelines       = reinterpret_cast<const DxvkStateCachePackedPipeline*>(index + blockSize);
+    m_shaders         = reinterpret_cast<const DxvkStateCachePackedShader*>(index + blockSize + pipelineSize);
+    m_pipelineRefs    = reinterpret_cast<const uint32_t*>(index + blockSize + pipelineSize + shaderSize);
+    m_pipelineBuckets = m_pipelineRefs + header.pipelineRefCount;
+    m_shaderBuckets   = m_pipelineBuckets + header.pipelineBucketCount;
+
+    m_entryCount = 0;
+
+    for (uint32_t i = 0; i < header.pipelineCount; i++)
+      m_entryCount += m_pipelines[i].entryCount;
+
+    return true;
+  }
+
+
+  uint32_t DxvkStateCachePackedReader::findPipeline(
+    const DxvkStateCacheKey&        key) const {
+    if (!m_header.pipelineCount)
+      return InvalidIndex;
+
+    uint32_t mask = m_header.pipelineBucketCount - 1;
+    uint32_t hash = getPackedHash(key);
+
+    for (uint32_t i = 0; i <= mask; i++) {
+      uint32_t index = m_pipelineBuckets[(hash + i) & mask];
+
+      if (!index || index > m_header.pipelineCount)
+        break;
+
+      if (m_pipelines[index - 1].key.eq(key))
+        return index - 1;
+    }
+
+    return InvalidIndex;
+  }
+
+
+  void DxvkStateCachePackedReader::findPipelines(
+    const DxvkShaderKey&            shader,
+          std::vector<DxvkStateCacheKey>& keys) const {
+    if (!m_header.shaderCount)
+      return;
+
+    uint32_t mask = m_header.shaderBucketCount - 1;
+    uint32_t hash = getPackedHash(shader);
+
+    for (uint32_t i = 0; i <= mask; i++) {
+      uint32_t index = m_shaderBuckets[(hash + i) & mask];
+
+      if (!index || index > m_header.shaderCount)
+        break;
+
+      const DxvkStateCachePackedShader& entry = m_shaders[index - 1];
+
+      if (!entry.key.eq(shader))
+        continue;
+
+      if (uint64_t(entry.refIndex) + entry.refCount > m_header.pipelineRefCount)
+        break;
+
+      for (uint32_t j = 0; j < entry.refCount; j++) {
+        uint32_t pipeline = m_pipelineRefs[entry.refIndex + j];
+
+        if (pipeline < m_header.pipelineCount)
+          keys.push_back(m_pipelines[pipeline].key);
+      }
+
+      break;
+    }
+  }
+
+
+  bool DxvkStateCachePackedReader::readPipeline(
+          uint32_t                  index,
+          DxvkStateCacheKey&        key,
+          std::string&              data) const {
+    if (index >= m_header.pipelineCount)
+      return false;
+
+    const DxvkStateCachePackedPipeline& pipeline = m_pipelines[index];
+
+    if (pipeline.blockId >= m_header.blockCount)
+      return false;
+
+    const DxvkStateCachePackedBlock& block = m_blocks[pipeline.blockId];
+
+    if (block.offset + block.compressedSize > m_header.indexOffset
+     || uint64_t(pipeline.offset) + pipeline.size > block.rawSize)
+      return false;
+
+    // Only decode the block up to the end of the pipeline
+    size_t decodeSize = pipeline.offset + pipeline.size;
+
+    std::vector<char> buffer(decodeSize);
+
+    if (lz::decompress(m_data + block.offset, block.compressedSize,
+          buffer.data(), buffer.size()) != decodeSize)
+      return false;
+
+    key = pipeline.key;
+    data.assign(buffer.data() + pipeline.offset, pipeline.size);
+    return true;
+  }
+
+}
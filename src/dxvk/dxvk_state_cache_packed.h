@@ -0,0 +1,260 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "dxvk_state_cache_types.h"
+
+namespace dxvk {
+
+  /**
+   * \brief Packed state cache header
+   *
+   * Follows the regular state cache header. Entries are
+   * grouped by pipeline and stored in compressed blocks,
+   * followed by index tables that allow looking up the
+   * entries of any given pipeline, as well as all
+   * pipelines that use a given shader. Any entries that
+   * were appended after \c dataSize use the regular
+   * unpacked entry format.
+   */
+  struct DxvkStateCachePackedHeader {
+    uint32_t blockCount           = 0;
+    uint32_t pipelineCount        = 0;
+    uint32_t shaderCount          = 0;
+    uint32_t pipelineRefCount     = 0;
+    uint32_t pipelineBucketCount  = 0;
+    uint32_t shaderBucketCount    = 0;
+    uint64_t indexOffset          = 0;
+    uint64_t indexSize            = 0;
+    uint64_t dataSize             = 0;
+  };
+
+  static_assert(sizeof(DxvkStateCachePackedHeader) == 48);
+
+
+  /**
+   * \brief Packed state cache block
+   *
+   * Stores the location of a compressed block
+   * within the file, as well as its raw size.
+   */
+  struct DxvkStateCachePackedBlock {
+    uint64_t offset;
+    uint32_t compressedSize;
+    uint32_t rawSize;
+  };
+
+
+  /**
+   * \brief Packed state cache pipeline
+   *
+   * Stores the location of all entries for a given
+   * pipeline within its block. Entries of a single
+   * pipeline are never split across blocks.
+   */
+  struct DxvkStateCachePackedPipeline {
+    DxvkStateCacheKey key;
+    uint32_t blockId;
+    uint32_t offset;
+    uint32_t size;
+    uint32_t entryCount;
+  };
+
+
+  /**
+   * \brief Packed state cache shader
+   *
+   * Stores a range of indices into the pipeline
+   * reference table, one for each pipeline that
+   * uses the given shader.
+   */
+  struct DxvkStateCachePackedShader {
+    DxvkShaderKey key;
+    uint32_t refIndex;
+    uint32_t refCount;
+  };
+
+
+  /**
+   * \brief Packed state cache writer
+   *
+   * Collects serialized state cache entries and
+   * writes them out in the packed format.
+   */
+  class DxvkStateCachePackedWriter {
+    constexpr static size_t BlockSize = 4096;
+  public:
+
+    DxvkStateCachePackedWriter();
+
+    ~DxvkStateCachePackedWriter();
+
+    /**
+     * \brief Adds a serialized entry
+     *
+     * \param [in] key Shader keys of the pipeline
+     * \param [in] data Serialized entry
+     */
+    void addEntry(
+      const DxvkStateCacheKey&        key,
+      const std::string&              data);
+
+    /**
+     * \brief Writes packed data to a stream
+     *
+     * The stream must be positioned right after
+     * the state cache header.
+     * \param [in] stream Output stream
+     * \returns \c true on success
+     */
+    bool write(
+            std::ostream&             stream) const;
+
+  private:
+
+    struct Pipeline {
+      DxvkStateCacheKey key;
+      std::string       data;
+      uint32_t          entryCount;
+    };
+
+    std::vector<Pipeline> m_pipelines;
+
+    std::unordered_map<
+      DxvkStateCacheKey, uint32_t,
+      DxvkHash, DxvkEq> m_pipelineMap;
+
+  };
+
+
+  /**
+   * \brief Packed state cache reader
+   *
+   * Provides lookups into packed state cache data
+   * without decoding anything up front. Entries are
+   * only decompressed when they are requested. The
+   * data must remain valid for the lifetime of the
+   * reader. All methods are thread-safe.
+   */
+  class DxvkStateCachePackedReader {
+
+  public:
+
+    constexpr static uint32_t InvalidIndex = ~0u;
+
+    DxvkStateCachePackedReader();
+
+    ~DxvkStateCachePackedReader();
+
+    /**
+     * \brief Initializes reader
+     *
+     * Validates the packed header and index tables.
+     * \param [in] data Pointer to the start of the file
+     * \param [in] size File size
+     * \returns \c true if the packed data is valid
+     */
+    bool init(
+      const char*                     data,
+            size_t                    size);
+
+    /**
+     * \brief Size of the packed region
+     *
+     * Unpacked entries may be stored after this offset.
+     * \returns Offset of first unpacked entry
+     */
+    size_t dataSize() const {
+      return m_header.dataSize;
+    }
+
+    /**
+     * \brief Number of pipelines
+     * \returns Pipeline count
+     */
+    uint32_t pipelineCount() const {
+      return m_header.pipelineCount;
+    }
+
+    /**
+     * \brief Total number of entries
+     * \returns Entry count
+     */
+    size_t entryCount() const {
+      return m_entryCount;
+    }
+
+    /**
+     * \brief Looks up a pipeline
+     *
+     * \param [in] key Pipeline shader keys
+     * \returns Pipeline index, or \c InvalidIndex
+     */
+    uint32_t findPipeline(
+      const DxvkStateCacheKey&        key) const;
+
+    /**
+     * \brief Looks up pipelines using a shader
+     *
+     * \param [in] shader Shader key
+     * \param [out] keys Shader keys of all pipelines
+     *    that use the given shader will be appended
+     */
+    void findPipelines(
+      const DxvkShaderKey&            shader,
+            std::vector<DxvkStateCacheKey>& keys) const;
+
+    /**
+     * \brief Decodes entries of a pipeline
+     *
+     * \param [in] index Pipeline index
+     * \param [out] key Pipeline shader keys
+     * \param [out] data Serialized entries
+     * \returns \c true on success
+     */
+    bool readPipeline(
+            uint32_t                  index,
+            DxvkStateCacheKey&        key,
+            std::string&              data) const;
+
+  private:
+
+    const char*                         m_data = nullptr;
+    DxvkStateCachePackedHeader          m_header;
+    size_t                              m_entryCount = 0;
+
+    const DxvkStateCachePackedBlock*    m_blocks          = nullptr;
+    const DxvkStateCachePackedPipeline* m_pipelines       = nullptr;
+    const DxvkStateCachePackedShader*   m_shaders         = nullptr;
+    const uint32_t*                     m_pipelineRefs    = nullptr;
+    const uint32_t*                     m_pipelineBuckets = nullptr;
+    const uint32_t*                     m_shaderBuckets   = nullptr;
+
+  };
+
+
+  /**
+   * \brief Computes lookup hash for packed index
+   *
+   * Unlike \c hash(), this does not depend on the
+   * host platform, so the same packed file can be
+   * used by both 32-bit and 64-bit processes.
+   * \param [in] key Shader key
+   * \returns Lookup hash
+   */
+  uint32_t getPackedHash(
+    const DxvkShaderKey&            key);
+
+  /**
+   * \brief Computes lookup hash for packed index
+   *
+   * \param [in] key Pipeline shader keys
+   * \returns Lookup hash
+   */
+  uint32_t getPackedHash(
+    const DxvkStateCacheKey&        key);
+
+}
@@ -49,10 +49,14 @@ namespace dxvk {
    * Stores the state cache format version. If an
    * existing cache file is incompatible to the
    * current version, it will be discarded.
+   *
+   * Starting with v11, the header is followed by
+   * packed entry data rather than a plain list of
+   * entries, see \ref DxvkStateCachePackedHeader.
    */
   struct DxvkStateCacheHeader {
     char     magic[4]   = { 'D', 'X', 'V', 'K' };
-    uint32_t version    = 10;
+    uint32_t version    = 11;
     uint32_t entrySize  = 0; /* no longer meaningful */
   };
 
@@ -31,4 +31,220 @@ namespace dxvk {
       m_counters[i] = 0;
   }
   
+  
+  DxvkStatHistogram::DxvkStatHistogram() {
+    this->reset();
+  }
+
+
+  DxvkStatHistogram::~DxvkStatHistogram() {
+
+  }
+
+
+  uint64_t DxvkStatHistogram::getSampleCount() const {
+    uint64_t result = 0;
+    for (size_t i = 0; i < m_buckets.size(); i++)
+      result += m_buckets[i];
+    return result;
+  }
+
+
+  DxvkStatHistogram DxvkStatHistogram::diff(const DxvkStatHistogram& other) const {
+    DxvkStatHistogram result;
+    for (size_t i = 0; i < m_buckets.size(); i++)
+      result.m_buckets[i] = m_buckets[i] - other.m_buckets[i];
+    return result;
+  }
+
+
+  void DxvkStatHistogram::merge(const DxvkStatHistogram& other) {
+    for (size_t i = 0; i < m_buckets.size(); i++)
+      m_buckets[i] += other.m_buckets[i];
+  }
+
+
+  void DxvkStatHistogram::reset() {
+    for (size_t i = 0; i < m_buckets.size(); i++)
+      m_buckets[i] = 0;
+  }
+
+
+  struct DxvkStatCounterInfo {
+    const char* name;
+    bool        cumulative;
+  };
+
+
+  static const std::array<DxvkStatCounterInfo, uint32_t(DxvkStatCounter::NumCounters)> g_statCounterInfos = {{
+    { "CmdDrawCalls",           true  },
+    { "CmdDispatchCalls",       true  },
+    { "CmdRenderPassCount",     true  },
+    { "CmdBufferUpdates",       true  },
+    { "CmdBufferUpdateCopies",  true  },
+    { "CmdBufferUpdateBytes",   true  },
+    { "CmdBarrierCount",        true  },
+    { "StagingAllocSize",       true  },
+    { "StagingRetiredSize",     true  },
+    { "StagingBufferCount",     true  },
+    { "StagingStallCount",      true  },
+    { "DescriptorPoolCount",    true  },
+    { "DescriptorSetCount",     true  },
+    { "PipeCountGraphics",      false },
+    { "PipeCountCompute",       false },
+    { "PipeCompilerBusy",       false },
+    { "PipeSkippedDraws",       true  },
+    { "PipeFallbackDraws",      true  },
+    { "QueueSubmitCount",       true  },
+    { "QueuePresentCount",      true  },
+    { "GpuIdleTicks",           true  },
+    { "MemoryAllocCount",       true  },
+    { "MemoryFreeCount",        true  },
+    { "MemoryDeviceAllocCount", true  },
+    { "MemoryDeviceFreeCount",  true  },
+    { "CsSyncCount",            true  },
+    { "CsSyncTicks",            true  },
+    { "MapWaitCount",           true  },
+    { "MapWaitTicks",           true  },
+  }};
+
+
+  static const std::array<const char*, uint32_t(DxvkStatHistogramType::NumHistograms)> g_statHistogramNames = {{
+    "CsQueueDepth",
+    "CsSyncTime",
+    "MapWaitTime",
+  }};
+
+
+  const char* getStatCounterName(DxvkStatCounter ctr) {
+    return g_statCounterInfos[uint32_t(ctr)].name;
+  }
+
+
+  const char* getStatHistogramName(DxvkStatHistogramType type) {
+    return g_statHistogramNames[uint32_t(type)];
+  }
+
+
+  static std::atomic<bool> g_statDumpActive = { false };
+
+
+  DxvkStatDump::DxvkStatDump(std::ofstream&& file)
+  : m_file(std::move(file)) {
+    this->writeHeader();
+  }
+
+
+  DxvkStatDump::~DxvkStatDump() {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+    this->flushBuffer();
+  }
+
+
+  Rc<DxvkStatDump> DxvkStatDump::create() {
+    if (env::getEnvVar("DXVK_STATS_DUMP") != "1")
+      return nullptr;
+
+    // Only dump stats for one device per process
+    // since they would all write to the same file
+    if (g_statDumpActive.exchange(true))
+      return nullptr;
+
+    std::string fileName = getFileName();
+
+    std::ofstream file(str::tows(fileName.c_str()).c_str(),
+      std::ios_base::binary | std::ios_base::trunc);
+
+    if (!file) {
+      Logger::err(str::format("DXVK: Failed to create stat dump file ", fileName));
+      return nullptr;
+    }
+
+    Logger::info(str::format("DXVK: Writing stats to ", fileName));
+    return new DxvkStatDump(std::move(file));
+  }
+
+
+  void DxvkStatDump::writeFrame(
+    const DxvkStatCounters&     counters,
+    const DxvkStatHistograms&   histograms) {
+    std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+    DxvkStatCounters diffCounters = counters.diff(m_prevCounters);
+
+    m_buffer += std::to_string(m_frameId++);
+
+    for (uint32_t i = 0; i < uint32_t(DxvkStatCounter::NumCounters); i++) {
+      auto ctr = DxvkStatCounter(i);
+
+      m_buffer += ',';
+      m_buffer += std::to_string(g_statCounterInfos[i].cumulative
+        ? diffCounters.getCtr(ctr)
+        : counters.getCtr(ctr));
+    }
+
+    for (uint32_t i = 0; i < uint32_t(DxvkStatHistogramType::NumHistograms); i++) {
+      DxvkStatHistogram diff = histograms[i].diff(m_prevHistograms[i]);
+
+      for (uint32_t j = 0; j < DxvkStatHistogram::BucketCount; j++) {
+        m_buffer += ',';
+        m_buffer += std::to_string(diff.getBucket(j));
+      }
+    }
+
+    m_buffer += '\n';
+
+    m_prevCounters   = counters;
+    m_prevHistograms = histograms;
+
+    if (!(m_frameId % FlushInterval))
+      this->flushBuffer();
+  }
+
+
+  void DxvkStatDump::writeHeader() {
+    m_file << "Frame";
+
+    for (uint32_t i = 0; i < uint32_t(DxvkStatCounter::NumCounters); i++)
+      m_file << ',' << g_statCounterInfos[i].name;
+
+    // Label histogram buckets with the range of values they count
+    for (uint32_t i = 0; i < uint32_t(DxvkStatHistogramType::NumHistograms); i++) {
+      for (uint32_t j = 0; j < DxvkStatHistogram::BucketCount; j++) {
+        m_file << ',' << g_statHistogramNames[i] << '[' << DxvkStatHistogram::getBucketMin(j);
+
+        if (j + 1 < DxvkStatHistogram::BucketCount) {
+          uint64_t max = DxvkStatHistogram::getBucketMin(j + 1) - 1;
+
+          if (max != DxvkStatHistogram::getBucketMin(j))
+            m_file << '-' << max;
+        } else {
+          m_file << '+';
+        }
+
+        m_file << ']';
+      }
+    }
+
+    m_file << '\n';
+  }
+
+
+  void DxvkStatDump::flushBuffer() {
+    m_file.write(m_buffer.data(), m_buffer.size());
+    m_file.flush();
+
+    m_buffer.clear();
+  }
+
+
+  std::string DxvkStatDump::getFileName() {
+    std::string path = env::getEnvVar("DXVK_STATS_DUMP_PATH");
+
+    if (!path.empty() && *path.rbegin() != '/')
+      path += '/';
+
+    return path + env::getExeBaseName() + ".dxvk-stats.csv";
+  }
+
 }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <fstream>
+
 #include "dxvk_include.h"
 
 namespace dxvk {
@@ -14,14 +16,48 @@ namespace dxvk {
     CmdDrawCalls,             ///< Number of draw calls
     CmdDispatchCalls,         ///< Number of compute calls
     CmdRenderPassCount,       ///< Number of render passes
+    CmdBufferUpdates,         ///< Number of buffer updates
+    CmdBufferUpdateCopies,    ///< Number of copy commands for buffer updates
+    CmdBufferUpdateBytes,     ///< Amount of data uploaded by buffer updates
+    CmdBarrierCount,          ///< Number of pipeline barriers
+    StagingAllocSize,         ///< Amount of staging memory sub-allocated
+    StagingRetiredSize,       ///< Capacity of filled staging buffers
+    StagingBufferCount,       ///< Number of staging buffers created
+    StagingStallCount,        ///< Number of staging buffer switches with no idle buffer
+    DescriptorPoolCount,      ///< Number of descriptor pools used
+    DescriptorSetCount,       ///< Number of descriptor sets allocated
     PipeCountGraphics,        ///< Number of graphics pipelines
     PipeCountCompute,         ///< Number of compute pipelines
     PipeCompilerBusy,         ///< Boolean indicating compiler activity
+    PipeSkippedDraws,         ///< Number of draws skipped while compiling pipelines
+    PipeFallbackDraws,        ///< Number of draws using a fallback pipeline
     QueueSubmitCount,         ///< Number of command buffer submissions
     QueuePresentCount,        ///< Number of present calls / frames
     GpuIdleTicks,             ///< GPU idle time in microseconds
+    MemoryAllocCount,         ///< Number of memory allocations
+    MemoryFreeCount,          ///< Number of memory frees
+    MemoryDeviceAllocCount,   ///< Number of Vulkan device memory allocations
+    MemoryDeviceFreeCount,    ///< Number of Vulkan device memory frees
+    CsSyncCount,              ///< Number of times the app waited for the CS thread
+    CsSyncTicks,              ///< Time spent waiting for the CS thread in microseconds
+    MapWaitCount,             ///< Number of times the app waited for a resource to map it
+    MapWaitTicks,             ///< Time spent waiting for resources in microseconds
     NumCounters,              ///< Number of counters available
   };
+
+
+  /**
+   * \brief Named stat histograms
+   *
+   * Enumerates available stat histograms.
+   * Used together with \ref DxvkStatHistogram.
+   */
+  enum class DxvkStatHistogramType : uint32_t {
+    CsQueueDepth,             ///< Number of pending CS chunks on dispatch
+    CsSyncTime,               ///< Time spent waiting for the CS thread in microseconds
+    MapWaitTime,              ///< Time spent waiting for resources in microseconds
+    NumHistograms,            ///< Number of histograms available
+  };
   
   
   /**
@@ -105,5 +141,181 @@ namespace dxvk {
     std::array<uint64_t, uint32_t(DxvkStatCounter::NumCounters)> m_counters;
     
   };
-  
+
+
+  /**
+   * \brief Stat histogram
+   *
+   * Counts samples in buckets of increasing size. The
+   * first bucket counts zero values, and bucket \c n
+   * counts values in the range [2^(n-1), 2^n), except
+   * for the last bucket, which counts all larger values.
+   */
+  class DxvkStatHistogram {
+
+  public:
+
+    constexpr static uint32_t BucketCount = 16;
+
+    DxvkStatHistogram();
+    ~DxvkStatHistogram();
+
+    /**
+     * \brief Retrieves a bucket value
+     *
+     * \param [in] bucket Bucket index
+     * \returns Number of samples in the bucket
+     */
+    uint64_t getBucket(uint32_t bucket) const {
+      return m_buckets[bucket];
+    }
+
+    /**
+     * \brief Sets a bucket value
+     *
+     * \param [in] bucket Bucket index
+     * \param [in] val Number of samples
+     */
+    void setBucket(uint32_t bucket, uint64_t val) {
+      m_buckets[bucket] = val;
+    }
+
+    /**
+     * \brief Adds a sample
+     * \param [in] value Sample value
+     */
+    void addSample(uint64_t value) {
+      m_buckets[getBucketIndex(value)] += 1;
+    }
+
+    /**
+     * \brief Total number of samples
+     * \returns Sum of all buckets
+     */
+    uint64_t getSampleCount() const;
+
+    /**
+     * \brief Computes difference
+     *
+     * \param [in] other Histogram to subtract
+     * \returns Difference between histograms
+     */
+    DxvkStatHistogram diff(const DxvkStatHistogram& other) const;
+
+    /**
+     * \brief Merges histograms
+     * \param [in] other Histogram to add
+     */
+    void merge(const DxvkStatHistogram& other);
+
+    /**
+     * \brief Resets histogram
+     */
+    void reset();
+
+    /**
+     * \brief Computes bucket index for a value
+     *
+     * \param [in] value Sample value
+     * \returns Bucket index
+     */
+    static uint32_t getBucketIndex(uint64_t value) {
+      return std::min(64u - bit::lzcnt(uint64_t(value)), BucketCount - 1);
+    }
+
+    /**
+     * \brief Smallest value counted by a bucket
+     *
+     * \param [in] bucket Bucket index
+     * \returns Lower bound of the bucket
+     */
+    static uint64_t getBucketMin(uint32_t bucket) {
+      return bucket ? uint64_t(1) << (bucket - 1) : 0;
+    }
+
+  private:
+
+    std::array<uint64_t, BucketCount> m_buckets;
+
+  };
+
+
+  /**
+   * \brief Set of all stat histograms
+   */
+  using DxvkStatHistograms = std::array<DxvkStatHistogram,
+    uint32_t(DxvkStatHistogramType::NumHistograms)>;
+
+
+  /**
+   * \brief Retrieves stat counter name
+   *
+   * \param [in] ctr The counter
+   * \returns Counter name
+   */
+  const char* getStatCounterName(DxvkStatCounter ctr);
+
+  /**
+   * \brief Retrieves stat histogram name
+   *
+   * \param [in] type The histogram
+   * \returns Histogram name
+   */
+  const char* getStatHistogramName(DxvkStatHistogramType type);
+
+
+  /**
+   * \brief Stat dump
+   *
+   * Writes all stat counters and histograms to a CSV
+   * file once per frame, so that they can be analyzed
+   * offline. Counters that accumulate over time are
+   * written as per-frame differences. Rows are buffered
+   * in memory and written out every few frames. Enabled
+   * via \c DXVK_STATS_DUMP=1.
+   */
+  class DxvkStatDump : public RcObject {
+    constexpr static uint32_t FlushInterval = 64; // frames
+
+  public:
+
+    DxvkStatDump(std::ofstream&& file);
+    ~DxvkStatDump();
+
+    /**
+     * \brief Creates stat dump if enabled
+     *
+     * \returns Stat dump object, or \c nullptr
+     *    if dumping stats is not enabled
+     */
+    static Rc<DxvkStatDump> create();
+
+    /**
+     * \brief Writes stats for one frame
+     *
+     * \param [in] counters Current counter values
+     * \param [in] histograms Current histograms
+     */
+    void writeFrame(
+      const DxvkStatCounters&     counters,
+      const DxvkStatHistograms&   histograms);
+
+  private:
+
+    dxvk::mutex         m_mutex;
+    std::ofstream       m_file;
+    std::string         m_buffer;
+    uint32_t            m_frameId = 0;
+
+    DxvkStatCounters    m_prevCounters;
+    DxvkStatHistograms  m_prevHistograms;
+
+    void writeHeader();
+
+    void flushBuffer();
+
+    static std::string getFileName();
+
+  };
+
 }
@@ -0,0 +1,292 @@
+#include "dxvk_tlsf.h"
+
+#include "../util/util_bit.h"
+
+namespace dxvk {
+
+  DxvkTlsfAllocator::DxvkTlsfAllocator(VkDeviceSize size)
+  : m_size(size) {
+    if (size >= MaxSize)
+      throw DxvkError(str::format("DxvkTlsfAllocator: Size ", size, " not supported"));
+
+    m_freeLists.fill(InvalidBlock);
+
+    // Mark the entire range as free
+    insertFreeBlock(createBlock(0, size));
+  }
+
+
+  DxvkTlsfAllocator::~DxvkTlsfAllocator() {
+
+  }
+
+
+  DxvkTlsfAllocation DxvkTlsfAllocator::alloc(
+          VkDeviceSize          size,
+          VkDeviceSize          align) {
+    size = dxvk::align(size, align);
+
+    uint32_t index = findFittingBlock(size, align);
+
+    if (index == InvalidBlock)
+      return { InvalidOffset, InvalidBlock };
+
+    removeFreeBlock(index);
+
+    // If the block start is not properly aligned, return
+    // the padding in front of the allocation to the pool
+    VkDeviceSize offset = dxvk::align(m_blocks[index].offset, align);
+
+    if (offset != m_blocks[index].offset) {
+      uint32_t next = splitBlock(index, offset - m_blocks[index].offset);
+      insertFreeBlock(index);
+      index = next;
+    }
+
+    // Same goes for any unused space at the end
+    if (m_blocks[index].length != size)
+      insertFreeBlock(splitBlock(index, size));
+
+    m_used += size;
+    return { offset, index };
+  }
+
+
+  void DxvkTlsfAllocator::free(
+          uint32_t              block) {
+    if (unlikely(block >= m_blocks.size() || m_blocks[block].isFree)) {
+      Logger::err(str::format("DxvkTlsfAllocator: Invalid block ", block));
+      return;
+    }
+
+    uint32_t index = block;
+    m_used -= m_blocks[index].length;
+
+    // Merge with adjacent free blocks. Since free blocks are
+    // always merged, no more than one block exists on either
+    // side, which keeps this a constant-time operation.
+    uint32_t next = m_blocks[index].nextPhys;
+
+    if (next != InvalidBlock && m_blocks[next].isFree) {
+      removeFreeBlock(next);
+      mergeBlocks(index, next);
+    }
+
+    uint32_t prev = m_blocks[index].prevPhys;
+
+    if (prev != InvalidBlock && m_blocks[prev].isFree) {
+      removeFreeBlock(prev);
+      mergeBlocks(prev, index);
+      index = prev;
+    }
+
+    insertFreeBlock(index);
+  }
+
+
+  uint32_t DxvkTlsfAllocator::createBlock(
+          VkDeviceSize          offset,
+          VkDeviceSize          length) {
+    uint32_t index;
+
+    if (!m_unusedBlocks.empty()) {
+      index = m_unusedBlocks.back();
+      m_unusedBlocks.pop_back();
+    } else {
+      index = uint32_t(m_blocks.size());
+      m_blocks.emplace_back();
+    }
+
+    Block& block = m_blocks[index];
+    block.offset   = offset;
+    block.length   = length;
+    block.prevPhys = InvalidBlock;
+    block.nextPhys = InvalidBlock;
+    block.prevFree = InvalidBlock;
+    block.nextFree = InvalidBlock;
+    block.isFree   = false;
+    return index;
+  }
+
+
+  void DxvkTlsfAllocator::destroyBlock(
+          uint32_t              index) {
+    // Unused blocks count as free so that
+    // freeing them again can be detected
+    m_blocks[index].isFree = true;
+    m_unusedBlocks.push_back(index);
+  }
+
+
+  uint32_t DxvkTlsfAllocator::splitBlock(
+          uint32_t              index,
+          VkDeviceSize          length) {
+    uint32_t next = createBlock(
+      m_blocks[index].offset + length,
+      m_blocks[index].length - length);
+
+    Block& block = m_blocks[index];
+    Block& split = m_blocks[next];
+
+    split.prevPhys = index;
+    split.nextPhys = block.nextPhys;
+
+    if (block.nextPhys != InvalidBlock)
+      m_blocks[block.nextPhys].prevPhys = next;
+
+    block.nextPhys = next;
+    block.length   = length;
+    return next;
+  }
+
+
+  void DxvkTlsfAllocator::mergeBlocks(
+          uint32_t              index,
+          uint32_t              next) {
+    Block& block = m_blocks[index];
+    Block& merge = m_blocks[next];
+
+    block.length  += merge.length;
+    block.nextPhys = merge.nextPhys;
+
+    if (merge.nextPhys != InvalidBlock)
+      m_blocks[merge.nextPhys].prevPhys = index;
+
+    destroyBlock(next);
+  }
+
+
+  void DxvkTlsfAllocator::insertFreeBlock(
+          uint32_t              index) {
+    uint32_t list = computeListIndex(m_blocks[index].length);
+
+    Block& block = m_blocks[index];
+    block.isFree   = true;
+    block.prevFree = InvalidBlock;
+    block.nextFree = m_freeLists[list];
+
+    if (block.nextFree != InvalidBlock)
+      m_blocks[block.nextFree].prevFree = index;
+
+    m_freeLists[list] = index;
+
+    m_flBitmap                    |= 1u << (list / SlCount);
+    m_slBitmaps[list / SlCount]   |= 1u << (list % SlCount);
+  }
+
+
+  void DxvkTlsfAllocator::removeFreeBlock(
+          uint32_t              index) {
+    uint32_t list = computeListIndex(m_blocks[index].length);
+
+    Block& block = m_blocks[index];
+    block.isFree = false;
+
+    if (block.prevFree != InvalidBlock)
+      m_blocks[block.prevFree].nextFree = block.nextFree;
+    else
+      m_freeLists[list] = block.nextFree;
+
+    if (block.nextFree != InvalidBlock)
+      m_blocks[block.nextFree].prevFree = block.prevFree;
+
+    if (m_freeLists[list] == InvalidBlock) {
+      m_slBitmaps[list / SlCount] &= ~(1u << (list % SlCount));
+
+      if (!m_slBitmaps[list / SlCount])
+        m_flBitmap &= ~(1u << (list / SlCount));
+    }
+  }
+
+
+  uint32_t DxvkTlsfAllocator::findFreeBlock(
+          VkDeviceSize          size) const {
+    // Round the size up to the next list boundary so
+    // that every block in the selected list is large
+    // enough to hold the requested number of bytes
+    if (size >= SlCount) {
+      uint32_t msb = 63 - bit::lzcnt(uint64_t(size));
+      size += (VkDeviceSize(1) << (msb - SlBits)) - 1;
+    }
+
+    uint32_t list = computeListIndex(size);
+    uint32_t fl = list / SlCount;
+    uint32_t sl = list % SlCount;
+
+    if (fl >= FlCount)
+      return InvalidBlock;
+
+    uint32_t slMap = m_slBitmaps[fl] & (~0u << sl);
+
+    if (!slMap) {
+      uint32_t flMap = m_flBitmap & (~1u << fl);
+
+      if (!flMap)
+        return InvalidBlock;
+
+      fl = bit::tzcnt(flMap);
+      slMap = m_slBitmaps[fl];
+    }
+
+    sl = bit::tzcnt(slMap);
+    return m_freeLists[fl * SlCount + sl];
+  }
+
+
+  uint32_t DxvkTlsfAllocator::findFittingBlock(
+          VkDeviceSize          size,
+          VkDeviceSize          align) const {
+    uint32_t index = findFreeBlock(size);
+
+    if (index != InvalidBlock && blockFits(index, size, align))
+      return index;
+
+    // Any block large enough to hold the size plus the
+    // maximum alignment padding is guaranteed to fit
+    if (align > 1) {
+      index = findFreeBlock(size + align - 1);
+
+      if (index != InvalidBlock)
+        return index;
+    }
+
+    // Rounding up may skip blocks that are large enough, which
+    // matters when the chunk is almost full. Scan the list that
+    // contains the exact size as a last resort.
+    uint32_t list = computeListIndex(size);
+
+    if (list >= FlCount * SlCount)
+      return InvalidBlock;
+
+    for (index = m_freeLists[list]; index != InvalidBlock; index = m_blocks[index].nextFree) {
+      if (blockFits(index, size, align))
+        return index;
+    }
+
+    return InvalidBlock;
+  }
+
+
+  bool DxvkTlsfAllocator::blockFits(
+          uint32_t              index,
+          VkDeviceSize          size,
+          VkDeviceSize          align) const {
+    const Block& block = m_blocks[index];
+
+    VkDeviceSize offset = dxvk::align(block.offset, align);
+    return offset + size <= block.offset + block.length;
+  }
+
+
+  uint32_t DxvkTlsfAllocator::computeListIndex(
+          VkDeviceSize          size) {
+    if (size < SlCount)
+      return uint32_t(size);
+
+    uint32_t msb = 63 - bit::lzcnt(uint64_t(size));
+    uint32_t fl = msb - SlBits + 1;
+    uint32_t sl = uint32_t(size >> (msb - SlBits)) ^ SlCount;
+    return fl * SlCount + sl;
+  }
+
+}
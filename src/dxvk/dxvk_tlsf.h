@@ -0,0 +1,157 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "dxvk_include.h"
+
+namespace dxvk {
+
+  /**
+   * \brief Allocated range
+   *
+   * Stores the offset of the allocated range along
+   * with the index of the block that describes it.
+   * The block index is required to free the range.
+   */
+  struct DxvkTlsfAllocation {
+    VkDeviceSize offset;
+    uint32_t     block;
+  };
+
+
+  /**
+   * \brief Two-level segregated fit allocator
+   *
+   * Manages a contiguous address range. Free blocks are
+   * sorted into size classes, where the first level is
+   * the power of two of the block size and the second
+   * level linearly subdivides that range, so that a
+   * suitable free block can be found with two bit scans.
+   * Physically adjacent free blocks are merged on free.
+   *
+   * The allocator does not touch the managed memory, so
+   * block metadata is stored separately. This is not
+   * thread-safe.
+   */
+  class DxvkTlsfAllocator {
+    constexpr static uint32_t SlBits  = 4;
+    constexpr static uint32_t SlCount = 1u << SlBits;
+    constexpr static uint32_t FlCount = 32;
+  public:
+
+    constexpr static VkDeviceSize InvalidOffset = ~VkDeviceSize(0);
+    constexpr static uint32_t     InvalidBlock  = ~0u;
+
+    /**
+     * \brief Size limit of the managed range
+     *
+     * The managed range must be smaller than this,
+     * since larger blocks have no free list.
+     */
+    constexpr static VkDeviceSize MaxSize = VkDeviceSize(1) << (FlCount + SlBits - 1);
+
+    DxvkTlsfAllocator(VkDeviceSize size);
+
+    ~DxvkTlsfAllocator();
+
+    /**
+     * \brief Total size of the managed range
+     * \returns Managed range size, in bytes
+     */
+    VkDeviceSize size() const {
+      return m_size;
+    }
+
+    /**
+     * \brief Number of bytes currently allocated
+     * \returns Number of allocated bytes
+     */
+    VkDeviceSize used() const {
+      return m_used;
+    }
+
+    /**
+     * \brief Allocates a range
+     *
+     * The allocated range covers \c size rounded
+     * up to a multiple of \c align, and its offset
+     * will be aligned to \c align.
+     * \param [in] size Number of bytes to allocate
+     * \param [in] align Required alignment, must be a power of two
+     * \returns The allocated range. The offset will be
+     *    \c InvalidOffset if no suitable block was found.
+     */
+    DxvkTlsfAllocation alloc(
+            VkDeviceSize          size,
+            VkDeviceSize          align);
+
+    /**
+     * \brief Frees a range
+     *
+     * \param [in] block Block index returned by \ref alloc
+     */
+    void free(
+            uint32_t              block);
+
+  private:
+
+    struct Block {
+      VkDeviceSize offset;
+      VkDeviceSize length;
+      uint32_t     prevPhys;
+      uint32_t     nextPhys;
+      uint32_t     prevFree;
+      uint32_t     nextFree;
+      bool         isFree;
+    };
+
+    VkDeviceSize                m_size;
+    VkDeviceSize                m_used = 0;
+
+    std::vector<Block>          m_blocks;
+    std::vector<uint32_t>       m_unusedBlocks;
+
+    uint32_t                                  m_flBitmap = 0;
+    std::array<uint32_t, FlCount>             m_slBitmaps = { };
+    std::array<uint32_t, FlCount * SlCount>   m_freeLists;
+
+    uint32_t createBlock(
+            VkDeviceSize          offset,
+            VkDeviceSize          length);
+
+    void destroyBlock(
+            uint32_t              index);
+
+    uint32_t splitBlock(
+            uint32_t              index,
+            VkDeviceSize          length);
+
+    void mergeBlocks(
+            uint32_t              index,
+            uint32_t              next);
+
+    void insertFreeBlock(
+            uint32_t              index);
+
+    void removeFreeBlock(
+            uint32_t              index);
+
+    uint32_t findFreeBlock(
+            VkDeviceSize          size) const;
+
+    uint32_t findFittingBlock(
+            VkDeviceSize          size,
+            VkDeviceSize          align) const;
+
+    bool blockFits(
+            uint32_t              index,
+            VkDeviceSize          size,
+            VkDeviceSize          align) const;
+
+    static uint32_t computeListIndex(
+            VkDeviceSize          size);
+
+  };
+
+}
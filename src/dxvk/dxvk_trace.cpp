@@ -0,0 +1,200 @@
+#include <cstdio>
+
+#include "dxvk_trace.h"
+
+namespace dxvk {
+
+  static std::atomic<bool> g_traceActive = { false };
+
+  DxvkTracer::DxvkTracer(
+          uint32_t              firstFrame,
+          uint32_t              lastFrame)
+  : m_firstFrame(firstFrame),
+    m_lastFrame (lastFrame),
+    m_active    (firstFrame == 0),
+    m_startTime (dxvk::high_resolution_clock::now()),
+    m_frameTime (m_startTime) {
+    std::string fileName = getFileName();
+
+    m_file = std::ofstream(str::tows(fileName.c_str()).c_str(),
+      std::ios_base::binary | std::ios_base::trunc);
+
+    if (!m_file) {
+      Logger::err(str::format("DXVK: Failed to create trace file ", fileName));
+      m_active = false;
+      m_done = true;
+      return;
+    }
+
+    m_events.reserve(1u << 16);
+
+    Logger::info(str::format("DXVK: Tracing frames ", firstFrame, "-", lastFrame, " to ", fileName));
+  }
+
+
+  DxvkTracer::~DxvkTracer() {
+    // Write whatever we have if the app exits
+    // before the last frame has been presented
+    this->writeEvents();
+  }
+
+
+  Rc<DxvkTracer> DxvkTracer::create() {
+    std::string frames = env::getEnvVar("DXVK_TRACE");
+
+    if (frames.empty())
+      return nullptr;
+
+    uint32_t firstFrame = 0;
+    uint32_t lastFrame  = 0;
+
+    try {
+      size_t separator = frames.find('-');
+      firstFrame = std::stoul(frames.substr(0, separator));
+      lastFrame  = separator != std::string::npos
+        ? std::stoul(frames.substr(separator + 1))
+        : firstFrame;
+    } catch (const std::exception&) {
+      Logger::err(str::format("DXVK: Invalid trace range: ", frames));
+      return nullptr;
+    }
+
+    if (lastFrame < firstFrame) {
+      Logger::err(str::format("DXVK: Invalid trace range: ", frames));
+      return nullptr;
+    }
+
+    // Only trace one device per process since
+    // they would all write to the same file
+    if (g_traceActive.exchange(true))
+      return nullptr;
+
+    return new DxvkTracer(firstFrame, lastFrame);
+  }
+
+
+  void DxvkTracer::addEvent(
+    const char*                             category,
+    const char*                             name,
+    dxvk::high_resolution_clock::time_point begin,
+    dxvk::high_resolution_clock::time_point end) {
+    DxvkTraceEvent event;
+    event.category = category;
+    event.name     = name;
+    event.threadId = dxvk::this_thread::get_id();
+    event.frameId  = m_frameId.load();
+    event.begin    = begin;
+    event.end      = end;
+
+    std::lock_guard<sync::Spinlock> lock(m_mutex);
+
+    if (m_done)
+      return;
+
+    if (m_events.size() < MaxEventCount)
+      m_events.push_back(event);
+    else
+      m_dropped += 1;
+  }
+
+
+  void DxvkTracer::notifyPresent() {
+    auto now = dxvk::high_resolution_clock::now();
+
+    // Frames get their own track, see writeEvents
+    if (m_active.load()) {
+      DxvkTraceEvent event;
+      event.category = "frame";
+      event.name     = "Frame";
+      event.threadId = 0;
+      event.frameId  = m_frameId.load();
+      event.begin    = m_frameTime;
+      event.end      = now;
+
+      std::lock_guard<sync::Spinlock> lock(m_mutex);
+
+      if (!m_done)
+        m_events.push_back(event);
+    }
+
+    m_frameTime = now;
+
+    uint32_t frameId = ++m_frameId;
+    m_active.store(frameId >= m_firstFrame && frameId <= m_lastFrame);
+
+    if (frameId > m_lastFrame)
+      this->writeEvents();
+  }
+
+
+  void DxvkTracer::writeEvents() {
+    std::vector<DxvkTraceEvent> events;
+    size_t dropped = 0;
+
+    { std::lock_guard<sync::Spinlock> lock(m_mutex);
+
+      if (m_done)
+        return;
+
+      m_done = true;
+
+      events  = std::move(m_events);
+      dropped = m_dropped;
+    }
+
+    m_active.store(false);
+
+    uint32_t processId = uint32_t(::GetCurrentProcessId());
+
+    m_file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+           << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << processId
+           << ",\"args\":{\"name\":\"" << env::getExeBaseName() << "\"}},\n"
+           << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << processId
+           << ",\"tid\":0,\"args\":{\"name\":\"Frames\"}}";
+
+    for (const auto& event : events)
+      this->writeEvent(event, processId);
+
+    m_file << "\n]}\n";
+    m_file.close();
+
+    Logger::info(str::format("DXVK: Trace finished, ", events.size(), " events"));
+
+    if (dropped)
+      Logger::warn(str::format("DXVK: Dropped ", dropped, " trace events"));
+  }
+
+
+  void DxvkTracer::writeEvent(
+    const DxvkTraceEvent&       event,
+          uint32_t              processId) {
+    // Timestamps are in microseconds, but we want
+    // to keep sub-microsecond precision for short
+    // events, so write out nanoseconds as fractions
+    int64_t ts  = std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::nanoseconds>(event.begin - m_startTime).count());
+    int64_t dur = std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::nanoseconds>(event.end - event.begin).count());
+
+    char buffer[512];
+
+    std::snprintf(buffer, sizeof(buffer),
+      ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%lld.%03u,\"dur\":%lld.%03u,"
+      "\"pid\":%u,\"tid\":%u,\"args\":{\"frame\":%u}}",
+      event.name, event.category,
+      static_cast<long long>(ts / 1000),  uint32_t(ts % 1000),
+      static_cast<long long>(dur / 1000), uint32_t(dur % 1000),
+      processId, event.threadId, event.frameId);
+
+    m_file << buffer;
+  }
+
+
+  std::string DxvkTracer::getFileName() {
+    std::string path = env::getEnvVar("DXVK_TRACE_PATH");
+
+    if (!path.empty() && *path.rbegin() != '/')
+      path += '/';
+
+    return path + env::getExeBaseName() + ".dxvk-trace.json";
+  }
+
+}
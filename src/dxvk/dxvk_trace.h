@@ -0,0 +1,156 @@
+#pragma once
+
+#include <fstream>
+#include <vector>
+
+#include "dxvk_include.h"
+
+#include "../util/util_time.h"
+
+namespace dxvk {
+
+  /**
+   * \brief Trace event
+   *
+   * Category and name must be string literals
+   * or otherwise outlive the tracer, since only
+   * the pointers are stored.
+   */
+  struct DxvkTraceEvent {
+    const char*                             category;
+    const char*                             name;
+    uint32_t                                threadId;
+    uint32_t                                frameId;
+    dxvk::high_resolution_clock::time_point begin;
+    dxvk::high_resolution_clock::time_point end;
+  };
+
+
+  /**
+   * \brief Tracer
+   *
+   * Records the time spent in instrumented parts of
+   * DXVK within a given range of frames, and writes
+   * them to a JSON file in the Chrome trace event
+   * format, which can be loaded into Perfetto or
+   * \c chrome://tracing for offline analysis. Enabled
+   * via \c DXVK_TRACE, which takes either a single
+   * frame or a range of frames in the form \c first-last.
+   */
+  class DxvkTracer : public RcObject {
+    constexpr static size_t MaxEventCount = 1u << 20;
+  public:
+
+    DxvkTracer(
+            uint32_t              firstFrame,
+            uint32_t              lastFrame);
+
+    ~DxvkTracer();
+
+    /**
+     * \brief Creates tracer if enabled
+     *
+     * \returns Tracer object, or \c nullptr
+     *    if tracing is not enabled
+     */
+    static Rc<DxvkTracer> create();
+
+    /**
+     * \brief Checks whether events are recorded
+     * \returns \c true if the current frame is traced
+     */
+    bool isActive() const {
+      return m_active.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * \brief Records an event
+     *
+     * \param [in] category Event category
+     * \param [in] name Event name
+     * \param [in] begin Start time
+     * \param [in] end End time
+     */
+    void addEvent(
+      const char*                             category,
+      const char*                             name,
+      dxvk::high_resolution_clock::time_point begin,
+      dxvk::high_resolution_clock::time_point end);
+
+    /**
+     * \brief Notifies tracer about a presented frame
+     *
+     * Advances the frame counter, and writes the
+     * trace file once the last frame is done.
+     */
+    void notifyPresent();
+
+  private:
+
+    uint32_t                    m_firstFrame;
+    uint32_t                    m_lastFrame;
+
+    std::atomic<uint32_t>       m_frameId = { 0u };
+    std::atomic<bool>           m_active  = { false };
+
+    dxvk::high_resolution_clock::time_point m_startTime;
+    dxvk::high_resolution_clock::time_point m_frameTime;
+
+    sync::Spinlock              m_mutex;
+    std::vector<DxvkTraceEvent> m_events;
+    size_t                      m_dropped = 0;
+    bool                        m_done    = false;
+
+    std::ofstream               m_file;
+
+    void writeEvents();
+
+    void writeEvent(
+      const DxvkTraceEvent&       event,
+            uint32_t              processId);
+
+    static std::string getFileName();
+
+  };
+
+
+  /**
+   * \brief Trace scope
+   *
+   * Records an event for the lifetime of the
+   * object if the tracer is active. Does nothing
+   * if \c tracer is \c nullptr, so that this can
+   * be used in hot code paths.
+   */
+  class DxvkTraceScope {
+
+  public:
+
+    DxvkTraceScope(
+            DxvkTracer*           tracer,
+      const char*                 category,
+      const char*                 name)
+    : m_tracer(tracer && tracer->isActive() ? tracer : nullptr),
+      m_category(category), m_name(name) {
+      if (unlikely(m_tracer != nullptr))
+        m_begin = dxvk::high_resolution_clock::now();
+    }
+
+    ~DxvkTraceScope() {
+      if (unlikely(m_tracer != nullptr))
+        m_tracer->addEvent(m_category, m_name, m_begin, dxvk::high_resolution_clock::now());
+    }
+
+    DxvkTraceScope             (const DxvkTraceScope&) = delete;
+    DxvkTraceScope& operator = (const DxvkTraceScope&) = delete;
+
+  private:
+
+    DxvkTracer*                             m_tracer;
+    const char*                             m_category;
+    const char*                             m_name;
+    dxvk::high_resolution_clock::time_point m_begin;
+
+  };
+
+}
@@ -0,0 +1,153 @@
+#include "dxvk_worker_pool.h"
+
+namespace dxvk {
+
+  DxvkWorkerPool::DxvkWorkerPool(
+    const std::string&          name,
+          ThreadPriority        priority)
+  : m_name(name), m_priority(priority) {
+
+  }
+
+
+  DxvkWorkerPool::~DxvkWorkerPool() {
+    this->stopWorkers();
+  }
+
+
+  void DxvkWorkerPool::startWorkers(
+          uint32_t              threadCount) {
+    threadCount = std::max(threadCount, 1u);
+
+    for (uint32_t i = 0; i < threadCount; i++)
+      m_workers.push_back(std::make_unique<Worker>());
+
+    for (uint32_t i = 0; i < threadCount; i++) {
+      m_workers[i]->thread = dxvk::thread([this, i] () { runWorker(i); });
+      m_workers[i]->thread.set_priority(m_priority);
+    }
+  }
+
+
+  void DxvkWorkerPool::stopWorkers() {
+    { std::lock_guard<dxvk::mutex> lock(m_mutex);
+
+      if (m_stopped.exchange(true))
+        return;
+
+      m_cond.notify_all();
+    }
+
+    for (auto& worker : m_workers)
+      worker->thread.join();
+  }
+
+
+  void DxvkWorkerPool::enqueue(
+          Job&&                 job,
+          DxvkWorkerPriority    priority) {
+    if (unlikely(m_workers.empty())) {
+      job();
+      return;
+    }
+
+    if (unlikely(m_stopped.load()))
+      return;
+
+    Worker& worker = *m_workers[m_nextWorker++ % m_workers.size()];
+
+    // The counter must be incremented before the job is
+    // visible in the queue, otherwise another worker could
+    // dequeue the job and decrement the counter first. Idle
+    // threads may briefly find no job, which is harmless.
+    m_pendingCount += 1;
+
+    { std::lock_guard<dxvk::mutex> lock(worker.mutex);
+      worker.queues[uint32_t(priority)].push_back(std::move(job));
+    }
+
+    { std::lock_guard<dxvk::mutex> lock(m_mutex);
+      m_cond.notify_one();
+    }
+  }
+
+
+  bool DxvkWorkerPool::dequeueJob(
+          uint32_t              index,
+          Job&                  job,
+          DxvkWorkerPriority&   priority) {
+    uint32_t workerCount = uint32_t(m_workers.size());
+
+    // Scan the high-priority queues of all threads before
+    // looking at any low-priority work. Threads process
+    // their own queue in order, and steal the most recently
+    // added jobs from other threads to reduce contention.
+    for (uint32_t p = 0; p < PriorityCount; p++) {
+      for (uint32_t i = 0; i < workerCount; i++) {
+        Worker& worker = *m_workers[(index + i) % workerCount];
+        std::lock_guard<dxvk::mutex> lock(worker.mutex);
+
+        auto& queue = worker.queues[p];
+
+        if (queue.empty())
+          continue;
+
+        if (!i) {
+          job = std::move(queue.front());
+          queue.pop_front();
+        } else {
+          job = std::move(queue.back());
+          queue.pop_back();
+        }
+
+        m_activeCount  += 1;
+        m_pendingCount -= 1;
+
+        priority = DxvkWorkerPriority(p);
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+
+  void DxvkWorkerPool::runWorker(
+          uint32_t              index) {
+    env::setThreadName(m_name);
+
+    ThreadPriority threadPriority = m_priority;
+
+    while (!m_stopped.load()) {
+      Job job;
+      DxvkWorkerPriority jobPriority;
+
+      if (!dequeueJob(index, job, jobPriority)) {
+        std::unique_lock<dxvk::mutex> lock(m_mutex);
+
+        m_cond.wait(lock, [this] () {
+          return m_pendingCount.load()
+              || m_stopped.load();
+        });
+
+        continue;
+      }
+
+      // Someone is waiting for high-priority jobs, so
+      // don't let them get starved by other processes
+      ThreadPriority newPriority = jobPriority == DxvkWorkerPriority::High
+        ? std::max(m_priority, ThreadPriority::Normal)
+        : m_priority;
+
+      if (threadPriority != newPriority) {
+        threadPriority = newPriority;
+        m_workers[index]->thread.set_priority(threadPriority);
+      }
+
+      job();
+
+      m_activeCount -= 1;
+    }
+  }
+
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../util/thread.h"
+
+#include "dxvk_include.h"
+
+namespace dxvk {
+
+  /**
+   * \brief Worker job priority
+   *
+   * High-priority jobs are always picked
+   * up before any low-priority job.
+   */
+  enum class DxvkWorkerPriority : uint32_t {
+    High  = 0,
+    Low   = 1,
+  };
+
+
+  /**
+   * \brief Worker pool
+   *
+   * Runs jobs on a fixed set of threads. Each thread owns
+   * one queue per priority level, and new jobs are spread
+   * across threads in a round-robin fashion. Threads that
+   * run out of work steal jobs from other threads' queues,
+   * so that no thread idles while there is work left.
+   */
+  class DxvkWorkerPool {
+    constexpr static uint32_t PriorityCount = 2;
+  public:
+
+    using Job = std::function<void ()>;
+
+    DxvkWorkerPool(
+      const std::string&          name,
+            ThreadPriority        priority);
+
+    ~DxvkWorkerPool();
+
+    /**
+     * \brief Starts worker threads
+     *
+     * Must be called exactly once before
+     * any jobs can be submitted.
+     * \param [in] threadCount Number of threads
+     */
+    void startWorkers(
+            uint32_t              threadCount);
+
+    /**
+     * \brief Stops worker threads
+     *
+     * Jobs that are currently executing will
+     * be finished, pending jobs are discarded.
+     */
+    void stopWorkers();
+
+    /**
+     * \brief Submits a job
+     *
+     * If no worker threads have been started, the job
+     * is executed on the calling thread. Jobs submitted
+     * after the workers have been stopped are discarded.
+     * \param [in] job The job to execute
+     * \param [in] priority Job priority
+     */
+    void enqueue(
+            Job&&                 job,
+            DxvkWorkerPriority    priority);
+
+    /**
+     * \brief Checks whether any jobs are pending
+     * \returns \c true if jobs are queued or executing
+     */
+    bool isBusy() const {
+      return m_pendingCount.load() + m_activeCount.load() > 0;
+    }
+
+  private:
+
+    struct Worker {
+      dxvk::mutex                           mutex;
+      std::array<std::deque<Job>, PriorityCount> queues;
+      dxvk::thread                          thread;
+    };
+
+    std::string                             m_name;
+    ThreadPriority                          m_priority;
+
+    std::vector<std::unique_ptr<Worker>>    m_workers;
+
+    std::atomic<uint32_t>                   m_nextWorker   = { 0u };
+    std::atomic<uint32_t>                   m_pendingCount = { 0u };
+    std::atomic<uint32_t>                   m_activeCount  = { 0u };
+    std::atomic<bool>                       m_stopped      = { false };
+
+    dxvk::mutex                             m_mutex;
+    dxvk::condition_variable                m_cond;
+
+    bool dequeueJob(
+            uint32_t              index,
+            Job&                  job,
+            DxvkWorkerPriority&   priority);
+
+    void runWorker(
+            uint32_t              index);
+
+  };
+
+}
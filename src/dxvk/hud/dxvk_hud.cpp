@@ -41,6 +41,10 @@ namespace dxvk::hud {
     addItem<HudFrameTimeItem>("frametimes", -1);
     addItem<HudSubmissionStatsItem>("submissions", -1, device);
     addItem<HudDrawCallStatsItem>("drawcalls", -1, device);
+    addItem<HudUploadStatsItem>("uploads", -1, device);
+    addItem<HudDescriptorStatsItem>("descriptors", -1, device);
+    addItem<HudCsStatsItem>("csstats", -1, device);
+    addItem<HudChurnStatsItem>("churn", -1, device);
     addItem<HudPipelineStatsItem>("pipelines", -1, device);
     addItem<HudMemoryStatsItem>("memory", -1, device);
     addItem<HudGpuLoadItem>("gpuload", -1, device);
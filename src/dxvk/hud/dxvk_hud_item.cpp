@@ -415,6 +415,332 @@ namespace dxvk::hud {
   }
 
 
+  HudUploadStatsItem::HudUploadStatsItem(const Rc<DxvkDevice>& device)
+  : m_device(device) {
+
+  }
+
+
+  HudUploadStatsItem::~HudUploadStatsItem() {
+
+  }
+
+
+  void HudUploadStatsItem::update(dxvk::high_resolution_clock::time_point time) {
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(time - m_lastUpdate);
+
+    DxvkStatCounters counters = m_device->getStatCounters();
+    auto diffCounters = counters.diff(m_prevCounters);
+
+    if (elapsed.count() >= UpdateInterval) {
+      m_updateCount = diffCounters.getCtr(DxvkStatCounter::CmdBufferUpdates);
+      m_copyCount   = diffCounters.getCtr(DxvkStatCounter::CmdBufferUpdateCopies);
+      m_byteCount   = diffCounters.getCtr(DxvkStatCounter::CmdBufferUpdateBytes);
+
+      m_lastUpdate = time;
+    }
+
+    m_prevCounters = counters;
+  }
+
+
+  HudPos HudUploadStatsItem::render(
+          HudRenderer&      renderer,
+          HudPos            position) {
+    position.y += 16.0f;
+    renderer.drawText(16.0f,
+      { position.x, position.y },
+      { 0.25f, 1.0f, 0.5f, 1.0f },
+      "Buffer updates:");
+
+    renderer.drawText(16.0f,
+      { position.x + 192.0f, position.y },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      str::format(m_updateCount));
+
+    position.y += 20.0f;
+    renderer.drawText(16.0f,
+      { position.x, position.y },
+      { 0.25f, 1.0f, 0.5f, 1.0f },
+      "Update copies:");
+
+    renderer.drawText(16.0f,
+      { position.x + 192.0f, position.y },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      str::format(m_copyCount));
+
+    position.y += 20.0f;
+    renderer.drawText(16.0f,
+      { position.x, position.y },
+      { 0.25f, 1.0f, 0.5f, 1.0f },
+      "Update size:");
+
+    renderer.drawText(16.0f,
+      { position.x + 192.0f, position.y },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      str::format(m_byteCount >> 10, " kB"));
+
+    position.y += 8.0f;
+    return position;
+  }
+
+
+  HudDescriptorStatsItem::HudDescriptorStatsItem(const Rc<DxvkDevice>& device)
+  : m_device(device) {
+
+  }
+
+
+  HudDescriptorStatsItem::~HudDescriptorStatsItem() {
+
+  }
+
+
+  void HudDescriptorStatsItem::update(dxvk::high_resolution_clock::time_point time) {
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(time - m_lastUpdate);
+
+    DxvkStatCounters counters = m_device->getStatCounters();
+    auto diffCounters = counters.diff(m_prevCounters);
+
+    if (elapsed.count() >= UpdateInterval) {
+      m_setCount  = diffCounters.getCtr(DxvkStatCounter::DescriptorSetCount);
+      m_poolCount = diffCounters.getCtr(DxvkStatCounter::DescriptorPoolCount);
+
+      m_lastUpdate = time;
+    }
+
+    m_prevCounters = counters;
+  }
+
+
+  HudPos HudDescriptorStatsItem::render(
+          HudRenderer&      renderer,
+          HudPos            position) {
+    position.y += 16.0f;
+    renderer.drawText(16.0f,
+      { position.x, position.y },
+      { 1.0f, 0.5f, 0.25f, 1.0f },
+      "Descriptor sets:");
+
+    renderer.drawText(16.0f,
+      { position.x + 192.0f, position.y },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      str::format(m_setCount));
+
+    position.y += 20.0f;
+    renderer.drawText(16.0f,
+      { position.x, position.y },
+      { 1.0f, 0.5f, 0.25f, 1.0f },
+      "Descriptor pools:");
+
+    renderer.drawText(16.0f,
+      { position.x + 192.0f, position.y },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      str::format(m_poolCount));
+
+    position.y += 8.0f;
+    return position;
+  }
+
+
+  static std::string formatPerFrame(uint64_t value, uint64_t frames) {
+    // Stalls are rare compared to draws, so show one
+    // decimal place rather than rounding down to zero
+    uint64_t scaled = frames ? (10 * value) / frames : 0;
+    return str::format(scaled / 10, ".", scaled % 10);
+  }
+
+
+  HudCsStatsItem::HudCsStatsItem(const Rc<DxvkDevice>& device)
+  : m_device(device) {
+
+  }
+
+
+  HudCsStatsItem::~HudCsStatsItem() {
+
+  }
+
+
+  void HudCsStatsItem::update(dxvk::high_resolution_clock::time_point time) {
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(time - m_lastUpdate);
+
+    if (elapsed.count() < UpdateInterval)
+      return;
+
+    // Average over the entire interval since
+    // stalls usually do not happen every frame
+    DxvkStatCounters counters = m_device->getStatCounters();
+    DxvkStatHistograms histograms = m_device->getStatHistograms();
+
+    auto diffCounters = counters.diff(m_prevCounters);
+    auto diffQueue = histograms[uint32_t(DxvkStatHistogramType::CsQueueDepth)].diff(
+      m_prevHistograms[uint32_t(DxvkStatHistogramType::CsQueueDepth)]);
+
+    uint64_t frames = diffCounters.getCtr(DxvkStatCounter::QueuePresentCount);
+
+    m_chunkString = formatPerFrame(diffQueue.getSampleCount(), frames);
+
+    uint32_t maxBucket = 0;
+
+    for (uint32_t i = 0; i < DxvkStatHistogram::BucketCount; i++) {
+      if (diffQueue.getBucket(i))
+        maxBucket = i;
+    }
+
+    uint64_t minDepth = DxvkStatHistogram::getBucketMin(maxBucket);
+
+    if (maxBucket + 1 == DxvkStatHistogram::BucketCount)
+      m_queueString = str::format(minDepth, "+");
+    else if (maxBucket < 2)
+      m_queueString = str::format(minDepth);
+    else
+      m_queueString = str::format(minDepth, "-", DxvkStatHistogram::getBucketMin(maxBucket + 1) - 1);
+
+    m_syncString = str::format(
+      formatPerFrame(diffCounters.getCtr(DxvkStatCounter::CsSyncCount), frames), " (",
+      formatPerFrame(diffCounters.getCtr(DxvkStatCounter::CsSyncTicks), frames), " us)");
+
+    m_mapString = str::format(
+      formatPerFrame(diffCounters.getCtr(DxvkStatCounter::MapWaitCount), frames), " (",
+      formatPerFrame(diffCounters.getCtr(DxvkStatCounter::MapWaitTicks), frames), " us)");
+
+    m_prevCounters   = counters;
+    m_prevHistograms = histograms;
+    m_lastUpdate     = time;
+  }
+
+
+  HudPos HudCsStatsItem::render(
+          HudRenderer&      renderer,
+          HudPos            position) {
+    position.y += 16.0f;
+    renderer.drawText(16.0f,
+      { position.x, position.y },
+      { 0.5f, 1.0f, 1.0f, 1.0f },
+      "CS chunks:");
+
+    renderer.drawText(16.0f,
+      { position.x + 192.0f, position.y },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      m_chunkString);
+
+    position.y += 20.0f;
+    renderer.drawText(16.0f,
+      { position.x, position.y },
+      { 0.5f, 1.0f, 1.0f, 1.0f },
+      "CS queue depth:");
+
+    renderer.drawText(16.0f,
+      { position.x + 192.0f, position.y },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      m_queueString);
+
+    position.y += 20.0f;
+    renderer.drawText(16.0f,
+      { position.x, position.y },
+      { 0.5f, 1.0f, 1.0f, 1.0f },
+      "CS syncs:");
+
+    renderer.drawText(16.0f,
+      { position.x + 192.0f, position.y },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      m_syncString);
+
+    position.y += 20.0f;
+    renderer.drawText(16.0f,
+      { position.x, position.y },
+      { 0.5f, 1.0f, 1.0f, 1.0f },
+      "Map stalls:");
+
+    renderer.drawText(16.0f,
+      { position.x + 192.0f, position.y },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      m_mapString);
+
+    position.y += 8.0f;
+    return position;
+  }
+
+
+  HudChurnStatsItem::HudChurnStatsItem(const Rc<DxvkDevice>& device)
+  : m_device(device) {
+
+  }
+
+
+  HudChurnStatsItem::~HudChurnStatsItem() {
+
+  }
+
+
+  void HudChurnStatsItem::update(dxvk::high_resolution_clock::time_point time) {
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(time - m_lastUpdate);
+
+    if (elapsed.count() < UpdateInterval)
+      return;
+
+    DxvkStatCounters counters = m_device->getStatCounters();
+    auto diffCounters = counters.diff(m_prevCounters);
+
+    uint64_t frames = diffCounters.getCtr(DxvkStatCounter::QueuePresentCount);
+
+    m_allocString = str::format(
+      formatPerFrame(diffCounters.getCtr(DxvkStatCounter::MemoryAllocCount), frames), " / ",
+      formatPerFrame(diffCounters.getCtr(DxvkStatCounter::MemoryFreeCount), frames));
+
+    m_deviceAllocString = str::format(
+      formatPerFrame(diffCounters.getCtr(DxvkStatCounter::MemoryDeviceAllocCount), frames), " / ",
+      formatPerFrame(diffCounters.getCtr(DxvkStatCounter::MemoryDeviceFreeCount), frames));
+
+    m_barrierString = formatPerFrame(diffCounters.getCtr(DxvkStatCounter::CmdBarrierCount), frames);
+
+    m_prevCounters = counters;
+    m_lastUpdate   = time;
+  }
+
+
+  HudPos HudChurnStatsItem::render(
+          HudRenderer&      renderer,
+          HudPos            position) {
+    position.y += 16.0f;
+    renderer.drawText(16.0f,
+      { position.x, position.y },
+      { 1.0f, 1.0f, 0.5f, 1.0f },
+      "Allocs / frees:");
+
+    renderer.drawText(16.0f,
+      { position.x + 192.0f, position.y },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      m_allocString);
+
+    position.y += 20.0f;
+    renderer.drawText(16.0f,
+      { position.x, position.y },
+      { 1.0f, 1.0f, 0.5f, 1.0f },
+      "Device memory:");
+
+    renderer.drawText(16.0f,
+      { position.x + 192.0f, position.y },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      m_deviceAllocString);
+
+    position.y += 20.0f;
+    renderer.drawText(16.0f,
+      { position.x, position.y },
+      { 1.0f, 1.0f, 0.5f, 1.0f },
+      "Barriers:");
+
+    renderer.drawText(16.0f,
+      { position.x + 192.0f, position.y },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      m_barrierString);
+
+    position.y += 8.0f;
+    return position;
+  }
+
+
   HudPipelineStatsItem::HudPipelineStatsItem(const Rc<DxvkDevice>& device)
   : m_device(device) {
 
@@ -429,8 +755,15 @@ namespace dxvk::hud {
   void HudPipelineStatsItem::update(dxvk::high_resolution_clock::time_point time) {
     DxvkStatCounters counters = m_device->getStatCounters();
 
+    auto diffCounters = counters.diff(m_prevCounters);
+
     m_graphicsPipelines = counters.getCtr(DxvkStatCounter::PipeCountGraphics);
     m_computePipelines  = counters.getCtr(DxvkStatCounter::PipeCountCompute);
+
+    m_skippedDraws      = diffCounters.getCtr(DxvkStatCounter::PipeSkippedDraws);
+    m_fallbackDraws     = diffCounters.getCtr(DxvkStatCounter::PipeFallbackDraws);
+
+    m_prevCounters = counters;
   }
 
 
@@ -459,6 +792,32 @@ namespace dxvk::hud {
       { 1.0f, 1.0f, 1.0f, 1.0f },
       str::format(m_computePipelines));
 
+    if (m_device->config().asyncPipelineCompile) {
+      position.y += 20.0f;
+      renderer.drawText(16.0f,
+        { position.x, position.y },
+        { 1.0f, 0.25f, 1.0f, 1.0f },
+        "Skipped draws:");
+
+      renderer.drawText(16.0f,
+        { position.x + 240.0f, position.y },
+        { 1.0f, 1.0f, 1.0f, 1.0f },
+        str::format(m_skippedDraws));
+
+      if (m_device->config().asyncPipelineFallback) {
+        position.y += 20.0f;
+        renderer.drawText(16.0f,
+          { position.x, position.y },
+          { 1.0f, 0.25f, 1.0f, 1.0f },
+          "Fallback draws:");
+
+        renderer.drawText(16.0f,
+          { position.x + 240.0f, position.y },
+          { 1.0f, 1.0f, 1.0f, 1.0f },
+          str::format(m_fallbackDraws));
+      }
+    }
+
     position.y += 8.0f;
     return position;
   }
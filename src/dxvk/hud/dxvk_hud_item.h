@@ -301,6 +301,144 @@ namespace dxvk::hud {
   };
 
 
+  /**
+   * \brief HUD item to display buffer update stats
+   */
+  class HudUploadStatsItem : public HudItem {
+    constexpr static int64_t UpdateInterval = 500'000;
+  public:
+
+    HudUploadStatsItem(const Rc<DxvkDevice>& device);
+
+    ~HudUploadStatsItem();
+
+    void update(dxvk::high_resolution_clock::time_point time);
+
+    HudPos render(
+            HudRenderer&      renderer,
+            HudPos            position);
+
+  private:
+
+    Rc<DxvkDevice>    m_device;
+
+    DxvkStatCounters  m_prevCounters;
+
+    uint64_t          m_updateCount = 0;
+    uint64_t          m_copyCount   = 0;
+    uint64_t          m_byteCount   = 0;
+
+    dxvk::high_resolution_clock::time_point m_lastUpdate
+      = dxvk::high_resolution_clock::now();
+
+  };
+
+
+  /**
+   * \brief HUD item to display descriptor stats
+   */
+  class HudDescriptorStatsItem : public HudItem {
+    constexpr static int64_t UpdateInterval = 500'000;
+  public:
+
+    HudDescriptorStatsItem(const Rc<DxvkDevice>& device);
+
+    ~HudDescriptorStatsItem();
+
+    void update(dxvk::high_resolution_clock::time_point time);
+
+    HudPos render(
+            HudRenderer&      renderer,
+            HudPos            position);
+
+  private:
+
+    Rc<DxvkDevice>    m_device;
+
+    DxvkStatCounters  m_prevCounters;
+
+    uint64_t          m_setCount  = 0;
+    uint64_t          m_poolCount = 0;
+
+    dxvk::high_resolution_clock::time_point m_lastUpdate
+      = dxvk::high_resolution_clock::now();
+
+  };
+
+
+  /**
+   * \brief HUD item to display CS thread stats
+   *
+   * Shows per-frame averages of how often and for how
+   * long the application had to wait for the CS thread
+   * or for resources to become available on map, as well
+   * as the largest CS queue depth seen.
+   */
+  class HudCsStatsItem : public HudItem {
+    constexpr static int64_t UpdateInterval = 500'000;
+  public:
+
+    HudCsStatsItem(const Rc<DxvkDevice>& device);
+
+    ~HudCsStatsItem();
+
+    void update(dxvk::high_resolution_clock::time_point time);
+
+    HudPos render(
+            HudRenderer&      renderer,
+            HudPos            position);
+
+  private:
+
+    Rc<DxvkDevice>      m_device;
+
+    DxvkStatCounters    m_prevCounters;
+    DxvkStatHistograms  m_prevHistograms;
+
+    std::string         m_chunkString;
+    std::string         m_queueString;
+    std::string         m_syncString;
+    std::string         m_mapString;
+
+    dxvk::high_resolution_clock::time_point m_lastUpdate
+      = dxvk::high_resolution_clock::now();
+
+  };
+
+
+  /**
+   * \brief HUD item to display memory and barrier churn
+   */
+  class HudChurnStatsItem : public HudItem {
+    constexpr static int64_t UpdateInterval = 500'000;
+  public:
+
+    HudChurnStatsItem(const Rc<DxvkDevice>& device);
+
+    ~HudChurnStatsItem();
+
+    void update(dxvk::high_resolution_clock::time_point time);
+
+    HudPos render(
+            HudRenderer&      renderer,
+            HudPos            position);
+
+  private:
+
+    Rc<DxvkDevice>    m_device;
+
+    DxvkStatCounters  m_prevCounters;
+
+    std::string       m_allocString;
+    std::string       m_deviceAllocString;
+    std::string       m_barrierString;
+
+    dxvk::high_resolution_clock::time_point m_lastUpdate
+      = dxvk::high_resolution_clock::now();
+
+  };
+
+
   /**
    * \brief HUD item to display pipeline counts
    */
@@ -322,9 +460,14 @@ namespace dxvk::hud {
 
     Rc<DxvkDevice> m_device;
 
+    DxvkStatCounters m_prevCounters;
+
     uint64_t m_graphicsPipelines = 0;
     uint64_t m_computePipelines = 0;
 
+    uint64_t m_skippedDraws = 0;
+    uint64_t m_fallbackDraws = 0;
+
   };
 
 
@@ -1,7 +1,69 @@
+#define SPV_ENABLE_UTILITY_CODE
+
+#include <array>
+
 #include "spirv_compression.h"
 
 namespace dxvk {
 
+  /// Op code value used to store data that
+  /// cannot be parsed as SPIR-V instructions
+  constexpr static uint32_t SpirvRawDataOp = 0x10000;
+
+
+  static uint32_t encodeDelta(uint32_t value, uint32_t ref) {
+    uint32_t delta = value - ref;
+    return (delta << 1) ^ uint32_t(int32_t(delta) >> 31);
+  }
+
+
+  static uint32_t decodeDelta(uint32_t encoded, uint32_t ref) {
+    return ref + ((encoded >> 1) ^ (0u - (encoded & 1)));
+  }
+
+
+  /// Number of op codes for which the operand
+  /// layout is looked up in a table
+  constexpr static uint32_t SpirvLayoutTableSize = 1024;
+
+
+  static uint32_t computeOperandLayout(uint32_t opCode) {
+    bool hasResult = false;
+    bool hasType   = false;
+
+    if (opCode <= spv::OpCodeMask)
+      spv::HasResultAndType(spv::Op(opCode), &hasResult, &hasType);
+
+    // Operand indices start at 1, 0 means none. The
+    // type index is stored in the low four bits.
+    uint32_t typeIndex   = hasType ? 1 : 0;
+    uint32_t resultIndex = hasResult ? typeIndex + 1 : 0;
+    return typeIndex | (resultIndex << 4);
+  }
+
+
+  static void getOperandLayout(
+          uint32_t              opCode,
+          uint32_t&             typeIndex,
+          uint32_t&             resultIndex) {
+    static const auto s_table = [] {
+      std::array<uint8_t, SpirvLayoutTableSize> table;
+
+      for (uint32_t i = 0; i < SpirvLayoutTableSize; i++)
+        table[i] = uint8_t(computeOperandLayout(i));
+
+      return table;
+    } ();
+
+    uint32_t layout = likely(opCode < SpirvLayoutTableSize)
+      ? s_table[opCode]
+      : computeOperandLayout(opCode);
+
+    typeIndex   = layout & 0xf;
+    resultIndex = layout >> 4;
+  }
+
+
   SpirvCompressedBuffer::SpirvCompressedBuffer()
   : m_size(0) {
 
@@ -13,56 +75,66 @@ namespace dxvk {
   : m_size(code.dwords()) {
     const uint32_t* data = code.data();
 
-    // The compression works by eliminating leading null bytes
-    // from DWORDs, exploiting that SPIR-V IDs are consecutive
-    // integers that usually fall into the 16-bit range. For
-    // each DWORD, a two-bit integer is stored which indicates
-    // the number of bytes it takes in the compressed buffer.
-    // This way, it can achieve a compression ratio of ~50%.
-    m_mask.reserve((m_size + NumMaskWords - 1) / NumMaskWords);
-    m_code.reserve((m_size + 1) / 2);
+    // SPIR-V code generated by DXVK uses 16-bit IDs in
+    // practice, and most operands refer to IDs that were
+    // defined shortly before, so most words can be stored
+    // in one or two bytes, including the instruction token.
+    // Reserve enough space for the worst case up front so
+    // that the encoder never has to check the buffer size.
+    m_data.resize(size_t(m_size) * 6 + 16);
+
+    uint32_t offset = 0;
 
-    uint64_t dstWord  = 0;
-    uint32_t dstShift = 0;
+    if (m_size >= 5 && data[0] == spv::MagicNumber) {
+      putVarInt(5);
 
-    for (uint32_t i = 0; i < m_size; i += NumMaskWords) {
-      uint64_t byteCounts = 0;
+      for (uint32_t i = 0; i < 5; i++)
+        putVarInt(data[i]);
 
-      for (uint32_t w = 0; w < NumMaskWords && i + w < m_size; w++) {
-        uint64_t word = data[i + w];
-        uint64_t bytes = 0;
+      offset = 5;
+    } else {
+      putVarInt(0);
+    }
+
+    uint32_t lastId = 0;
 
-        if      (word < (1 <<  8)) bytes = 0;
-        else if (word < (1 << 16)) bytes = 1;
-        else if (word < (1 << 24)) bytes = 2;
-        else                       bytes = 3;
+    while (offset < m_size) {
+      uint32_t opCode = data[offset] & spv::OpCodeMask;
+      uint32_t length = data[offset] >> spv::WordCountShift;
 
-        byteCounts |= bytes << (2 * w);
+      // Store anything that is not valid SPIR-V as raw data
+      if (!length || length > m_size - offset) {
+        putRaw(&data[offset], m_size - offset);
+        break;
+      }
 
-        uint32_t bits = 8 * bytes + 8;
-        uint32_t rem  = bit::pack(dstWord, dstShift, word, bits);
+      putVarInt(opCode);
+      putVarInt(length);
 
-        if (unlikely(rem != 0)) {
-          m_code.push_back(dstWord);
+      uint32_t typeIndex;
+      uint32_t resultIndex;
 
-          dstWord  = 0;
-          dstShift = 0;
+      getOperandLayout(opCode, typeIndex, resultIndex);
 
-          bit::pack(dstWord, dstShift, word >> (bits - rem), rem);
+      for (uint32_t i = 1; i < length; i++) {
+        uint32_t word = data[offset + i];
+
+        if (i == resultIndex) {
+          putVarInt(encodeDelta(word, lastId + 1));
+          lastId = word;
+        } else {
+          putOperand(word, lastId);
         }
       }
 
-      m_mask.push_back(byteCounts);
+      offset += length;
     }
 
-    if (dstShift)
-      m_code.push_back(dstWord);
-
-    m_mask.shrink_to_fit();
-    m_code.shrink_to_fit();
+    m_data.resize(m_write);
+    m_data.shrink_to_fit();
   }
 
-    
+
   SpirvCompressedBuffer::~SpirvCompressedBuffer() {
 
   }
@@ -70,41 +142,140 @@ namespace dxvk {
 
   SpirvCodeBuffer SpirvCompressedBuffer::decompress() const {
     SpirvCodeBuffer code(m_size);
+    SpirvCompressedReader reader(*this);
+
     uint32_t* data = code.data();
 
-    if (m_size == 0)
-      return code;
+    while (reader.readInstruction(&data[reader.offset()]))
+      continue;
 
-    uint32_t maskIdx = 0;
-    uint32_t codeIdx = 0;
+    return code;
+  }
 
-    uint64_t srcWord  = m_code[codeIdx++];
-    uint32_t srcShift = 0;
 
-    for (uint32_t i = 0; i < m_size; i += NumMaskWords) {
-      uint64_t srcMask = m_mask[maskIdx++];
+  void SpirvCompressedBuffer::putVarInt(uint64_t value) {
+    uint8_t* dst = &m_data[m_write];
 
-      for (uint32_t w = 0; w < NumMaskWords && i + w < m_size; w++) {
-        uint32_t bits = 8 * ((srcMask & 3) + 1);
+    while (value >= 0x80) {
+      *(dst++) = uint8_t(value | 0x80);
+      value >>= 7;
+    }
 
-        uint64_t word = 0;
-        uint32_t rem = bit::unpack(word, srcWord, srcShift, bits);
+    *(dst++) = uint8_t(value);
+    m_write = dst - m_data.data();
+  }
 
-        if (unlikely(rem != 0)) {
-          srcWord  = m_code[codeIdx++];
-          srcShift = 0;
 
-          uint64_t tmp = 0;
-          bit::unpack(tmp, srcWord, srcShift, rem);
-          word |= tmp << (bits - rem);
-        }
+  void SpirvCompressedBuffer::putOperand(uint32_t word, uint32_t ref) {
+    // The lowest bit indicates whether the operand
+    // is stored as-is or relative to the given ID
+    uint32_t encoded = encodeDelta(word, ref);
+
+    if (encoded < word)
+      putVarInt((uint64_t(encoded) << 1) | 1);
+    else
+      putVarInt((uint64_t(word) << 1));
+  }
 
-        data[i + w] = word;
-        srcMask >>= 2;
+
+  void SpirvCompressedBuffer::putRaw(const uint32_t* words, uint32_t count) {
+    putVarInt(SpirvRawDataOp);
+    putVarInt(count);
+
+    for (uint32_t i = 0; i < count; i++)
+      putVarInt(words[i]);
+  }
+
+
+  SpirvCompressedReader::SpirvCompressedReader(
+    const SpirvCompressedBuffer&  buffer)
+  : m_data    (buffer.m_data.data()),
+    m_dataSize(buffer.m_data.size()),
+    m_size    (buffer.m_size) {
+
+  }
+
+
+  SpirvCompressedReader::~SpirvCompressedReader() {
+
+  }
+
+
+  uint32_t SpirvCompressedReader::readInstruction(
+          uint32_t*             dst) {
+    if (unlikely(m_header)) {
+      m_header = false;
+
+      uint32_t count = uint32_t(getVarInt());
+
+      if (unlikely(count > m_size))
+        return 0;
+
+      for (uint32_t i = 0; i < count; i++)
+        dst[i] = uint32_t(getVarInt());
+
+      m_offset += count;
+
+      if (count)
+        return count;
+    }
+
+    if (m_offset >= m_size)
+      return 0;
+
+    uint32_t opCode = uint32_t(getVarInt());
+    uint32_t length = uint32_t(getVarInt());
+
+    if (unlikely(length > m_size - m_offset))
+      return 0;
+
+    if (unlikely(opCode == SpirvRawDataOp)) {
+      for (uint32_t i = 0; i < length; i++)
+        dst[i] = uint32_t(getVarInt());
+
+      m_offset += length;
+      return length;
+    }
+
+    if (unlikely(!length))
+      return 0;
+
+    dst[0] = opCode | (length << spv::WordCountShift);
+
+    uint32_t typeIndex;
+    uint32_t resultIndex;
+
+    getOperandLayout(opCode, typeIndex, resultIndex);
+
+    for (uint32_t i = 1; i < length; i++) {
+      if (i == resultIndex) {
+        m_lastId = decodeDelta(uint32_t(getVarInt()), m_lastId + 1);
+        dst[i] = m_lastId;
+      } else {
+        dst[i] = getOperand(m_lastId);
       }
     }
 
-    return code;
+    m_offset += length;
+    return length;
+  }
+
+
+  uint64_t SpirvCompressedReader::getVarIntSlow() {
+    uint64_t result = 0;
+    uint32_t shift  = 0;
+
+    while (likely(m_read < m_dataSize && shift < 64)) {
+      uint8_t byte = m_data[m_read++];
+      result |= uint64_t(byte & 0x7f) << shift;
+
+      if (likely(!(byte & 0x80)))
+        break;
+
+      shift += 7;
+    }
+
+    return result;
   }
 
-}
\ No newline at end of file
+}
@@ -11,26 +11,138 @@ namespace dxvk {
    *
    * Implements a fast in-memory compression
    * to keep memory footprint low.
+   *
+   * Instructions are stored as variable-length
+   * integers. Result IDs are delta-encoded against
+   * the previous result ID, and all other operands
+   * are either stored as-is or relative to the
+   * current result ID, whichever is smaller. Since
+   * most operands reference recently defined IDs,
+   * they typically take up one or two bytes.
    */
   class SpirvCompressedBuffer {
-    constexpr static uint32_t NumMaskWords = 32;
+    friend class SpirvCompressedReader;
   public:
 
     SpirvCompressedBuffer();
 
     SpirvCompressedBuffer(
       const SpirvCodeBuffer&  code);
-    
+
     ~SpirvCompressedBuffer();
-    
+
+    /**
+     * \brief Uncompressed code size
+     * \returns Code size, in dwords
+     */
+    uint32_t dwords() const {
+      return m_size;
+    }
+
+    /**
+     * \brief Compressed size
+     * \returns Compressed size, in bytes
+     */
+    size_t size() const {
+      return m_data.size();
+    }
+
     SpirvCodeBuffer decompress() const;
 
   private:
 
     uint32_t              m_size;
-    std::vector<uint64_t> m_mask;
-    std::vector<uint64_t> m_code;
+    size_t                m_write = 0;
+    std::vector<uint8_t>  m_data;
+
+    void putVarInt(uint64_t value);
+
+    void putOperand(uint32_t word, uint32_t ref);
+
+    void putRaw(const uint32_t* words, uint32_t count);
+
+  };
+
+
+  /**
+   * \brief Compressed SPIR-V reader
+   *
+   * Decodes compressed SPIR-V code one instruction
+   * at a time, so that instructions can be patched
+   * while they are still in cache, without having
+   * to make a second pass over the decoded code.
+   */
+  class SpirvCompressedReader {
+
+  public:
+
+    SpirvCompressedReader(
+      const SpirvCompressedBuffer&  buffer);
+
+    ~SpirvCompressedReader();
+
+    /**
+     * \brief Dword offset of the next instruction
+     * \returns Offset of the next instruction
+     */
+    uint32_t offset() const {
+      return m_offset;
+    }
+
+    /**
+     * \brief Checks whether all code has been read
+     * \returns \c true if no instructions are left
+     */
+    bool atEnd() const {
+      return m_offset >= m_size;
+    }
+
+    /**
+     * \brief Decodes the next instruction
+     *
+     * The SPIR-V header is returned as a single
+     * instruction. The destination array must be
+     * large enough to hold all remaining dwords.
+     * \param [out] dst Destination array
+     * \returns Number of dwords written, or 0 if
+     *    there are no more instructions to read
+     */
+    uint32_t readInstruction(
+            uint32_t*             dst);
+
+  private:
+
+    const uint8_t*  m_data;
+    size_t          m_dataSize;
+
+    size_t          m_read      = 0;
+    uint32_t        m_offset    = 0;
+    uint32_t        m_size      = 0;
+    uint32_t        m_lastId    = 0;
+    bool            m_header    = true;
+
+    uint64_t getVarInt() {
+      // Most values fit into a single byte
+      if (likely(m_read < m_dataSize && m_data[m_read] < 0x80))
+        return m_data[m_read++];
+
+      return getVarIntSlow();
+    }
+
+    uint64_t getVarIntSlow();
+
+    uint32_t getOperand(uint32_t ref) {
+      uint64_t encoded = getVarInt();
+      uint32_t value   = uint32_t(encoded >> 1);
+
+      // The lowest bit indicates whether the operand
+      // is stored relative to the given ID
+      if (encoded & 1)
+        value = ref + ((value >> 1) ^ (0u - (value & 1)));
+
+      return value;
+    }
 
   };
 
-}
\ No newline at end of file
+}
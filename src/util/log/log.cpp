@@ -1,6 +1,7 @@
 #include "log.h"
 
 #include "../util_env.h"
+#include "../util_likely.h"
 
 namespace dxvk {
   
@@ -15,7 +16,9 @@ namespace dxvk {
   }
   
   
-  Logger::~Logger() { }
+  Logger::~Logger() {
+    this->flushMessages();
+  }
   
   
   void Logger::trace(const std::string& message) {
@@ -48,28 +51,168 @@ namespace dxvk {
   }
   
   
+  void Logger::flush() {
+    s_instance.flushMessages();
+  }
+
+
+  void Logger::acquireWriter() {
+    Logger& logger = s_instance;
+
+    if (logger.m_minLevel == LogLevel::None)
+      return;
+
+    std::lock_guard<dxvk::mutex> lock(logger.m_writerMutex);
+
+    if (logger.m_writerRefs++)
+      return;
+
+    logger.m_writerStop = false;
+    logger.m_writerThread = dxvk::thread([&logger] { logger.runWriter(); });
+    logger.m_writerActive.store(true);
+  }
+
+
+  void Logger::releaseWriter() {
+    Logger& logger = s_instance;
+
+    if (logger.m_minLevel == LogLevel::None)
+      return;
+
+    { std::lock_guard<dxvk::mutex> lock(logger.m_writerMutex);
+
+      if (--logger.m_writerRefs)
+        return;
+
+      logger.m_writerActive.store(false);
+      logger.m_writerStop = true;
+      logger.m_writerCond.notify_one();
+    }
+
+    logger.m_writerThread.join();
+    logger.flushMessages();
+  }
+  
+  
   void Logger::emitMsg(LogLevel level, const std::string& message) {
     if (level >= m_minLevel) {
-      std::lock_guard<dxvk::mutex> lock(m_mutex);
-      
       static std::array<const char*, 5> s_prefixes
         = {{ "trace: ", "debug: ", "info:  ", "warn:  ", "err:   " }};
       
       const char* prefix = s_prefixes.at(static_cast<uint32_t>(level));
 
-      std::stringstream stream(message);
-      std::string       line;
+      // Format the entire message on the calling thread
+      // so that the writer only has to copy strings
+      std::string text;
+      text.reserve(message.size() + 16);
+
+      size_t pos = 0;
+
+      while (pos < message.size()) {
+        size_t end = message.find('\n', pos);
+
+        if (end == std::string::npos)
+          end = message.size();
 
-      while (std::getline(stream, line, '\n')) {
-        std::cerr << prefix << line << std::endl;
+        text.append(prefix);
+        text.append(message, pos, end - pos);
+        text.push_back('\n');
 
-        if (m_fileStream)
-          m_fileStream << prefix << line << std::endl;
+        pos = end + 1;
       }
+
+      if (level >= LogLevel::Error) {
+        // Write errors out right away since the app may be about
+        // to crash, and never drop them if the ring is full.
+        while (!m_ring.tryPush(text))
+          this->flushMessages();
+
+        this->flushMessages();
+        return;
+      }
+
+      if (!m_ring.tryPush(text))
+        m_dropped += 1;
+
+      if (m_writerActive.load())
+        this->notifyWriter();
+      else
+        this->tryFlushMessages();
     }
   }
-  
-  
+
+
+  void Logger::flushMessages() {
+    std::lock_guard<dxvk::mutex> lock(m_writeLock);
+    this->writeMessages();
+  }
+
+
+  void Logger::tryFlushMessages() {
+    // Messages that are pushed while another thread is
+    // writing may stay in the ring until the next call,
+    // but we never write more than one batch here.
+    if (m_writeLock.try_lock()) {
+      this->writeMessages();
+      m_writeLock.unlock();
+    }
+  }
+
+
+  void Logger::writeMessages() {
+    std::string record;
+    m_writeBuffer.clear();
+
+    // The ring cannot hold more than one batch, so this writes
+    // out everything that was logged before we got here, even
+    // if other threads keep pushing messages in the meantime.
+    for (uint32_t i = 0; i < RingSize; i++) {
+      if (!m_ring.tryPop(record))
+        break;
+
+      m_writeBuffer += record;
+    }
+
+    uint64_t dropped = m_dropped.exchange(0);
+
+    if (dropped)
+      m_writeBuffer += str::format("warn:  Logger: Dropped ", dropped, " messages\n");
+
+    if (m_writeBuffer.empty())
+      return;
+
+    std::cerr << m_writeBuffer << std::flush;
+
+    if (m_fileStream)
+      m_fileStream << m_writeBuffer << std::flush;
+  }
+
+
+  void Logger::notifyWriter() {
+    std::lock_guard<dxvk::mutex> lock(m_writerMutex);
+    m_writerCond.notify_one();
+  }
+
+
+  void Logger::runWriter() {
+    env::setThreadName("dxvk-log");
+
+    std::unique_lock<dxvk::mutex> lock(m_writerMutex);
+
+    while (!m_writerStop) {
+      m_writerCond.wait(lock, [this] {
+        return m_writerStop
+            || !m_ring.empty()
+            || m_dropped.load();
+      });
+
+      lock.unlock();
+      this->flushMessages();
+      lock.lock();
+    }
+  }
+
+
   LogLevel Logger::getMinLogLevel() {
     const std::array<std::pair<const char*, LogLevel>, 6> logLevels = {{
       { "trace", LogLevel::Trace },
@@ -1,12 +1,15 @@
 #pragma once
 
 #include <array>
+#include <atomic>
 #include <fstream>
 #include <iostream>
 #include <string>
 
 #include "../thread.h"
 
+#include "../sync/sync_ring.h"
+
 namespace dxvk {
   
   enum class LogLevel : uint32_t {
@@ -23,9 +26,22 @@ namespace dxvk {
    * 
    * Logger for one DLL. Creates a text file and
    * writes all log messages to that file.
+   *
+   * Messages are formatted on the calling thread and
+   * pushed into a lock-free ring buffer, which is drained
+   * by a writer thread while any DXVK instance or device
+   * holds a reference to it. Since the writer must not be
+   * joined from DllMain, it is not tied to the lifetime of
+   * the logger itself. Without a writer thread, whichever
+   * thread acquires the write lock writes out one batch of
+   * pending messages, while others return immediately.
+   * If the ring is full, messages are dropped and the
+   * number of dropped messages is logged later on.
+   * Errors are never dropped and are written out before
+   * returning, in case the application is about to crash.
    */
   class Logger {
-    
+    constexpr static uint32_t RingSize = 4096;
   public:
     
     Logger(const std::string& file_name);
@@ -41,6 +57,32 @@ namespace dxvk {
     static LogLevel logLevel() {
       return s_instance.m_minLevel;
     }
+
+    /**
+     * \brief Writes out all pending messages
+     *
+     * Blocks the calling thread until all messages
+     * that have been logged so far are written to
+     * the log file and standard error.
+     */
+    static void flush();
+
+    /**
+     * \brief Acquires the writer thread
+     *
+     * Starts the writer thread if it is not already
+     * running. Must be paired with \ref releaseWriter.
+     */
+    static void acquireWriter();
+
+    /**
+     * \brief Releases the writer thread
+     *
+     * Stops the writer thread once the last
+     * reference has been released. Pending
+     * messages are written out before.
+     */
+    static void releaseWriter();
     
   private:
     
@@ -48,10 +90,33 @@ namespace dxvk {
     
     const LogLevel m_minLevel;
     
-    dxvk::mutex   m_mutex;
     std::ofstream m_fileStream;
+
+    sync::MpscRing<std::string, RingSize> m_ring;
+
+    std::atomic<uint64_t> m_dropped = { 0ull };
+
+    dxvk::mutex   m_writeLock;
+    std::string   m_writeBuffer;
+
+    dxvk::mutex               m_writerMutex;
+    dxvk::condition_variable  m_writerCond;
+    uint32_t                  m_writerRefs = 0;
+    bool                      m_writerStop = false;
+    std::atomic<bool>         m_writerActive = { false };
+    dxvk::thread              m_writerThread;
     
     void emitMsg(LogLevel level, const std::string& message);
+
+    void flushMessages();
+
+    void tryFlushMessages();
+
+    void writeMessages();
+
+    void notifyWriter();
+
+    void runWriter();
     
     static LogLevel getMinLogLevel();
     
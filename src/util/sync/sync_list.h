@@ -0,0 +1,129 @@
+#pragma once
+
+#include <atomic>
+#include <iterator>
+#include <utility>
+
+namespace dxvk::sync {
+
+  /**
+   * \brief Lock-free append-only list
+   *
+   * Elements are inserted at the front of the list
+   * and never removed until the list is destroyed,
+   * so iterating over the list does not require any
+   * locking and pointers to elements remain valid.
+   * Any number of threads may insert elements and
+   * iterate over the list concurrently.
+   */
+  template<typename T>
+  class List {
+
+    struct Entry {
+      template<typename... Args>
+      Entry(Args&&... args)
+      : data(std::forward<Args>(args)...) { }
+
+      T      data;
+      Entry* next = nullptr;
+    };
+
+  public:
+
+    class Iterator {
+
+    public:
+
+      using iterator_category = std::forward_iterator_tag;
+      using difference_type   = std::ptrdiff_t;
+      using value_type        = T;
+      using pointer           = T*;
+      using reference         = T&;
+
+      Iterator()
+      : m_entry(nullptr) { }
+
+      Iterator(Entry* e)
+      : m_entry(e) { }
+
+      reference operator * () const {
+        return m_entry->data;
+      }
+
+      pointer operator -> () const {
+        return &m_entry->data;
+      }
+
+      Iterator& operator ++ () {
+        m_entry = m_entry->next;
+        return *this;
+      }
+
+      Iterator operator ++ (int) {
+        Iterator tmp(m_entry);
+        m_entry = m_entry->next;
+        return tmp;
+      }
+
+      bool operator == (const Iterator& other) const { return m_entry == other.m_entry; }
+      bool operator != (const Iterator& other) const { return m_entry != other.m_entry; }
+
+    private:
+
+      Entry* m_entry;
+
+    };
+
+    using iterator = Iterator;
+
+    List() { }
+    List(const List&) = delete;
+    List& operator = (const List&) = delete;
+
+    ~List() {
+      Entry* e = m_head.load();
+
+      while (e) {
+        Entry* next = e->next;
+        delete e;
+        e = next;
+      }
+    }
+
+    /**
+     * \brief Inserts element
+     *
+     * The element is visible to other threads
+     * as soon as this function returns.
+     * \param [in] args Constructor arguments
+     * \returns Iterator to the new element
+     */
+    template<typename... Args>
+    Iterator emplace(Args&&... args) {
+      Entry* e = new Entry(std::forward<Args>(args)...);
+      Entry* next = m_head.load(std::memory_order_acquire);
+
+      do {
+        e->next = next;
+      } while (!m_head.compare_exchange_weak(next, e,
+        std::memory_order_release,
+        std::memory_order_acquire));
+
+      return Iterator(e);
+    }
+
+    Iterator begin() const {
+      return Iterator(m_head.load(std::memory_order_acquire));
+    }
+
+    Iterator end() const {
+      return Iterator(nullptr);
+    }
+
+  private:
+
+    std::atomic<Entry*> m_head = { nullptr };
+
+  };
+
+}
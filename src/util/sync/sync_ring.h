@@ -0,0 +1,239 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+
+#include "../util_math.h"
+
+namespace dxvk::sync {
+
+  /**
+   * \brief Single-producer single-consumer ring buffer
+   *
+   * Bounded lock-free queue which can be accessed by one
+   * producer thread and one consumer thread concurrently.
+   * Each side only ever writes its own index and keeps a
+   * cached copy of the other side's index, so that the
+   * shared cache lines are only touched when the cached
+   * copy indicates that the ring is full or empty.
+   * \tparam T Item type, must be default-constructible
+   * \tparam Size Capacity, must be a power of two
+   */
+  template<typename T, uint32_t Size>
+  class SpscRing {
+    static_assert(Size && !(Size & (Size - 1)), "Ring size must be a power of two");
+  public:
+
+    SpscRing() { }
+    ~SpscRing() { }
+
+    SpscRing             (const SpscRing&) = delete;
+    SpscRing& operator = (const SpscRing&) = delete;
+
+    /**
+     * \brief Tries to add an item
+     *
+     * Must only be called from the producer thread.
+     * \param [in] item The item. Will only be moved
+     *    from if the operation succeeds.
+     * \returns \c false if the ring is full
+     */
+    bool tryPush(T& item) {
+      uint32_t tail = m_tail.load(std::memory_order_relaxed);
+
+      if (tail - m_headCache == Size) {
+        m_headCache = m_head.load(std::memory_order_acquire);
+
+        if (tail - m_headCache == Size)
+          return false;
+      }
+
+      m_items[tail % Size] = std::move(item);
+      m_tail.store(tail + 1, std::memory_order_release);
+      return true;
+    }
+
+    /**
+     * \brief Tries to remove an item
+     *
+     * Must only be called from the consumer thread.
+     * \param [out] item The item
+     * \returns \c false if the ring is empty
+     */
+    bool tryPop(T& item) {
+      uint32_t head = m_head.load(std::memory_order_relaxed);
+
+      if (head == m_tailCache) {
+        m_tailCache = m_tail.load(std::memory_order_acquire);
+
+        if (head == m_tailCache)
+          return false;
+      }
+
+      item = std::move(m_items[head % Size]);
+      m_head.store(head + 1, std::memory_order_release);
+      return true;
+    }
+
+    /**
+     * \brief Checks whether the ring is empty
+     *
+     * The result may be out of date by the time
+     * the function returns if called from any
+     * thread other than the consumer.
+     * \returns \c true if the ring is empty
+     */
+    bool empty() const {
+      return m_head.load(std::memory_order_acquire)
+          == m_tail.load(std::memory_order_acquire);
+    }
+
+    /**
+     * \brief Checks whether the ring is full
+     *
+     * Same caveats as \ref empty apply for
+     * any thread other than the producer.
+     * \returns \c true if the ring is full
+     */
+    bool full() const {
+      return m_tail.load(std::memory_order_acquire)
+           - m_head.load(std::memory_order_acquire) == Size;
+    }
+
+  private:
+
+    // Written by the consumer
+    alignas(CACHE_LINE_SIZE)
+    std::atomic<uint32_t> m_head      = { 0u };
+    uint32_t              m_tailCache = 0u;
+
+    // Written by the producer
+    alignas(CACHE_LINE_SIZE)
+    std::atomic<uint32_t> m_tail      = { 0u };
+    uint32_t              m_headCache = 0u;
+
+    alignas(CACHE_LINE_SIZE)
+    std::array<T, Size>   m_items;
+
+  };
+
+
+  /**
+   * \brief Multi-producer single-consumer ring buffer
+   *
+   * Bounded lock-free queue which can be accessed by any
+   * number of producer threads and one consumer thread
+   * concurrently. Each slot stores a sequence number that
+   * indicates whether it can be written or read for the
+   * current round, so that producers only need to contend
+   * on the tail index and never wait for each other. The
+   * consumer may change over time as long as consumers are
+   * serialized externally, e.g. through a lock.
+   * \tparam T Item type, must be default-constructible
+   * \tparam Size Capacity, must be a power of two
+   */
+  template<typename T, uint32_t Size>
+  class MpscRing {
+    static_assert(Size && !(Size & (Size - 1)), "Ring size must be a power of two");
+  public:
+
+    MpscRing() {
+      for (uint32_t i = 0; i < Size; i++)
+        m_slots[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    ~MpscRing() { }
+
+    MpscRing             (const MpscRing&) = delete;
+    MpscRing& operator = (const MpscRing&) = delete;
+
+    /**
+     * \brief Tries to add an item
+     *
+     * Can be called from any thread.
+     * \param [in] item The item. Will only be moved
+     *    from if the operation succeeds.
+     * \returns \c false if the ring is full
+     */
+    bool tryPush(T& item) {
+      uint32_t tail = m_tail.load(std::memory_order_relaxed);
+      Slot* slot;
+
+      while (true) {
+        slot = &m_slots[tail % Size];
+
+        uint32_t seq = slot->seq.load(std::memory_order_acquire);
+        int32_t diff = int32_t(seq - tail);
+
+        if (diff == 0) {
+          if (m_tail.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed))
+            break;
+        } else if (diff < 0) {
+          return false;
+        } else {
+          tail = m_tail.load(std::memory_order_relaxed);
+        }
+      }
+
+      slot->item = std::move(item);
+      slot->seq.store(tail + 1, std::memory_order_release);
+      return true;
+    }
+
+    /**
+     * \brief Tries to remove an item
+     *
+     * Must only be called from the consumer thread.
+     * Items are returned in the order in which their
+     * slots were claimed, so an item that is still
+     * being written by a producer will block all
+     * subsequent items until it is complete.
+     * \param [out] item The item
+     * \returns \c false if the ring is empty
+     */
+    bool tryPop(T& item) {
+      uint32_t head = m_head.load(std::memory_order_relaxed);
+      Slot* slot = &m_slots[head % Size];
+
+      if (slot->seq.load(std::memory_order_acquire) != head + 1)
+        return false;
+
+      item = std::move(slot->item);
+      slot->seq.store(head + Size, std::memory_order_release);
+      m_head.store(head + 1, std::memory_order_relaxed);
+      return true;
+    }
+
+    /**
+     * \brief Checks whether the ring is empty
+     *
+     * Can be called from any thread, but the result
+     * may be outdated unless called by the consumer.
+     * \returns \c true if no item can be read
+     */
+    bool empty() const {
+      uint32_t head = m_head.load(std::memory_order_acquire);
+      return m_slots[head % Size].seq.load(std::memory_order_acquire) != head + 1;
+    }
+
+  private:
+
+    struct Slot {
+      std::atomic<uint32_t> seq;
+      T                     item;
+    };
+
+    // Written by the consumer
+    alignas(CACHE_LINE_SIZE)
+    std::atomic<uint32_t> m_head  = { 0u };
+
+    // Written by producers
+    alignas(CACHE_LINE_SIZE)
+    std::atomic<uint32_t> m_tail  = { 0u };
+
+    alignas(CACHE_LINE_SIZE)
+    std::array<Slot, Size> m_slots;
+
+  };
+
+}
@@ -116,6 +116,17 @@ namespace dxvk::bit {
     #endif
   }
 
+  inline uint32_t lzcnt(uint64_t n) {
+    #if (defined(_M_X64) || defined(__x86_64__)) && ((defined(_MSC_VER) && !defined(__clang__)) || defined(__LZCNT__))
+    return uint32_t(_lzcnt_u64(n));
+    #elif defined(__GNUC__) || defined(__clang__)
+    return n != 0 ? __builtin_clzll(n) : 64;
+    #else
+    uint32_t hi = lzcnt(uint32_t(n >> 32));
+    return hi == 32 ? 32 + lzcnt(uint32_t(n)) : hi;
+    #endif
+  }
+
   template<typename T>
   uint32_t pack(T& dst, uint32_t& shift, T src, uint32_t count) {
     constexpr uint32_t Bits = 8 * sizeof(T);
@@ -186,6 +197,61 @@ namespace dxvk::bit {
     #endif
   }
 
+  /**
+   * \brief Hashes the raw bytes of an object
+   *
+   * Processes the object in 64-bit words, using four
+   * independent lanes so that the multiplications can
+   * overlap. The result is not stable across builds and
+   * must only be used for in-memory lookups.
+   * \param [in] data Object to hash
+   * \returns Hash value
+   */
+  template<typename T>
+  size_t bhash(const T* data) {
+    static_assert(sizeof(T) % sizeof(uint64_t) == 0);
+
+    constexpr size_t   WordCount = sizeof(T) / sizeof(uint64_t);
+    constexpr uint64_t Prime     = 0x100000001b3ull;
+
+    auto words = reinterpret_cast<const char*>(data);
+
+    auto load = [words] (size_t idx) {
+      uint64_t word;
+      std::memcpy(&word, words + idx * sizeof(word), sizeof(word));
+      return word;
+    };
+
+    uint64_t h0 = 0xcbf29ce484222325ull;
+    uint64_t h1 = 0x84222325cbf29ce4ull;
+    uint64_t h2 = 0x9e3779b97f4a7c15ull;
+    uint64_t h3 = 0x7f4a7c159e3779b9ull;
+
+    for (size_t i = 0; i < WordCount - WordCount % 4; i += 4) {
+      h0 = (h0 ^ load(i + 0)) * Prime;
+      h1 = (h1 ^ load(i + 1)) * Prime;
+      h2 = (h2 ^ load(i + 2)) * Prime;
+      h3 = (h3 ^ load(i + 3)) * Prime;
+    }
+
+    if constexpr (WordCount % 4 != 0) {
+      for (size_t i = WordCount - WordCount % 4; i < WordCount; i++)
+        h0 = (h0 ^ load(i)) * Prime;
+    }
+
+    // Multiplications only propagate bits upwards,
+    // so mix the high bits back into the low ones
+    uint64_t result = h0;
+    result = (result ^ (h1 >> 32) ^ (h1 << 32)) * Prime;
+    result = (result ^ (h2 >> 32) ^ (h2 << 32)) * Prime;
+    result = (result ^ (h3 >> 32) ^ (h3 << 32)) * Prime;
+
+    result ^= result >> 29;
+    result *= 0xbf58476d1ce4e5b9ull;
+    result ^= result >> 32;
+    return size_t(result);
+  }
+
   template <size_t Bits>
   class bitset {
     static constexpr size_t Dwords = align(Bits, 32) / 32;
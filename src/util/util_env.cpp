@@ -85,5 +85,10 @@ namespace dxvk::env {
     str::tows(path.c_str(), widePath);
     return !!CreateDirectoryW(widePath, nullptr);
   }
+
+
+  bool replaceFile(const std::wstring& src, const std::wstring& dst) {
+    return !!MoveFileExW(src.c_str(), dst.c_str(), MOVEFILE_REPLACE_EXISTING);
+  }
   
 }
@@ -69,5 +69,16 @@ namespace dxvk::env {
    * \returns \c true on success
    */
   bool createDirectory(const std::string& path);
+
+  /**
+   * \brief Replaces a file
+   *
+   * Moves a file to the given path, replacing any
+   * existing file. Used to write files atomically.
+   * \param [in] src Path to the new file
+   * \param [in] dst Path to the file to replace
+   * \returns \c true on success
+   */
+  bool replaceFile(const std::wstring& src, const std::wstring& dst);
   
 }
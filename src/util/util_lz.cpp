@@ -0,0 +1,220 @@
+#include <algorithm>
+#include <cstring>
+
+#include "util_lz.h"
+
+namespace dxvk::lz {
+
+  constexpr static uint32_t MinMatch    = 4;
+  constexpr static uint32_t MaxOffset   = 65535;
+  constexpr static uint32_t HashBits    = 12;
+  constexpr static uint32_t LengthMask  = 15;
+
+
+  static uint32_t read32(const uint8_t* ptr) {
+    uint32_t result;
+    std::memcpy(&result, ptr, sizeof(result));
+    return result;
+  }
+
+
+  static uint32_t hash32(uint32_t value) {
+    return (value * 2654435761u) >> (32 - HashBits);
+  }
+
+
+  static bool writeLength(
+          uint8_t*  dst,
+          size_t    dstSize,
+          size_t&   op,
+          size_t    length) {
+    while (length >= 255) {
+      if (op >= dstSize)
+        return false;
+
+      dst[op++] = 255;
+      length -= 255;
+    }
+
+    if (op >= dstSize)
+      return false;
+
+    dst[op++] = uint8_t(length);
+    return true;
+  }
+
+
+  static bool readLength(
+    const uint8_t*  src,
+          size_t    srcSize,
+          size_t&   ip,
+          size_t&   length) {
+    uint8_t value;
+
+    do {
+      if (ip >= srcSize)
+        return false;
+
+      value = src[ip++];
+      length += value;
+    } while (value == 255);
+
+    return true;
+  }
+
+
+  static bool writeSequence(
+    const uint8_t*  literals,
+          size_t    literalCount,
+          size_t    offset,
+          size_t    matchLength,
+          uint8_t*  dst,
+          size_t    dstSize,
+          size_t&   op) {
+    size_t litToken = std::min<size_t>(literalCount, LengthMask);
+    size_t lenToken = matchLength ? std::min<size_t>(matchLength - MinMatch, LengthMask) : 0;
+
+    if (op >= dstSize)
+      return false;
+
+    dst[op++] = uint8_t((litToken << 4) | lenToken);
+
+    if (litToken == LengthMask && !writeLength(dst, dstSize, op, literalCount - LengthMask))
+      return false;
+
+    if (op + literalCount > dstSize)
+      return false;
+
+    std::memcpy(&dst[op], literals, literalCount);
+    op += literalCount;
+
+    // The last sequence only consists of literals
+    if (!matchLength)
+      return true;
+
+    if (op + 2 > dstSize)
+      return false;
+
+    dst[op++] = uint8_t(offset);
+    dst[op++] = uint8_t(offset >> 8);
+
+    if (lenToken == LengthMask && !writeLength(dst, dstSize, op, matchLength - MinMatch - LengthMask))
+      return false;
+
+    return true;
+  }
+
+
+  size_t compress(
+    const void*     src,
+          size_t    srcSize,
+          void*     dst,
+          size_t    dstSize) {
+    auto in  = reinterpret_cast<const uint8_t*>(src);
+    auto out = reinterpret_cast<uint8_t*>(dst);
+
+    uint32_t table[1u << HashBits] = { };
+
+    size_t ip = 0;
+    size_t op = 0;
+    size_t anchor = 0;
+
+    while (ip + MinMatch <= srcSize) {
+      uint32_t value = read32(&in[ip]);
+      uint32_t hash  = hash32(value);
+
+      size_t candidate = table[hash];
+      table[hash] = uint32_t(ip);
+
+      if (candidate >= ip || ip - candidate > MaxOffset
+       || read32(&in[candidate]) != value) {
+        ip += 1;
+        continue;
+      }
+
+      size_t length = MinMatch;
+
+      while (ip + length < srcSize && in[candidate + length] == in[ip + length])
+        length += 1;
+
+      if (!writeSequence(&in[anchor], ip - anchor, ip - candidate, length, out, dstSize, op))
+        return 0;
+
+      ip += length;
+      anchor = ip;
+    }
+
+    if (!writeSequence(&in[anchor], srcSize - anchor, 0, 0, out, dstSize, op))
+      return 0;
+
+    return op;
+  }
+
+
+  size_t decompress(
+    const void*     src,
+          size_t    srcSize,
+          void*     dst,
+          size_t    dstSize) {
+    auto in  = reinterpret_cast<const uint8_t*>(src);
+    auto out = reinterpret_cast<uint8_t*>(dst);
+
+    size_t ip = 0;
+    size_t op = 0;
+
+    while (ip < srcSize) {
+      uint8_t token = in[ip++];
+
+      // Copy literals
+      size_t literalCount = token >> 4;
+
+      if (literalCount == LengthMask && !readLength(in, srcSize, ip, literalCount))
+        return 0;
+
+      if (ip + literalCount > srcSize)
+        return 0;
+
+      size_t copySize = std::min(literalCount, dstSize - op);
+      std::memcpy(&out[op], &in[ip], copySize);
+
+      ip += literalCount;
+      op += copySize;
+
+      if (op == dstSize || ip == srcSize)
+        return op;
+
+      // Copy match, which may overlap the output
+      if (ip + 2 > srcSize)
+        return 0;
+
+      size_t offset = size_t(in[ip]) | (size_t(in[ip + 1]) << 8);
+      ip += 2;
+
+      if (!offset || offset > op)
+        return 0;
+
+      size_t length = token & LengthMask;
+
+      if (length == LengthMask && !readLength(in, srcSize, ip, length))
+        return 0;
+
+      length = std::min(length + MinMatch, dstSize - op);
+
+      if (offset >= length) {
+        std::memcpy(&out[op], &out[op - offset], length);
+      } else {
+        for (size_t i = 0; i < length; i++)
+          out[op + i] = out[op + i - offset];
+      }
+
+      op += length;
+
+      if (op == dstSize)
+        return op;
+    }
+
+    // Every block ends with a literal sequence
+    return 0;
+  }
+
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace dxvk::lz {
+
+  /**
+   * \brief Computes worst-case compressed size
+   *
+   * \param [in] size Uncompressed data size
+   * \returns Maximum size of the compressed data
+   */
+  inline size_t compressBound(size_t size) {
+    return size + size / 255 + 16;
+  }
+
+  /**
+   * \brief Compresses a block of data
+   *
+   * Uses a simple byte-oriented LZ77 encoding which
+   * favours decompression speed over compression
+   * ratio. Each sequence consists of a token byte,
+   * a literal run and a back-reference of at least
+   * four bytes into the last 64 kB of output.
+   * \param [in] src Source data
+   * \param [in] srcSize Source data size
+   * \param [out] dst Destination buffer
+   * \param [in] dstSize Destination buffer size
+   * \returns Compressed size, or 0 if the destination
+   *    buffer is too small to hold the compressed data
+   */
+  size_t compress(
+    const void*     src,
+          size_t    srcSize,
+          void*     dst,
+          size_t    dstSize);
+
+  /**
+   * \brief Decompresses a block of data
+   *
+   * Stops once the destination buffer is full, so that
+   * callers only interested in a prefix of the block do
+   * not need to decode the entire block.
+   * \param [in] src Compressed data
+   * \param [in] srcSize Compressed data size
+   * \param [out] dst Destination buffer
+   * \param [in] dstSize Destination buffer size
+   * \returns Number of bytes written, or 0 if the
+   *    compressed data is malformed
+   */
+  size_t decompress(
+    const void*     src,
+          size_t    srcSize,
+          void*     dst,
+          size_t    dstSize);
+
+}
@@ -0,0 +1,95 @@
+#include <fstream>
+
+#include "util_mapped_file.h"
+
+namespace dxvk {
+
+  MappedFile::MappedFile() {
+
+  }
+
+
+  MappedFile::~MappedFile() {
+    this->close();
+  }
+
+
+  bool MappedFile::open(const std::wstring& path) {
+    this->close();
+
+    HANDLE file = ::CreateFileW(path.c_str(), GENERIC_READ,
+      FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+      nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+    if (file == INVALID_HANDLE_VALUE)
+      return false;
+
+    LARGE_INTEGER fileSize;
+
+    if (!::GetFileSizeEx(file, &fileSize)
+     || uint64_t(fileSize.QuadPart) > uint64_t(SIZE_MAX)) {
+      ::CloseHandle(file);
+      return false;
+    }
+
+    // Empty files cannot be mapped
+    if (!fileSize.QuadPart) {
+      ::CloseHandle(file);
+      m_data = m_copy.data();
+      return true;
+    }
+
+    // The view keeps the mapping alive, so we
+    // can close both handles right away
+    HANDLE mapping = ::CreateFileMappingW(file,
+      nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+    if (mapping) {
+      m_view = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+      ::CloseHandle(mapping);
+    }
+
+    ::CloseHandle(file);
+
+    if (!m_view)
+      return readFile(path);
+
+    m_data = reinterpret_cast<const char*>(m_view);
+    m_size = size_t(fileSize.QuadPart);
+    return true;
+  }
+
+
+  void MappedFile::close() {
+    if (m_view)
+      ::UnmapViewOfFile(m_view);
+
+    m_view = nullptr;
+    m_data = nullptr;
+    m_size = 0;
+
+    m_copy.clear();
+    m_copy.shrink_to_fit();
+  }
+
+
+  bool MappedFile::readFile(const std::wstring& path) {
+    std::ifstream file(path.c_str(), std::ios_base::binary | std::ios_base::ate);
+
+    if (!file)
+      return false;
+
+    m_copy.resize(size_t(file.tellg()));
+    file.seekg(0);
+
+    if (!file.read(m_copy.data(), m_copy.size())) {
+      m_copy.clear();
+      return false;
+    }
+
+    m_data = m_copy.data();
+    m_size = m_copy.size();
+    return true;
+  }
+
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "./com/com_include.h"
+
+namespace dxvk {
+
+  /**
+   * \brief Read-only mapped file
+   *
+   * Maps the contents of a file into the address space
+   * of the process, so that only the pages that are
+   * actually accessed need to be read from disk. If the
+   * file cannot be mapped, its contents will be read
+   * into memory instead.
+   *
+   * The file remains open for writing by other handles,
+   * but data appended after mapping it is not visible.
+   */
+  class MappedFile {
+
+  public:
+
+    MappedFile();
+
+    ~MappedFile();
+
+    MappedFile             (const MappedFile&) = delete;
+    MappedFile& operator = (const MappedFile&) = delete;
+
+    /**
+     * \brief Opens and maps a file
+     *
+     * Closes any previously opened file.
+     * \param [in] path File path
+     * \returns \c true on success
+     */
+    bool open(const std::wstring& path);
+
+    /**
+     * \brief Closes the file
+     *
+     * Invalidates all pointers into the mapped data.
+     */
+    void close();
+
+    /**
+     * \brief Mapped data
+     * \returns Pointer to file contents
+     */
+    const char* data() const {
+      return m_data;
+    }
+
+    /**
+     * \brief File size
+     * \returns Size of the mapped data, in bytes
+     */
+    size_t size() const {
+      return m_size;
+    }
+
+  private:
+
+    void*             m_view = nullptr;
+    const char*       m_data = nullptr;
+    size_t            m_size = 0;
+
+    std::vector<char> m_copy;
+
+    bool readFile(const std::wstring& path);
+
+  };
+
+}
@@ -0,0 +1,334 @@
+#include <fstream>
+#include <iterator>
+#include <random>
+
+#include "../../src/dxbc/dxbc_module.h"
+#include "../../src/dxvk/dxvk_shader.h"
+#include "../../src/spirv/spirv_module.h"
+
+#include "../../src/util/util_time.h"
+
+#include <shellapi.h>
+#include <windows.h>
+
+namespace dxvk {
+  Logger Logger::s_instance("spirv-compression.log");
+}
+
+using namespace dxvk;
+
+using Clock = dxvk::high_resolution_clock;
+
+/**
+ * \brief Bit mask compression
+ *
+ * Reference implementation of the codec previously
+ * used by \c SpirvCompressedBuffer, which stores the
+ * number of non-zero bytes of each dword in a mask.
+ */
+class MaskCompressedBuffer {
+  constexpr static uint32_t NumMaskWords = 32;
+public:
+
+  MaskCompressedBuffer(const SpirvCodeBuffer& code)
+  : m_size(code.dwords()) {
+    const uint32_t* data = code.data();
+
+    uint64_t dstWord  = 0;
+    uint32_t dstShift = 0;
+
+    for (uint32_t i = 0; i < m_size; i += NumMaskWords) {
+      uint64_t byteCounts = 0;
+
+      for (uint32_t w = 0; w < NumMaskWords && i + w < m_size; w++) {
+        uint64_t word = data[i + w];
+        uint64_t bytes = 0;
+
+        if      (word < (1 <<  8)) bytes = 0;
+        else if (word < (1 << 16)) bytes = 1;
+        else if (word < (1 << 24)) bytes = 2;
+        else                       bytes = 3;
+
+        byteCounts |= bytes << (2 * w);
+
+        uint32_t bits = 8 * bytes + 8;
+        uint32_t rem  = bit::pack(dstWord, dstShift, word, bits);
+
+        if (unlikely(rem != 0)) {
+          m_code.push_back(dstWord);
+
+          dstWord  = 0;
+          dstShift = 0;
+
+          bit::pack(dstWord, dstShift, word >> (bits - rem), rem);
+        }
+      }
+
+      m_mask.push_back(byteCounts);
+    }
+
+    if (dstShift)
+      m_code.push_back(dstWord);
+  }
+
+  size_t size() const {
+    return sizeof(uint64_t) * (m_mask.size() + m_code.size());
+  }
+
+  SpirvCodeBuffer decompress() const {
+    SpirvCodeBuffer code(m_size);
+    uint32_t* data = code.data();
+
+    if (m_size == 0)
+      return code;
+
+    uint32_t maskIdx = 0;
+    uint32_t codeIdx = 0;
+
+    uint64_t srcWord  = m_code[codeIdx++];
+    uint32_t srcShift = 0;
+
+    for (uint32_t i = 0; i < m_size; i += NumMaskWords) {
+      uint64_t srcMask = m_mask[maskIdx++];
+
+      for (uint32_t w = 0; w < NumMaskWords && i + w < m_size; w++) {
+        uint32_t bits = 8 * ((srcMask & 3) + 1);
+
+        uint64_t word = 0;
+        uint32_t rem = bit::unpack(word, srcWord, srcShift, bits);
+
+        if (unlikely(rem != 0)) {
+          srcWord  = m_code[codeIdx++];
+          srcShift = 0;
+
+          uint64_t tmp = 0;
+          bit::unpack(tmp, srcWord, srcShift, rem);
+          word |= tmp << (bits - rem);
+        }
+
+        data[i + w] = word;
+        srcMask >>= 2;
+      }
+    }
+
+    return code;
+  }
+
+private:
+
+  uint32_t              m_size;
+  std::vector<uint64_t> m_mask;
+  std::vector<uint64_t> m_code;
+
+};
+
+
+struct CodecStats {
+  uint64_t  rawSize         = 0;
+  uint64_t  compressedSize  = 0;
+  double    compressUs      = 0.0;
+  double    decompressUs    = 0.0;
+  uint32_t  errorCount      = 0;
+};
+
+
+/**
+ * \brief Loads a shader
+ *
+ * DXBC shaders are compiled the same way the
+ * \c dxbc-compiler test does it, any other file
+ * is expected to contain SPIR-V code.
+ */
+SpirvCodeBuffer loadShader(const std::string& fileName) {
+  std::ifstream file(fileName, std::ios::binary);
+  std::vector<char> data((std::istreambuf_iterator<char>(file)),
+                          std::istreambuf_iterator<char>());
+
+  if (data.size() >= 4 && !std::memcmp(data.data(), "DXBC", 4)) {
+    DxbcReader reader(data.data(), data.size());
+    DxbcModule module(reader);
+
+    DxbcModuleInfo moduleInfo;
+    moduleInfo.options.useSubgroupOpsForAtomicCounters = true;
+    moduleInfo.options.useDemoteToHelperInvocation = true;
+    moduleInfo.options.minSsboAlignment = 4;
+    moduleInfo.xfb = nullptr;
+
+    std::stringstream stream;
+    module.compile(moduleInfo, fileName)->dump(stream);
+    return SpirvCodeBuffer(stream);
+  }
+
+  return SpirvCodeBuffer(data.size() / sizeof(uint32_t),
+    reinterpret_cast<const uint32_t*>(data.data()));
+}
+
+
+/**
+ * \brief Generates a synthetic shader
+ *
+ * Emits declarations and a long chain of arithmetic
+ * operations on recently defined values, which is
+ * roughly what translated shaders look like.
+ */
+SpirvCodeBuffer generateShader(uint32_t seed) {
+  std::mt19937 rng(seed);
+  SpirvModule module(spvVersion(1, 3));
+
+  module.enableCapability(spv::CapabilityShader);
+
+  uint32_t voidType  = module.defVoidType();
+  uint32_t floatType = module.defFloatType(32);
+  uint32_t vec4Type  = module.defVectorType(floatType, 4);
+  uint32_t ptrType   = module.defPointerType(vec4Type, spv::StorageClassPrivate);
+  uint32_t funcType  = module.defFunctionType(voidType, 0, nullptr);
+
+  std::vector<uint32_t> values;
+
+  for (uint32_t i = 0; i < 32; i++) {
+    uint32_t var = module.newVar(ptrType, spv::StorageClassPrivate);
+    module.decorateBinding(var, i);
+    module.decorateDescriptorSet(var, 0);
+    values.push_back(var);
+  }
+
+  uint32_t funcId = module.allocateId();
+  module.functionBegin(voidType, funcId, funcType, spv::FunctionControlMaskNone);
+  module.opLabel(module.allocateId());
+
+  for (uint32_t i = 0; i < 32; i++)
+    values[i] = module.opLoad(vec4Type, values[i]);
+
+  uint32_t opCount = 2000 + rng() % 2000;
+
+  for (uint32_t i = 0; i < opCount; i++) {
+    auto pick = [&] () {
+      return values[values.size() - 1 - rng() % std::min<size_t>(values.size(), 16)];
+    };
+
+    uint32_t a = pick();
+    uint32_t b = pick();
+    uint32_t c = pick();
+
+    switch (rng() % 6) {
+      case 0: values.push_back(module.opFAdd(vec4Type, a, b)); break;
+      case 1: values.push_back(module.opFMul(vec4Type, a, b)); break;
+      case 2: values.push_back(module.opFFma(vec4Type, a, b, c)); break;
+      case 3: values.push_back(module.opFClamp(vec4Type, a, b, c)); break;
+      case 4: {
+        const uint32_t index = uint32_t(rng() % 4);
+        uint32_t scalar = module.opCompositeExtract(floatType, a, 1, &index);
+        const uint32_t members[4] = { scalar, scalar, scalar, scalar };
+        values.push_back(module.opCompositeConstruct(vec4Type, 4, members));
+      } break;
+      case 5: {
+        const uint32_t indices[4] = {
+          uint32_t(rng() % 4), uint32_t(rng() % 4),
+          uint32_t(rng() % 4), uint32_t(rng() % 4) };
+        values.push_back(module.opVectorShuffle(vec4Type, a, b, 4, indices));
+      } break;
+    }
+  }
+
+  module.opReturn();
+  module.functionEnd();
+  return module.compile();
+}
+
+
+template<typename Codec>
+void runCodec(const SpirvCodeBuffer& code, CodecStats& stats, uint32_t iterations) {
+  auto t0 = Clock::now();
+
+  for (uint32_t i = 1; i < iterations; i++)
+    Codec codec(code);
+
+  Codec codec(code);
+
+  auto t1 = Clock::now();
+
+  for (uint32_t i = 1; i < iterations; i++)
+    codec.decompress();
+
+  SpirvCodeBuffer result = codec.decompress();
+
+  auto t2 = Clock::now();
+
+  stats.rawSize         += code.size();
+  stats.compressedSize  += codec.size();
+  stats.compressUs      += std::chrono::duration<double, std::micro>(t1 - t0).count() / iterations;
+  stats.decompressUs    += std::chrono::duration<double, std::micro>(t2 - t1).count() / iterations;
+
+  if (result.dwords() != code.dwords()
+   || std::memcmp(result.data(), code.data(), code.size()))
+    stats.errorCount += 1;
+}
+
+
+void printStats(const char* name, const CodecStats& stats) {
+  Logger::info(str::format(name, ":",
+    "\n  Size:        ", stats.rawSize >> 10, " kB -> ", stats.compressedSize >> 10, " kB (",
+      uint32_t(100.0 * double(stats.compressedSize) / double(stats.rawSize)), "%)",
+    "\n  Compress:    ", uint32_t(double(stats.rawSize) / stats.compressUs), " MB/s",
+    "\n  Decompress:  ", uint32_t(double(stats.rawSize) / stats.decompressUs), " MB/s",
+    "\n  Errors:      ", stats.errorCount));
+}
+
+
+int WINAPI WinMain(HINSTANCE hInstance,
+                   HINSTANCE hPrevInstance,
+                   LPSTR lpCmdLine,
+                   int nCmdShow) {
+  int     argc = 0;
+  LPWSTR* argv = CommandLineToArgvW(
+    GetCommandLineW(), &argc);
+
+  std::vector<SpirvCodeBuffer> shaders;
+
+  try {
+    for (int i = 1; i < argc; i++)
+      shaders.push_back(loadShader(str::fromws(argv[i])));
+  } catch (const DxvkError& e) {
+    Logger::err(e.message());
+    return 1;
+  }
+
+  if (shaders.empty()) {
+    Logger::info("Usage: spirv-compression [shader.dxbc|shader.spv]...");
+    Logger::info("No shaders given, using synthetic shaders");
+
+    for (uint32_t i = 0; i < 64; i++)
+      shaders.push_back(generateShader(i));
+  }
+
+  CodecStats maskStats;
+  CodecStats varIntStats;
+
+  for (const auto& shader : shaders) {
+    runCodec<MaskCompressedBuffer> (shader, maskStats,   16);
+    runCodec<SpirvCompressedBuffer>(shader, varIntStats, 16);
+  }
+
+  printStats("Bit mask", maskStats);
+  printStats("Varint",   varIntStats);
+
+  // Make sure that the streaming decoder produces
+  // the same code when reading one instruction at
+  // a time, including the SPIR-V header
+  uint32_t errors = maskStats.errorCount + varIntStats.errorCount;
+
+  for (const auto& shader : shaders) {
+    SpirvCompressedBuffer compressed(shader);
+    SpirvCompressedReader reader(compressed);
+
+    std::vector<uint32_t> code(shader.dwords());
+
+    while (reader.readInstruction(&code[reader.offset()]))
+      continue;
+
+    if (!reader.atEnd() || std::memcmp(code.data(), shader.data(), shader.size()))
+      errors += 1;
+  }
+
+  return errors ? 1 : 0;
+}
@@ -0,0 +1,246 @@
+#include <algorithm>
+#include <queue>
+
+#include "../../src/dxvk/dxvk_cs.h"
+#include "../../src/dxvk/dxvk_device.h"
+
+#include "../../src/util/util_time.h"
+
+#include <windows.h>
+
+namespace dxvk {
+  Logger Logger::s_instance("dxvk-cs.log");
+}
+
+using namespace dxvk;
+
+using Clock     = dxvk::high_resolution_clock;
+using TimePoint = Clock::time_point;
+
+/**
+ * \brief Locked CS thread
+ *
+ * Reference implementation of the mutex-protected
+ * chunk queue previously used by the CS thread.
+ */
+class LockedCsThread {
+
+public:
+
+  LockedCsThread(
+    const Rc<DxvkDevice>&       device,
+    const Rc<DxvkContext>&      context)
+  : m_context(context), m_thread([this] { threadFunc(); }) { }
+
+  ~LockedCsThread() {
+    { std::unique_lock<dxvk::mutex> lock(m_mutex);
+      m_stopped.store(true);
+    }
+
+    m_condOnAdd.notify_one();
+    m_thread.join();
+  }
+
+  void dispatchChunk(DxvkCsChunkRef&& chunk) {
+    { std::unique_lock<dxvk::mutex> lock(m_mutex);
+      m_chunksQueued.push(std::move(chunk));
+      m_chunksPending += 1;
+    }
+
+    m_condOnAdd.notify_one();
+  }
+
+  void synchronize() {
+    std::unique_lock<dxvk::mutex> lock(m_mutex);
+
+    m_condOnSync.wait(lock, [this] {
+      return !m_chunksPending.load();
+    });
+  }
+
+private:
+
+  const Rc<DxvkContext>       m_context;
+
+  std::atomic<bool>           m_stopped = { false };
+  dxvk::mutex                 m_mutex;
+  dxvk::condition_variable    m_condOnAdd;
+  dxvk::condition_variable    m_condOnSync;
+  std::queue<DxvkCsChunkRef>  m_chunksQueued;
+  std::atomic<uint32_t>       m_chunksPending = { 0u };
+  dxvk::thread                m_thread;
+
+  void threadFunc() {
+    DxvkCsChunkRef chunk;
+
+    while (!m_stopped.load()) {
+      { std::unique_lock<dxvk::mutex> lock(m_mutex);
+        if (chunk) {
+          if (--m_chunksPending == 0)
+            m_condOnSync.notify_one();
+
+          chunk = DxvkCsChunkRef();
+        }
+
+        if (m_chunksQueued.size() == 0) {
+          m_condOnAdd.wait(lock, [this] {
+            return (m_chunksQueued.size() != 0)
+                || (m_stopped.load());
+          });
+        }
+
+        if (m_chunksQueued.size() != 0) {
+          chunk = std::move(m_chunksQueued.front());
+          m_chunksQueued.pop();
+        }
+      }
+
+      if (chunk)
+        chunk->executeAll(m_context.ptr());
+    }
+  }
+
+};
+
+
+struct BenchResult {
+  double throughputNs = 0.0;
+  double latencyAvgUs = 0.0;
+  double latencyP50Us = 0.0;
+  double latencyP99Us = 0.0;
+  double latencyMaxUs = 0.0;
+};
+
+
+/**
+ * \brief Busy-waits for the given amount of time
+ *
+ * Emulates the application doing some work between
+ * two chunk submissions, without sleeping.
+ */
+void spinFor(std::chrono::nanoseconds duration) {
+  TimePoint end = Clock::now() + duration;
+
+  while (Clock::now() < end)
+    continue;
+}
+
+
+DxvkCsChunkRef allocChunk(DxvkCsChunkPool& pool) {
+  return DxvkCsChunkRef(pool.allocChunk(
+    DxvkCsChunkFlag::SingleUse), &pool);
+}
+
+
+template<typename CsThread>
+double measureThroughput(
+        DxvkCsChunkPool&      pool,
+        uint32_t              chunkCount) {
+  CsThread thread(nullptr, nullptr);
+
+  // Chunks are allocated up front so that we don't
+  // benchmark the chunk pool or the command itself
+  std::vector<DxvkCsChunkRef> chunks(chunkCount);
+
+  for (auto& chunk : chunks) {
+    auto cmd = [] (DxvkContext*) { };
+
+    chunk = allocChunk(pool);
+    chunk->push(cmd);
+  }
+
+  TimePoint t0 = Clock::now();
+
+  for (auto& chunk : chunks)
+    thread.dispatchChunk(std::move(chunk));
+
+  thread.synchronize();
+
+  TimePoint t1 = Clock::now();
+  return std::chrono::duration<double, std::nano>(t1 - t0).count() / double(chunkCount);
+}
+
+
+template<typename CsThread>
+void measureLatency(
+        DxvkCsChunkPool&      pool,
+        uint32_t              chunkCount,
+        std::chrono::nanoseconds interval,
+        BenchResult&          result) {
+  CsThread thread(nullptr, nullptr);
+
+  std::vector<double> latencies(chunkCount);
+
+  for (uint32_t i = 0; i < chunkCount; i++) {
+    DxvkCsChunkRef chunk = allocChunk(pool);
+
+    double* latency = &latencies[i];
+    TimePoint t0 = Clock::now();
+
+    auto cmd = [latency, t0] (DxvkContext*) {
+      *latency = std::chrono::duration<double, std::micro>(Clock::now() - t0).count();
+    };
+
+    chunk->push(cmd);
+
+    thread.dispatchChunk(std::move(chunk));
+    spinFor(interval);
+  }
+
+  thread.synchronize();
+
+  std::sort(latencies.begin(), latencies.end());
+
+  double sum = 0.0;
+
+  for (double l : latencies)
+    sum += l;
+
+  result.latencyAvgUs = sum / double(chunkCount);
+  result.latencyP50Us = latencies[chunkCount / 2];
+  result.latencyP99Us = latencies[(chunkCount * 99) / 100];
+  result.latencyMaxUs = latencies[chunkCount - 1];
+}
+
+
+template<typename CsThread>
+void runBenchmark(
+  const char*                 name,
+        std::chrono::nanoseconds interval) {
+  constexpr uint32_t ThroughputChunks = 1u << 18;
+  constexpr uint32_t LatencyChunks    = 1u << 14;
+
+  DxvkCsChunkPool pool;
+  BenchResult result;
+
+  result.throughputNs = measureThroughput<CsThread>(pool, ThroughputChunks);
+  measureLatency<CsThread>(pool, LatencyChunks, interval, result);
+
+  Logger::info(str::format(name, " (", interval.count() / 1000, " us interval):",
+    "\n  Throughput:  ", uint32_t(result.throughputNs), " ns/chunk",
+    "\n  Latency avg: ", result.latencyAvgUs, " us",
+    "\n  Latency p50: ", result.latencyP50Us, " us",
+    "\n  Latency p99: ", result.latencyP99Us, " us",
+    "\n  Latency max: ", result.latencyMaxUs, " us"));
+}
+
+
+int WINAPI WinMain(HINSTANCE hInstance,
+                   HINSTANCE hPrevInstance,
+                   LPSTR lpCmdLine,
+                   int nCmdShow) {
+  // Back-to-back submissions, as well as submissions with
+  // enough time in between for the CS thread to go idle
+  const std::array<std::chrono::nanoseconds, 3> intervals = {
+    std::chrono::nanoseconds(0),
+    std::chrono::microseconds(5),
+    std::chrono::microseconds(200),
+  };
+
+  for (auto interval : intervals) {
+    runBenchmark<LockedCsThread>("Locked queue", interval);
+    runBenchmark<DxvkCsThread>  ("SPSC ring",    interval);
+  }
+
+  return 0;
+}
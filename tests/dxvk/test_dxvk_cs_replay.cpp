@@ -0,0 +1,288 @@
+#include <algorithm>
+#include <fstream>
+#include <utility>
+
+#include "../../src/dxvk/dxvk_cs.h"
+#include "../../src/dxvk/dxvk_device.h"
+
+#include "../../src/util/util_time.h"
+
+#include <shellapi.h>
+#include <windows.h>
+
+namespace dxvk {
+  Logger Logger::s_instance("dxvk-cs-replay.log");
+}
+
+using namespace dxvk;
+
+using Clock = dxvk::high_resolution_clock;
+
+struct CaptureType {
+  std::string       name;
+  uint64_t          count   = 0;
+  uint64_t          timeNs  = 0;
+  uint64_t          bytes   = 0;
+};
+
+struct CaptureChunk {
+  uint32_t                      frameId;
+  std::vector<DxvkCsCaptureCmd> commands;
+};
+
+struct Capture {
+  std::vector<CaptureType>  types;
+  std::vector<CaptureChunk> chunks;
+};
+
+
+/**
+ * \brief Loads a capture file
+ *
+ * \param [in] fileName File name
+ * \param [out] capture Capture data
+ * \returns \c true on success
+ */
+bool loadCapture(const std::string& fileName, Capture& capture) {
+  std::ifstream file(fileName, std::ios_base::binary);
+
+  DxvkCsCaptureHeader expected;
+  DxvkCsCaptureHeader header;
+
+  if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))
+   || std::memcmp(header.magic, expected.magic, sizeof(header.magic))
+   || header.version != expected.version)
+    return false;
+
+  DxvkCsCaptureRecordType type;
+
+  while (file.read(reinterpret_cast<char*>(&type), sizeof(type))) {
+    switch (type) {
+      case DxvkCsCaptureRecordType::TypeName: {
+        uint32_t typeId = 0;
+        uint32_t length = 0;
+
+        if (!file.read(reinterpret_cast<char*>(&typeId), sizeof(typeId))
+         || !file.read(reinterpret_cast<char*>(&length), sizeof(length)))
+          return false;
+
+        if (typeId >= capture.types.size())
+          capture.types.resize(typeId + 1);
+
+        capture.types[typeId].name.resize(length);
+
+        if (!file.read(capture.types[typeId].name.data(), length))
+          return false;
+      } break;
+
+      case DxvkCsCaptureRecordType::Chunk: {
+        DxvkCsCaptureChunk info;
+
+        if (!file.read(reinterpret_cast<char*>(&info), sizeof(info)))
+          return false;
+
+        CaptureChunk chunk;
+        chunk.frameId = info.frameId;
+        chunk.commands.resize(info.cmdCount);
+
+        if (!file.read(reinterpret_cast<char*>(chunk.commands.data()),
+            sizeof(DxvkCsCaptureCmd) * info.cmdCount))
+          return false;
+
+        for (const auto& cmd : chunk.commands) {
+          if (cmd.typeId >= capture.types.size())
+            return false;
+
+          auto& t = capture.types[cmd.typeId];
+          t.count  += 1;
+          t.timeNs += cmd.timeNs;
+          t.bytes  += cmd.size;
+        }
+
+        capture.chunks.push_back(std::move(chunk));
+      } break;
+
+      default:
+        return false;
+    }
+  }
+
+  return true;
+}
+
+
+/**
+ * \brief Prints command profile
+ *
+ * Lists the command types that took the most time
+ * to execute on the context while capturing.
+ */
+void printProfile(const Capture& capture) {
+  std::vector<uint32_t> order(capture.types.size());
+
+  for (uint32_t i = 0; i < order.size(); i++)
+    order[i] = i;
+
+  std::sort(order.begin(), order.end(), [&capture] (uint32_t a, uint32_t b) {
+    return capture.types[a].timeNs > capture.types[b].timeNs;
+  });
+
+  uint64_t totalTime  = 0;
+  uint64_t totalCount = 0;
+
+  for (const auto& t : capture.types) {
+    totalTime  += t.timeNs;
+    totalCount += t.count;
+  }
+
+  uint32_t frameCount = capture.chunks.empty() ? 0
+    : capture.chunks.back().frameId - capture.chunks.front().frameId + 1;
+
+  Logger::info(str::format("Captured ", frameCount, " frames, ",
+    capture.chunks.size(), " chunks, ", totalCount, " commands, ",
+    totalTime / 1000, " us on the context"));
+
+  for (uint32_t i = 0; i < std::min<size_t>(order.size(), 32); i++) {
+    const auto& t = capture.types[order[i]];
+
+    Logger::info(str::format(
+      "  ", t.timeNs / 1000, " us (", t.count, " calls, ",
+      t.timeNs / std::max<uint64_t>(t.count, 1), " ns/call, ",
+      t.bytes / std::max<uint64_t>(t.count, 1), " bytes): ", t.name));
+  }
+}
+
+
+/**
+ * \brief Replay command
+ *
+ * Only counts how often it gets executed. Padded so
+ * that chunks have roughly the same memory footprint
+ * as the captured ones.
+ */
+template<size_t N>
+struct ReplayCmd {
+  uint64_t* counter;
+  char      padding[N];
+
+  void operator () (DxvkContext*) const {
+    *counter += 1;
+  }
+};
+
+constexpr size_t ReplayBucketSize  = 64;
+constexpr size_t ReplayBucketCount = 64;
+
+using ReplayPushFn = bool (*) (DxvkCsChunk*, uint64_t*);
+
+template<size_t N>
+bool pushReplayCmd(DxvkCsChunk* chunk, uint64_t* counter) {
+  ReplayCmd<N> cmd = { counter };
+  return chunk->push(cmd);
+}
+
+template<size_t... Is>
+constexpr std::array<ReplayPushFn, sizeof...(Is)> getReplayPushFns(std::index_sequence<Is...>) {
+  return {{ &pushReplayCmd<Is * ReplayBucketSize + 8>... }};
+}
+
+static const auto g_replayPushFns = getReplayPushFns(
+  std::make_index_sequence<ReplayBucketCount>());
+
+
+/**
+ * \brief Replays the capture
+ *
+ * Feeds chunks with the captured command layout through
+ * a CS thread with a null context, which measures the
+ * overhead of recording and dispatching commands.
+ */
+void replayCapture(const Capture& capture, uint32_t iterations) {
+  DxvkCsChunkPool pool;
+
+  std::vector<uint64_t> counters(capture.types.size());
+
+  auto t0 = Clock::now();
+
+  { DxvkCsThread thread(nullptr, nullptr);
+
+    for (uint32_t i = 0; i < iterations; i++) {
+      uint32_t frameId = capture.chunks.empty() ? 0 : capture.chunks.front().frameId;
+
+      for (const auto& c : capture.chunks) {
+        // Emulate the application waiting for the previous frame
+        if (c.frameId != frameId) {
+          thread.synchronize();
+          frameId = c.frameId;
+        }
+
+        DxvkCsChunk* chunk = pool.allocChunk(DxvkCsChunkFlag::SingleUse);
+
+        for (const auto& cmd : c.commands) {
+          size_t bucket = std::min<size_t>(cmd.size / ReplayBucketSize, ReplayBucketCount - 1);
+
+          if (!g_replayPushFns[bucket](chunk, &counters[cmd.typeId])) {
+            thread.dispatchChunk(DxvkCsChunkRef(chunk, &pool));
+            chunk = pool.allocChunk(DxvkCsChunkFlag::SingleUse);
+            g_replayPushFns[bucket](chunk, &counters[cmd.typeId]);
+          }
+        }
+
+        thread.dispatchChunk(DxvkCsChunkRef(chunk, &pool));
+      }
+
+      thread.synchronize();
+    }
+  }
+
+  auto t1 = Clock::now();
+
+  uint32_t errors = 0;
+
+  for (uint32_t i = 0; i < capture.types.size(); i++) {
+    if (counters[i] != capture.types[i].count * iterations)
+      errors += 1;
+  }
+
+  uint64_t commandCount = 0;
+
+  for (const auto& t : capture.types)
+    commandCount += t.count;
+
+  double totalUs = std::chrono::duration<double, std::micro>(t1 - t0).count();
+
+  Logger::info(str::format("Replayed ", iterations, " times:",
+    "\n  Time:     ", uint64_t(totalUs / double(iterations)), " us per iteration",
+    "\n  Commands: ", uint64_t(1000.0 * totalUs / double(commandCount * iterations)), " ns per command",
+    "\n  Errors:   ", errors));
+}
+
+
+int WINAPI WinMain(HINSTANCE hInstance,
+                   HINSTANCE hPrevInstance,
+                   LPSTR lpCmdLine,
+                   int nCmdShow) {
+  int     argc = 0;
+  LPWSTR* argv = CommandLineToArgvW(
+    GetCommandLineW(), &argc);
+
+  if (argc < 2) {
+    Logger::err("Usage: dxvk-cs-replay capture.dxvk-cs [iterations]");
+    return 1;
+  }
+
+  Capture capture;
+
+  if (!loadCapture(str::fromws(argv[1]), capture)) {
+    Logger::err("Failed to load capture file");
+    return 1;
+  }
+
+  uint32_t iterations = argc >= 3
+    ? uint32_t(std::stoul(str::fromws(argv[2])))
+    : 10;
+
+  printProfile(capture);
+  replayCapture(capture, iterations);
+  return 0;
+}
@@ -0,0 +1,279 @@
+#include <random>
+
+#include "../../src/dxvk/dxvk_graphics.h"
+
+#include "../../src/util/util_time.h"
+
+#include <shellapi.h>
+#include <windows.h>
+
+namespace dxvk {
+  Logger Logger::s_instance("dxvk-pipeline-lookup.log");
+}
+
+using namespace dxvk;
+
+using Clock = dxvk::high_resolution_clock;
+
+struct TestPipeline {
+  std::vector<DxvkGraphicsPipelineStateInfo> states;
+};
+
+struct TestDraw {
+  uint32_t pipeline;
+  uint32_t state;
+  uint32_t renderPass;
+};
+
+struct TestTrace {
+  std::vector<TestPipeline> pipelines;
+  std::vector<TestDraw>     draws;
+};
+
+
+/**
+ * \brief Linear instance list
+ *
+ * Reference implementation of the instance
+ * lookup previously used by graphics pipelines.
+ */
+class LinearInstanceList {
+
+public:
+
+  VkPipeline find(
+    const DxvkGraphicsPipelineStateInfo&  state,
+    const DxvkRenderPass*                 rp) {
+    std::lock_guard<sync::Spinlock> lock(m_mutex);
+
+    for (const auto& instance : m_instances) {
+      if (instance.isCompatible(state, rp, 0))
+        return instance.pipeline();
+    }
+
+    return VK_NULL_HANDLE;
+  }
+
+  void insert(
+    const DxvkGraphicsPipelineStateInfo&  state,
+    const DxvkRenderPass*                 rp,
+          VkPipeline                      pipe) {
+    std::lock_guard<sync::Spinlock> lock(m_mutex);
+    m_instances.emplace_back(state, rp, 0, pipe);
+  }
+
+private:
+
+  sync::Spinlock                            m_mutex;
+  std::vector<DxvkGraphicsPipelineInstance> m_instances;
+
+};
+
+
+/**
+ * \brief Generates a synthetic draw trace
+ *
+ * Each pipeline gets a number of state vectors that
+ * are derived from a common state with a few random
+ * changes, which roughly matches what games do when
+ * using the same shaders with different blend, depth
+ * or vertex layout state. Draws are issued in batches
+ * that reuse the same few pipeline states.
+ */
+TestTrace generateTrace(uint32_t pipelineCount, uint32_t maxStates, uint32_t drawCount, uint32_t seed) {
+  std::mt19937 rng(seed);
+
+  TestTrace trace;
+  trace.pipelines.resize(pipelineCount);
+
+  DxvkGraphicsPipelineStateInfo base;
+  auto baseBytes = reinterpret_cast<uint8_t*>(&base);
+
+  for (size_t i = 0; i < sizeof(base) / 2; i += 1 + rng() % 8)
+    baseBytes[i] = uint8_t(rng() % 16);
+
+  for (auto& p : trace.pipelines) {
+    uint32_t stateCount = 1 + rng() % maxStates;
+
+    while (p.states.size() < stateCount) {
+      DxvkGraphicsPipelineStateInfo state = base;
+      auto bytes = reinterpret_cast<uint8_t*>(&state);
+
+      for (uint32_t j = 0; j < 3; j++)
+        bytes[rng() % sizeof(state)] = uint8_t(rng());
+
+      bool unique = true;
+
+      for (const auto& s : p.states)
+        unique &= s != state;
+
+      if (unique)
+        p.states.push_back(state);
+    }
+  }
+
+  trace.draws.reserve(drawCount);
+
+  while (trace.draws.size() < drawCount) {
+    TestDraw draw;
+    draw.pipeline   = rng() % pipelineCount;
+    draw.renderPass = rng() % 2;
+
+    const auto& p = trace.pipelines[draw.pipeline];
+
+    uint32_t batch = 1 + rng() % 16;
+    uint32_t first = rng() % p.states.size();
+
+    for (uint32_t i = 0; i < batch; i++) {
+      draw.state = (first + rng() % 2) % p.states.size();
+      trace.draws.push_back(draw);
+    }
+  }
+
+  return trace;
+}
+
+
+VkPipeline getPipelineHandle(uint32_t pipeline, uint32_t state, uint32_t renderPass) {
+  return (VkPipeline)(uintptr_t((pipeline << 16) | (state << 1) | renderPass) + 1);
+}
+
+
+const DxvkRenderPass* getRenderPass(uint32_t renderPass) {
+  static const uint64_t renderPasses[2] = { };
+  return reinterpret_cast<const DxvkRenderPass*>(&renderPasses[renderPass]);
+}
+
+
+template<typename Fn>
+uint32_t runTest(const char* name, const TestTrace& trace, const Fn& lookup) {
+  uint32_t errors = 0;
+  uint32_t misses = 0;
+
+  auto t0 = Clock::now();
+
+  for (const auto& draw : trace.draws) {
+    const auto& state = trace.pipelines[draw.pipeline].states[draw.state];
+    VkPipeline expected = getPipelineHandle(draw.pipeline, draw.state, draw.renderPass);
+
+    bool created = false;
+    VkPipeline pipeline = lookup(draw.pipeline, state,
+      getRenderPass(draw.renderPass), expected, created);
+
+    errors += pipeline != expected;
+    misses += created;
+  }
+
+  auto t1 = Clock::now();
+
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+
+  Logger::info(str::format(name, ":",
+    "\n  Total:       ", ns / 1000, " us",
+    "\n  Per draw:    ", ns / std::max<size_t>(trace.draws.size(), 1), " ns",
+    "\n  Instances:   ", misses,
+    "\n  Errors:      ", errors));
+
+  return errors;
+}
+
+
+uint32_t runTests(uint32_t pipelineCount, uint32_t maxStates, uint32_t drawCount) {
+  TestTrace trace = generateTrace(pipelineCount, maxStates, drawCount, pipelineCount);
+
+  Logger::info(str::format(pipelineCount, " pipelines, up to ", maxStates,
+    " states per pipeline, ", drawCount, " draws"));
+
+  uint32_t errors = 0;
+
+  // Old behaviour: Linear scan under a lock
+  std::vector<LinearInstanceList> linear(pipelineCount);
+
+  errors += runTest("Linear", trace, [&] (
+          uint32_t                        pipeline,
+    const DxvkGraphicsPipelineStateInfo&  state,
+    const DxvkRenderPass*                 rp,
+          VkPipeline                      handle,
+          bool&                           created) {
+    VkPipeline result = linear[pipeline].find(state, rp);
+
+    if (!result) {
+      linear[pipeline].insert(state, rp, handle);
+      result = handle;
+      created = true;
+    }
+
+    return result;
+  });
+
+  // Hashed instance table only
+  std::vector<DxvkGraphicsPipelineInstanceTable> hashed(pipelineCount);
+
+  errors += runTest("Hashed", trace, [&] (
+          uint32_t                        pipeline,
+    const DxvkGraphicsPipelineStateInfo&  state,
+    const DxvkRenderPass*                 rp,
+          VkPipeline                      handle,
+          bool&                           created) {
+    size_t hash = state.hash();
+    auto instance = hashed[pipeline].find(state, rp, hash);
+
+    if (!instance) {
+      instance = hashed[pipeline].insert(state, rp, hash, handle);
+      created = true;
+    }
+
+    return instance->pipeline();
+  });
+
+  // Hashed instance table with a per-context instance cache,
+  // which is what the context uses. The pipeline objects are
+  // only used as keys, so we can use the tables instead.
+  std::vector<DxvkGraphicsPipelineInstanceTable> cached(pipelineCount);
+  DxvkGraphicsPipelineInstanceCache cache;
+
+  errors += runTest("Hashed + cache", trace, [&] (
+          uint32_t                        pipeline,
+    const DxvkGraphicsPipelineStateInfo&  state,
+    const DxvkRenderPass*                 rp,
+          VkPipeline                      handle,
+          bool&                           created) {
+    auto key = reinterpret_cast<const DxvkGraphicsPipeline*>(&cached[pipeline]);
+
+    size_t hash = state.hash();
+    auto instance = cache.find(key, state, rp, hash);
+
+    if (!instance) {
+      instance = cached[pipeline].find(state, rp, hash);
+
+      if (!instance) {
+        instance = cached[pipeline].insert(state, rp, hash, handle);
+        created = true;
+      }
+
+      cache.insert(key, instance);
+    }
+
+    return instance->pipeline();
+  });
+
+  return errors;
+}
+
+
+int WINAPI WinMain(HINSTANCE hInstance,
+                   HINSTANCE hPrevInstance,
+                   LPSTR lpCmdLine,
+                   int nCmdShow) {
+  uint32_t errors = 0;
+
+  errors += runTests(  1,   1, 1u << 20);
+  errors += runTests(256,   4, 1u << 20);
+  errors += runTests(256,  64, 1u << 20);
+  errors += runTests( 16, 256, 1u << 20);
+
+  if (errors)
+    Logger::err(str::format("Failed with ", errors, " errors"));
+
+  return errors ? 1 : 0;
+}
@@ -0,0 +1,269 @@
+#include <random>
+#include <sstream>
+
+#include "../../src/dxvk/dxvk_state_cache_packed.h"
+
+#include "../../src/util/util_lz.h"
+#include "../../src/util/util_time.h"
+
+#include <shellapi.h>
+#include <windows.h>
+
+namespace dxvk {
+  Logger Logger::s_instance("dxvk-state-cache.log");
+}
+
+using namespace dxvk;
+
+using Clock = dxvk::high_resolution_clock;
+
+struct TestPipeline {
+  DxvkStateCacheKey         key;
+  std::vector<std::string>  entries;
+};
+
+
+/**
+ * \brief Generates a synthetic cache
+ *
+ * Pipelines use a random subset of a shared pool of
+ * shaders, and entries are derived from a common state
+ * vector with a few random changes, which roughly
+ * matches serialized pipeline state.
+ */
+std::vector<TestPipeline> generatePipelines(uint32_t pipelineCount, uint32_t seed) {
+  std::mt19937 rng(seed);
+
+  std::vector<DxvkShaderKey> vs;
+  std::vector<DxvkShaderKey> fs;
+  std::vector<DxvkShaderKey> cs;
+
+  for (uint32_t i = 0; i < pipelineCount / 4 + 1; i++) {
+    uint32_t id = rng();
+    vs.emplace_back(VK_SHADER_STAGE_VERTEX_BIT,   Sha1Hash::compute(&id, sizeof(id)));
+    id = rng();
+    fs.emplace_back(VK_SHADER_STAGE_FRAGMENT_BIT, Sha1Hash::compute(&id, sizeof(id)));
+    id = rng();
+    cs.emplace_back(VK_SHADER_STAGE_COMPUTE_BIT,  Sha1Hash::compute(&id, sizeof(id)));
+  }
+
+  // Most state is shared between pipelines, with each
+  // entry only changing a handful of values
+  std::string state(400, '\0');
+
+  for (size_t i = 0; i < state.size(); i += 1 + rng() % 8)
+    state[i] = char(rng() % 16);
+
+  std::vector<TestPipeline> pipelines(pipelineCount);
+
+  for (auto& p : pipelines) {
+    if (rng() % 16) {
+      p.key.vs = vs[rng() % vs.size()];
+      p.key.fs = fs[rng() % fs.size()];
+    } else {
+      p.key.cs = cs[rng() % cs.size()];
+    }
+
+    uint32_t entryCount = 1 + rng() % 4;
+
+    for (uint32_t i = 0; i < entryCount; i++) {
+      std::string data(state, 0, 200 + rng() % 200);
+
+      for (uint32_t j = 0; j < 4; j++)
+        data[rng() % data.size()] = char(rng());
+
+      p.entries.push_back(std::move(data));
+    }
+  }
+
+  return pipelines;
+}
+
+
+uint32_t testCodec(const std::vector<TestPipeline>& pipelines) {
+  uint32_t errors = 0;
+
+  for (uint32_t i = 0; i < pipelines.size() && i < 256; i++) {
+    std::string raw;
+
+    for (const auto& e : pipelines[i].entries)
+      raw += e;
+
+    std::vector<char> compressed(lz::compressBound(raw.size()));
+    std::vector<char> decompressed(raw.size());
+
+    size_t size = lz::compress(raw.data(), raw.size(), compressed.data(), compressed.size());
+
+    if (!size || lz::decompress(compressed.data(), size, decompressed.data(), decompressed.size()) != raw.size()
+     || std::memcmp(raw.data(), decompressed.data(), raw.size()))
+      errors += 1;
+
+    // Partial decoding must produce a prefix of the data
+    size_t prefix = raw.size() / 3;
+
+    if (lz::decompress(compressed.data(), size, decompressed.data(), prefix) != prefix
+     || std::memcmp(raw.data(), decompressed.data(), prefix))
+      errors += 1;
+
+    // Truncated data must not decode successfully
+    if (lz::decompress(compressed.data(), size / 2, decompressed.data(), decompressed.size()) == raw.size())
+      errors += 1;
+  }
+
+  return errors;
+}
+
+
+uint32_t testPacked(const std::vector<TestPipeline>& pipelines) {
+  uint32_t errors = 0;
+
+  // Pipelines may occur more than once in the generated set,
+  // entries are expected to be concatenated in order
+  std::unordered_map<DxvkStateCacheKey, std::string, DxvkHash, DxvkEq> expected;
+
+  for (const auto& p : pipelines) {
+    for (const auto& e : p.entries)
+      expected[p.key] += e;
+  }
+
+  // Pack all entries
+  auto t0 = Clock::now();
+
+  DxvkStateCachePackedWriter writer;
+  size_t rawSize = 0;
+
+  for (const auto& p : pipelines) {
+    for (const auto& e : p.entries) {
+      writer.addEntry(p.key, e);
+      rawSize += e.size();
+    }
+  }
+
+  std::ostringstream stream;
+  DxvkStateCacheHeader header;
+  stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+  if (!writer.write(stream))
+    errors += 1;
+
+  std::string file = stream.str();
+
+  // Open packed data and look up all pipelines
+  auto t1 = Clock::now();
+
+  DxvkStateCachePackedReader reader;
+
+  if (!reader.init(file.data(), file.size()) || reader.dataSize() != file.size())
+    return errors + 1;
+
+  auto t2 = Clock::now();
+
+  for (const auto& p : pipelines) {
+    uint32_t index = reader.findPipeline(p.key);
+
+    DxvkStateCacheKey key;
+    std::string data;
+
+    if (index == DxvkStateCachePackedReader::InvalidIndex
+     || !reader.readPipeline(index, key, data)
+     || !key.eq(p.key)) {
+      errors += 1;
+      continue;
+    }
+
+    if (data != expected[p.key])
+      errors += 1;
+  }
+
+  auto t3 = Clock::now();
+
+  // Look up pipelines by shader
+  for (uint32_t i = 0; i < pipelines.size() && i < 1024; i++) {
+    std::vector<DxvkStateCacheKey> keys;
+    reader.findPipelines(pipelines[i].key.cs.eq(DxvkShaderKey())
+      ? pipelines[i].key.vs : pipelines[i].key.cs, keys);
+
+    bool found = false;
+
+    for (const auto& k : keys)
+      found |= k.eq(pipelines[i].key);
+
+    if (!found)
+      errors += 1;
+  }
+
+  // Unknown keys must not be found
+  DxvkStateCacheKey unknown;
+  unknown.vs = DxvkShaderKey(VK_SHADER_STAGE_VERTEX_BIT, Sha1Hash::compute(&unknown, sizeof(unknown)));
+
+  if (reader.findPipeline(unknown) != DxvkStateCachePackedReader::InvalidIndex)
+    errors += 1;
+
+  // Truncated files must be rejected
+  DxvkStateCachePackedReader truncated;
+
+  if (truncated.init(file.data(), file.size() - 1))
+    errors += 1;
+
+  // Compare against decoding everything up front and building
+  // lookup tables, which is what loading the old format does
+  auto t4 = Clock::now();
+
+  std::unordered_multimap<DxvkStateCacheKey, std::string, DxvkHash, DxvkEq> entryMap;
+  std::unordered_multimap<DxvkShaderKey, DxvkStateCacheKey, DxvkHash, DxvkEq> shaderMap;
+
+  for (uint32_t i = 0; i < reader.pipelineCount(); i++) {
+    DxvkStateCacheKey key;
+    std::string data;
+
+    if (!reader.readPipeline(i, key, data))
+      errors += 1;
+
+    entryMap.insert({ key, std::move(data) });
+
+    const DxvkShaderKey* keys = &key.vs;
+
+    for (uint32_t j = 0; j < 6; j++) {
+      if (!keys[j].eq(DxvkShaderKey()))
+        shaderMap.insert({ keys[j], key });
+    }
+  }
+
+  auto t5 = Clock::now();
+
+  auto us = [] (Clock::duration d) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+  };
+
+  Logger::info(str::format(pipelines.size(), " pipelines:",
+    "\n  Entries:     ", reader.entryCount(),
+    "\n  Raw size:    ", rawSize >> 10, " kB",
+    "\n  File size:   ", file.size() >> 10, " kB",
+    "\n  Pack:        ", us(t1 - t0), " us",
+    "\n  Open:        ", us(t2 - t1), " us",
+    "\n  Lookup all:  ", us(t3 - t2), " us",
+    "\n  Decode all:  ", us(t5 - t4), " us",
+    "\n  Errors:      ", errors));
+
+  return errors;
+}
+
+
+int WINAPI WinMain(HINSTANCE hInstance,
+                   HINSTANCE hPrevInstance,
+                   LPSTR lpCmdLine,
+                   int nCmdShow) {
+  uint32_t errors = 0;
+
+  for (uint32_t count : { 0u, 1u, 1000u, 20000u }) {
+    auto pipelines = generatePipelines(count, count);
+
+    errors += testCodec(pipelines);
+    errors += testPacked(pipelines);
+  }
+
+  if (errors)
+    Logger::err(str::format("Failed with ", errors, " errors"));
+
+  return errors ? 1 : 0;
+}
@@ -0,0 +1,354 @@
+#include <fstream>
+#include <map>
+#include <random>
+#include <sstream>
+
+#include "../../src/dxvk/dxvk_tlsf.h"
+
+#include "../../src/util/util_time.h"
+
+#include <shellapi.h>
+#include <windows.h>
+
+namespace dxvk {
+  Logger Logger::s_instance("dxvk-tlsf.log");
+}
+
+using namespace dxvk;
+
+/**
+ * \brief Linear free list
+ *
+ * Reference implementation of the worst-fit
+ * free list previously used for memory chunks.
+ */
+class LinearFreeList {
+
+public:
+
+  LinearFreeList(VkDeviceSize size) {
+    m_freeList.push_back({ 0, size });
+  }
+
+  VkDeviceSize alloc(VkDeviceSize size, VkDeviceSize align, uint32_t& block) {
+    if (m_freeList.empty())
+      return DxvkTlsfAllocator::InvalidOffset;
+
+    auto bestSlice = m_freeList.begin();
+
+    for (auto slice = m_freeList.begin(); slice != m_freeList.end(); slice++) {
+      if (slice->length == size) {
+        bestSlice = slice;
+        break;
+      } else if (slice->length > bestSlice->length) {
+        bestSlice = slice;
+      }
+    }
+
+    const VkDeviceSize sliceStart = bestSlice->offset;
+    const VkDeviceSize sliceEnd   = bestSlice->offset + bestSlice->length;
+
+    const VkDeviceSize allocStart = dxvk::align(sliceStart,        align);
+    const VkDeviceSize allocEnd   = dxvk::align(allocStart + size, align);
+
+    if (allocEnd > sliceEnd)
+      return DxvkTlsfAllocator::InvalidOffset;
+
+    m_freeList.erase(bestSlice);
+
+    if (allocStart != sliceStart)
+      m_freeList.push_back({ sliceStart, allocStart - sliceStart });
+
+    if (allocEnd != sliceEnd)
+      m_freeList.push_back({ allocEnd, sliceEnd - allocEnd });
+
+    return allocStart;
+  }
+
+  void free(VkDeviceSize offset, VkDeviceSize length, uint32_t block) {
+    auto curr = m_freeList.begin();
+
+    while (curr != m_freeList.end()) {
+      if (curr->offset == offset + length) {
+        length += curr->length;
+        curr = m_freeList.erase(curr);
+      } else if (curr->offset + curr->length == offset) {
+        offset -= curr->length;
+        length += curr->length;
+        curr = m_freeList.erase(curr);
+      } else {
+        curr++;
+      }
+    }
+
+    m_freeList.push_back({ offset, length });
+  }
+
+private:
+
+  struct FreeSlice {
+    VkDeviceSize offset;
+    VkDeviceSize length;
+  };
+
+  std::vector<FreeSlice> m_freeList;
+
+};
+
+
+/**
+ * \brief TLSF allocator adapter
+ */
+class TlsfFreeList {
+
+public:
+
+  TlsfFreeList(VkDeviceSize size)
+  : m_allocator(size) { }
+
+  VkDeviceSize alloc(VkDeviceSize size, VkDeviceSize align, uint32_t& block) {
+    DxvkTlsfAllocation allocation = m_allocator.alloc(size, align);
+    block = allocation.block;
+    return allocation.offset;
+  }
+
+  void free(VkDeviceSize offset, VkDeviceSize length, uint32_t block) {
+    m_allocator.free(block);
+  }
+
+private:
+
+  DxvkTlsfAllocator m_allocator;
+
+};
+
+
+struct TraceOp {
+  bool          isAlloc;
+  uint32_t      id;
+  VkDeviceSize  size;
+  VkDeviceSize  align;
+};
+
+
+struct ReplayStats {
+  uint32_t      allocCount  = 0;
+  uint32_t      failCount   = 0;
+  uint32_t      freeCount   = 0;
+  uint32_t      errorCount  = 0;
+  double        timeUs      = 0.0;
+};
+
+
+/**
+ * \brief Loads a trace file
+ *
+ * Each line is either \c "a <id> <size> <align>"
+ * for allocations or \c "f <id>" for frees.
+ */
+std::vector<TraceOp> loadTrace(const std::string& fileName) {
+  std::ifstream file(fileName);
+  std::vector<TraceOp> trace;
+  std::string line;
+
+  while (std::getline(file, line)) {
+    std::stringstream stream(line);
+    std::string type;
+    TraceOp op = { };
+
+    stream >> type >> op.id;
+
+    if (type == "a") {
+      stream >> op.size >> op.align;
+      op.isAlloc = true;
+      trace.push_back(op);
+    } else if (type == "f") {
+      trace.push_back(op);
+    }
+  }
+
+  return trace;
+}
+
+
+/**
+ * \brief Generates a synthetic trace
+ *
+ * Mimics resource streaming: mostly small buffers and
+ * textures with occasional large allocations, with the
+ * number of live allocations oscillating over time.
+ */
+std::vector<TraceOp> generateTrace(uint32_t opCount, uint32_t seed) {
+  std::mt19937 rng(seed);
+  std::vector<TraceOp> trace;
+  std::vector<uint32_t> live;
+
+  uint32_t nextId = 0;
+
+  for (uint32_t i = 0; i < opCount; i++) {
+    uint32_t target = 256 + 128 * ((i / 8192) & 1);
+    bool alloc = live.empty() || (rng() % (2 * target)) >= live.size();
+
+    if (alloc) {
+      TraceOp op;
+      op.isAlloc = true;
+      op.id      = nextId++;
+
+      uint32_t sizeClass = rng() % 100;
+
+      if (sizeClass < 70)
+        op.size = 256 + rng() % (64 << 10);
+      else if (sizeClass < 97)
+        op.size = (64 << 10) + rng() % (1 << 20);
+      else
+        op.size = (1 << 20) + rng() % (4 << 20);
+
+      op.align = VkDeviceSize(256) << (rng() % 9);
+      live.push_back(op.id);
+      trace.push_back(op);
+    } else {
+      uint32_t index = rng() % live.size();
+
+      TraceOp op = { };
+      op.id = live[index];
+      live[index] = live.back();
+      live.pop_back();
+      trace.push_back(op);
+    }
+  }
+
+  for (uint32_t id : live) {
+    TraceOp op = { };
+    op.id = id;
+    trace.push_back(op);
+  }
+
+  return trace;
+}
+
+
+template<typename Alloc>
+ReplayStats replayTrace(
+  const std::vector<TraceOp>& trace,
+        VkDeviceSize          chunkSize,
+        bool                  validate) {
+  struct Range {
+    VkDeviceSize offset;
+    VkDeviceSize length;
+    uint32_t     block;
+  };
+
+  ReplayStats stats;
+  Alloc allocator(chunkSize);
+
+  std::unordered_map<uint32_t, Range> allocations;
+  std::map<VkDeviceSize, VkDeviceSize> ranges;
+
+  auto t0 = dxvk::high_resolution_clock::now();
+
+  for (const auto& op : trace) {
+    if (op.isAlloc) {
+      uint32_t block = 0;
+      VkDeviceSize offset = allocator.alloc(op.size, op.align, block);
+      stats.allocCount += 1;
+
+      if (offset == DxvkTlsfAllocator::InvalidOffset) {
+        stats.failCount += 1;
+        continue;
+      }
+
+      Range range = { offset, dxvk::align(op.size, op.align), block };
+      allocations.insert({ op.id, range });
+
+      if (validate) {
+        auto next = ranges.lower_bound(range.offset);
+
+        bool overlaps = range.offset % op.align != 0
+                     || range.offset + range.length > chunkSize
+                     || (next != ranges.end() && next->first < range.offset + range.length);
+
+        if (next != ranges.begin()) {
+          auto prev = std::prev(next);
+          overlaps |= prev->first + prev->second > range.offset;
+        }
+
+        if (overlaps)
+          stats.errorCount += 1;
+
+        ranges.insert({ range.offset, range.length });
+      }
+    } else {
+      auto entry = allocations.find(op.id);
+
+      if (entry == allocations.end())
+        continue;
+
+      allocator.free(entry->second.offset, entry->second.length, entry->second.block);
+      stats.freeCount += 1;
+
+      if (validate)
+        ranges.erase(entry->second.offset);
+
+      allocations.erase(entry);
+    }
+  }
+
+  auto t1 = dxvk::high_resolution_clock::now();
+  stats.timeUs = std::chrono::duration<double, std::micro>(t1 - t0).count();
+
+  if (validate) {
+    // Free everything that is still alive and make sure
+    // that all free blocks got merged back together
+    for (const auto& a : allocations)
+      allocator.free(a.second.offset, a.second.length, a.second.block);
+
+    uint32_t block = 0;
+
+    if (allocator.alloc(chunkSize, 1, block) != 0)
+      stats.errorCount += 1;
+  }
+
+  return stats;
+}
+
+
+template<typename Alloc>
+void runTest(
+  const char*                 name,
+  const std::vector<TraceOp>& trace,
+        VkDeviceSize          chunkSize) {
+  ReplayStats validation = replayTrace<Alloc>(trace, chunkSize, true);
+  ReplayStats benchmark  = replayTrace<Alloc>(trace, chunkSize, false);
+
+  Logger::info(str::format(name, ":",
+    "\n  Allocations: ", benchmark.allocCount, " (", benchmark.failCount, " failed)",
+    "\n  Frees:       ", benchmark.freeCount,
+    "\n  Errors:      ", validation.errorCount,
+    "\n  Time:        ", uint64_t(benchmark.timeUs), " us (",
+      uint64_t(1000.0 * benchmark.timeUs / double(trace.size())), " ns/op)"));
+}
+
+
+int WINAPI WinMain(HINSTANCE hInstance,
+                   HINSTANCE hPrevInstance,
+                   LPSTR lpCmdLine,
+                   int nCmdShow) {
+  int     argc = 0;
+  LPWSTR* argv = CommandLineToArgvW(
+    GetCommandLineW(), &argc);
+
+  constexpr VkDeviceSize ChunkSize = 128 << 20;
+
+  std::vector<TraceOp> trace = argc >= 2
+    ? loadTrace(str::fromws(argv[1]))
+    : generateTrace(1u << 20, 0);
+
+  if (trace.empty()) {
+    Logger::err("Usage: dxvk-tlsf [trace.txt]");
+    return 1;
+  }
+
+  runTest<LinearFreeList>("Linear free list", trace, ChunkSize);
+  runTest<TlsfFreeList>  ("TLSF",             trace, ChunkSize);
+  return 0;
+}